@@ -181,6 +181,45 @@ typedef struct MppBufferInfo_t {
 
 #define BUFFER_GROUP_SIZE_DEFAULT           (SZ_1M*80)
 
+/*
+ * mpp buffer group cpu mapping policy
+ *
+ * on_demand : buffer is mapped on the first cpu access. If map limit is set
+ *             the least recently used mapping of an unused buffer will be
+ *             unmapped when the mapped buffer count reaches the limit.
+ *             With zero limit the mapping stays until buffer is destroyed.
+ *             This is the default policy.
+ * always    : buffer is mapped when it is created and stays mapped.
+ * never     : buffer is never mapped and can only be accessed by fd.
+ *             The mapping of unused buffer is removed on policy change.
+ *
+ * NOTE: Mapping created by allocator on allocation (hugetlb memfd buffer) is
+ *       counted in the limit and can be unmapped like the others. Heap memory
+ *       of the normal allocator without memfd can not be unmapped. It is not
+ *       counted in the limit and keeps its pointer on never policy.
+ */
+typedef enum {
+    MPP_BUFFER_MAP_ON_DEMAND,
+    MPP_BUFFER_MAP_ALWAYS,
+    MPP_BUFFER_MAP_NEVER,
+    MPP_BUFFER_MAP_BUTT,
+} MppBufferMapPolicy;
+
+/*
+ * mpp buffer group statistics
+ *
+ * alloc_count      : buffer count allocated by allocator
+ * alloc_time_sum   : total allocator time in us including preallocation
+ * alloc_time_max   : max allocator time of one buffer in us
+ * reuse_count      : buffer get count served by unused buffer in group
+ */
+typedef struct MppBufferGroupStat_t {
+    RK_S32          alloc_count;
+    RK_S64          alloc_time_sum;
+    RK_S64          alloc_time_max;
+    RK_S32          reuse_count;
+} MppBufferGroupStat;
+
 /*
  * mpp_buffer_import_with_tag(MppBufferGroup group, MppBufferInfo *info, MppBuffer *buffer)
  *
@@ -257,6 +296,9 @@ typedef struct MppBufferInfo_t {
 #define mpp_buffer_group_get_external(group, type, ...) \
         mpp_buffer_group_get(group, type, MPP_BUFFER_EXTERNAL, MODULE_TAG, __FUNCTION__)
 
+#define mpp_buffer_group_prealloc(group, size, count) \
+        mpp_buffer_group_prealloc_with_tag(group, size, count, MODULE_TAG, __FUNCTION__)
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -301,6 +343,22 @@ MppBufferType mpp_buffer_group_type(MppBufferGroup group);
  */
 MPP_RET mpp_buffer_group_limit_config(MppBufferGroup group, size_t size, RK_S32 count);
 
+/*
+ * policy : cpu mapping policy of buffers in group
+ * limit  : 0 - no limit, other - max mapped buffer count on on_demand policy
+ */
+MPP_RET mpp_buffer_group_map_config(MppBufferGroup group, MppBufferMapPolicy policy, RK_S32 limit);
+
+/*
+ * Preallocate count buffers with size into internal group as unused buffers.
+ * The buffers are allocated in one batch out of the global buffer lock so
+ * it can be called from a separated thread before the stream starts.
+ * The count is clipped by the group count limit.
+ */
+MPP_RET mpp_buffer_group_prealloc_with_tag(MppBufferGroup group, size_t size, RK_S32 count,
+                                           const char *tag, const char *caller);
+MPP_RET mpp_buffer_group_stat(MppBufferGroup group, MppBufferGroupStat *stat);
+
 #ifdef __cplusplus
 }
 #endif
@@ -76,6 +76,7 @@ typedef enum MppMetaKey_e {
     /* mpp_frame / mpp_packet meta data info key */
     KEY_TEMPORAL_ID             = FOURCC_META('t', 'l', 'i', 'd'),
     KEY_LONG_REF_IDX            = FOURCC_META('l', 't', 'i', 'd'),
+    KEY_ENC_FRAME_DROP          = FOURCC_META('e', 'd', 'r', 'p'),   /* input frame dropped by encoder, value is delay in ms */
 } MppMetaKey;
 
 #define mpp_meta_get(meta) mpp_meta_get_with_tag(meta, MODULE_TAG, __FUNCTION__)
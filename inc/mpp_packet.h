@@ -67,6 +67,14 @@ MPP_RET mpp_packet_clr_eos(MppPacket packet);
 RK_U32  mpp_packet_get_eos(MppPacket packet);
 MPP_RET mpp_packet_set_extra_data(MppPacket packet);
 
+/*
+ * slice output on low delay encoding
+ * partition : packet contains only part of one encoded frame
+ * eoi       : packet contains the end of one encoded frame (end of image)
+ */
+RK_U32  mpp_packet_is_partition(const MppPacket packet);
+RK_U32  mpp_packet_is_eoi(const MppPacket packet);
+
 void        mpp_packet_set_buffer(MppPacket packet, MppBuffer buffer);
 MppBuffer   mpp_packet_get_buffer(const MppPacket packet);
 
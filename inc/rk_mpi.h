@@ -164,6 +164,26 @@ typedef struct MppApi_t {
     RK_U32 reserv[16];
 } MppApi;
 
+/**
+ * @ingroup rk_mpi
+ * @brief Stream information from sequence header probing.
+ *        Item which is not coded in stream is left zero.
+ */
+typedef struct MppDecStreamInfo_t {
+    MppCodingType   coding;
+    RK_U32          width;
+    RK_U32          height;
+    /* coding specific profile / level indication */
+    RK_U32          profile;
+    RK_U32          level;
+    RK_U32          bit_depth;
+    MppFrameFormat  fmt;
+    RK_U32          interlaced;
+    /* frame rate is fps_num / fps_den */
+    RK_U32          fps_num;
+    RK_U32          fps_den;
+} MppDecStreamInfo;
+
 
 #ifdef __cplusplus
 extern "C" {
@@ -197,6 +217,21 @@ MPP_RET mpp_destroy(MppCtx ctx);
 MPP_RET mpp_check_support_format(MppCtxType type, MppCodingType coding);
 void    mpp_show_support_format(void);
 
+/**
+ * @ingroup rk_mpi
+ * @brief Probe stream information from the first sequence header in data.
+ *        Only header syntax is parsed. No context, thread, hardware or
+ *        buffer is created so it is safe to call from any thread.
+ * @param coding video compression coding
+ * @param data stream data in the same format as decoder input packet
+ * @param size stream data size
+ * @param info output stream information
+ * @return MPP_OK on success, MPP_NOK when no sequence header is found,
+ *         MPP_ERR_STREAM on broken header, MPP_ERR_VALUE on unsupported coding
+ */
+MPP_RET mpp_dec_probe(MppCodingType coding, void *data, size_t size,
+                      MppDecStreamInfo *info);
+
 #ifdef __cplusplus
 }
 #endif
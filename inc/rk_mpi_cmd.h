@@ -17,6 +17,8 @@
 #ifndef __RK_MPI_CMD_H__
 #define __RK_MPI_CMD_H__
 
+#include "rk_type.h"
+
 /*
  * Command id bit usage is defined as follows:
  * bit 20 - 23  - module id
@@ -72,6 +74,17 @@ typedef enum {
      */
     MPP_SET_INPUT_TIMEOUT,              /* parameter type RK_S64 */
     MPP_SET_OUTPUT_TIMEOUT,             /* parameter type RK_S64 */
+    /*
+     * hardware scheduling across contexts, refer to MppSchedPriority
+     * deadline is the time budget in us of each frame on hardware
+     * counted from its submission request, zero for no deadline
+     */
+    MPP_SET_SCHED_PRIORITY,             /* parameter type RK_S32 */
+    MPP_SET_SCHED_DEADLINE,             /* parameter type RK_S64 */
+    MPP_GET_SCHED_STAT,                 /* parameter type MppSchedStat */
+    /* hardware latency histogram of the context, refer to MppHwLatStat */
+    MPP_GET_HW_LAT_STAT,                /* parameter type MppHwLatStat */
+    MPP_RESET_HW_LAT_STAT,              /* no parameter */
     MPP_CMD_END,
 
     MPP_CODEC_CMD_BASE                  = CMD_MODULE_CODEC,
@@ -92,6 +105,9 @@ typedef enum {
     MPP_DEC_SET_DISABLE_ERROR,          /* When set it will disable sw/hw error (H.264 / H.265) */
     MPP_DEC_SET_IMMEDIATE_OUT,
     MPP_DEC_SET_ENABLE_DEINTERLACE,     /* MPP enable deinterlace by default. Vpuapi can disable it */
+    MPP_DEC_SET_TASK_COUNT,             /* Need to setup before init, hal tasks in flight, parameter is RK_U32, 0 for default */
+    MPP_DEC_SET_OUTPUT_SCALE,           /* post-processor downscale output, parameter is RK_U32 ratio 1 / 2 / 4 / 8, MJPEG only */
+    MPP_DEC_SET_SKIP_MODE,              /* frame skip mode, parameter is MppDecSkipCfg */
     MPP_DEC_CMD_END,
 
     MPP_ENC_CMD_BASE                    = CMD_MODULE_CODEC | CMD_CTX_ID_ENC,
@@ -117,6 +133,9 @@ typedef enum {
     MPP_ENC_SET_QP_RANGE,               /* used for adjusting qp range, the parameter can be 1 or 2 */
     MPP_ENC_SET_ROI_CFG,                /* set MppEncROICfg structure */
     MPP_ENC_SET_CTU_QP,                 /* for H265 Encoder,set CTU's size and QP */
+    MPP_ENC_SET_TASK_BATCH,             /* frames sent to hardware in one batch, parameter is RK_S32, default 1 */
+    MPP_ENC_SET_PRE_ANALYSIS,           /* input scene cut and complexity analysis, parameter is RK_S32, default 0 */
+    MPP_ENC_GET_BUF_STAT,               /* get reference and scratch buffer memory, parameter is MppEncBufStat */
 
     MPP_ENC_CFG_RC                      = CMD_MODULE_CODEC | CMD_CTX_ID_ENC | CMD_ENC_CFG_RC,
     MPP_ENC_SET_RC,                     /* set MppEncRcCfg structure */
@@ -159,6 +178,90 @@ typedef enum {
     MPI_CMD_BUTT,
 } MpiCmd;
 
+/*
+ * Hardware priority class of one context
+ * Contexts sharing one hardware device are served by priority class first.
+ * BATCH    - offline transcoding which can be delayed
+ * NORMAL   - default class
+ * REALTIME - live stream which needs low latency
+ */
+typedef enum MppSchedPriority_e {
+    MPP_SCHED_PRIO_BATCH,
+    MPP_SCHED_PRIO_NORMAL,
+    MPP_SCHED_PRIO_REALTIME,
+    MPP_SCHED_PRIO_BUTT,
+} MppSchedPriority;
+
+/*
+ * Hardware scheduling statistic of one context, time is in us
+ * task_count   - finished hardware task count
+ * miss_count   - task count finished after its deadline
+ * max_late     - max time of task finished after its deadline
+ * wait_time    - total time waiting for other contexts on the device
+ * max_wait     - max time of one wait for other contexts on the device
+ */
+typedef struct MppSchedStat_t {
+    RK_U32  task_count;
+    RK_U32  miss_count;
+    RK_S64  max_late;
+    RK_S64  wait_time;
+    RK_S64  max_wait;
+} MppSchedStat;
+
+/*
+ * Latency histogram, time is in us
+ * Each power of two range is split into 4 bins and values below 4 us have
+ * their own bins. Bin i counts the values in [lower(i), lower(i + 1)) with
+ * lower(i) = MPP_LAT_HIST_BIN_LOWER(i). The last bin also counts all the
+ * values beyond its range.
+ * count    - sample count
+ * max      - max sample
+ * sum      - sum of all samples for average
+ */
+#define MPP_LAT_HIST_BINS               72
+#define MPP_LAT_HIST_BIN_LOWER(i)       \
+    (((i) < 4) ? (RK_U32)(i) : ((RK_U32)(4 + ((i) & 3)) << ((i) / 4 - 1)))
+
+typedef struct MppLatHist_t {
+    RK_U32  count;
+    RK_U32  max;
+    RK_U64  sum;
+    RK_U32  bins[MPP_LAT_HIST_BINS];
+} MppLatHist;
+
+/*
+ * Hardware latency statistic of one context
+ * hw       - register send to hardware done
+ * queue    - register ready to send, long queue means hardware saturation
+ * gen      - register generation, long gen means cpu bound hal
+ */
+typedef struct MppHwLatStat_t {
+    MppLatHist  hw;
+    MppLatHist  queue;
+    MppLatHist  gen;
+} MppHwLatStat;
+
+/*
+ * Decoder frame skip mode
+ * Skipped frames are dropped by parser before any frame buffer or hardware
+ * is used and no frame is output for them.
+ * NON_REF  - skip frames which are not used for reference
+ * NON_KEY  - decode key frames only (IDR / IRAP / intra frame)
+ * GOP      - decode one gop then skip the next (interval - 1) gops
+ */
+typedef enum MppDecSkipMode_e {
+    MPP_DEC_SKIP_NONE,
+    MPP_DEC_SKIP_NON_REF,
+    MPP_DEC_SKIP_NON_KEY,
+    MPP_DEC_SKIP_GOP,
+    MPP_DEC_SKIP_BUTT,
+} MppDecSkipMode;
+
+typedef struct MppDecSkipCfg_t {
+    MppDecSkipMode  mode;
+    RK_U32          interval;
+} MppDecSkipCfg;
+
 #include "rk_venc_cmd.h"
 
 #endif /*__RK_MPI_CMD_H__*/
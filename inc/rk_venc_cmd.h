@@ -159,6 +159,7 @@ typedef enum MppEncRcCfgChange_e {
     MPP_ENC_RC_CFG_CHANGE_FPS_OUT       = (1 << 6),     /* change on fps out flex / numerator / denorminator */
     MPP_ENC_RC_CFG_CHANGE_GOP           = (1 << 7),
     MPP_ENC_RC_CFG_CHANGE_SKIP_CNT      = (1 << 8),
+    MPP_ENC_RC_CFG_CHANGE_DROP_FRM      = (1 << 9),     /* change on drop mode / threshold */
     MPP_ENC_RC_CFG_CHANGE_ALL           = (0xFFFFFFFF),
 } MppEncRcCfgChange;
 
@@ -273,6 +274,23 @@ typedef struct MppEncRcCfg_t {
      * 0 - frame skip is not allow
      */
     RK_S32  skip_cnt;
+
+    /*
+     * drop_mode - input frame drop on encoder overload
+     * 0 - disable, all input frames are encoded
+     * 1 - drop input frame which can not be encoded in time
+     *
+     * Input frames are expected to arrive on fps_in timeline. When a frame
+     * is later than drop_threshold after adding the measured encoding time
+     * it is dropped and an empty packet with KEY_ENC_FRAME_DROP meta is
+     * output instead. Continuous drop count is limited by skip_cnt and
+     * limited to 2 when skip_cnt is 0.
+     *
+     * drop_threshold - max frame delay in millisecond
+     * 0 for two input frame intervals
+     */
+    RK_S32  drop_mode;
+    RK_S32  drop_threshold;
 } MppEncRcCfg;
 
 /*
@@ -848,10 +866,35 @@ typedef struct MppEncCodecCfg_t {
     };
 } MppEncCodecCfg;
 
+/*
+ * Slice split configuration
+ *
+ * split_en   - enable slice split
+ * split_mode - MppEncSplitMode
+ *              MPP_ENC_SPLIT_BY_BYTE - slice_size is the max byte size of slice
+ *              MPP_ENC_SPLIT_BY_CTU  - slice_size is the macroblock / CTU count
+ *                                      of slice
+ * slice_size - slice size in the unit of split_mode
+ * split_out  - 0 - all slices of one frame are output in one packet
+ *              1 - each slice is output in its own packet for low delay
+ *                  transmission. These packets are marked as partition and
+ *                  the last slice of the frame is marked as eoi, see
+ *                  mpp_packet_is_partition / mpp_packet_is_eoi.
+ *
+ * NOTE: hardware may round slice_size to its own granularity. For example
+ *       vepu only support split by whole macroblock row.
+ */
+typedef enum MppEncSplitMode_e {
+    MPP_ENC_SPLIT_NONE,
+    MPP_ENC_SPLIT_BY_BYTE,
+    MPP_ENC_SPLIT_BY_CTU,
+} MppEncSplitMode;
+
 typedef struct MppEncSliceSplit_t {
     RK_S32  split_en;
     RK_S32  split_mode;
     RK_S32  slice_size;
+    RK_S32  split_out;
 } MppEncSliceSplit;
 
 typedef enum MppEncRefMode_e {
@@ -993,4 +1036,20 @@ typedef struct MppEncOSDData_t {
     MppEncOSDRegion region[8];
 } MppEncOSDData;
 
+/*
+ * Buffer memory statistic of one encoder context for MPP_ENC_GET_BUF_STAT
+ *
+ * ref_size         - size of reconstruction / reference buffers owned by
+ *                    the context
+ * scratch_size     - size of buffers only used during one hardware task
+ * scratch_shared   - scratch buffers are taken from the process wide shared
+ *                    pool (env mpp_buffer_shared_pool) on each task and are
+ *                    not resident in the context
+ */
+typedef struct MppEncBufStat_t {
+    RK_S64          ref_size;
+    RK_S64          scratch_size;
+    RK_S32          scratch_shared;
+} MppEncBufStat;
+
 #endif /*__RK_VENC_CMD_H__*/
@@ -237,6 +237,7 @@ typedef enum SlotsPropType_e {
     SLOTS_COUNT,
     SLOTS_SIZE,
     SLOTS_FRAME_INFO,
+    SLOTS_OUTPUT_SCALE,         // downscale ratio of post-processor output, 1 for full size
     SLOTS_PROP_BUTT,
 } SlotsPropType;
 
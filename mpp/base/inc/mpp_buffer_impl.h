@@ -61,6 +61,21 @@ struct MppBufferImpl_t {
     RK_U32              internal;
     RK_S32              ref_count;
     struct list_head    list_status;
+
+    // cpu mapping status, map_count is the number of times buffer is mapped
+    RK_U32              mapped;
+    RK_S32              map_count;
+    struct list_head    list_maps;
+
+    // dma-buf identity of imported buffer for import cache lookup
+    RK_U32              import_key;
+    RK_U64              import_dev;
+    RK_U64              import_ino;
+    RK_U64              import_size;
+    // info.fd is dup'ed from user fd by import cache and closed on destroy
+    RK_U32              import_dup;
+    // time in us when the imported buffer is put into import cache
+    RK_S64              import_time;
 };
 
 struct MppBufferGroupImpl_t {
@@ -83,6 +98,35 @@ struct MppBufferGroupImpl_t {
     MppAllocator        allocator;
     MppAllocatorApi     *alloc_api;
 
+    // cpu mapping policy and mapped buffer status
+    MppBufferMapPolicy  map_policy;
+    RK_S32              map_limit;
+    RK_S32              count_mapped;
+    // link to list_maps in MppBufferImpl, most recently used at tail
+    struct list_head    list_mapped;
+
+    /*
+     * import cache on misc external group. The imported buffer is kept in
+     * unused list after it is released and reused by next import with the
+     * same dma-buf. cache_limit is the max unused buffer count and the
+     * unused buffer is dropped after cache_timeout ms. It is enabled by env
+     * mpp_buffer_import_cache and only caches dma-buf with its own inode.
+     */
+    RK_S32              cache_limit;
+    RK_S32              cache_timeout;
+    RK_U32              cache_hit;
+    RK_U32              cache_miss;
+
+    /*
+     * shared pool group for hardware scratch buffer. All buffers in the group
+     * have the same aligned size and are reused by every codec instance.
+     */
+    size_t              shared_size;
+    size_t              shared_align;
+
+    // allocation statistics
+    MppBufferGroupStat  stat;
+
     // thread that will be signal on buffer return
     MppBufCallback      callback;
     void                *arg;
@@ -119,7 +163,8 @@ extern RK_U32 mpp_buffer_debug;
  *
  *  mpp_buffer_mmap         : The created mpp_buffer can not be accessed directly.
  *                            It required map to access. This is an optimization
- *                            for reducing virtual memory usage.
+ *                            for reducing virtual memory usage. The mapping is
+ *                            controlled by group map policy.
  *
  *  mpp_buffer_get_unused   : get unused buffer with size. it will first search
  *                            the unused list. if failed it will create on from
@@ -143,17 +188,62 @@ MPP_RET mpp_buffer_mmap(MppBufferImpl *buffer, const char* caller);
 MPP_RET mpp_buffer_ref_inc(MppBufferImpl *buffer, const char* caller);
 MPP_RET mpp_buffer_ref_dec(MppBufferImpl *buffer, const char* caller);
 MppBufferImpl *mpp_buffer_get_unused(MppBufferGroupImpl *p, size_t size);
+MppBufferImpl *mpp_buffer_get_cached(MppBufferGroupImpl *p, MppBufferInfo *info,
+                                     const char *caller);
 
 MPP_RET mpp_buffer_group_init(MppBufferGroupImpl **group, const char *tag, const char *caller, MppBufferMode mode, MppBufferType type);
 MPP_RET mpp_buffer_group_deinit(MppBufferGroupImpl *p);
 MPP_RET mpp_buffer_group_reset(MppBufferGroupImpl *p);
 MPP_RET mpp_buffer_group_set_callback(MppBufferGroupImpl *p,
                                       MppBufCallback callback, void *arg);
+MPP_RET mpp_buffer_group_set_map(MppBufferGroupImpl *p,
+                                 MppBufferMapPolicy policy, RK_S32 limit);
+MPP_RET mpp_buffer_group_prealloc_impl(MppBufferGroupImpl *p, size_t size, RK_S32 count,
+                                       const char *tag, const char *caller);
+MPP_RET mpp_buffer_group_get_stat(MppBufferGroupImpl *p, MppBufferGroupStat *stat);
 // mpp_buffer_group helper function
 void mpp_buffer_group_dump(MppBufferGroupImpl *p);
 void mpp_buffer_service_dump();
 MppBufferGroupImpl *mpp_buffer_get_misc_group(MppBufferMode mode, MppBufferType type);
 
+/*
+ * Process wide pool for hardware scratch buffer which is only used during one
+ * hardware task, e.g. intermediate output or size table. Buffers are kept in
+ * one internal ion group per aligned size and returned by mpp_buffer_put.
+ * Codec instances with the same resolution then share the same buffers when
+ * they run on hardware one by one.
+ *
+ * The pool is opt-in by env mpp_buffer_shared_pool. Caller should keep its
+ * own buffer for the whole session when it is disabled.
+ * align should be power of 2 and zero means 4096.
+ */
+RK_U32  mpp_buffer_shared_pool_en(void);
+MPP_RET mpp_buffer_get_shared_with_tag(MppBuffer *buffer, size_t size, size_t align,
+                                       const char *tag, const char *caller);
+
+#define mpp_buffer_get_shared(buffer, size, align) \
+        mpp_buffer_get_shared_with_tag(buffer, size, align, MODULE_TAG, __FUNCTION__)
+
+/*
+ * Process wide cache for read-only hardware table, e.g. cabac init table.
+ * Table is keyed by name and buffer type and only filled once on first get.
+ * Following get with the same key returns the same buffer with a reference
+ * and the buffer is released on the last mpp_buffer_table_put.
+ *
+ * init is called to fill the table on creation. When init is NULL param is
+ * the table data and is copied directly. Caller must NOT write the buffer.
+ */
+typedef void (*MppBufferTableInit)(void *dst, size_t size, const void *param);
+
+MPP_RET mpp_buffer_table_get_with_caller(MppBuffer *buffer, const char *name,
+                                         MppBufferType type, size_t size,
+                                         MppBufferTableInit init, const void *param,
+                                         const char *caller);
+MPP_RET mpp_buffer_table_put(MppBuffer buffer);
+
+#define mpp_buffer_table_get(buffer, name, type, size, init, param) \
+        mpp_buffer_table_get_with_caller(buffer, name, type, size, init, param, __FUNCTION__)
+
 #ifdef __cplusplus
 }
 #endif
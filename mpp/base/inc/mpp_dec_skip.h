@@ -0,0 +1,56 @@
+/*
+ * Copyright 2018 Rockchip Electronics Co. LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __MPP_DEC_SKIP_H__
+#define __MPP_DEC_SKIP_H__
+
+#include "rk_type.h"
+#include "mpp_err.h"
+#include "rk_mpi_cmd.h"
+
+/*
+ * Frame skip decision shared by parsers
+ *
+ * Parser calls mpp_dec_skip_check once on the first slice / header of each
+ * frame with its key and reference property. When it returns non-zero the
+ * parser drops the frame before allocating any slot or dpb entry and returns
+ * a task without valid flag.
+ *
+ * gop_count    - key frames found after reset, the first gop is decoded
+ * gop_skip     - frames of current gop are skipped in gop mode
+ * skip_count   - total skipped frames
+ */
+typedef struct MppDecSkip_t {
+    MppDecSkipCfg   cfg;
+    RK_U32          gop_count;
+    RK_U32          gop_skip;
+    RK_U32          skip_count;
+} MppDecSkip;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+MPP_RET mpp_dec_skip_cfg_check(MppDecSkipCfg *cfg);
+MPP_RET mpp_dec_skip_set(MppDecSkip *skip, MppDecSkipCfg *cfg);
+void    mpp_dec_skip_reset(MppDecSkip *skip);
+RK_U32  mpp_dec_skip_check(MppDecSkip *skip, RK_U32 key, RK_U32 ref);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __MPP_DEC_SKIP_H__ */
@@ -23,6 +23,8 @@
 #define MPP_PACKET_FLAG_EXTRA_DATA      (0x00000002)
 #define MPP_PACKET_FLAG_INTERNAL        (0x00000004)
 #define MPP_PACKET_FLAG_INTRA           (0x00000008)
+#define MPP_PACKET_FLAG_PARTITION       (0x00000010)
+#define MPP_PACKET_FLAG_EOI             (0x00000020)
 
 /*
  * mpp_packet_imp structure
@@ -22,6 +22,7 @@
 #include "mpp_mem.h"
 #include "mpp_env.h"
 #include "mpp_list.h"
+#include "mpp_atomic.h"
 #include "mpp_common.h"
 
 #include "mpp_frame_impl.h"
@@ -167,6 +168,9 @@ typedef union SlotStatus_u {
         RK_U32  eos         : 1;        // buffer slot is last buffer slot from codec
         RK_U32  has_buffer  : 1;
         RK_U32  has_frame   : 1;
+
+        // release flag for lockless status check
+        RK_U32  on_release  : 1;        // buffer slot is releasing by one thread
     };
 } SlotStatus;
 
@@ -177,17 +181,45 @@ typedef struct MppBufSlotLog_t {
     SlotStatus          status_out;
 } MppBufSlotLog;
 
+/*
+ * Slot status is updated by compare-and-swap on SlotStatus.val so that parser
+ * and hal thread can mark slot flags without taking the slots lock.
+ *
+ * Free slots are tracked by a bitmap (bit set means free) which is claimed by
+ * compare-and-swap in mpp_buf_slot_get_unused. The entry array is allocated
+ * once with maximum capacity so that lockless access never sees a realloc.
+ */
+#define SLOT_MAP_BITS                   32
+#define SLOT_MAP_SIZE                   ((SLOT_IDX_BUTT + SLOT_MAP_BITS - 1) / SLOT_MAP_BITS)
+
 struct MppBufSlotEntry_t {
     MppBufSlotsImpl     *slots;
     struct list_head    list;
+    MppBufSlotEntry     *next;              // link in queue lockless pending stack
     SlotStatus          status;
     RK_S32              index;
+    // queue which slot is waiting in, QUEUE_BUTT for no queue
+    RK_U32              queue;
 
     RK_U32              eos;
     MppFrame            frame;
     MppBuffer           buffer;
 };
 
+/*
+ * multi-producer single-consumer slot queue
+ *
+ * enqueue pushes slot to the pending stack by compare-and-swap without lock.
+ * dequeue moves the whole pending stack to the fifo list in order and then
+ * checks the head of fifo. The consumer side is protected by its own lock
+ * which is only shared by the dequeue callers of the same queue.
+ */
+typedef struct MppBufSlotQueue_t {
+    MppBufSlotEntry     *pending;
+    struct list_head    fifo;
+    Mutex               *lock;
+} MppBufSlotQueue;
+
 struct MppBufSlotsImpl_t {
     Mutex               *lock;
     RK_U32              slots_idx;
@@ -214,6 +246,9 @@ struct MppBufSlotsImpl_t {
     // internal parameter
     RK_U32              numerator;
     RK_U32              denominator;
+    // frame width / height / stride divided by output_scale when hal
+    // post-processor writes downscaled output instead of decoded picture
+    RK_U32              output_scale;
 
     // NOTE: use MppFrame to store the buffer/display infomation
     //       any buffer related infomation change comparing to previous frame will
@@ -223,11 +258,15 @@ struct MppBufSlotsImpl_t {
     MppFrame            info;
     MppFrame            info_set;
 
-    // list for display
-    struct list_head    queue[QUEUE_BUTT];
+    // queue for display / deinterlace / convert
+    MppBufSlotQueue     queue[QUEUE_BUTT];
+
+    // free slot bitmap
+    RK_U32              free_map[SLOT_MAP_SIZE];
 
-    // list for log
-    mpp_list            *logs;
+    // ring buffer for operation log
+    MppBufSlotLog       *logs;
+    RK_U32              log_count;
 
     MppBufSlotEntry     *slots;
 };
@@ -237,15 +276,27 @@ static RK_U32 default_align_16(RK_U32 val)
     return MPP_ALIGN(val, 16);
 }
 
+static RK_U32 scale_size(RK_U32 val, RK_U32 scale)
+{
+    return (val + scale - 1) / scale;
+}
+
+/* codec stride is kept 16 aligned after downscale */
+static RK_U32 scale_stride(RK_U32 val, RK_U32 scale)
+{
+    return (scale > 1 && val) ? default_align_16(scale_size(val, scale)) : val;
+}
+
 static void generate_info_set(MppBufSlotsImpl *impl, MppFrame frame, RK_U32 force_default_align)
 {
-    RK_U32 width  = mpp_frame_get_width(frame);
-    RK_U32 height = mpp_frame_get_height(frame);
+    RK_U32 scale  = impl->output_scale;
+    RK_U32 width  = scale_size(mpp_frame_get_width(frame), scale);
+    RK_U32 height = scale_size(mpp_frame_get_height(frame), scale);
     MppFrameFormat fmt = mpp_frame_get_fmt(frame);
     RK_U32 depth = (fmt == MPP_FMT_YUV420SP_10BIT
                     || fmt == MPP_FMT_YUV422SP_10BIT) ? 10 : 8;
-    RK_U32 codec_hor_stride = mpp_frame_get_hor_stride(frame);
-    RK_U32 codec_ver_stride = mpp_frame_get_ver_stride(frame);
+    RK_U32 codec_hor_stride = scale_stride(mpp_frame_get_hor_stride(frame), scale);
+    RK_U32 codec_ver_stride = scale_stride(mpp_frame_get_ver_stride(frame), scale);
     RK_U32 hal_hor_stride = (codec_hor_stride) ?
                             (impl->hal_hor_align(codec_hor_stride)) :
                             (impl->hal_hor_align(width * depth >> 3));
@@ -300,14 +351,17 @@ static void _dump_slots(const char *caller, MppBufSlotsImpl *impl)
 
     mpp_log("\nslot operation history:\n\n");
 
-    mpp_list *logs = impl->logs;
+    MppBufSlotLog *logs = impl->logs;
     if (logs) {
-        while (logs->list_size()) {
-            MppBufSlotLog log;
-            logs->del_at_head(&log, sizeof(log));
+        RK_U32 count = impl->log_count;
+        RK_U32 start = (count > SLOT_OPS_MAX_COUNT) ? (count - SLOT_OPS_MAX_COUNT) : (0);
+
+        for (RK_U32 j = start; j < count; j++) {
+            MppBufSlotLog *log = &logs[j % SLOT_OPS_MAX_COUNT];
             mpp_log("index %2d op: %s status in %08x out %08x",
-                    log.index, op_string[log.ops], log.status_in.val, log.status_out.val);
+                    log->index, op_string[log->ops], log->status_in.val, log->status_out.val);
         }
+        impl->log_count = 0;
     }
 
     mpp_assert(0);
@@ -315,27 +369,23 @@ static void _dump_slots(const char *caller, MppBufSlotsImpl *impl)
     return;
 }
 
-static void add_slot_log(mpp_list *logs, RK_S32 index, MppBufSlotOps op, SlotStatus before, SlotStatus after)
+static void add_slot_log(MppBufSlotsImpl *impl, RK_S32 index, MppBufSlotOps op, SlotStatus before, SlotStatus after)
 {
+    MppBufSlotLog *logs = impl->logs;
+
     if (logs) {
-        MppBufSlotLog log = {
-            index,
-            op,
-            before,
-            after,
-        };
-        if (logs->list_size() >= SLOT_OPS_MAX_COUNT)
-            logs->del_at_head(NULL, sizeof(log));
-        logs->add_at_tail(&log, sizeof(log));
+        RK_U32 pos = MPP_FETCH_ADD(&impl->log_count, 1) % SLOT_OPS_MAX_COUNT;
+        MppBufSlotLog *log = &logs[pos];
+
+        log->index      = index;
+        log->ops        = op;
+        log->status_in  = before;
+        log->status_out = after;
     }
 }
 
-static void slot_ops_with_log(MppBufSlotsImpl *impl, MppBufSlotEntry *slot, MppBufSlotOps op, void *arg)
+static SlotStatus slot_ops_update(SlotStatus status, MppBufSlotOps op, void *arg, RK_U32 *error)
 {
-    RK_U32 error = 0;
-    RK_S32 index = slot->index;
-    SlotStatus status = slot->status;
-    SlotStatus before = status;
     switch (op) {
     case SLOT_INIT : {
         status.val = 0;
@@ -345,6 +395,7 @@ static void slot_ops_with_log(MppBufSlotsImpl *impl, MppBufSlotEntry *slot, MppB
     } break;
     case SLOT_CLR_ON_USE : {
         status.on_used = 0;
+        status.on_release = 0;
     } break;
     case SLOT_SET_NOT_READY : {
         status.not_ready = 1;
@@ -370,10 +421,8 @@ static void slot_ops_with_log(MppBufSlotsImpl *impl, MppBufSlotEntry *slot, MppB
     case SLOT_CLR_HAL_INPUT : {
         if (status.hal_use)
             status.hal_use--;
-        else {
-            mpp_err("can not clr hal_input on slot %d\n", slot->index);
-            error = 1;
-        }
+        else
+            *error = 1;
     } break;
     case SLOT_SET_HAL_OUTPUT : {
         status.hal_output = 1;
@@ -398,17 +447,14 @@ static void slot_ops_with_log(MppBufSlotsImpl *impl, MppBufSlotEntry *slot, MppB
     case SLOT_DEQUEUE_CONVERT : {
         if (status.queue_use)
             status.queue_use--;
-        else {
-            mpp_err("can not clr queue_use on slot %d\n", slot->index);
-            error = 1;
-        }
+        else
+            *error = 1;
     } break;
     case SLOT_SET_EOS : {
         status.eos = 1;
     } break;
     case SLOT_CLR_EOS : {
         status.eos = 0;
-        slot->eos = 0;
     } break;
     case SLOT_SET_FRAME : {
         status.has_frame = (arg) ? (1) : (0);
@@ -423,59 +469,180 @@ static void slot_ops_with_log(MppBufSlotsImpl *impl, MppBufSlotEntry *slot, MppB
         status.has_buffer = 0;
     } break;
     default : {
-        mpp_err("found invalid operation code %d\n", op);
-        error = 1;
+        *error = 1;
     } break;
     }
-    slot->status = status;
+
+    return status;
+}
+
+static void slot_ops_with_log(MppBufSlotsImpl *impl, MppBufSlotEntry *slot, MppBufSlotOps op, void *arg)
+{
+    RK_U32 error = 0;
+    RK_S32 index = slot->index;
+    SlotStatus before;
+    SlotStatus status;
+
+    do {
+        error = 0;
+        before.val = slot->status.val;
+        status = slot_ops_update(before, op, arg, &error);
+    } while (!MPP_BOOL_CAS(&slot->status.val, before.val, status.val));
+
+    if (op == SLOT_CLR_EOS)
+        slot->eos = 0;
+
     buf_slot_dbg(BUF_SLOT_DBG_OPS_RUNTIME, "slot %3d index %2d op: %s arg %010p status in %08x out %08x",
                  impl->slots_idx, index, op_string[op], arg, before.val, status.val);
-    add_slot_log(impl->logs, index, op, before, status);
-    if (error)
+    add_slot_log(impl, index, op, before, status);
+    if (error) {
+        if (op == SLOT_CLR_HAL_INPUT)
+            mpp_err("can not clr hal_input on slot %d\n", slot->index);
+        else if (op >= SLOT_ENQUEUE_OUTPUT && op <= SLOT_DEQUEUE_CONVERT)
+            mpp_err("can not clr queue_use on slot %d\n", slot->index);
+        else
+            mpp_err("found invalid operation code %d\n", op);
+
         dump_slots(impl);
+    }
 }
 
 static void init_slot_entry(MppBufSlotsImpl *impl, RK_S32 pos, RK_S32 count)
 {
-    MppBufSlotEntry *slot = impl->slots;
+    MppBufSlotEntry *slot = impl->slots + pos;
     for (RK_S32 i = 0; i < count; i++, slot++) {
         slot->slots = impl;
         INIT_LIST_HEAD(&slot->list);
+        slot->next  = NULL;
         slot->index = pos + i;
+        slot->queue = QUEUE_BUTT;
         slot->frame = NULL;
         slot_ops_with_log(impl, slot, SLOT_INIT, NULL);
     }
 }
 
+static void slot_mark_free(MppBufSlotsImpl *impl, RK_S32 index)
+{
+    MPP_FETCH_OR(&impl->free_map[index / SLOT_MAP_BITS], 1U << (index % SLOT_MAP_BITS));
+}
+
+/*
+ * rebuild free slot bitmap from slot status
+ * only called with lock on setup / info change when slots are not accessed
+ */
+static void reset_free_map(MppBufSlotsImpl *impl)
+{
+    MppBufSlotEntry *slot = impl->slots;
+    RK_S32 used = 0;
+    RK_S32 i;
+
+    memset(impl->free_map, 0, sizeof(impl->free_map));
+    for (i = 0; i < impl->buf_count; i++, slot++) {
+        if (slot->status.on_used)
+            used++;
+        else
+            impl->free_map[i / SLOT_MAP_BITS] |= 1U << (i % SLOT_MAP_BITS);
+    }
+    impl->used_count = used;
+    MPP_SYNC();
+}
+
+/*
+ * called by dequeue side with queue lock
+ * move all pending slots to fifo list with enqueue order
+ */
+static void slot_queue_fetch(MppBufSlotQueue *queue)
+{
+    MppBufSlotEntry *pending = (MppBufSlotEntry *)MPP_LOCK_XCHG(&queue->pending, NULL);
+    MppBufSlotEntry *order = NULL;
+
+    // pending stack is in reversed order
+    while (pending) {
+        MppBufSlotEntry *next = pending->next;
+
+        pending->next = order;
+        order = pending;
+        pending = next;
+    }
+
+    while (order) {
+        list_add_tail(&order->list, &queue->fifo);
+        order = order->next;
+    }
+}
+
+static void slot_queue_push(MppBufSlotQueue *queue, MppBufSlotEntry *slot)
+{
+    MppBufSlotEntry *head;
+
+    do {
+        head = queue->pending;
+        slot->next = head;
+    } while (!MPP_PTR_CAS(&queue->pending, head, slot));
+}
+
+static void slot_queue_remove(MppBufSlotsImpl *impl, MppBufSlotEntry *slot)
+{
+    RK_U32 type = slot->queue;
+
+    if (type >= QUEUE_BUTT)
+        return;
+
+    MppBufSlotQueue *queue = &impl->queue[type];
+    AutoMutex auto_lock(queue->lock);
+
+    slot_queue_fetch(queue);
+    list_del_init(&slot->list);
+    slot->queue = QUEUE_BUTT;
+}
+
 /*
  * only called on unref / displayed / decoded
  *
  * NOTE: MppFrame will be destroyed outside mpp
  *       but MppBuffer must dec_ref here
+ *
+ * The thread which successfully marks on_release on an idle slot owns the
+ * release process. Other threads will find the slot busy and skip.
  */
+static RK_U32 slot_is_idle(SlotStatus status)
+{
+    return (status.on_used &&
+            !status.on_release &&
+            !status.not_ready &&
+            !status.codec_use &&
+            !status.hal_output &&
+            !status.hal_use &&
+            !status.queue_use);
+}
+
 static void check_entry_unused(MppBufSlotsImpl *impl, MppBufSlotEntry *entry)
 {
-    SlotStatus status = entry->status;
-
-    if (status.on_used &&
-        !status.not_ready &&
-        !status.codec_use &&
-        !status.hal_output &&
-        !status.hal_use &&
-        !status.queue_use) {
-        if (entry->frame) {
-            slot_ops_with_log(impl, entry, SLOT_CLR_FRAME, entry->frame);
-            mpp_frame_deinit(&entry->frame);
-        }
-        if (entry->buffer) {
-            mpp_buffer_put(entry->buffer);
-            slot_ops_with_log(impl, entry, SLOT_CLR_BUFFER, entry->buffer);
-            entry->buffer = NULL;
-        }
+    SlotStatus status;
+    SlotStatus claim;
 
-        slot_ops_with_log(impl, entry, SLOT_CLR_ON_USE, NULL);
-        impl->used_count--;
+    do {
+        status.val = entry->status.val;
+        if (!slot_is_idle(status))
+            return;
+
+        claim = status;
+        claim.on_release = 1;
+    } while (!MPP_BOOL_CAS(&entry->status.val, status.val, claim.val));
+
+    if (entry->frame) {
+        slot_ops_with_log(impl, entry, SLOT_CLR_FRAME, entry->frame);
+        mpp_frame_deinit(&entry->frame);
+    }
+    if (entry->buffer) {
+        mpp_buffer_put(entry->buffer);
+        slot_ops_with_log(impl, entry, SLOT_CLR_BUFFER, entry->buffer);
+        entry->buffer = NULL;
     }
+
+    slot_ops_with_log(impl, entry, SLOT_CLR_ON_USE, NULL);
+    MPP_FETCH_SUB(&impl->used_count, 1);
+    slot_mark_free(impl, entry->index);
 }
 
 static void clear_slots_impl(MppBufSlotsImpl *impl)
@@ -484,10 +651,19 @@ static void clear_slots_impl(MppBufSlotsImpl *impl)
     RK_S32 i;
 
     for (i = 0; i < (RK_S32)MPP_ARRAY_ELEMS(impl->queue); i++) {
-        if (!list_empty(&impl->queue[i]))
+        MppBufSlotQueue *queue = &impl->queue[i];
+
+        if (NULL == queue->lock)
+            continue;
+
+        queue->lock->lock();
+        slot_queue_fetch(queue);
+        queue->lock->unlock();
+
+        if (!list_empty(&queue->fifo))
             dump_slots(impl);
 
-        mpp_assert(list_empty(&impl->queue[i]));
+        mpp_assert(list_empty(&queue->fifo));
     }
 
     for (i = 0; i < impl->buf_count; i++, slot++) {
@@ -506,8 +682,12 @@ static void clear_slots_impl(MppBufSlotsImpl *impl)
     if (impl->info_set)
         mpp_frame_deinit(&impl->info_set);
 
-    if (impl->logs)
-        delete impl->logs;
+    MPP_FREE(impl->logs);
+
+    for (i = 0; i < (RK_S32)MPP_ARRAY_ELEMS(impl->queue); i++) {
+        if (impl->queue[i].lock)
+            delete impl->queue[i].lock;
+    }
 
     if (impl->lock)
         delete impl->lock;
@@ -531,16 +711,26 @@ MPP_RET mpp_buf_slot_init(MppBufSlots *slots)
     mpp_env_get_u32("buf_slot_debug", &buf_slot_debug, BUF_SLOT_DBG_OPS_HISTORY);
 
     do {
+        RK_U32 i;
+
         impl->lock = new Mutex();
         if (NULL == impl->lock)
             break;
 
-        for (RK_U32 i = 0; i < MPP_ARRAY_ELEMS(impl->queue); i++) {
-            INIT_LIST_HEAD(&impl->queue[i]);
+        for (i = 0; i < MPP_ARRAY_ELEMS(impl->queue); i++) {
+            MppBufSlotQueue *queue = &impl->queue[i];
+
+            queue->pending = NULL;
+            INIT_LIST_HEAD(&queue->fifo);
+            queue->lock = new Mutex();
+            if (NULL == queue->lock)
+                break;
         }
+        if (i < MPP_ARRAY_ELEMS(impl->queue))
+            break;
 
         if (buf_slot_debug & BUF_SLOT_DBG_OPS_HISTORY) {
-            impl->logs = new mpp_list(NULL);
+            impl->logs = mpp_calloc(MppBufSlotLog, SLOT_OPS_MAX_COUNT);
             if (NULL == impl->logs)
                 break;
         }
@@ -557,6 +747,7 @@ MPP_RET mpp_buf_slot_init(MppBufSlots *slots)
         impl->hal_len_align = NULL;
         impl->numerator     = 9;
         impl->denominator   = 5;
+        impl->output_scale  = 1;
         impl->slots_idx     = buf_slot_idx++;
 
         *slots = impl;
@@ -591,19 +782,20 @@ MPP_RET mpp_buf_slot_setup(MppBufSlots slots, RK_S32 count)
 
     MppBufSlotsImpl *impl = (MppBufSlotsImpl *)slots;
     AutoMutex auto_lock(impl->lock);
+    slot_assert(impl, (count > 0) && (count <= SLOT_IDX_BUTT));
 
     if (NULL == impl->slots) {
         // first slot setup
+        // NOTE: slot entry array is never reallocated for lockless access
         impl->buf_count = impl->new_count = count;
-        impl->slots = mpp_calloc(MppBufSlotEntry, count);
+        impl->slots = mpp_calloc(MppBufSlotEntry, SLOT_IDX_BUTT);
         init_slot_entry(impl, 0, count);
-        impl->used_count = 0;
+        reset_free_map(impl);
     } else {
         // record the slot count for info changed ready config
-        if (count > impl->buf_count) {
-            mpp_realloc(impl->slots, MppBufSlotEntry, count);
+        if (count > impl->buf_count)
             init_slot_entry(impl, impl->buf_count, (count - impl->buf_count));
-        }
+
         impl->new_count = count;
     }
 
@@ -618,8 +810,7 @@ RK_U32 mpp_buf_slot_is_changed(MppBufSlots slots)
     }
 
     MppBufSlotsImpl *impl = (MppBufSlotsImpl *)slots;
-    AutoMutex auto_lock(impl->lock);
-    return impl->info_changed;
+    return MPP_ATOMIC_READ(&impl->info_changed);
 }
 
 MPP_RET mpp_buf_slot_ready(MppBufSlots slots)
@@ -639,19 +830,15 @@ MPP_RET mpp_buf_slot_ready(MppBufSlots slots)
 
     // ready mean the info_set will be copy to info as the new configuration
     if (impl->buf_count != impl->new_count) {
-        mpp_realloc(impl->slots, MppBufSlotEntry, impl->new_count);
         init_slot_entry(impl, 0, impl->new_count);
+        impl->buf_count = impl->new_count;
+        reset_free_map(impl);
     }
-    impl->buf_count = impl->new_count;
 
     mpp_frame_copy(impl->info, impl->info_set);
     impl->buf_size = mpp_frame_get_buf_size(impl->info);
 
-    if (impl->logs) {
-        mpp_list *logs = impl->logs;
-        while (logs->list_size())
-            logs->del_at_head(NULL, sizeof(MppBufSlotLog));
-    }
+    impl->log_count = 0;
     impl->info_changed  = 0;
     return MPP_OK;
 }
@@ -664,7 +851,6 @@ size_t mpp_buf_slot_get_size(MppBufSlots slots)
     }
 
     MppBufSlotsImpl *impl = (MppBufSlotsImpl *)slots;
-    AutoMutex auto_lock(impl->lock);
     return impl->buf_size;
 }
 
@@ -676,16 +862,29 @@ MPP_RET mpp_buf_slot_get_unused(MppBufSlots slots, RK_S32 *index)
     }
 
     MppBufSlotsImpl *impl = (MppBufSlotsImpl *)slots;
-    AutoMutex auto_lock(impl->lock);
-    RK_S32 i;
-    MppBufSlotEntry *slot = impl->slots;
-    for (i = 0; i < impl->buf_count; i++, slot++) {
-        if (!slot->status.on_used) {
-            *index = i;
-            slot_ops_with_log(impl, slot, SLOT_SET_ON_USE, NULL);
-            slot_ops_with_log(impl, slot, SLOT_SET_NOT_READY, NULL);
-            impl->used_count++;
-            return MPP_OK;
+    RK_U32 i;
+
+    for (i = 0; i < SLOT_MAP_SIZE; i++) {
+        RK_U32 *map = &impl->free_map[i];
+        RK_U32 val = MPP_ATOMIC_READ(map);
+
+        while (val) {
+            RK_U32 bit = val & (~val + 1);
+
+            if (MPP_BOOL_CAS(map, val, val & ~bit)) {
+                RK_S32 pos = i * SLOT_MAP_BITS + mpp_ctz(bit);
+                MppBufSlotEntry *slot = &impl->slots[pos];
+
+                slot_assert(impl, pos < impl->buf_count);
+                slot_assert(impl, !slot->status.on_used);
+
+                *index = pos;
+                slot_ops_with_log(impl, slot, SLOT_SET_ON_USE, NULL);
+                slot_ops_with_log(impl, slot, SLOT_SET_NOT_READY, NULL);
+                MPP_FETCH_ADD(&impl->used_count, 1);
+                return MPP_OK;
+            }
+            val = MPP_ATOMIC_READ(map);
         }
     }
 
@@ -704,7 +903,6 @@ MPP_RET mpp_buf_slot_set_flag(MppBufSlots slots, RK_S32 index, SlotUsageType typ
     }
 
     MppBufSlotsImpl *impl = (MppBufSlotsImpl *)slots;
-    AutoMutex auto_lock(impl->lock);
     slot_assert(impl, (index >= 0) && (index < impl->buf_count));
     slot_ops_with_log(impl, &impl->slots[index], set_flag_op[type], NULL);
     return MPP_OK;
@@ -718,13 +916,12 @@ MPP_RET mpp_buf_slot_clr_flag(MppBufSlots slots, RK_S32 index, SlotUsageType typ
     }
 
     MppBufSlotsImpl *impl = (MppBufSlotsImpl *)slots;
-    AutoMutex auto_lock(impl->lock);
     slot_assert(impl, (index >= 0) && (index < impl->buf_count));
     MppBufSlotEntry *slot = &impl->slots[index];
     slot_ops_with_log(impl, slot, clr_flag_op[type], NULL);
 
     if (type == SLOT_HAL_OUTPUT)
-        impl->decode_count++;
+        MPP_FETCH_ADD(&impl->decode_count, 1);
 
     check_entry_unused(impl, slot);
     return MPP_OK;
@@ -738,14 +935,18 @@ MPP_RET mpp_buf_slot_enqueue(MppBufSlots slots, RK_S32 index, SlotQueueType type
     }
 
     MppBufSlotsImpl *impl = (MppBufSlotsImpl *)slots;
-    AutoMutex auto_lock(impl->lock);
     slot_assert(impl, (index >= 0) && (index < impl->buf_count));
     MppBufSlotEntry *slot = &impl->slots[index];
     slot_ops_with_log(impl, slot, (MppBufSlotOps)(SLOT_ENQUEUE + type), NULL);
 
+    // slot already in a queue should be removed from the old queue first
+    if (!MPP_BOOL_CAS(&slot->queue, QUEUE_BUTT, (RK_U32)type)) {
+        slot_queue_remove(impl, slot);
+        slot->queue = type;
+    }
+
     // add slot to display list
-    list_del_init(&slot->list);
-    list_add_tail(&slot->list, &impl->queue[type]);
+    slot_queue_push(&impl->queue[type], slot);
     return MPP_OK;
 }
 
@@ -757,19 +958,23 @@ MPP_RET mpp_buf_slot_dequeue(MppBufSlots slots, RK_S32 *index, SlotQueueType typ
     }
 
     MppBufSlotsImpl *impl = (MppBufSlotsImpl *)slots;
-    AutoMutex auto_lock(impl->lock);
-    if (list_empty(&impl->queue[type]))
+    MppBufSlotQueue *queue = &impl->queue[type];
+    AutoMutex auto_lock(queue->lock);
+
+    slot_queue_fetch(queue);
+    if (list_empty(&queue->fifo))
         return MPP_NOK;
 
-    MppBufSlotEntry *slot = list_entry(impl->queue[type].next, MppBufSlotEntry, list);
+    MppBufSlotEntry *slot = list_entry(queue->fifo.next, MppBufSlotEntry, list);
     if (slot->status.not_ready)
         return MPP_NOK;
 
     // make sure that this slot is just the next display slot
     list_del_init(&slot->list);
+    slot->queue = QUEUE_BUTT;
     slot_assert(impl, slot->index < impl->buf_count);
     slot_ops_with_log(impl, slot, (MppBufSlotOps)(SLOT_DEQUEUE + type), NULL);
-    impl->display_count++;
+    MPP_FETCH_ADD(&impl->display_count, 1);
     *index = slot->index;
 
     return MPP_OK;
@@ -783,10 +988,8 @@ MPP_RET mpp_buf_slot_set_prop(MppBufSlots slots, RK_S32 index, SlotPropType type
     }
 
     MppBufSlotsImpl *impl = (MppBufSlotsImpl *)slots;
-    AutoMutex auto_lock(impl->lock);
     slot_assert(impl, (index >= 0) && (index < impl->buf_count));
     MppBufSlotEntry *slot = &impl->slots[index];
-    slot_ops_with_log(impl, slot, set_val_op[type], val);
 
     switch (type) {
     case SLOT_EOS: {
@@ -797,6 +1000,8 @@ MPP_RET mpp_buf_slot_set_prop(MppBufSlots slots, RK_S32 index, SlotPropType type
     } break;
     case SLOT_FRAME: {
         MppFrame frame = val;
+        // info change detection shares info_set with other slots
+        AutoMutex auto_lock(impl->lock);
 
         slot_assert(impl, slot->status.not_ready);
         /*
@@ -822,8 +1027,10 @@ MPP_RET mpp_buf_slot_set_prop(MppBufSlots slots, RK_S32 index, SlotPropType type
         //       then hal will modify it according to hardware requirement
         mpp_assert(src->hor_stride);
         mpp_assert(src->ver_stride);
-        dst->hor_stride = impl->hal_hor_align(src->hor_stride);
-        dst->ver_stride = impl->hal_ver_align(src->ver_stride);
+        dst->width = scale_size(src->width, impl->output_scale);
+        dst->height = scale_size(src->height, impl->output_scale);
+        dst->hor_stride = impl->hal_hor_align(scale_stride(src->hor_stride, impl->output_scale));
+        dst->ver_stride = impl->hal_ver_align(scale_stride(src->ver_stride, impl->output_scale));
         dst->eos = slot->eos;
 
         if (mpp_frame_info_cmp(impl->info, impl->info_set)) {
@@ -862,6 +1069,13 @@ MPP_RET mpp_buf_slot_set_prop(MppBufSlots slots, RK_S32 index, SlotPropType type
     } break;
     }
 
+    /*
+     * has_frame / has_buffer is published after the pointer is stored. The
+     * status CAS is a full barrier so lock-free get_prop never finds the
+     * flag with a NULL or stale pointer.
+     */
+    slot_ops_with_log(impl, slot, set_val_op[type], val);
+
     return MPP_OK;
 }
 
@@ -873,9 +1087,12 @@ MPP_RET mpp_buf_slot_get_prop(MppBufSlots slots, RK_S32 index, SlotPropType type
     }
 
     MppBufSlotsImpl *impl = (MppBufSlotsImpl *)slots;
-    AutoMutex auto_lock(impl->lock);
     slot_assert(impl, (index >= 0) && (index < impl->buf_count));
     MppBufSlotEntry *slot = &impl->slots[index];
+    SlotStatus status;
+
+    // pairs with the status update after pointer store in set_prop
+    status.val = MPP_ATOMIC_READ(&slot->status.val);
 
     switch (type) {
     case SLOT_EOS: {
@@ -883,10 +1100,10 @@ MPP_RET mpp_buf_slot_get_prop(MppBufSlots slots, RK_S32 index, SlotPropType type
     } break;
     case SLOT_FRAME: {
         MppFrame *frame = (MppFrame *)val;
-        //*frame = (slot->status.has_frame) ? (slot->frame) : (NULL);
+        //*frame = (status.has_frame) ? (slot->frame) : (NULL);
 
-        mpp_assert(slot->status.has_frame);
-        if (slot->status.has_frame) {
+        mpp_assert(status.has_frame);
+        if (status.has_frame) {
             if (NULL == *frame )
                 mpp_frame_init(frame);
             if (*frame)
@@ -896,12 +1113,12 @@ MPP_RET mpp_buf_slot_get_prop(MppBufSlots slots, RK_S32 index, SlotPropType type
     } break;
     case SLOT_FRAME_PTR: {
         MppFrame *frame = (MppFrame *)val;
-        mpp_assert(slot->status.has_frame);
-        *frame = (slot->status.has_frame) ? (slot->frame) : (NULL);
+        mpp_assert(status.has_frame);
+        *frame = (status.has_frame) ? (slot->frame) : (NULL);
     } break;
     case SLOT_BUFFER: {
         MppBuffer *buffer = (MppBuffer *)val;
-        *buffer = (slot->status.has_buffer) ? (slot->buffer) : (NULL);
+        *buffer = (status.has_buffer) ? (slot->buffer) : (NULL);
     } break;
     default : {
     } break;
@@ -923,12 +1140,34 @@ MPP_RET mpp_buf_slot_reset(MppBufSlots slots, RK_S32 index)
     AutoMutex auto_lock(impl->lock);
     slot_assert(impl, (index >= 0) && (index < impl->buf_count));
     MppBufSlotEntry *slot = &impl->slots[index];
+    SlotStatus status;
+    SlotStatus claim;
+    RK_U32 on_used;
+
+    /*
+     * claim the release by on_release like check_entry_unused. When the
+     * release is owned by other thread the slot is idle and not in queue.
+     */
+    do {
+        status.val = slot->status.val;
+        if (status.on_release)
+            return MPP_OK;
+
+        on_used = status.on_used;
+        claim = status;
+        claim.on_release = on_used;
+    } while (!MPP_BOOL_CAS(&slot->status.val, status.val, claim.val));
 
     // make sure that this slot is just the next display slot
-    list_del_init(&slot->list);
+    slot_queue_remove(impl, slot);
     slot_ops_with_log(impl, slot, SLOT_CLR_QUEUE_USE, NULL);
     slot_ops_with_log(impl, slot, SLOT_DEQUEUE, NULL);
     slot_ops_with_log(impl, slot, SLOT_CLR_ON_USE, NULL);
+
+    if (on_used) {
+        MPP_FETCH_SUB(&impl->used_count, 1);
+        slot_mark_free(impl, index);
+    }
     return MPP_OK;
 }
 
@@ -969,8 +1208,11 @@ RK_U32 mpp_slots_is_empty(MppBufSlots slots, SlotQueueType type)
     }
 
     MppBufSlotsImpl *impl = (MppBufSlotsImpl *)slots;
-    AutoMutex auto_lock(impl->lock);
-    return list_empty(&impl->queue[type]) ? 1 : 0;
+    MppBufSlotQueue *queue = &impl->queue[type];
+    AutoMutex auto_lock(queue->lock);
+
+    slot_queue_fetch(queue);
+    return list_empty(&queue->fifo) ? 1 : 0;
 }
 
 RK_S32 mpp_slots_get_used_count(MppBufSlots slots)
@@ -980,8 +1222,7 @@ RK_S32 mpp_slots_get_used_count(MppBufSlots slots)
         return 0;
     }
     MppBufSlotsImpl *impl = (MppBufSlotsImpl *)slots;
-    AutoMutex auto_lock(impl->lock);
-    return impl->used_count;
+    return MPP_ATOMIC_READ(&impl->used_count);
 }
 
 RK_S32 mpp_slots_get_unused_count(MppBufSlots slots)
@@ -992,9 +1233,9 @@ RK_S32 mpp_slots_get_unused_count(MppBufSlots slots)
     }
 
     MppBufSlotsImpl *impl = (MppBufSlotsImpl *)slots;
-    AutoMutex auto_lock(impl->lock);
-    slot_assert(impl, (impl->used_count >= 0) && (impl->used_count <= impl->buf_count));
-    return impl->buf_count - impl->used_count;
+    RK_S32 used_count = MPP_ATOMIC_READ(&impl->used_count);
+    slot_assert(impl, (used_count >= 0) && (used_count <= impl->buf_count));
+    return impl->buf_count - used_count;
 }
 
 MPP_RET mpp_slots_set_prop(MppBufSlots slots, SlotsPropType type, void *val)
@@ -1027,11 +1268,22 @@ MPP_RET mpp_slots_set_prop(MppBufSlots slots, SlotsPropType type, void *val)
         impl->hal_len_align = (AlignFunc)val;
     } break;
     case SLOTS_COUNT: {
-        impl->buf_count = value;
+        slot_assert(impl, value <= SLOT_IDX_BUTT);
+        if (impl->slots) {
+            // new entries must be initialized before the free map exposes them
+            if ((RK_S32)value > impl->buf_count)
+                init_slot_entry(impl, impl->buf_count, value - impl->buf_count);
+            impl->buf_count = value;
+            reset_free_map(impl);
+        } else
+            impl->buf_count = value;
     } break;
     case SLOTS_SIZE: {
         impl->buf_size = value;
     } break;
+    case SLOTS_OUTPUT_SCALE: {
+        impl->output_scale = value ? value : 1;
+    } break;
     case SLOTS_FRAME_INFO: {
         // do info change detection here
         generate_info_set(impl, (MppFrame)val, 1);
@@ -1070,6 +1322,9 @@ MPP_RET mpp_slots_get_prop(MppBufSlots slots, SlotsPropType type, void *val)
     case SLOTS_SIZE: {
         *((RK_U32 *)val) = (RK_U32)impl->buf_size;
     } break;
+    case SLOTS_OUTPUT_SCALE: {
+        *((RK_U32 *)val) = impl->output_scale;
+    } break;
     case SLOTS_FRAME_INFO: {
         MppFrame frame = (MppFrame)val;
         MppFrame info  = impl->info;
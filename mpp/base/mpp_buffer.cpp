@@ -44,6 +44,15 @@ MPP_RET mpp_buffer_import_with_tag(MppBufferGroup group, MppBufferInfo *info, Mp
     } else {
         // otherwise use default external group to manage them
         p = mpp_buffer_get_misc_group(MPP_BUFFER_EXTERNAL, info->type);
+
+        // the same dma-buf is usually imported repeatedly so try cache first
+        if (p && buffer) {
+            MppBufferImpl *buf = mpp_buffer_get_cached(p, info, caller);
+            if (buf) {
+                *buffer = buf;
+                return MPP_OK;
+            }
+        }
     }
 
     mpp_assert(p);
@@ -354,3 +363,36 @@ MPP_RET mpp_buffer_group_limit_config(MppBufferGroup group, size_t size, RK_S32
     return MPP_OK;
 }
 
+MPP_RET mpp_buffer_group_prealloc_with_tag(MppBufferGroup group, size_t size, RK_S32 count,
+                                           const char *tag, const char *caller)
+{
+    MppBufferGroupImpl *p = (MppBufferGroupImpl *)group;
+
+    if (NULL == p || p->mode != MPP_BUFFER_INTERNAL || 0 == size || count < 0) {
+        mpp_err_f("input invalid group %p size %d count %d\n", group, size, count);
+        return MPP_NOK;
+    }
+
+    return mpp_buffer_group_prealloc_impl(p, size, count, tag, caller);
+}
+
+MPP_RET mpp_buffer_group_stat(MppBufferGroup group, MppBufferGroupStat *stat)
+{
+    if (NULL == group || NULL == stat) {
+        mpp_err_f("input invalid group %p stat %p\n", group, stat);
+        return MPP_NOK;
+    }
+
+    return mpp_buffer_group_get_stat((MppBufferGroupImpl *)group, stat);
+}
+
+MPP_RET mpp_buffer_group_map_config(MppBufferGroup group, MppBufferMapPolicy policy, RK_S32 limit)
+{
+    if (NULL == group || policy >= MPP_BUFFER_MAP_BUTT || limit < 0) {
+        mpp_err_f("input invalid group %p policy %d limit %d\n", group, policy, limit);
+        return MPP_NOK;
+    }
+
+    return mpp_buffer_group_set_map((MppBufferGroupImpl *)group, policy, limit);
+}
+
@@ -17,14 +17,27 @@
 #define MODULE_TAG "mpp_buffer"
 
 #include <string.h>
+#include <sys/stat.h>
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+#if defined(__linux__)
+#include <sys/eventfd.h>
+#endif
 
 #include "mpp_log.h"
 #include "mpp_mem.h"
 #include "mpp_env.h"
+#include "mpp_time.h"
 
 #include "mpp_buffer_impl.h"
 
 #define BUFFER_OPS_MAX_COUNT            1024
+#define BUFFER_IMPORT_CACHE_DEFAULT     0
+#define BUFFER_IMPORT_CACHE_TIMEOUT     1000
+#define BUFFER_SHARED_ALIGN_DEFAULT     4096
+#define BUFFER_TABLE_NAME_LEN           32
 
 #define SEARCH_GROUP_BY_ID(id)  ((MppBufferService::get_instance())->get_group_by_id(id))
 
@@ -41,6 +54,8 @@ typedef enum MppBufOps_e {
     BUF_COMMIT,
     BUF_CREATE,
     BUF_MMAP,
+    BUF_MUNMAP,
+    BUF_CACHE_HIT,
     BUF_REF_INC,
     BUF_REF_DEC,
     BUF_DISCARD,
@@ -48,6 +63,15 @@ typedef enum MppBufOps_e {
     BUF_OPS_BUTT,
 } MppBufOps;
 
+typedef struct MppBufferTable_t {
+    struct list_head    list;
+    char                name[BUFFER_TABLE_NAME_LEN];
+    MppBufferType       type;
+    size_t              size;
+    RK_S32              ref_count;
+    MppBuffer           buffer;
+} MppBufferTable;
+
 typedef struct MppBufLog_t {
     struct list_head    list;
     RK_U32              group_id;
@@ -80,6 +104,14 @@ private:
     MppBufferGroupImpl  *misc[MPP_BUFFER_MODE_BUTT][MPP_BUFFER_TYPE_BUTT];
     RK_U32              misc_count;
 
+    // shared scratch pool groups keyed by size and alignment
+    RK_U32              shared_en;
+    RK_U32              shared_count;
+
+    // read-only hardware table cache and its group for each buffer type
+    MppBufferGroupImpl  *table_grp[MPP_BUFFER_TYPE_BUTT];
+    struct list_head    mListTable;
+
     struct list_head    mListGroup;
 
     // list for used buffer which do not have group
@@ -99,6 +131,13 @@ public:
                                    MppBufferMode mode, MppBufferType type,
                                    RK_U32 is_misc);
     MppBufferGroupImpl  *get_misc(MppBufferMode mode, MppBufferType type);
+    MppBufferGroupImpl  *get_shared(size_t size, size_t align);
+    RK_U32              get_shared_en() { return shared_en; }
+    MPP_RET             get_table(MppBuffer *buffer, const char *name,
+                                  MppBufferType type, size_t size,
+                                  MppBufferTableInit init, const void *param,
+                                  const char *caller);
+    MPP_RET             put_table(MppBuffer buffer);
     void                set_misc(MppBufferMode mode, MppBufferType type, MppBufferGroupImpl *val);
     void                put_group(MppBufferGroupImpl *group);
     MppBufferGroupImpl  *get_group_by_id(RK_U32 id);
@@ -117,6 +156,12 @@ static const char *type2str[MPP_BUFFER_TYPE_BUTT] = {
     "dma-buf",
     "drm",
 };
+static const char *map2str[MPP_BUFFER_MAP_BUTT] = {
+    "on demand",
+    "always",
+    "never",
+};
+
 static const char *ops2str[BUF_OPS_BUTT] = {
     "grp create ",
     "grp release",
@@ -127,6 +172,8 @@ static const char *ops2str[BUF_OPS_BUTT] = {
     "buf commit ",
     "buf create ",
     "buf mmap   ",
+    "buf munmap ",
+    "buf cached ",
     "buf ref inc",
     "buf ref dec",
     "buf discard",
@@ -193,6 +240,30 @@ static void buffer_group_dump_log(MppBufferGroupImpl *group)
     }
 }
 
+static MPP_RET map_buffer_no_lock(MppBufferGroupImpl *group, MppBufferImpl *buffer,
+                                  const char *caller);
+static void unmap_buffer_no_lock(MppBufferGroupImpl *group, MppBufferImpl *buffer,
+                                 const char *caller);
+
+static RK_S32 get_import_fd(RK_S32 fd)
+{
+#ifdef _WIN32
+    (void)fd;
+    return -1;
+#else
+    return fcntl(fd, F_DUPFD_CLOEXEC, 0);
+#endif
+}
+
+static void put_import_fd(RK_S32 fd)
+{
+#ifdef _WIN32
+    (void)fd;
+#else
+    close(fd);
+#endif
+}
+
 static MPP_RET deinit_buffer_no_lock(MppBufferImpl *buffer, const char *caller)
 {
     if (!MppBufferService::get_instance()->is_finalizing()) {
@@ -203,10 +274,21 @@ static MPP_RET deinit_buffer_no_lock(MppBufferImpl *buffer, const char *caller)
     list_del_init(&buffer->list_status);
     MppBufferGroupImpl *group = SEARCH_GROUP_BY_ID(buffer->group_id);
     if (group) {
+        // mapping will be released by allocator free / release
+        if (buffer->mapped) {
+            list_del_init(&buffer->list_maps);
+            buffer->mapped = 0;
+            group->count_mapped--;
+        }
+
         BufferOp func = (group->mode == MPP_BUFFER_INTERNAL) ?
                         (group->alloc_api->free) :
                         (group->alloc_api->release);
+        RK_S32 fd = buffer->info.fd;
+
         func(group->allocator, &buffer->info);
+        if (buffer->import_dup)
+            put_import_fd(fd);
         group->usage -= buffer->info.size;
         group->buffer_count--;
 
@@ -237,6 +319,12 @@ static MPP_RET inc_buffer_ref_no_lock(MppBufferImpl *buffer, const char *caller)
             list_add_tail(&buffer->list_status, &group->list_used);
             group->count_used++;
             group->count_unused--;
+
+            // reused buffer is the most recently used mapping
+            if (buffer->mapped) {
+                list_del_init(&buffer->list_maps);
+                list_add_tail(&buffer->list_maps, &group->list_mapped);
+            }
         } else {
             mpp_err_f("unused buffer without group\n");
             ret = MPP_NOK;
@@ -247,11 +335,230 @@ static MPP_RET inc_buffer_ref_no_lock(MppBufferImpl *buffer, const char *caller)
     return ret;
 }
 
+/*
+ * unmap the least recently used mapping of unused buffers until the mapped
+ * buffer count is below limit. Buffers in used can not be unmapped because
+ * the user may still hold the pointer.
+ */
+static void evict_mapped_no_lock(MppBufferGroupImpl *group, RK_S32 limit)
+{
+    MppBufferImpl *pos, *n;
+
+    list_for_each_entry_safe(pos, n, &group->list_mapped, MppBufferImpl, list_maps) {
+        if (group->count_mapped < limit)
+            break;
+
+        if (!pos->used)
+            unmap_buffer_no_lock(group, pos, __FUNCTION__);
+    }
+}
+
+// add new mapping as the most recently used one
+static void track_mapped_no_lock(MppBufferGroupImpl *group, MppBufferImpl *buffer)
+{
+    buffer->mapped = 1;
+    buffer->map_count++;
+    list_add_tail(&buffer->list_maps, &group->list_mapped);
+    group->count_mapped++;
+}
+
+static MPP_RET map_buffer_no_lock(MppBufferGroupImpl *group, MppBufferImpl *buffer,
+                                  const char *caller)
+{
+    MPP_RET ret = MPP_NOK;
+
+    if (group->map_policy == MPP_BUFFER_MAP_NEVER) {
+        mpp_err_f("group %d buffer %d map is disabled caller %s\n",
+                  group->group_id, buffer->buffer_id, caller);
+        return MPP_NOK;
+    }
+
+    if (buffer->info.ptr)
+        return MPP_OK;
+
+    if (group->alloc_api && group->alloc_api->mmap) {
+        if (group->map_limit && group->count_mapped >= group->map_limit)
+            evict_mapped_no_lock(group, group->map_limit);
+
+        ret = group->alloc_api->mmap(group->allocator, &buffer->info);
+        if (!ret && buffer->info.ptr && !buffer->mapped)
+            track_mapped_no_lock(group, buffer);
+
+        buffer_group_add_log(group, buffer, BUF_MMAP, caller);
+    }
+
+    return ret;
+}
+
+static void unmap_buffer_no_lock(MppBufferGroupImpl *group, MppBufferImpl *buffer,
+                                 const char *caller)
+{
+    MPP_RET ret = MPP_NOK;
+
+    if (!buffer->mapped)
+        return;
+
+    if (group->alloc_api->munmap)
+        ret = group->alloc_api->munmap(group->allocator, &buffer->info);
+
+    /*
+     * heap memory of normal allocator can not be unmapped and costs no extra
+     * mapping so it is removed from the mapped buffer accounting
+     */
+    list_del_init(&buffer->list_maps);
+    buffer->mapped = 0;
+    group->count_mapped--;
+
+    if (!ret)
+        buffer_group_add_log(group, buffer, BUF_MUNMAP, caller);
+}
+
+/*
+ * dma-buf fd is identified by (dev, inode, size). Different fds of one dma-buf
+ * share the same inode since kernel 5.3. Older kernel creates all dma-buf on
+ * the shared anon inode, the same one eventfd uses, and then the inode does
+ * not identify the dma-buf. No key is returned in that case and the buffer is
+ * not cached.
+ */
+#if defined(__linux__)
+static RK_S32 anon_inode_checked = 0;
+static RK_U64 anon_inode_dev = 0;
+static RK_U64 anon_inode_ino = 0;
+
+static RK_U32 is_anon_inode(struct stat *st)
+{
+    if (!anon_inode_checked) {
+        RK_S32 fd = eventfd(0, 0);
+        struct stat anon;
+
+        if (fd >= 0) {
+            if (!fstat(fd, &anon)) {
+                anon_inode_dev = (RK_U64)anon.st_dev;
+                anon_inode_ino = (RK_U64)anon.st_ino;
+            }
+            close(fd);
+        }
+        anon_inode_checked = 1;
+    }
+
+    return (RK_U64)st->st_dev == anon_inode_dev &&
+           (RK_U64)st->st_ino == anon_inode_ino;
+}
+#endif
+
+static MPP_RET get_dma_buf_key(RK_S32 fd, RK_U64 *dev, RK_U64 *ino, RK_U64 *size)
+{
+#ifdef _WIN32
+    (void)fd;
+    (void)dev;
+    (void)ino;
+    (void)size;
+    return MPP_NOK;
+#else
+    struct stat st;
+    off_t pos;
+    off_t end;
+
+    if (fd < 0 || fstat(fd, &st))
+        return MPP_NOK;
+
+#if defined(__linux__)
+    if (is_anon_inode(&st))
+        return MPP_NOK;
+#endif
+
+    // dma-buf reports its size on seek to end
+    pos = lseek(fd, 0, SEEK_CUR);
+    end = lseek(fd, 0, SEEK_END);
+    if (pos < 0 || end < 0)
+        return MPP_NOK;
+    lseek(fd, pos, SEEK_SET);
+
+    *dev = (RK_U64)st.st_dev;
+    *ino = (RK_U64)st.st_ino;
+    *size = (RK_U64)end;
+    return MPP_OK;
+#endif
+}
+
 static void dump_buffer_info(MppBufferImpl *buffer)
 {
-    mpp_log("buffer %p fd %4d size %10d ref_count %3d discard %d caller %s\n",
+    mpp_log("buffer %p fd %4d size %10d ref_count %3d discard %d mapped %d/%d caller %s\n",
             buffer, buffer->info.fd, buffer->info.size,
-            buffer->ref_count, buffer->discard, buffer->caller);
+            buffer->ref_count, buffer->discard, buffer->mapped,
+            buffer->map_count, buffer->caller);
+}
+
+static void update_alloc_stat_no_lock(MppBufferGroupImpl *group, RK_S64 time)
+{
+    MppBufferGroupStat *stat = &group->stat;
+
+    stat->alloc_count++;
+    stat->alloc_time_sum += time;
+    if (time > stat->alloc_time_max)
+        stat->alloc_time_max = time;
+
+    if (group->log_runtime_en)
+        mpp_log("group %2d alloc count %d cost %lld us\n",
+                group->group_id, stat->alloc_count, time);
+}
+
+/* add a buffer with valid info to the unused list of group */
+static void add_buffer_no_lock(MppBufferGroupImpl *group, MppBufferImpl *p,
+                               const char *tag, const char *caller)
+{
+    p->mode = group->mode;
+
+    if (NULL == tag)
+        tag = group->tag;
+
+    strncpy(p->tag, tag, sizeof(p->tag));
+    p->caller = caller;
+    p->group_id = group->group_id;
+    p->buffer_id = group->buffer_id;
+    INIT_LIST_HEAD(&p->list_status);
+    INIT_LIST_HEAD(&p->list_maps);
+    list_add_tail(&p->list_status, &group->list_unused);
+
+    /* allocator like hugetlb memfd maps the buffer on allocation */
+    if (p->info.ptr) {
+        if (group->map_limit && group->count_mapped >= group->map_limit)
+            evict_mapped_no_lock(group, group->map_limit);
+
+        track_mapped_no_lock(group, p);
+        if (group->map_policy == MPP_BUFFER_MAP_NEVER)
+            unmap_buffer_no_lock(group, p, caller);
+    } else if (group->map_policy == MPP_BUFFER_MAP_ALWAYS)
+        map_buffer_no_lock(group, p, caller);
+
+    group->buffer_id++;
+    group->usage += p->info.size;
+    group->buffer_count++;
+    group->count_unused++;
+
+    buffer_group_add_log(group, p,
+                         (group->mode == MPP_BUFFER_INTERNAL) ? (BUF_CREATE) : (BUF_COMMIT),
+                         caller);
+}
+
+/*
+ * Cached buffer holds the dma-buf after user has closed all its fds. Drop the
+ * oldest ones over the count limit and the ones unused for too long.
+ */
+static void evict_cached_no_lock(MppBufferGroupImpl *group, RK_S64 now, const char *caller)
+{
+    MppBufferImpl *pos, *n;
+    RK_S64 timeout = (RK_S64)group->cache_timeout * 1000;
+
+    // unused list is in put order so the oldest one is at head
+    list_for_each_entry_safe(pos, n, &group->list_unused, MppBufferImpl, list_status) {
+        if (group->count_unused <= group->cache_limit &&
+            (!timeout || now - pos->import_time < timeout))
+            break;
+
+        deinit_buffer_no_lock(pos, caller);
+        group->count_unused--;
+    }
 }
 
 MPP_RET mpp_buffer_create(const char *tag, const char *caller,
@@ -262,8 +569,12 @@ MPP_RET mpp_buffer_create(const char *tag, const char *caller,
     MPP_BUF_FUNCTION_ENTER();
 
     MPP_RET ret = MPP_OK;
-    BufferOp func = NULL;
     MppBufferImpl *p = NULL;
+    RK_U32 import_key = 0;
+    RK_U64 import_dev = 0;
+    RK_U64 import_ino = 0;
+    RK_U64 import_size = 0;
+    RK_S32 import_fd = info->fd;
 
     if (NULL == group) {
         mpp_err_f("can not create buffer without group\n");
@@ -291,9 +602,20 @@ MPP_RET mpp_buffer_create(const char *tag, const char *caller,
         goto RET;
     }
 
-    func = (group->mode == MPP_BUFFER_INTERNAL) ?
-           (group->alloc_api->alloc) : (group->alloc_api->import);
-    ret = func(group->allocator, info);
+    // record dma-buf identity before allocator may replace the fd
+    if (group->cache_limit && NULL == info->ptr)
+        import_key = !get_dma_buf_key(info->fd, &import_dev, &import_ino,
+                                      &import_size);
+
+    if (group->mode == MPP_BUFFER_INTERNAL) {
+        RK_S64 time = mpp_time();
+
+        ret = group->alloc_api->alloc(group->allocator, info);
+        if (MPP_OK == ret)
+            update_alloc_stat_no_lock(group, mpp_time() - time);
+    } else
+        ret = group->alloc_api->import(group->allocator, info);
+
     if (MPP_OK != ret) {
         mpp_err_f("failed to create buffer with size %d\n", info->size);
         mpp_free(p);
@@ -302,26 +624,31 @@ MPP_RET mpp_buffer_create(const char *tag, const char *caller,
     }
 
     p->info = *info;
-    p->mode = group->mode;
-
-    if (NULL == tag)
-        tag = group->tag;
-
-    strncpy(p->tag, tag, sizeof(p->tag));
-    p->caller = caller;
-    p->group_id = group->group_id;
-    p->buffer_id = group->buffer_id;
-    INIT_LIST_HEAD(&p->list_status);
-    list_add_tail(&p->list_status, &group->list_unused);
+    /*
+     * Only cache buffer which holds a fd of the same dma-buf. Allocator like
+     * the normal allocator replaces the fd with a fake one.
+     */
+    if (import_key && !get_dma_buf_key(info->fd, &p->import_dev, &p->import_ino,
+                                       &p->import_size))
+        p->import_key = (p->import_dev == import_dev &&
+                         p->import_ino == import_ino &&
+                         p->import_size == import_size);
+
+    /*
+     * Cached buffer outlives the user fd. When allocator keeps the user fd
+     * hold a dup of it to keep the fd valid until buffer is destroyed.
+     */
+    if (p->import_key && p->info.fd == import_fd) {
+        RK_S32 fd = get_import_fd(import_fd);
+
+        if (fd >= 0) {
+            p->info.fd = fd;
+            p->import_dup = 1;
+        } else
+            p->import_key = 0;
+    }
 
-    group->buffer_id++;
-    group->usage += info->size;
-    group->buffer_count++;
-    group->count_unused++;
-
-    buffer_group_add_log(group, p,
-                         (group->mode == MPP_BUFFER_INTERNAL) ? (BUF_CREATE) : (BUF_COMMIT),
-                         caller);
+    add_buffer_no_lock(group, p, tag, caller);
 
     if (buffer) {
         inc_buffer_ref_no_lock(p, caller);
@@ -343,11 +670,8 @@ MPP_RET mpp_buffer_mmap(MppBufferImpl *buffer, const char* caller)
     MPP_RET ret = MPP_NOK;
     MppBufferGroupImpl *group = SEARCH_GROUP_BY_ID(buffer->group_id);
 
-    if (group && group->alloc_api && group->alloc_api->mmap) {
-        ret = group->alloc_api->mmap(group->allocator, &buffer->info);
-
-        buffer_group_add_log(group, buffer, BUF_MMAP, caller);
-    }
+    if (group)
+        ret = map_buffer_no_lock(group, buffer, caller);
 
     if (ret)
         mpp_err_f("buffer %p group %p fd %d map failed caller %s\n",
@@ -390,13 +714,24 @@ MPP_RET mpp_buffer_ref_dec(MppBufferImpl *buffer, const char* caller)
             buffer->used = 0;
             list_del_init(&buffer->list_status);
             if (group == MppBufferService::get_instance()->get_misc(group->mode, group->type)) {
-                deinit_buffer_no_lock(buffer, caller);
+                if (buffer->import_key && !buffer->discard && group->cache_limit) {
+                    // keep imported buffer for next import of the same dma-buf
+                    buffer->import_time = mpp_time();
+                    list_add_tail(&buffer->list_status, &group->list_unused);
+                    group->count_unused++;
+
+                    evict_cached_no_lock(group, buffer->import_time, caller);
+                } else
+                    deinit_buffer_no_lock(buffer, caller);
             } else {
                 if (buffer->discard) {
                     deinit_buffer_no_lock(buffer, caller);
                 } else {
                     list_add_tail(&buffer->list_status, &group->list_unused);
                     group->count_unused++;
+
+                    if (group->map_policy == MPP_BUFFER_MAP_NEVER)
+                        unmap_buffer_no_lock(group, buffer, caller);
                 }
             }
             group->count_used--;
@@ -427,6 +762,7 @@ MppBufferImpl *mpp_buffer_get_unused(MppBufferGroupImpl *p, size_t size)
             if (pos->info.size >= size) {
                 buffer = pos;
                 inc_buffer_ref_no_lock(buffer, __FUNCTION__);
+                p->stat.reuse_count++;
                 found = 1;
                 break;
             } else {
@@ -446,6 +782,50 @@ MppBufferImpl *mpp_buffer_get_unused(MppBufferGroupImpl *p, size_t size)
     return buffer;
 }
 
+MppBufferImpl *mpp_buffer_get_cached(MppBufferGroupImpl *p, MppBufferInfo *info,
+                                     const char *caller)
+{
+    RK_U64 dev = 0;
+    RK_U64 ino = 0;
+    RK_U64 size = 0;
+
+    if (!p->cache_limit || info->ptr)
+        return NULL;
+
+    AutoMutex auto_lock(MppBufferService::get_lock());
+
+    if (get_dma_buf_key(info->fd, &dev, &ino, &size))
+        return NULL;
+
+    MPP_BUF_FUNCTION_ENTER();
+
+    MppBufferImpl *buffer = NULL;
+    MppBufferImpl *pos, *n;
+
+    evict_cached_no_lock(p, mpp_time(), caller);
+
+    list_for_each_entry_safe(pos, n, &p->list_unused, MppBufferImpl, list_status) {
+        if (pos->import_dev != dev || pos->import_ino != ino ||
+            pos->import_size != size)
+            continue;
+
+        if (pos->info.size >= info->size) {
+            buffer = pos;
+            buffer_group_add_log(p, buffer, BUF_CACHE_HIT, caller);
+            inc_buffer_ref_no_lock(buffer, caller);
+        }
+        break;
+    }
+
+    if (buffer)
+        p->cache_hit++;
+    else
+        p->cache_miss++;
+
+    MPP_BUF_FUNCTION_LEAVE();
+    return buffer;
+}
+
 MPP_RET mpp_buffer_group_init(MppBufferGroupImpl **group, const char *tag, const char *caller,
                               MppBufferMode mode, MppBufferType type)
 {
@@ -527,6 +907,129 @@ MPP_RET mpp_buffer_group_set_callback(MppBufferGroupImpl *p,
     return MPP_OK;
 }
 
+MPP_RET mpp_buffer_group_prealloc_impl(MppBufferGroupImpl *p, size_t size, RK_S32 count,
+                                       const char *tag, const char *caller)
+{
+    MppBufferImpl **bufs = NULL;
+    RK_S64 *times = NULL;
+    RK_S32 done = 0;
+    RK_S32 i;
+
+    MPP_BUF_FUNCTION_ENTER();
+
+    {
+        AutoMutex auto_lock(MppBufferService::get_lock());
+
+        if (p->limit_size && size > p->limit_size) {
+            mpp_err_f("required size %d reach group size limit %d\n", size, p->limit_size);
+            return MPP_NOK;
+        }
+
+        if (p->limit_count)
+            count = MPP_MIN(count, p->limit_count - p->buffer_count);
+    }
+
+    if (count <= 0)
+        return MPP_OK;
+
+    bufs = mpp_calloc(MppBufferImpl *, count);
+    times = mpp_calloc(RK_S64, count);
+    if (NULL == bufs || NULL == times) {
+        mpp_err_f("failed to allocate context\n");
+        MPP_FREE(bufs);
+        MPP_FREE(times);
+        return MPP_ERR_MALLOC;
+    }
+
+    // the allocator has its own lock so the global buffer lock is not held
+    for (i = 0; i < count; i++) {
+        MppBufferImpl *buf = mpp_calloc(MppBufferImpl, 1);
+        RK_S64 time = mpp_time();
+
+        if (NULL == buf)
+            break;
+
+        buf->info.type = p->type;
+        buf->info.size = size;
+        buf->info.fd = -1;
+        buf->info.index = -1;
+
+        if (p->alloc_api->alloc(p->allocator, &buf->info)) {
+            mpp_err_f("failed to create buffer %d with size %d\n", i, size);
+            mpp_free(buf);
+            break;
+        }
+
+        times[done] = mpp_time() - time;
+        bufs[done++] = buf;
+    }
+
+    {
+        AutoMutex auto_lock(MppBufferService::get_lock());
+
+        for (i = 0; i < done; i++) {
+            MppBufferImpl *buf = bufs[i];
+
+            // other thread may create buffer meanwhile
+            if (p->limit_count && p->buffer_count >= p->limit_count) {
+                p->alloc_api->free(p->allocator, &buf->info);
+                mpp_free(buf);
+                continue;
+            }
+
+            update_alloc_stat_no_lock(p, times[i]);
+            add_buffer_no_lock(p, buf, tag, caller);
+        }
+
+        if (done && p->callback)
+            p->callback(p->arg, p);
+    }
+
+    mpp_free(bufs);
+    mpp_free(times);
+
+    MPP_BUF_FUNCTION_LEAVE();
+    return (done == count) ? (MPP_OK) : (MPP_NOK);
+}
+
+MPP_RET mpp_buffer_group_get_stat(MppBufferGroupImpl *p, MppBufferGroupStat *stat)
+{
+    AutoMutex auto_lock(MppBufferService::get_lock());
+
+    *stat = p->stat;
+    return MPP_OK;
+}
+
+MPP_RET mpp_buffer_group_set_map(MppBufferGroupImpl *p,
+                                 MppBufferMapPolicy policy, RK_S32 limit)
+{
+    AutoMutex auto_lock(MppBufferService::get_lock());
+    if (NULL == p) {
+        mpp_err_f("found NULL pointer\n");
+        return MPP_ERR_NULL_PTR;
+    }
+
+    MPP_BUF_FUNCTION_ENTER();
+
+    p->map_policy = policy;
+    p->map_limit  = limit;
+
+    switch (policy) {
+    case MPP_BUFFER_MAP_ON_DEMAND : {
+        if (limit)
+            evict_mapped_no_lock(p, limit);
+    } break;
+    case MPP_BUFFER_MAP_NEVER : {
+        evict_mapped_no_lock(p, 0);
+    } break;
+    default : {
+    } break;
+    }
+
+    MPP_BUF_FUNCTION_LEAVE();
+    return MPP_OK;
+}
+
 void mpp_buffer_group_dump(MppBufferGroupImpl *group, const char *caller)
 {
     mpp_log("\ndumping buffer group %p id %d from %s\n", group,
@@ -534,6 +1037,16 @@ void mpp_buffer_group_dump(MppBufferGroupImpl *group, const char *caller)
     mpp_log("mode %s\n", mode2str[group->mode]);
     mpp_log("type %s\n", type2str[group->type]);
     mpp_log("limit size %d count %d\n", group->limit_size, group->limit_count);
+    mpp_log("map policy %s limit %d mapped %d\n", map2str[group->map_policy],
+            group->map_limit, group->count_mapped);
+    if (group->cache_limit)
+        mpp_log("import cache limit %d hit %d miss %d\n", group->cache_limit,
+                group->cache_hit, group->cache_miss);
+    if (group->stat.alloc_count)
+        mpp_log("alloc count %d reuse %d time avg %lld max %lld us\n",
+                group->stat.alloc_count, group->stat.reuse_count,
+                group->stat.alloc_time_sum / group->stat.alloc_count,
+                group->stat.alloc_time_max);
 
     mpp_log("used buffer count %d\n", group->count_used);
 
@@ -576,21 +1089,96 @@ MppBufferGroupImpl *mpp_buffer_get_misc_group(MppBufferMode mode, MppBufferType
     return misc;
 }
 
+RK_U32 mpp_buffer_shared_pool_en(void)
+{
+    AutoMutex auto_lock(MppBufferService::get_lock());
+    return MppBufferService::get_instance()->get_shared_en();
+}
+
+MPP_RET mpp_buffer_get_shared_with_tag(MppBuffer *buffer, size_t size, size_t align,
+                                       const char *tag, const char *caller)
+{
+    MppBufferGroupImpl *group = NULL;
+
+    if (NULL == buffer || 0 == size) {
+        mpp_err_f("invalid input buffer %p size %d\n", buffer, size);
+        return MPP_ERR_NULL_PTR;
+    }
+
+    if (0 == align)
+        align = BUFFER_SHARED_ALIGN_DEFAULT;
+
+    if (align & (align - 1)) {
+        mpp_err_f("invalid align %d\n", align);
+        return MPP_ERR_VALUE;
+    }
+
+    size = MPP_ALIGN(size, align);
+
+    {
+        AutoMutex auto_lock(MppBufferService::get_lock());
+        group = MppBufferService::get_instance()->get_shared(size, align);
+    }
+
+    if (NULL == group) {
+        mpp_err_f("failed to get shared group size %d\n", size);
+        return MPP_NOK;
+    }
+
+    return mpp_buffer_get_with_tag(group, buffer, size, tag, caller);
+}
+
+MPP_RET mpp_buffer_table_get_with_caller(MppBuffer *buffer, const char *name,
+                                         MppBufferType type, size_t size,
+                                         MppBufferTableInit init, const void *param,
+                                         const char *caller)
+{
+    if (NULL == buffer || NULL == name || 0 == size ||
+        (NULL == init && NULL == param)) {
+        mpp_err_f("invalid input buffer %p name %s size %d init %p param %p\n",
+                  buffer, name, size, init, param);
+        return MPP_ERR_NULL_PTR;
+    }
+
+    AutoMutex auto_lock(MppBufferService::get_lock());
+    return MppBufferService::get_instance()->get_table(buffer, name, type, size,
+                                                       init, param, caller);
+}
+
+MPP_RET mpp_buffer_table_put(MppBuffer buffer)
+{
+    if (NULL == buffer) {
+        mpp_err_f("invalid NULL input\n");
+        return MPP_ERR_NULL_PTR;
+    }
+
+    AutoMutex auto_lock(MppBufferService::get_lock());
+    return MppBufferService::get_instance()->put_table(buffer);
+}
+
 MppBufferService::MppBufferService()
     : group_id(0),
       group_count(0),
       finalizing(0),
-      misc_count(0)
+      misc_count(0),
+      shared_en(0),
+      shared_count(0)
 {
     RK_S32 i, j;
 
+    INIT_LIST_HEAD(&mListTable);
     INIT_LIST_HEAD(&mListGroup);
     INIT_LIST_HEAD(&mListOrphan);
 
+    mpp_env_get_u32("mpp_buffer_shared_pool", &shared_en, 0);
+
     // NOTE: Do not create misc group at beginning. Only create on when needed.
     for (i = 0; i < MPP_BUFFER_MODE_BUTT; i++)
         for (j = 0; j < MPP_BUFFER_TYPE_BUTT; j++)
             misc[i][j] = NULL;
+
+    for (i = 0; i < MPP_BUFFER_TYPE_BUTT; i++)
+        table_grp[i] = NULL;
 }
 
 MppBufferService::~MppBufferService()
@@ -599,6 +1187,35 @@ MppBufferService::~MppBufferService()
 
     finalizing = 1;
 
+    // release the tables which are not put by user then the table groups
+    if (!list_empty(&mListTable)) {
+        MppBufferTable *pos, *n;
+
+        mpp_log_f("cleaning leaked table\n");
+        list_for_each_entry_safe(pos, n, &mListTable, MppBufferTable, list) {
+            mpp_log_f("table %s ref %d\n", pos->name, pos->ref_count);
+            pos->ref_count = 1;
+            put_table(pos->buffer);
+        }
+    }
+
+    for (i = 0; i < MPP_BUFFER_TYPE_BUTT; i++) {
+        if (table_grp[i]) {
+            put_group(table_grp[i]);
+            table_grp[i] = NULL;
+        }
+    }
+
+    // shared pool groups are owned by service and released here
+    if (shared_count) {
+        MppBufferGroupImpl *pos, *n;
+
+        list_for_each_entry_safe(pos, n, &mListGroup, MppBufferGroupImpl, list_group) {
+            if (pos->shared_size)
+                put_group(pos);
+        }
+    }
+
     // first remove legacy group which is the normal case
     if (misc_count) {
         mpp_log_f("cleaning misc group\n");
@@ -661,6 +1278,7 @@ MppBufferGroupImpl *MppBufferService::get_group(const char *tag, const char *cal
     INIT_LIST_HEAD(&p->list_group);
     INIT_LIST_HEAD(&p->list_used);
     INIT_LIST_HEAD(&p->list_unused);
+    INIT_LIST_HEAD(&p->list_mapped);
 
     mpp_env_get_u32("mpp_buffer_debug", &mpp_buffer_debug, 0);
     p->log_runtime_en   = (mpp_buffer_debug & MPP_BUF_DBG_OPS_RUNTIME) ? (1) : (0);
@@ -690,6 +1308,23 @@ MppBufferGroupImpl *MppBufferService::get_group(const char *tag, const char *cal
     if (is_misc) {
         misc[mode][buffer_type] = p;
         misc_count++;
+
+        /*
+         * import cache only works on dma-buf fd and is disabled by default.
+         * It needs kernel 5.3 or later where each dma-buf has its own inode.
+         */
+        if (mode == MPP_BUFFER_EXTERNAL && buffer_type != MPP_BUFFER_TYPE_NORMAL) {
+            RK_U32 cache_limit = BUFFER_IMPORT_CACHE_DEFAULT;
+
+            RK_U32 cache_timeout = BUFFER_IMPORT_CACHE_TIMEOUT;
+
+            mpp_env_get_u32("mpp_buffer_import_cache", &cache_limit,
+                            BUFFER_IMPORT_CACHE_DEFAULT);
+            mpp_env_get_u32("mpp_buffer_import_cache_ms", &cache_timeout,
+                            BUFFER_IMPORT_CACHE_TIMEOUT);
+            p->cache_limit = cache_limit;
+            p->cache_timeout = cache_timeout;
+        }
     }
 
     return p;
@@ -707,6 +1342,123 @@ MppBufferGroupImpl *MppBufferService::get_misc(MppBufferMode mode, MppBufferType
     return misc[mode][type];
 }
 
+MppBufferGroupImpl *MppBufferService::get_shared(size_t size, size_t align)
+{
+    MppBufferGroupImpl *pos, *n;
+
+    list_for_each_entry_safe(pos, n, &mListGroup, MppBufferGroupImpl, list_group) {
+        if (pos->shared_size == size && pos->shared_align == align)
+            return pos;
+    }
+
+    pos = get_group("shared", __FUNCTION__, MPP_BUFFER_INTERNAL, MPP_BUFFER_TYPE_ION, 0);
+    if (pos) {
+        pos->shared_size = size;
+        pos->shared_align = align;
+        shared_count++;
+
+        mpp_buf_dbg(MPP_BUF_DBG_OPS_RUNTIME, "shared group %d size %d align %d\n",
+                    pos->group_id, size, align);
+    }
+
+    return pos;
+}
+
+MPP_RET MppBufferService::get_table(MppBuffer *buffer, const char *name,
+                                    MppBufferType type, size_t size,
+                                    MppBufferTableInit init, const void *param,
+                                    const char *caller)
+{
+    MppBufferType buffer_type = (MppBufferType)(type & MPP_BUFFER_TYPE_MASK);
+    MppBufferTable *pos, *n;
+    MppBufferTable *table = NULL;
+    void *ptr = NULL;
+    MPP_RET ret = MPP_OK;
+
+    *buffer = NULL;
+
+    list_for_each_entry_safe(pos, n, &mListTable, MppBufferTable, list) {
+        if (pos->type == buffer_type && !strcmp(pos->name, name)) {
+            if (pos->size != size) {
+                mpp_err_f("table %s size %d mismatch with %d from %s\n",
+                          name, pos->size, size, caller);
+                return MPP_ERR_VALUE;
+            }
+
+            pos->ref_count++;
+            *buffer = pos->buffer;
+
+            mpp_buf_dbg(MPP_BUF_DBG_OPS_RUNTIME, "table %s ref %d from %s\n",
+                        name, pos->ref_count, caller);
+            return MPP_OK;
+        }
+    }
+
+    if (NULL == table_grp[buffer_type]) {
+        table_grp[buffer_type] = get_group("table", __FUNCTION__,
+                                           MPP_BUFFER_INTERNAL, buffer_type, 0);
+        if (NULL == table_grp[buffer_type])
+            return MPP_ERR_MALLOC;
+    }
+
+    table = mpp_calloc(MppBufferTable, 1);
+    if (NULL == table) {
+        mpp_err_f("failed to malloc table %s\n", name);
+        return MPP_ERR_MALLOC;
+    }
+
+    ret = mpp_buffer_get_with_tag(table_grp[buffer_type], &table->buffer, size,
+                                  MODULE_TAG, caller);
+    if (ret || NULL == (ptr = mpp_buffer_get_ptr(table->buffer))) {
+        mpp_err_f("failed to get table %s size %d\n", name, size);
+        if (table->buffer)
+            mpp_buffer_put(table->buffer);
+        mpp_free(table);
+        return MPP_ERR_MALLOC;
+    }
+
+    if (init)
+        init(ptr, size, param);
+    else
+        memcpy(ptr, param, size);
+
+    INIT_LIST_HEAD(&table->list);
+    strncpy(table->name, name, sizeof(table->name) - 1);
+    table->type = buffer_type;
+    table->size = size;
+    table->ref_count = 1;
+    list_add_tail(&table->list, &mListTable);
+
+    mpp_buf_dbg(MPP_BUF_DBG_OPS_RUNTIME, "table %s size %d create from %s\n",
+                name, size, caller);
+
+    *buffer = table->buffer;
+    return MPP_OK;
+}
+
+MPP_RET MppBufferService::put_table(MppBuffer buffer)
+{
+    MppBufferTable *pos, *n;
+
+    list_for_each_entry_safe(pos, n, &mListTable, MppBufferTable, list) {
+        if (pos->buffer == buffer) {
+            pos->ref_count--;
+            mpp_buf_dbg(MPP_BUF_DBG_OPS_RUNTIME, "table %s ref %d\n",
+                        pos->name, pos->ref_count);
+
+            if (pos->ref_count <= 0) {
+                list_del_init(&pos->list);
+                mpp_buffer_put(pos->buffer);
+                mpp_free(pos);
+            }
+            return MPP_OK;
+        }
+    }
+
+    mpp_err_f("buffer %p is not a table\n", buffer);
+    return MPP_NOK;
+}
+
 void MppBufferService::set_misc(MppBufferMode mode, MppBufferType type, MppBufferGroupImpl *val)
 {
     type = (MppBufferType)(type & MPP_BUFFER_TYPE_MASK);
@@ -806,6 +1558,9 @@ void MppBufferService::destroy_group(MppBufferGroupImpl *group)
         misc[mode][type] = NULL;
         misc_count--;
     }
+
+    if (group->shared_size)
+        shared_count--;
 }
 
 MppBufferGroupImpl *MppBufferService::get_group_by_id(RK_U32 id)
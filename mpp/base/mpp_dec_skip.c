@@ -0,0 +1,98 @@
+/*
+ * Copyright 2018 Rockchip Electronics Co. LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define MODULE_TAG "mpp_dec_skip"
+
+#include <string.h>
+
+#include "mpp_log.h"
+
+#include "mpp_dec_skip.h"
+
+MPP_RET mpp_dec_skip_cfg_check(MppDecSkipCfg *cfg)
+{
+    if (NULL == cfg) {
+        mpp_err_f("found NULL input\n");
+        return MPP_ERR_NULL_PTR;
+    }
+
+    if ((RK_U32)cfg->mode >= MPP_DEC_SKIP_BUTT ||
+        (cfg->mode == MPP_DEC_SKIP_GOP && !cfg->interval)) {
+        mpp_err_f("invalid skip mode %d interval %d\n", cfg->mode, cfg->interval);
+        return MPP_ERR_VALUE;
+    }
+
+    return MPP_OK;
+}
+
+MPP_RET mpp_dec_skip_set(MppDecSkip *skip, MppDecSkipCfg *cfg)
+{
+    MPP_RET ret;
+
+    if (NULL == skip) {
+        mpp_err_f("found NULL input\n");
+        return MPP_ERR_NULL_PTR;
+    }
+
+    ret = mpp_dec_skip_cfg_check(cfg);
+    if (ret)
+        return ret;
+
+    skip->cfg = *cfg;
+    mpp_dec_skip_reset(skip);
+
+    return MPP_OK;
+}
+
+void mpp_dec_skip_reset(MppDecSkip *skip)
+{
+    if (NULL == skip)
+        return ;
+
+    skip->gop_count = 0;
+    skip->gop_skip = 0;
+}
+
+RK_U32 mpp_dec_skip_check(MppDecSkip *skip, RK_U32 key, RK_U32 ref)
+{
+    RK_U32 drop = 0;
+
+    if (NULL == skip)
+        return 0;
+
+    switch (skip->cfg.mode) {
+    case MPP_DEC_SKIP_NON_REF : {
+        drop = !ref;
+    } break;
+    case MPP_DEC_SKIP_NON_KEY : {
+        drop = !key;
+    } break;
+    case MPP_DEC_SKIP_GOP : {
+        /* frames before the first key frame follow the first gop */
+        if (key) {
+            skip->gop_skip = (skip->gop_count % skip->cfg.interval) ? 1 : 0;
+            skip->gop_count++;
+        }
+        drop = skip->gop_skip;
+    } break;
+    default : {
+    } break;
+    }
+
+    skip->skip_count += drop;
+
+    return drop;
+}
@@ -42,6 +42,9 @@ static MppMetaDef meta_defs[] = {
     /* extra information for tsvc */
     {   KEY_TEMPORAL_ID,       TYPE_S32,      },
     {   KEY_LONG_REF_IDX,      TYPE_S32,      },
+
+    /* encoder frame drop on overload */
+    {   KEY_ENC_FRAME_DROP,    TYPE_S32,      },
 };
 
 class MppMetaService
@@ -241,6 +241,24 @@ RK_U32 mpp_packet_get_eos(MppPacket packet)
     return (p->flag & MPP_PACKET_FLAG_EOS) ? (1) : (0);
 }
 
+RK_U32 mpp_packet_is_partition(const MppPacket packet)
+{
+    if (check_is_mpp_packet(packet))
+        return 0;
+
+    MppPacketImpl *p = (MppPacketImpl *)packet;
+    return (p->flag & MPP_PACKET_FLAG_PARTITION) ? (1) : (0);
+}
+
+RK_U32 mpp_packet_is_eoi(const MppPacket packet)
+{
+    if (check_is_mpp_packet(packet))
+        return 0;
+
+    MppPacketImpl *p = (MppPacketImpl *)packet;
+    return (p->flag & MPP_PACKET_FLAG_EOI) ? (1) : (0);
+}
+
 MPP_RET mpp_packet_set_extra_data(MppPacket packet)
 {
     if (check_is_mpp_packet(packet))
@@ -0,0 +1,334 @@
+/*
+ * Copyright 2018 Rockchip Electronics Co. LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define MODULE_TAG "mpp_buf_slot_test"
+
+#include "mpp_log.h"
+#include "mpp_time.h"
+#include "mpp_thread.h"
+#include "mpp_atomic.h"
+
+#include "mpp_frame.h"
+#include "mpp_buf_slot.h"
+
+#define MAX_SLOT_LOOP   100000
+#define MAX_SLOT_COUNT  18
+#define RESET_LOOP      10000
+
+static MppBufSlots slots = NULL;
+static RK_U32 output_done = 0;
+static RK_U32 output_disorder = 0;
+/* enqueue sequence of each slot, written before enqueue and read after dequeue */
+static RK_U32 slot_seq[MAX_SLOT_COUNT];
+
+/*
+ * simulate parser thread
+ * get slot -> decode -> mark display -> release reference of previous slot
+ */
+void *slot_parser(void *arg)
+{
+    RK_S32 i;
+    RK_S32 index = -1;
+    RK_S32 prev = -1;
+    MPP_RET ret = MPP_OK;
+
+    for (i = 0; i < MAX_SLOT_LOOP; i++) {
+        while (!mpp_slots_get_unused_count(slots))
+            sched_yield();
+
+        ret = mpp_buf_slot_get_unused(slots, &index);
+        mpp_assert(!ret);
+
+        mpp_buf_slot_set_flag(slots, index, SLOT_CODEC_USE);
+        mpp_buf_slot_set_flag(slots, index, SLOT_HAL_OUTPUT);
+        mpp_buf_slot_clr_flag(slots, index, SLOT_HAL_OUTPUT);
+
+        slot_seq[index] = i;
+        mpp_buf_slot_set_flag(slots, index, SLOT_QUEUE_USE);
+        mpp_buf_slot_enqueue(slots, index, QUEUE_DISPLAY);
+
+        if (prev >= 0)
+            mpp_buf_slot_clr_flag(slots, prev, SLOT_CODEC_USE);
+
+        prev = index;
+    }
+
+    if (prev >= 0)
+        mpp_buf_slot_clr_flag(slots, prev, SLOT_CODEC_USE);
+
+    (void)arg;
+    return NULL;
+}
+
+/*
+ * simulate display thread
+ * dequeue display slot -> check fifo order -> output -> release queue usage
+ */
+void *slot_display(void *arg)
+{
+    RK_S32 index = -1;
+    RK_U32 done;
+
+    while ((done = MPP_FETCH_ADD(&output_done, 0)) < MAX_SLOT_LOOP) {
+        if (mpp_buf_slot_dequeue(slots, &index, QUEUE_DISPLAY)) {
+            sched_yield();
+            continue;
+        }
+
+        if (slot_seq[index] != done) {
+            if (!output_disorder)
+                mpp_err("display slot %d seq %d expect %d\n",
+                        index, slot_seq[index], done);
+            MPP_FETCH_ADD(&output_disorder, 1);
+        }
+
+        mpp_buf_slot_clr_flag(slots, index, SLOT_QUEUE_USE);
+        MPP_FETCH_ADD(&output_done, 1);
+    }
+
+    (void)arg;
+    return NULL;
+}
+
+/*
+ * grow slot count by property and check all new slots are usable
+ */
+static RK_S32 slot_count_test(void)
+{
+    MppBufSlots count_slots = NULL;
+    RK_U32 count = 8;
+    RK_S32 index = -1;
+    RK_S32 ret = 0;
+    RK_U32 i;
+
+    mpp_buf_slot_init(&count_slots);
+    mpp_buf_slot_setup(count_slots, 4);
+    mpp_slots_set_prop(count_slots, SLOTS_COUNT, &count);
+
+    if (mpp_slots_get_unused_count(count_slots) != (RK_S32)count) {
+        mpp_err("mpp buf slot count test found unused %d expect %d\n",
+                mpp_slots_get_unused_count(count_slots), count);
+        ret = -1;
+    }
+
+    for (i = 0; i < count && !ret; i++) {
+        if (mpp_buf_slot_get_unused(count_slots, &index) ||
+            index < 0 || index >= (RK_S32)count) {
+            mpp_err("mpp buf slot count test get slot %d failed\n", i);
+            ret = -1;
+            break;
+        }
+        mpp_buf_slot_set_flag(count_slots, index, SLOT_CODEC_USE);
+        mpp_buf_slot_set_flag(count_slots, index, SLOT_HAL_OUTPUT);
+        mpp_buf_slot_clr_flag(count_slots, index, SLOT_HAL_OUTPUT);
+    }
+
+    if (!ret && mpp_slots_get_used_count(count_slots) != (RK_S32)count) {
+        mpp_err("mpp buf slot count test found used %d expect %d\n",
+                mpp_slots_get_used_count(count_slots), count);
+        ret = -1;
+    }
+
+    /* new entries must have valid index and queue state */
+    for (i = 0; i < count && !ret; i++) {
+        mpp_buf_slot_set_flag(count_slots, i, SLOT_QUEUE_USE);
+        mpp_buf_slot_enqueue(count_slots, i, QUEUE_DISPLAY);
+        if (mpp_buf_slot_dequeue(count_slots, &index, QUEUE_DISPLAY) ||
+            index != (RK_S32)i) {
+            mpp_err("mpp buf slot count test dequeue %d got %d\n", i, index);
+            ret = -1;
+        }
+        mpp_buf_slot_clr_flag(count_slots, i, SLOT_QUEUE_USE);
+    }
+
+    for (i = 0; i < count; i++)
+        mpp_buf_slot_clr_flag(count_slots, i, SLOT_CODEC_USE);
+
+    mpp_buf_slot_deinit(count_slots);
+
+    return ret;
+}
+
+/*
+ * reset one displaying slot while the codec reference on it is released by
+ * other thread. The slot must be released only once.
+ */
+static MppBufSlots reset_slots = NULL;
+static RK_S32 reset_index = -1;
+static RK_U32 reset_start = 0;
+static RK_U32 reset_done = 0;
+
+static void *slot_reset_thread(void *arg)
+{
+    RK_U32 i;
+
+    for (i = 0; i < RESET_LOOP; i++) {
+        while (MPP_ATOMIC_READ(&reset_start) <= i)
+            sched_yield();
+
+        mpp_buf_slot_reset(reset_slots, reset_index);
+        MPP_FETCH_ADD(&reset_done, 1);
+    }
+
+    (void)arg;
+    return NULL;
+}
+
+static RK_S32 slot_reset_test(void)
+{
+    pthread_t thread_reset;
+    void *dummy;
+    RK_S32 index = -1;
+    RK_S32 ret = 0;
+    RK_U32 i, j;
+
+    mpp_buf_slot_init(&reset_slots);
+    mpp_buf_slot_setup(reset_slots, 4);
+
+    pthread_create(&thread_reset, NULL, slot_reset_thread, NULL);
+
+    for (i = 0; i < RESET_LOOP; i++) {
+        mpp_buf_slot_get_unused(reset_slots, &index);
+        mpp_buf_slot_set_flag(reset_slots, index, SLOT_CODEC_USE);
+        mpp_buf_slot_set_flag(reset_slots, index, SLOT_HAL_OUTPUT);
+        mpp_buf_slot_clr_flag(reset_slots, index, SLOT_HAL_OUTPUT);
+        mpp_buf_slot_set_flag(reset_slots, index, SLOT_QUEUE_USE);
+        mpp_buf_slot_enqueue(reset_slots, index, QUEUE_DISPLAY);
+
+        reset_index = index;
+        MPP_FETCH_ADD(&reset_start, 1);
+
+        /* spread the release over the reset process */
+        for (j = 0; j < (i % 256) * 4; j++)
+            MPP_SYNC();
+
+        mpp_buf_slot_clr_flag(reset_slots, index, SLOT_CODEC_USE);
+
+        while (MPP_ATOMIC_READ(&reset_done) <= i)
+            sched_yield();
+    }
+
+    pthread_join(thread_reset, &dummy);
+
+    if (mpp_slots_get_used_count(reset_slots) ||
+        mpp_slots_get_unused_count(reset_slots) != 4) {
+        mpp_err("mpp buf slot reset test found used %d unused %d\n",
+                mpp_slots_get_used_count(reset_slots),
+                mpp_slots_get_unused_count(reset_slots));
+        ret = -1;
+    }
+
+    mpp_buf_slot_deinit(reset_slots);
+
+    return ret;
+}
+
+/*
+ * check frame info of downscaled output
+ * 1920x1080 with scale 4 -> 480x270 and stride 480x272
+ */
+static RK_S32 slot_scale_test(void)
+{
+    MppBufSlots scale_slots = NULL;
+    MppFrame frame = NULL;
+    RK_U32 scale = 4;
+    RK_S32 ret = 0;
+
+    mpp_buf_slot_init(&scale_slots);
+    mpp_frame_init(&frame);
+
+    mpp_slots_set_prop(scale_slots, SLOTS_OUTPUT_SCALE, &scale);
+
+    mpp_frame_set_width(frame, 1920);
+    mpp_frame_set_height(frame, 1080);
+    mpp_frame_set_hor_stride(frame, 1920);
+    mpp_frame_set_ver_stride(frame, 1088);
+    mpp_frame_set_fmt(frame, MPP_FMT_YUV420SP);
+    mpp_slots_set_prop(scale_slots, SLOTS_FRAME_INFO, frame);
+
+    if (mpp_frame_get_width(frame) != 480 ||
+        mpp_frame_get_height(frame) != 270 ||
+        mpp_frame_get_hor_stride(frame) != 480 ||
+        mpp_frame_get_ver_stride(frame) != 272) {
+        mpp_err("mpp buf slot scale test found wrong info %dx%d stride %dx%d\n",
+                mpp_frame_get_width(frame), mpp_frame_get_height(frame),
+                mpp_frame_get_hor_stride(frame), mpp_frame_get_ver_stride(frame));
+        ret = -1;
+    }
+
+    mpp_frame_deinit(&frame);
+    mpp_buf_slot_deinit(scale_slots);
+
+    return ret;
+}
+
+int main()
+{
+    RK_S64 time_start, time_end;
+    pthread_t thread_parser;
+    pthread_t thread_display;
+    pthread_attr_t attr;
+    void *dummy;
+    RK_S32 ret = 0;
+
+    mpp_log("mpp buf slot test start\n");
+
+    mpp_buf_slot_init(&slots);
+    mpp_buf_slot_setup(slots, MAX_SLOT_COUNT);
+
+    pthread_attr_init(&attr);
+    pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_JOINABLE);
+
+    time_start = mpp_time();
+    pthread_create(&thread_parser,  &attr, slot_parser,  NULL);
+    pthread_create(&thread_display, &attr, slot_display, NULL);
+
+    pthread_join(thread_parser, &dummy);
+    pthread_join(thread_display, &dummy);
+    time_end = mpp_time();
+    mpp_time_diff(time_start, time_end, 0, "2 thread slot test");
+    pthread_attr_destroy(&attr);
+
+    if (output_disorder) {
+        mpp_err("mpp buf slot test found %d slot out of fifo order\n",
+                output_disorder);
+        ret = -1;
+    }
+
+    if (mpp_slots_get_used_count(slots) ||
+        mpp_slots_get_unused_count(slots) != MAX_SLOT_COUNT ||
+        !mpp_slots_is_empty(slots, QUEUE_DISPLAY)) {
+        mpp_err("mpp buf slot test found slot leak used %d unused %d\n",
+                mpp_slots_get_used_count(slots),
+                mpp_slots_get_unused_count(slots));
+        ret = -1;
+    }
+
+    mpp_buf_slot_deinit(slots);
+
+    if (slot_count_test())
+        ret = -1;
+
+    if (slot_scale_test())
+        ret = -1;
+
+    if (slot_reset_test())
+        ret = -1;
+
+    mpp_log("mpp buf slot test %s\n", ret ? "failed" : "done");
+
+    return ret;
+}
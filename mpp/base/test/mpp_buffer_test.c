@@ -16,28 +16,44 @@
 
 #define MODULE_TAG "mpp_buffer_test"
 
+#include <stdio.h>
 #include <string.h>
 
 #if defined(_WIN32)
 #include "vld.h"
+#else
+#include <unistd.h>
+#include <sys/stat.h>
 #endif
 #include "mpp_log.h"
+#include "mpp_mem.h"
 #include "mpp_env.h"
+#include "mpp_time.h"
 #include "mpp_common.h"
 #include "mpp_buffer.h"
 #include "mpp_allocator.h"
+#include "mpp_buffer_impl.h"
 
 #define MPP_BUFFER_TEST_DEBUG_FLAG      (0xf)
 #define MPP_BUFFER_TEST_SIZE            (SZ_1K*4)
 #define MPP_BUFFER_TEST_COMMIT_COUNT    10
 #define MPP_BUFFER_TEST_NORMAL_COUNT    10
 
+static RK_S32 table_init_count = 0;
+
+static void test_table_init(void *dst, size_t size, const void *param)
+{
+    memset(dst, *(const RK_U8 *)param, size);
+    table_init_count++;
+}
+
 int main()
 {
     MPP_RET ret = MPP_OK;
     MppAllocator allocator = NULL;
     MppAllocatorApi *api = NULL;
     MppBufferInfo commit;
+    MppBufferInfo alloc_info[MPP_BUFFER_TEST_COMMIT_COUNT];
     MppBufferGroup group = NULL;
     MppBuffer commit_buffer[MPP_BUFFER_TEST_COMMIT_COUNT];
     void *commit_ptr[MPP_BUFFER_TEST_COMMIT_COUNT];
@@ -141,6 +157,9 @@ int main()
 
         mpp_log("allocator get ptr %p with fd %d\n", commit.ptr, commit.fd);
 
+        // keep allocator buffer info for free
+        alloc_info[i] = commit;
+
         /*
          * NOTE: commit buffer info will be directly return within new MppBuffer
          *       This mode allow input group is NULL
@@ -184,7 +203,7 @@ int main()
             commit_buffer[i] = NULL;
 
             /* NOTE: buffer info from allocator need to be free directly */
-            ret = api->free(allocator, &commit);
+            ret = api->free(allocator, &alloc_info[i]);
             if (MPP_OK != ret) {
                 mpp_err("mpp_buffer_test api->free failed\n");
                 goto MPP_BUFFER_failed;
@@ -239,6 +258,411 @@ int main()
         group = NULL;
     }
 
+    mpp_log("mpp_buffer_test prealloc start\n");
+
+    ret = mpp_buffer_group_get_internal(&group, MPP_BUFFER_TYPE_ION);
+    if (MPP_OK != ret) {
+        mpp_err("mpp_buffer_test mpp_buffer_group_get failed\n");
+        goto MPP_BUFFER_failed;
+    }
+
+    mpp_buffer_group_limit_config(group, 0, count);
+
+    // preallocated buffers should serve all the following get
+    ret = mpp_buffer_group_prealloc(group, count * SZ_1K, count);
+    if (MPP_OK != ret) {
+        mpp_err("mpp_buffer_test mpp_buffer_group_prealloc failed\n");
+        goto MPP_BUFFER_failed;
+    }
+
+    for (i = 0; i < count; i++) {
+        ret = mpp_buffer_get(group, &normal_buffer[i], (i + 1) * SZ_1K);
+        if (MPP_OK != ret) {
+            mpp_err("mpp_buffer_test mpp_buffer_get mode prealloc failed\n");
+            goto MPP_BUFFER_failed;
+        }
+    }
+
+    {
+        MppBufferGroupStat stat;
+
+        mpp_buffer_group_stat(group, &stat);
+        mpp_log("group alloc count %d reuse %d time sum %lld max %lld us\n",
+                stat.alloc_count, stat.reuse_count,
+                stat.alloc_time_sum, stat.alloc_time_max);
+
+        if (stat.alloc_count != count || stat.reuse_count != count) {
+            mpp_err("mpp_buffer_test prealloc mismatch alloc %d reuse %d\n",
+                    stat.alloc_count, stat.reuse_count);
+            ret = MPP_NOK;
+            goto MPP_BUFFER_failed;
+        }
+    }
+
+    for (i = 0; i < count; i++) {
+        if (normal_buffer[i]) {
+            ret = mpp_buffer_put(normal_buffer[i]);
+            if (MPP_OK != ret) {
+                mpp_err("mpp_buffer_test mpp_buffer_put mode prealloc failed\n");
+                goto MPP_BUFFER_failed;
+            }
+            normal_buffer[i] = NULL;
+        }
+    }
+
+    mpp_log("mpp_buffer_test prealloc success\n");
+
+    if (group) {
+        mpp_buffer_group_put(group);
+        group = NULL;
+    }
+
+    mpp_log("mpp_buffer_test map policy start\n");
+
+    {
+        MppBufferImpl *map_buffer[3];
+        MppBufferGroupImpl *impl = NULL;
+        MppBuffer huge_buffer = NULL;
+        MppBuffer buf = NULL;
+        RK_U8 *ptr = NULL;
+
+        memset(map_buffer, 0, sizeof(map_buffer));
+
+        ret = mpp_buffer_group_get_internal(&group, MPP_BUFFER_TYPE_ION);
+        if (!ret)
+            ret = mpp_buffer_group_map_config(group, MPP_BUFFER_MAP_ON_DEMAND, 2);
+
+        impl = (MppBufferGroupImpl *)group;
+
+        /* map two buffers up to the budget */
+        for (i = 0; i < 3 && !ret; i++)
+            ret = mpp_buffer_get(group, (MppBuffer *)&map_buffer[i], size);
+
+        for (i = 0; i < 2 && !ret; i++) {
+            ptr = (RK_U8 *)mpp_buffer_get_ptr(map_buffer[i]);
+            if (ptr)
+                memset(ptr, 0x10 + i, size);
+            else
+                ret = MPP_NOK;
+        }
+
+        /* mapping the third buffer evicts the unused least recently used one */
+        if (!ret) {
+            mpp_buffer_put(map_buffer[0]);
+            if (NULL == mpp_buffer_get_ptr(map_buffer[2]))
+                ret = MPP_NOK;
+        }
+
+        if (!ret && map_buffer[0]->info.ptr) {
+            mpp_log("mpp_buffer_test allocator can not unmap, skip map check\n");
+        } else if (!ret) {
+            if (map_buffer[0]->mapped || !map_buffer[1]->mapped ||
+                impl->count_mapped != 2) {
+                mpp_err("mpp_buffer_test map evict mismatch mapped %d %d count %d\n",
+                        map_buffer[0]->mapped, map_buffer[1]->mapped,
+                        impl->count_mapped);
+                ret = MPP_NOK;
+            }
+
+            /* reused buffer is mapped again with the same content */
+            mpp_buffer_put(map_buffer[1]);
+            mpp_buffer_put(map_buffer[2]);
+            if (!ret)
+                ret = mpp_buffer_get(group, &buf, size);
+            if (!ret) {
+                ptr = (RK_U8 *)mpp_buffer_get_ptr(buf);
+                if (buf != (MppBuffer)map_buffer[0] || NULL == ptr ||
+                    ptr[0] != 0x10 || ptr[size - 1] != 0x10 ||
+                    map_buffer[0]->map_count != 2 || map_buffer[1]->mapped ||
+                    impl->count_mapped != 2) {
+                    mpp_err("mpp_buffer_test map remap mismatch count %d/%d\n",
+                            map_buffer[0]->map_count, impl->count_mapped);
+                    ret = MPP_NOK;
+                }
+                mpp_buffer_put(buf);
+            }
+            map_buffer[0] = map_buffer[1] = map_buffer[2] = NULL;
+
+            /* mapping made on allocation is counted in the budget too */
+            if (!ret)
+                ret = mpp_buffer_get(group, &huge_buffer, SZ_1M * 2);
+            if (!ret) {
+                MppBufferImpl *huge = (MppBufferImpl *)huge_buffer;
+
+                if (huge->info.ptr && (!huge->mapped || impl->count_mapped > 2)) {
+                    mpp_err("mpp_buffer_test allocated mapping not counted\n");
+                    ret = MPP_NOK;
+                }
+                mpp_buffer_put(huge_buffer);
+            }
+        }
+
+        for (i = 0; i < 3; i++)
+            if (map_buffer[i] && map_buffer[i]->used)
+                mpp_buffer_put(map_buffer[i]);
+
+        if (group) {
+            mpp_buffer_group_put(group);
+            group = NULL;
+        }
+
+        if (ret) {
+            mpp_err("mpp_buffer_test map policy failed\n");
+            goto MPP_BUFFER_failed;
+        }
+    }
+
+    mpp_log("mpp_buffer_test map policy success\n");
+
+    mpp_log("mpp_buffer_test import user memory start\n");
+
+    {
+        MppBuffer user_buffer = NULL;
+        void *user_ptr = mpp_malloc_size(void, size);
+
+        /* user memory committed with zero fd from memset info keeps its ptr */
+        memset(&commit, 0, sizeof(commit));
+        commit.type = MPP_BUFFER_TYPE_NORMAL;
+        commit.size = size;
+        commit.ptr = user_ptr;
+
+        ret = (user_ptr) ? mpp_buffer_import(&user_buffer, &commit) : MPP_NOK;
+        if (!ret && mpp_buffer_get_ptr(user_buffer) != user_ptr) {
+            mpp_err("mpp_buffer_test import user memory ptr %p mismatch %p\n",
+                    mpp_buffer_get_ptr(user_buffer), user_ptr);
+            ret = MPP_NOK;
+        }
+
+        if (user_buffer)
+            mpp_buffer_put(user_buffer);
+        MPP_FREE(user_ptr);
+
+        if (ret) {
+            mpp_err("mpp_buffer_test import user memory failed\n");
+            goto MPP_BUFFER_failed;
+        }
+    }
+
+    mpp_log("mpp_buffer_test import user memory success\n");
+
+#if !defined(_WIN32)
+    mpp_log("mpp_buffer_test import cache start\n");
+
+    {
+        /*
+         * regular file fd is used to simulate dma-buf fd on import. It has
+         * its own inode like dma-buf on kernel 5.3 or later. The shared anon
+         * inode of dma-buf on older kernel is not covered here.
+         */
+        FILE *fp0 = tmpfile();
+        FILE *fp1 = tmpfile();
+        FILE *fp2 = NULL;
+        MppBuffer import_buffer[3];
+        MppBufferGroupImpl *misc = NULL;
+        RK_S32 fd_dup = -1;
+        struct stat st0;
+        struct stat st1;
+
+        memset(import_buffer, 0, sizeof(import_buffer));
+        memset(&commit, 0, sizeof(commit));
+        commit.type = MPP_BUFFER_TYPE_EXT_DMA;
+        commit.size = size;
+
+        /* import cache is disabled by default */
+        misc = mpp_buffer_get_misc_group(MPP_BUFFER_EXTERNAL, MPP_BUFFER_TYPE_EXT_DMA);
+        if (misc && !misc->cache_limit)
+            misc->cache_limit = 16;
+
+        if (NULL == fp0 || NULL == fp1) {
+            mpp_err("mpp_buffer_test create temp file failed\n");
+            ret = MPP_NOK;
+        }
+
+        if (!ret) {
+            commit.fd = fileno(fp0);
+            ret = mpp_buffer_import(&import_buffer[0], &commit);
+        }
+        if (!ret)
+            ret = mpp_buffer_put(import_buffer[0]);
+
+        /*
+         * close the first fd and import the same file with another fd should
+         * hit cache with the buffer fd still valid after the fd number is
+         * reused by other file
+         */
+        fd_dup = (ret) ? (-1) : dup(commit.fd);
+        if (fp0) {
+            fclose(fp0);
+            fp0 = NULL;
+        }
+        fp2 = tmpfile();
+        if (!ret) {
+            commit.fd = fd_dup;
+            ret = mpp_buffer_import(&import_buffer[1], &commit);
+        }
+        if (!ret && (import_buffer[1] != import_buffer[0] ||
+                     fstat(mpp_buffer_get_fd(import_buffer[1]), &st0) ||
+                     fstat(fd_dup, &st1) ||
+                     st0.st_dev != st1.st_dev || st0.st_ino != st1.st_ino)) {
+            mpp_err("mpp_buffer_test import cache hit %p %p with invalid fd\n",
+                    import_buffer[0], import_buffer[1]);
+            ret = MPP_NOK;
+        }
+        if (!ret) {
+            commit.fd = fileno(fp1);
+            ret = mpp_buffer_import(&import_buffer[2], &commit);
+        }
+
+        if (!ret && import_buffer[2] == import_buffer[0]) {
+            mpp_err("mpp_buffer_test import cache mismatch %p %p %p\n",
+                    import_buffer[0], import_buffer[1], import_buffer[2]);
+            ret = MPP_NOK;
+        }
+
+        if (import_buffer[1])
+            mpp_buffer_put(import_buffer[1]);
+        if (import_buffer[2])
+            mpp_buffer_put(import_buffer[2]);
+
+        /* cached buffer unused for too long is dropped on next import */
+        if (!ret && misc && misc->cache_limit) {
+            RK_S32 cache_timeout = misc->cache_timeout;
+            RK_U32 cache_hit = misc->cache_hit;
+
+            misc->cache_timeout = 10;
+            msleep(20);
+
+            import_buffer[1] = NULL;
+            commit.fd = fd_dup;
+            ret = mpp_buffer_import(&import_buffer[1], &commit);
+            if (!ret && (misc->cache_hit != cache_hit || misc->count_unused)) {
+                mpp_err("mpp_buffer_test import cache not evicted unused %d\n",
+                        misc->count_unused);
+                ret = MPP_NOK;
+            }
+            if (import_buffer[1])
+                mpp_buffer_put(import_buffer[1]);
+
+            misc->cache_timeout = cache_timeout;
+        }
+
+        if (fd_dup >= 0)
+            close(fd_dup);
+        if (fp1)
+            fclose(fp1);
+        if (fp2)
+            fclose(fp2);
+
+        if (ret) {
+            mpp_err("mpp_buffer_test import cache failed\n");
+            goto MPP_BUFFER_failed;
+        }
+    }
+
+    mpp_log("mpp_buffer_test import cache success\n");
+#endif
+
+    mpp_log("mpp_buffer_test shared pool start\n");
+
+    {
+        MppBuffer shared_buffer[3];
+
+        memset(shared_buffer, 0, sizeof(shared_buffer));
+
+        /* size aligned to the same value should reuse the same buffer */
+        ret = mpp_buffer_get_shared(&shared_buffer[0], size - 100, 0);
+        if (!ret)
+            ret = mpp_buffer_put(shared_buffer[0]);
+        if (!ret)
+            ret = mpp_buffer_get_shared(&shared_buffer[1], size, 0);
+        if (!ret)
+            ret = mpp_buffer_get_shared(&shared_buffer[2], size * 2, 0);
+
+        if (!ret && (shared_buffer[1] != shared_buffer[0] ||
+                     shared_buffer[2] == shared_buffer[1] ||
+                     mpp_buffer_get_size(shared_buffer[2]) != size * 2)) {
+            mpp_err("mpp_buffer_test shared pool mismatch %p %p %p\n",
+                    shared_buffer[0], shared_buffer[1], shared_buffer[2]);
+            ret = MPP_NOK;
+        }
+
+        if (!ret && MPP_OK == mpp_buffer_get_shared(&shared_buffer[0], size, 3)) {
+            mpp_err("mpp_buffer_test shared pool accept invalid align\n");
+            ret = MPP_NOK;
+        }
+
+        if (shared_buffer[1])
+            mpp_buffer_put(shared_buffer[1]);
+        if (shared_buffer[2])
+            mpp_buffer_put(shared_buffer[2]);
+
+        if (ret) {
+            mpp_err("mpp_buffer_test shared pool failed\n");
+            goto MPP_BUFFER_failed;
+        }
+    }
+
+    mpp_log("mpp_buffer_test shared pool success\n");
+
+    mpp_log("mpp_buffer_test table cache start\n");
+
+    {
+        static const RK_U8 table_val = 0x5a;
+        MppBuffer table_buffer[3];
+        RK_U8 *ptr = NULL;
+
+        memset(table_buffer, 0, sizeof(table_buffer));
+
+        /* the same table is filled once and shared by reference */
+        ret = mpp_buffer_table_get(&table_buffer[0], "test_table", MPP_BUFFER_TYPE_ION,
+                                   size, test_table_init, &table_val);
+        if (!ret)
+            ret = mpp_buffer_table_get(&table_buffer[1], "test_table", MPP_BUFFER_TYPE_ION,
+                                       size, test_table_init, &table_val);
+        if (!ret)
+            ptr = (RK_U8 *)mpp_buffer_get_ptr(table_buffer[1]);
+
+        if (!ret && (table_buffer[0] != table_buffer[1] || table_init_count != 1 ||
+                     NULL == ptr || ptr[0] != table_val || ptr[size - 1] != table_val)) {
+            mpp_err("mpp_buffer_test table cache mismatch %p %p init %d\n",
+                    table_buffer[0], table_buffer[1], table_init_count);
+            ret = MPP_NOK;
+        }
+
+        /* size mismatch on the same key is rejected */
+        if (!ret && MPP_OK == mpp_buffer_table_get(&table_buffer[2], "test_table",
+                                                   MPP_BUFFER_TYPE_ION, size * 2,
+                                                   test_table_init, &table_val)) {
+            mpp_err("mpp_buffer_test table cache accept size mismatch\n");
+            table_buffer[2] = NULL;
+            ret = MPP_NOK;
+        }
+
+        if (table_buffer[1])
+            mpp_buffer_table_put(table_buffer[1]);
+        if (table_buffer[0])
+            mpp_buffer_table_put(table_buffer[0]);
+
+        /* table is released on last put and filled again on next get */
+        if (!ret)
+            ret = mpp_buffer_table_get(&table_buffer[2], "test_table", MPP_BUFFER_TYPE_ION,
+                                       size, test_table_init, &table_val);
+        if (!ret && table_init_count != 2) {
+            mpp_err("mpp_buffer_test table cache not released init %d\n",
+                    table_init_count);
+            ret = MPP_NOK;
+        }
+        if (table_buffer[2])
+            mpp_buffer_table_put(table_buffer[2]);
+
+        if (ret) {
+            mpp_err("mpp_buffer_test table cache failed\n");
+            goto MPP_BUFFER_failed;
+        }
+    }
+
+    mpp_log("mpp_buffer_test table cache success\n");
+
     mpp_log("mpp_buffer_test success\n");
 
     ret = mpp_buffer_get(NULL, &legacy_buffer, MPP_BUFFER_TEST_SIZE);
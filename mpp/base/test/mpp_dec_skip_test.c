@@ -0,0 +1,106 @@
+/*
+ * Copyright 2018 Rockchip Electronics Co. LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define MODULE_TAG "mpp_dec_skip_test"
+
+#include <string.h>
+
+#include "mpp_log.h"
+#include "mpp_dec_skip.h"
+
+#define SKIP_TEST_GOP_NUM   4
+
+/* I P B B P B B P gop, B frame is not used for reference */
+static const char gop_pattern[] = "IPBBPBBP";
+
+static RK_U32 skip_test_run(MppDecSkipMode mode, RK_U32 interval)
+{
+    MppDecSkip skip;
+    MppDecSkipCfg cfg;
+    RK_U32 decoded = 0;
+    RK_U32 i, j;
+
+    memset(&skip, 0, sizeof(skip));
+    cfg.mode = mode;
+    cfg.interval = interval;
+
+    if (mpp_dec_skip_set(&skip, &cfg))
+        return 0;
+
+    for (i = 0; i < SKIP_TEST_GOP_NUM; i++) {
+        for (j = 0; j < strlen(gop_pattern); j++) {
+            RK_U32 key = gop_pattern[j] == 'I';
+            RK_U32 ref = gop_pattern[j] != 'B';
+
+            if (!mpp_dec_skip_check(&skip, key, ref))
+                decoded++;
+        }
+    }
+
+    if (decoded + skip.skip_count != SKIP_TEST_GOP_NUM * strlen(gop_pattern))
+        return 0;
+
+    return decoded;
+}
+
+int main()
+{
+    MPP_RET ret = MPP_NOK;
+    MppDecSkipCfg cfg;
+
+    mpp_log("mpp_dec_skip_test start\n");
+
+    if (skip_test_run(MPP_DEC_SKIP_NONE, 0) != 32) {
+        mpp_err("skip none failed\n");
+        goto DONE;
+    }
+
+    if (skip_test_run(MPP_DEC_SKIP_NON_REF, 0) != 16) {
+        mpp_err("skip non-reference failed\n");
+        goto DONE;
+    }
+
+    if (skip_test_run(MPP_DEC_SKIP_NON_KEY, 0) != 4) {
+        mpp_err("skip non-key failed\n");
+        goto DONE;
+    }
+
+    /* gop 0 and 2 for interval 2, gop 0 and 3 for interval 3 */
+    if (skip_test_run(MPP_DEC_SKIP_GOP, 2) != 16 ||
+        skip_test_run(MPP_DEC_SKIP_GOP, 3) != 16 ||
+        skip_test_run(MPP_DEC_SKIP_GOP, 5) != 8) {
+        mpp_err("skip gop failed\n");
+        goto DONE;
+    }
+
+    cfg.mode = MPP_DEC_SKIP_GOP;
+    cfg.interval = 0;
+    if (MPP_OK == mpp_dec_skip_cfg_check(&cfg)) {
+        mpp_err("zero gop interval is not rejected\n");
+        goto DONE;
+    }
+
+    cfg.mode = MPP_DEC_SKIP_BUTT;
+    if (MPP_OK == mpp_dec_skip_cfg_check(&cfg)) {
+        mpp_err("invalid mode is not rejected\n");
+        goto DONE;
+    }
+
+    ret = MPP_OK;
+DONE:
+    mpp_log("mpp_dec_skip_test %s\n", ret ? "failed" : "success");
+    return ret;
+}
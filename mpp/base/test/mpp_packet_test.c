@@ -19,7 +19,7 @@
 #include <stdlib.h>
 
 #include "mpp_log.h"
-#include "mpp_packet.h"
+#include "mpp_packet_impl.h"
 
 #define MPP_PACKET_TEST_SIZE    1024
 
@@ -48,6 +48,23 @@ int main()
         mpp_err("mpp_packet_test mpp_packet_set_eos failed\n");
         goto MPP_PACKET_failed;
     }
+
+    /* normal packet is a whole frame */
+    if (mpp_packet_is_partition(packet) || mpp_packet_is_eoi(packet)) {
+        mpp_err("mpp_packet_test default partition flag failed\n");
+        ret = MPP_NOK;
+        goto MPP_PACKET_failed;
+    }
+
+    /* last slice of one frame on slice output */
+    mpp_packet_set_flag(packet, mpp_packet_get_flag(packet) |
+                        MPP_PACKET_FLAG_PARTITION | MPP_PACKET_FLAG_EOI);
+    if (!mpp_packet_is_partition(packet) || !mpp_packet_is_eoi(packet) ||
+        !mpp_packet_get_eos(packet)) {
+        mpp_err("mpp_packet_test partition flag failed\n");
+        ret = MPP_NOK;
+        goto MPP_PACKET_failed;
+    }
     mpp_packet_deinit(&packet);
 
     free(data);
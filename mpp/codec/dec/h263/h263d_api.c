@@ -321,5 +321,6 @@ const ParserApi api_h263d_parser = {
     .flush = h263d_flush,
     .control = h263d_control,
     .callback = h263d_callback,
+    .probe = mpp_h263_parser_probe,
 };
 
@@ -572,5 +572,38 @@ MPP_RET mpp_h263_parser_update_dpb(H263dParser ctx)
     return MPP_OK;
 }
 
+MPP_RET mpp_h263_parser_probe(RK_U8 *data, RK_S32 size, MppDecStreamInfo *info)
+{
+    H263dParserImpl p;
+    BitReadCtx_t gb;
+    RK_S32 i;
+
+    for (i = 0; i + 3 < size; i++) {
+        MPP_RET ret;
+
+        /* picture start code is byte aligned 17 zero and 1 one */
+        if (data[i] || data[i + 1] || (data[i + 2] & 0xfc) != 0x80)
+            continue;
+
+        memset(&p, 0, sizeof(p));
+        mpp_set_bitread_ctx(&gb, data + i, size - i);
+        ret = h263_parse_picture_header(&p, &gb);
+        if (ret == MPP_ERR_STREAM)
+            return ret;
+        if (ret)
+            continue;
+
+        info->width     = p.hdr_curr.width;
+        info->height    = p.hdr_curr.height;
+        info->bit_depth = 8;
+        info->fmt       = MPP_FMT_YUV420SP;
+        /* picture clock frequency is fixed to 30000 / 1001 */
+        info->fps_num   = 30000;
+        info->fps_den   = 1001;
+
+        h263d_dbg_status("probe w %d h %d\n", info->width, info->height);
+        return MPP_OK;
+    }
 
-
+    return MPP_NOK;
+}
@@ -21,6 +21,7 @@
 #include "mpp_packet.h"
 #include "mpp_buf_slot.h"
 #include "hal_task.h"
+#include "rk_mpi.h"
 
 #define H263D_DBG_FUNCTION          (0x00000001)
 #define H263D_DBG_STARTCODE         (0x00000002)
@@ -45,6 +46,8 @@ MPP_RET mpp_h263_parser_setup_syntax(H263dParser ctx, MppSyntax *syntax);
 MPP_RET mpp_h263_parser_setup_hal_output(H263dParser ctx, RK_S32 *output);
 MPP_RET mpp_h263_parser_setup_refer(H263dParser ctx, RK_S32 *refer, RK_S32 max_ref);
 MPP_RET mpp_h263_parser_update_dpb(H263dParser ctx);
+/* stateless intra picture header parsing */
+MPP_RET mpp_h263_parser_probe(RK_U8 *data, RK_S32 size, MppDecStreamInfo *info);
 
 #ifdef __cplusplus
 }
@@ -428,6 +428,8 @@ MPP_RET h264d_reset(void *decoder)
     p_Dec->dxva_ctx->strm_offset = 0;
     p_Dec->dxva_ctx->slice_count = 0;
     p_Dec->last_frame_slot_idx   = -1;
+    p_Dec->skip_frame = 0;
+    mpp_dec_skip_reset(&p_Dec->skip);
 
 __RETURN:
     return ret = MPP_OK;
@@ -480,6 +482,9 @@ MPP_RET  h264d_control(void *decoder, MpiCmd cmd_type, void *param)
     case MPP_DEC_SET_IMMEDIATE_OUT: {
         dec->immediate_out = *((RK_U32 *)param);
     } break;
+    case MPP_DEC_SET_SKIP_MODE: {
+        mpp_dec_skip_set(&dec->skip, (MppDecSkipCfg *)param);
+    } break;
     default : {
     } break;
     }
@@ -602,6 +607,15 @@ MPP_RET h264d_parse(void *decoder, HalDecTask *in_task)
         in_task->flags.parse_err = 1;
     }
 
+    //!< skipped frame returns task without valid flag
+    if (p_Dec->skip_frame) {
+        p_Dec->skip_frame = 0;
+        if (in_task->flags.eos) {
+            h264d_flush_dpb_eos(p_Dec);
+        }
+        return ret;
+    }
+
     if (p_Dec->is_parser_end) {
         p_Dec->is_parser_end = 0;
         p_Dec->p_Vid->g_framecnt++;
@@ -671,6 +685,95 @@ MPP_RET h264d_callback(void *decoder, void *errinfo)
 __RETURN:
     return ret = MPP_OK;
 }
+/*!
+***********************************************************************
+* \brief
+*   probe stream information from sps
+***********************************************************************
+*/
+static MPP_RET h264d_probe_sps(RK_U8 *buf, RK_S32 len, MppDecStreamInfo *info)
+{
+    BitReadCtx_t bitctx;
+    H264_SPS_t sps;
+    RK_S32 crop_x = 1;
+    RK_S32 crop_y = 1;
+
+    /* skip one byte nal header */
+    mpp_set_bitread_ctx(&bitctx, buf + 1, len - 1);
+    mpp_set_pre_detection(&bitctx);
+    if (probe_sps(&bitctx, &sps))
+        return MPP_ERR_STREAM;
+
+    if (sps.chroma_format_idc == H264_CHROMA_420 ||
+        sps.chroma_format_idc == H264_CHROMA_422)
+        crop_x = 2;
+    if (sps.chroma_format_idc == H264_CHROMA_420)
+        crop_y = 2;
+    crop_y *= 2 - sps.frame_mbs_only_flag;
+
+    info->width = (sps.pic_width_in_mbs_minus1 + 1) * 16 -
+                  crop_x * (sps.frame_crop_left_offset + sps.frame_crop_right_offset);
+    info->height = (2 - sps.frame_mbs_only_flag) * (sps.pic_height_in_map_units_minus1 + 1) * 16 -
+                   crop_y * (sps.frame_crop_top_offset + sps.frame_crop_bottom_offset);
+    info->profile = sps.profile_idc;
+    info->level = sps.level_idc;
+    info->bit_depth = sps.bit_depth_luma_minus8 + 8;
+    info->interlaced = !sps.frame_mbs_only_flag;
+
+    if (sps.chroma_format_idc == H264_CHROMA_400)
+        info->fmt = MPP_FMT_YUV400;
+    else if (sps.chroma_format_idc == H264_CHROMA_422)
+        info->fmt = (info->bit_depth > 8) ? MPP_FMT_YUV422SP_10BIT : MPP_FMT_YUV422SP;
+    else
+        info->fmt = (info->bit_depth > 8) ? MPP_FMT_YUV420SP_10BIT : MPP_FMT_YUV420SP;
+
+    /* one tick is one field */
+    if (sps.vui_parameters_present_flag &&
+        sps.vui_seq_parameters.timing_info_present_flag &&
+        sps.vui_seq_parameters.num_units_in_tick) {
+        info->fps_num = sps.vui_seq_parameters.time_scale;
+        info->fps_den = sps.vui_seq_parameters.num_units_in_tick * 2;
+    }
+
+    return MPP_OK;
+}
+
+static MPP_RET h264d_probe(RK_U8 *data, RK_S32 size, MppDecStreamInfo *info)
+{
+    RK_S32 i;
+
+    /* avcC extradata carries the first sps at byte 8 with 16bit length */
+    if (size > 8 && data[0] == 1) {
+        RK_S32 len = (data[6] << 8) | data[7];
+
+        if (!(data[5] & 0x1f) || len < 2 || len + 8 > size)
+            return MPP_ERR_STREAM;
+
+        return h264d_probe_sps(data + 8, len, info);
+    }
+
+    for (i = 0; i + 3 < size; i++) {
+        RK_S32 start = i + 3;
+        RK_S32 end;
+
+        if (data[i] || data[i + 1] || data[i + 2] != 1 ||
+            (data[start] & 0x1f) != H264_NALU_TYPE_SPS)
+            continue;
+
+        /* nal ends at next 0x000000 or 0x000001 */
+        for (end = start; end + 2 < size; end++) {
+            if (!data[end] && !data[end + 1] && data[end + 2] <= 1)
+                break;
+        }
+        if (end + 2 >= size)
+            end = size;
+
+        return h264d_probe_sps(data + start, end - start, info);
+    }
+
+    return MPP_NOK;
+}
+
 /*!
 ***********************************************************************
 * \brief
@@ -691,5 +794,6 @@ const ParserApi api_h264d_parser = {
     .flush = h264d_flush,
     .control = h264d_control,
     .callback = h264d_callback,
+    .probe = h264d_probe,
 };
 
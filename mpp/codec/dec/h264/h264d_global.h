@@ -23,6 +23,7 @@
 
 #include "mpp_log.h"
 #include "mpp_bitread.h"
+#include "mpp_dec_skip.h"
 
 #include "h264d_syntax.h"
 #include "h264d_api.h"
@@ -1134,6 +1135,9 @@ typedef struct h264_dec_ctx_t {
     RK_S32                     last_frame_slot_idx;
     RK_U32                     disable_error;
     RK_U32                     immediate_out;
+    //!< frame skip mode, current frame is dropped when skip_frame is set
+    MppDecSkip                 skip;
+    RK_U32                     skip_frame;
     struct h264_err_ctx_t      errctx;
 } H264_DecCtx_t;
 
@@ -2012,6 +2012,29 @@ __FAILED:
     return ret;
 }
 
+/*!
+***********************************************************************
+* \brief
+*    skip picture without dpb storage, only keep poc and frame_num
+*    status for the following pictures
+***********************************************************************
+*/
+//extern "C"
+MPP_RET skip_picture(H264_SLICE_t *currSlice)
+{
+    MPP_RET ret = MPP_ERR_UNKNOW;
+    H264dVideoCtx_t *p_Vid = currSlice->p_Vid;
+
+    FUN_CHECK(ret = decode_poc(p_Vid, currSlice));
+    H264D_DBG(H264D_DBG_PARSE_NALU, "[SKIP] type=%d, ref=%d, frame_num=%d, poc=%d",
+              currSlice->slice_type, currSlice->nal_reference_idc,
+              currSlice->frame_num, currSlice->ThisPOC);
+
+    return ret = MPP_OK;
+__FAILED:
+    return ret;
+}
+
 /*!
 ***********************************************************************
 * \brief
@@ -30,6 +30,7 @@ extern "C" {
 
 MPP_RET update_dpb    (H264_DecCtx_t  *p_Dec);
 MPP_RET init_picture  (H264_SLICE_t   *currSlice);
+MPP_RET skip_picture  (H264_SLICE_t   *currSlice);
 MPP_RET reset_dpb_mark(H264_DpbMark_t *p_mark);
 void flush_dpb_buf_slot(H264_DecCtx_t *p_Dec);
 
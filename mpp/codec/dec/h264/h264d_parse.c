@@ -912,7 +912,20 @@ MPP_RET parse_loop(H264_DecCtx_t *p_Dec)
             break;
         case SliceSTATE_InitPicture:
             if (!p_Dec->p_Vid->iNumOfSlicesDecoded) {
-                FUN_CHECK(ret = init_picture(&p_Dec->p_Cur->slice));
+                H264_SLICE_t *slice = &p_Dec->p_Cur->slice;
+                RK_U32 key = slice->idr_flag || (H264_I_SLICE == slice->slice_type);
+
+                //!< drop skipped picture before any dpb or slot is used
+                if (mpp_dec_skip_check(&p_Dec->skip, key, slice->nal_reference_idc)) {
+                    FUN_CHECK(ret = skip_picture(slice));
+                    p_Dec->skip_frame = 1;
+                    p_Dec->dxva_ctx->slice_count = 0;
+                    p_Dec->dxva_ctx->strm_offset = 0;
+                    p_Dec->next_state = SliceSTATE_ReadNalu;
+                    while_loop_flag = 0;
+                    break;
+                }
+                FUN_CHECK(ret = init_picture(slice));
                 p_Dec->is_parser_end = 1;
             }
             p_Dec->next_state = SliceSTATE_GetSliceData;
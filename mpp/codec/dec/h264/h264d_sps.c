@@ -211,7 +211,8 @@ static MPP_RET parser_sps(BitReadCtx_t *p_bitctx, H264_SPS_t *cur_sps, H264_DecC
         READ_UE(p_bitctx, &cur_sps->chroma_format_idc);
         if (cur_sps->chroma_format_idc > 2) {
             H264D_ERR("ERROR: Not support chroma_format_idc=%d.", cur_sps->chroma_format_idc);
-            p_Dec->errctx.un_spt_flag = MPP_FRAME_ERR_UNSUPPORT;
+            if (p_Dec)
+                p_Dec->errctx.un_spt_flag = MPP_FRAME_ERR_UNSUPPORT;
             goto __FAILED;
         }
         READ_UE(p_bitctx, &cur_sps->bit_depth_luma_minus8);
@@ -432,6 +433,20 @@ static void update_last_video_pars(H264dVideoCtx_t *p_Vid, H264_SPS_t *sps, RK_U
     p_Vid->last_level_idc[layer_id] = sps->level_idc;
 }
 
+/*!
+***********************************************************************
+* \brief
+*    parse sps only without decoder context for stream probing
+***********************************************************************
+*/
+//extern "C"
+MPP_RET probe_sps(BitReadCtx_t *p_bitctx, H264_SPS_t *sps)
+{
+    memset(sps, 0, sizeof(*sps));
+
+    return parser_sps(p_bitctx, sps, NULL);
+}
+
 /*!
 ***********************************************************************
 * \brief
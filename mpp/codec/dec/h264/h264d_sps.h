@@ -27,6 +27,7 @@
 extern "C" {
 #endif
 
+MPP_RET probe_sps     (BitReadCtx_t  *p_bitctx, H264_SPS_t *sps);
 MPP_RET process_sps   (H264_SLICE_t  *currSlice);
 void    recycle_subsps(H264_subSPS_t *subset_sps);
 MPP_RET process_subsps(H264_SLICE_t  *currSlice);
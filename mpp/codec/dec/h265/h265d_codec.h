@@ -29,6 +29,7 @@
 #define __MPP_CODEC_H__
 
 #include "mpp_frame.h"
+#include "mpp_dec_skip.h"
 
 typedef struct MppRational {
     RK_S32 num; ///< numerator
@@ -139,6 +140,7 @@ typedef struct H265dContext {
 
     RK_U32 need_split;
     RK_U32 disable_error;
+    MppDecSkip skip;
 } H265dContext_t;
 #ifdef  __cplusplus
 extern "C" {
@@ -1340,6 +1340,23 @@ static RK_S32 parser_nal_unit(HEVCContext *s, const RK_U8 *nal, int length)
                 s->max_ra = INT_MIN;
         }
 
+        if (s->sh.first_slice_in_pic_flag) {
+            /* sub-layer non-reference picture on the highest sub-layer */
+            RK_U32 ref = !(s->nal_unit_type < NAL_BLA_W_LP &&
+                           !(s->nal_unit_type & 1) &&
+                           s->temporal_id == s->sps->max_sub_layers - 1);
+
+            s->skip_frame = mpp_dec_skip_check(&s->h265dctx->skip, IS_IRAP(s), ref);
+            /* leading pictures of next cra may refer to the skipped one */
+            if (s->skip_frame && ref && !IS_IDR(s))
+                s->max_ra = INT_MAX;
+        }
+
+        if (s->skip_frame) {
+            s->is_decoded = 0;
+            break;
+        }
+
         if (s->sh.first_slice_in_pic_flag) {
             ret = hevc_frame_start(s);
             if (ret < 0) {
@@ -1781,6 +1798,7 @@ MPP_RET h265d_parse(void *ctx, HalDecTask *task)
     s->got_frame = 0;
     s->task = task;
     s->ref = NULL;
+    s->skip_frame = 0;
     ret    = parser_nal_units(s);
     if (ret < 0) {
         if (ret ==  MPP_ERR_STREAM) {
@@ -1986,6 +2004,7 @@ MPP_RET h265d_reset(void *ctx)
     h265d_split_reset(h265dctx->split_cxt);
     s->max_ra = INT_MAX;
     s->eos = 0;
+    mpp_dec_skip_reset(&h265dctx->skip);
     return MPP_OK;
 }
 
@@ -1996,7 +2015,10 @@ MPP_RET h265d_control(void *ctx, MpiCmd cmd, void *param)
     switch (cmd) {
     case MPP_DEC_SET_DISABLE_ERROR: {
         h265dctx->disable_error = *((RK_U32 *)param);
-    }
+    } break;
+    case MPP_DEC_SET_SKIP_MODE: {
+        mpp_dec_skip_set(&h265dctx->skip, (MppDecSkipCfg *)param);
+    } break;
     default : {
     } break;
     }
@@ -2032,7 +2054,82 @@ MPP_RET h265d_callback(void *ctx, void *err_info)
     return MPP_OK;
 }
 
+static MPP_RET h265d_probe_sps(RK_U8 *buf, RK_S32 len, MppDecStreamInfo *info)
+{
+    BitReadCtx_t gb;
+
+    /* skip two bytes nal header */
+    if (len <= 2)
+        return MPP_ERR_STREAM;
+
+    mpp_set_bitread_ctx(&gb, buf + 2, len - 2);
+    mpp_set_pre_detection(&gb);
+
+    return mpp_hevc_probe_sps(&gb, info) ? MPP_ERR_STREAM : MPP_OK;
+}
+
+static MPP_RET h265d_probe(RK_U8 *data, RK_S32 size, MppDecStreamInfo *info)
+{
+    RK_S32 i, j;
+
+    /* hvcC extradata, same check as hevc_parser_extradata */
+    if (size > 23 && (data[0] || data[1] || data[2] > 1)) {
+        RK_S32 num_arrays = data[22];
+        RK_S32 pos = 23;
+
+        for (i = 0; i < num_arrays; i++) {
+            RK_S32 type;
+            RK_S32 num_nals;
+
+            if (pos + 3 > size)
+                return MPP_ERR_STREAM;
 
+            type = data[pos] & 0x3f;
+            num_nals = U16_AT(data + pos + 1);
+            pos += 3;
+
+            for (j = 0; j < num_nals; j++) {
+                RK_S32 len;
+
+                if (pos + 2 > size)
+                    return MPP_ERR_STREAM;
+
+                len = U16_AT(data + pos);
+                pos += 2;
+                if (pos + len > size)
+                    return MPP_ERR_STREAM;
+
+                if (type == NAL_SPS)
+                    return h265d_probe_sps(data + pos, len, info);
+
+                pos += len;
+            }
+        }
+
+        return MPP_NOK;
+    }
+
+    for (i = 0; i + 3 < size; i++) {
+        RK_S32 start = i + 3;
+        RK_S32 end;
+
+        if (data[i] || data[i + 1] || data[i + 2] != 1 ||
+            ((data[start] >> 1) & 0x3f) != NAL_SPS)
+            continue;
+
+        /* nal ends at next 0x000000 or 0x000001 */
+        for (end = start; end + 2 < size; end++) {
+            if (!data[end] && !data[end + 1] && data[end + 2] <= 1)
+                break;
+        }
+        if (end + 2 >= size)
+            end = size;
+
+        return h265d_probe_sps(data + start, end - start, info);
+    }
+
+    return MPP_NOK;
+}
 
 const ParserApi api_h265d_parser = {
     .name = "h265d_parse",
@@ -2047,6 +2144,7 @@ const ParserApi api_h265d_parser = {
     .flush = h265d_flush,
     .control = h265d_control,
     .callback = h265d_callback,
+    .probe = h265d_probe,
 };
 
 
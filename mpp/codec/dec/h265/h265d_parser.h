@@ -36,6 +36,7 @@
 #include "mpp_bitread.h"
 #include "mpp_buf_slot.h"
 
+#include "rk_mpi.h"
 #include "hal_task.h"
 #include "h265d_codec.h"
 #include "h265_syntax.h"
@@ -528,6 +529,8 @@ typedef struct HEVCContext {
     RK_S32 nals_allocated;
     // type of the first VCL NAL of the current frame
     enum NALUnitType first_nal_type;
+    // current frame is dropped by skip mode
+    RK_U8 skip_frame;
 
     RK_U8 context_initialized;
     RK_U8 is_nalff;       ///< this flag is != 0 if bitstream is encapsulated
@@ -600,6 +603,8 @@ RK_S32 mpp_hevc_decode_short_term_rps(HEVCContext *s, ShortTermRPS *rps,
                                       const HEVCSPS *sps, RK_S32 is_slice_header);
 RK_S32 mpp_hevc_decode_nal_vps(HEVCContext *s);
 RK_S32 mpp_hevc_decode_nal_sps(HEVCContext *s);
+/* parse sps without decoder context for stream probing */
+RK_S32 mpp_hevc_probe_sps(BitReadCtx_t *gb, MppDecStreamInfo *info);
 RK_S32 mpp_hevc_decode_nal_pps(HEVCContext *s);
 RK_S32 mpp_hevc_decode_nal_sei(HEVCContext *s);
 
@@ -125,10 +125,9 @@ const RK_U8 mpp_hevc_diag_scan8x8_y[64] = {
     5, 7, 6, 7,
 };
 
-int mpp_hevc_decode_short_term_rps(HEVCContext *s, ShortTermRPS *rps,
-                                   const HEVCSPS *sps, RK_S32 is_slice_header)
+static RK_S32 decode_short_term_rps(BitReadCtx_t *gb, ShortTermRPS *rps,
+                                    const HEVCSPS *sps, RK_S32 is_slice_header)
 {
-    HEVCLocalContext *lc = s->HEVClc;
     RK_U8 rps_predict = 0;
     RK_S32 delta_poc;
     RK_S32 k0 = 0;
@@ -136,8 +135,6 @@ int mpp_hevc_decode_short_term_rps(HEVCContext *s, ShortTermRPS *rps,
     RK_S32 k  = 0;
     RK_S32 i;
 
-    BitReadCtx_t *gb = &lc->gb;
-
     if (rps != sps->st_rps && sps->nb_st_rps)
         READ_ONEBIT(gb, &rps_predict);
 
@@ -263,11 +260,15 @@ __BITREAD_ERR:
 }
 
 
-static RK_S32 decode_profile_tier_level(HEVCContext *s, PTLCommon *ptl)
+int mpp_hevc_decode_short_term_rps(HEVCContext *s, ShortTermRPS *rps,
+                                   const HEVCSPS *sps, RK_S32 is_slice_header)
+{
+    return decode_short_term_rps(&s->HEVClc->gb, rps, sps, is_slice_header);
+}
+
+static RK_S32 decode_profile_tier_level(BitReadCtx_t *gb, PTLCommon *ptl)
 {
     int i;
-    HEVCLocalContext *lc = s->HEVClc;
-    BitReadCtx_t *gb = &lc->gb;
 
     READ_BITS(gb, 2, &ptl->profile_space);
     READ_ONEBIT(gb, &ptl->tier_flag);
@@ -297,12 +298,10 @@ __BITREAD_ERR:
     return  MPP_ERR_STREAM;
 }
 
-static RK_S32 parse_ptl(HEVCContext *s, PTL *ptl, int max_num_sub_layers)
+static RK_S32 parse_ptl(BitReadCtx_t *gb, PTL *ptl, int max_num_sub_layers)
 {
     RK_S32 i;
-    HEVCLocalContext *lc = s->HEVClc;
-    BitReadCtx_t *gb = &lc->gb;
-    decode_profile_tier_level(s, &ptl->general_ptl);
+    decode_profile_tier_level(gb, &ptl->general_ptl);
     READ_BITS(gb, 8, &ptl->general_ptl.level_idc);
 
     for (i = 0; i < max_num_sub_layers - 1; i++) {
@@ -314,7 +313,7 @@ static RK_S32 parse_ptl(HEVCContext *s, PTL *ptl, int max_num_sub_layers)
             SKIP_BITS(gb, 2); // reserved_zero_2bits[i]
     for (i = 0; i < max_num_sub_layers - 1; i++) {
         if (ptl->sub_layer_profile_present_flag[i])
-            decode_profile_tier_level(s, &ptl->sub_layer_ptl[i]);
+            decode_profile_tier_level(gb, &ptl->sub_layer_ptl[i]);
         if (ptl->sub_layer_level_present_flag[i])
             READ_BITS(gb, 8, &ptl->sub_layer_ptl[i].level_idc);
     }
@@ -324,10 +323,9 @@ __BITREAD_ERR:
     return  MPP_ERR_STREAM;
 }
 
-static RK_S32 decode_sublayer_hrd(HEVCContext *s, unsigned int nb_cpb,
+static RK_S32 decode_sublayer_hrd(BitReadCtx_t *gb, unsigned int nb_cpb,
                                   int subpic_params_present)
 {
-    BitReadCtx_t *gb = &s->HEVClc->gb;
     RK_U32 i, value;
 
     for (i = 0; i < nb_cpb; i++) {
@@ -345,10 +343,9 @@ __BITREAD_ERR:
     return  MPP_ERR_STREAM;
 }
 
-static RK_S32 decode_hrd(HEVCContext *s, int common_inf_present,
+static RK_S32 decode_hrd(BitReadCtx_t *gb, int common_inf_present,
                          int max_sublayers)
 {
-    BitReadCtx_t *gb = &s->HEVClc->gb;
     int nal_params_present = 0, vcl_params_present = 0;
     int subpic_params_present = 0;
     int i;
@@ -401,9 +398,9 @@ static RK_S32 decode_hrd(HEVCContext *s, int common_inf_present,
         }
 
         if (nal_params_present)
-            decode_sublayer_hrd(s, nb_cpb, subpic_params_present);
+            decode_sublayer_hrd(gb, nb_cpb, subpic_params_present);
         if (vcl_params_present)
-            decode_sublayer_hrd(s, nb_cpb, subpic_params_present);
+            decode_sublayer_hrd(gb, nb_cpb, subpic_params_present);
     }
     return 0;
 __BITREAD_ERR:
@@ -509,7 +506,7 @@ static RK_S32 parse_vps_extension (HEVCContext *s, HEVCVPS *vps)
             memcpy(vps->PTLExt[i], vps->PTLExt[vps->profile_ref[i]], sizeof(PTL));
         }
         vps->PTLExt[i] = mpp_malloc(PTL, 1); // TO DO add free
-        parse_ptl(s, vps->PTLExt[i], vps->vps_max_sub_layers);
+        parse_ptl(gb, vps->PTLExt[i], vps->vps_max_sub_layers);
     }
 #endif
 
@@ -1070,7 +1067,7 @@ int mpp_hevc_decode_nal_vps(HEVCContext *s)
         goto err;
     }
 
-    parse_ptl(s, &vps->ptl, vps->vps_max_sub_layers);
+    parse_ptl(gb, &vps->ptl, vps->vps_max_sub_layers);
 
     READ_ONEBIT(gb, &vps->vps_sub_layer_ordering_info_present_flag);
 
@@ -1118,7 +1115,7 @@ int mpp_hevc_decode_nal_vps(HEVCContext *s)
             READ_UE(gb, &hrd_layer_set_idx); // hrd_layer_set_idx
             if (i)
                 READ_ONEBIT(gb, &common_inf_present);
-            decode_hrd(s, common_inf_present, vps->vps_max_sub_layers);
+            decode_hrd(gb, common_inf_present, vps->vps_max_sub_layers);
         }
     }
 
@@ -1159,10 +1156,9 @@ err:
 }
 
 
-static RK_S32 decode_vui(HEVCContext *s, HEVCSPS *sps)
+static RK_S32 decode_vui(BitReadCtx_t *gb, HEVCSPS *sps)
 {
     VUI *vui          = &sps->vui;
-    BitReadCtx_t *gb = &s->HEVClc->gb;
     RK_S32 sar_present;
 
     h265d_dbg(H265D_DBG_FUNCTION, "Decoding VUI\n");
@@ -1259,7 +1255,7 @@ static RK_S32 decode_vui(HEVCContext *s, HEVCSPS *sps)
             READ_UE(gb, &vui->vui_num_ticks_poc_diff_one_minus1);
         READ_ONEBIT(gb, &vui->vui_hrd_parameters_present_flag);
         if (vui->vui_hrd_parameters_present_flag)
-            decode_hrd(s, 1, sps->max_sub_layers);
+            decode_hrd(gb, 1, sps->max_sub_layers);
     }
 
     READ_ONEBIT(gb, &vui->bitstream_restriction_flag);
@@ -1309,9 +1305,8 @@ static void set_default_scaling_list_data(ScalingList *sl)
     memcpy(sl->sl[3][5], default_scaling_list_inter, 64);
 }
 
-static int scaling_list_data(HEVCContext *s, ScalingList *sl, HEVCSPS *sps)
+static int scaling_list_data(BitReadCtx_t *gb, ScalingList *sl, HEVCSPS *sps)
 {
-    BitReadCtx_t *gb = &s->HEVClc->gb;
     RK_U8 scaling_list_pred_mode_flag;
     RK_S32 scaling_list_dc_coef[2][6];
     RK_S32 size_id,  i, pos;
@@ -1382,10 +1377,13 @@ __BITREAD_ERR:
     return  MPP_ERR_STREAM;
 }
 
-RK_S32 mpp_hevc_decode_nal_sps(HEVCContext *s)
+/*
+ * Parse sps syntax into cleared sps. The decoder context s is optional,
+ * stream probe passes NULL to parse a standalone sps without vps check.
+ */
+static RK_S32 parser_sps(BitReadCtx_t *gb, HEVCSPS *sps, HEVCContext *s)
 {
     // const AVPixFmtDescriptor *desc;
-    BitReadCtx_t *gb = &s->HEVClc->gb;
     RK_S32 ret    = 0;
     RK_S32 sps_id = 0;
     RK_S32 log2_diff_max_min_transform_block_size;
@@ -1393,13 +1391,6 @@ RK_S32 mpp_hevc_decode_nal_sps(HEVCContext *s)
     RK_S32 i;
     RK_S32 value = 0;
 
-    HEVCSPS *sps;
-    RK_U8 *sps_buf = mpp_calloc(RK_U8, sizeof(*sps));
-
-    if (!sps_buf)
-        return MPP_ERR_NOMEM;
-    sps = (HEVCSPS*)sps_buf;
-
     h265d_dbg(H265D_DBG_FUNCTION, "Decoding SPS\n");
 
     // Coded parameters
@@ -1411,7 +1402,7 @@ RK_S32 mpp_hevc_decode_nal_sps(HEVCContext *s)
         goto err;
     }
 
-    if (!s->vps_list[sps->vps_id]) {
+    if (s && !s->vps_list[sps->vps_id]) {
         mpp_err( "VPS %d does not exist\n",
                  sps->vps_id);
         ret =  MPP_ERR_STREAM;
@@ -1430,7 +1421,7 @@ RK_S32 mpp_hevc_decode_nal_sps(HEVCContext *s)
 
     SKIP_BITS(gb, 1); // temporal_id_nesting_flag
 
-    parse_ptl(s, &sps->ptl, sps->max_sub_layers);
+    parse_ptl(gb, &sps->ptl, sps->max_sub_layers);
 
     READ_UE(gb, &sps_id);
     sps->sps_id = sps_id;///<- zrh add
@@ -1513,7 +1504,8 @@ RK_S32 mpp_hevc_decode_nal_sps(HEVCContext *s)
     } else {
         mpp_err(
             "non-4:2:0 support is currently unspecified.\n");
-        return  MPP_ERR_PROTOL;
+        ret =  MPP_ERR_PROTOL;
+        goto err;
     }
 #if 0
     desc = av_pix_fmt_desc_get(sps->pix_fmt);
@@ -1607,12 +1599,10 @@ RK_S32 mpp_hevc_decode_nal_sps(HEVCContext *s)
         set_default_scaling_list_data(&sps->scaling_list);
         READ_ONEBIT(gb, &value);
         if (value) {
-            ret = scaling_list_data(s, &sps->scaling_list, sps);
+            ret = scaling_list_data(gb, &sps->scaling_list, sps);
             if (ret < 0)
                 goto err;
         }
-
-        s->scaling_list_listen[sps_id] = 1;
     }
 
     READ_ONEBIT(gb, &sps->amp_enabled_flag);
@@ -1651,8 +1641,8 @@ RK_S32 mpp_hevc_decode_nal_sps(HEVCContext *s)
         goto err;
     }
     for (i = 0; (RK_U32)i < sps->nb_st_rps; i++) {
-        if ((ret = mpp_hevc_decode_short_term_rps(s, &sps->st_rps[i],
-                                                  sps, 0)) < 0)
+        if ((ret = decode_short_term_rps(gb, &sps->st_rps[i],
+                                         sps, 0)) < 0)
             goto err;
     }
 
@@ -1668,7 +1658,7 @@ RK_S32 mpp_hevc_decode_nal_sps(HEVCContext *s)
     READ_ONEBIT(gb, &sps->sps_temporal_mvp_enabled_flag);
 
 #ifdef REF_IDX_MFM
-    if (s->nuh_layer_id > 0)
+    if (s && s->nuh_layer_id > 0)
         READ_ONEBIT(gb, &sps->set_mfm_enabled_flag);
 #endif
     READ_ONEBIT(gb, &sps->sps_strong_intra_smoothing_enable_flag);
@@ -1677,9 +1667,9 @@ RK_S32 mpp_hevc_decode_nal_sps(HEVCContext *s)
     sps->vui.sar.den = 1;
     READ_ONEBIT(gb, &vui_present);
     if (vui_present)
-        decode_vui(s, sps);
+        decode_vui(gb, sps);
 #ifdef SCALED_REF_LAYER_OFFSETS
-    if ( s->nuh_layer_id > 0 )   {
+    if (s && s->nuh_layer_id > 0) {
         READ_SE(gb, &value);
         sps->scaled_ref_layer_window.left_offset = (value << 1);
         READ_SE(gb, &value);
@@ -1693,7 +1683,7 @@ RK_S32 mpp_hevc_decode_nal_sps(HEVCContext *s)
 
     //  SKIP_BITS(gb, 1); // sps_extension_flag
 
-    if (s->apply_defdispwin) {
+    if (s && s->apply_defdispwin) {
         sps->output_window.left_offset   += sps->vui.def_disp_win.left_offset;
         sps->output_window.right_offset  += sps->vui.def_disp_win.right_offset;
         sps->output_window.top_offset    += sps->vui.def_disp_win.top_offset;
@@ -1729,13 +1719,6 @@ RK_S32 mpp_hevc_decode_nal_sps(HEVCContext *s)
         sps->output_height              = sps->height;
     }
 
-    // NOTE: only do this for the first time of parsing sps
-    //       this is for extra data sps/pps parser
-    if (s->h265dctx->width == 0 && s->h265dctx->height == 0) {
-        s->h265dctx->width = sps->output_width;
-        s->h265dctx->height = sps->output_height;
-    }
-
     // Inferred parameters
     sps->log2_ctb_size = sps->log2_min_cb_size + sps->log2_diff_max_min_coding_block_size;
 
@@ -1760,21 +1743,25 @@ RK_S32 mpp_hevc_decode_nal_sps(HEVCContext *s)
     if (sps->width  & ((1 << sps->log2_min_cb_size) - 1) ||
         sps->height & ((1 << sps->log2_min_cb_size) - 1)) {
         mpp_err( "Invalid coded frame dimensions.\n");
+        ret =  MPP_ERR_STREAM;
         goto err;
     }
 
     if (sps->log2_ctb_size > MAX_LOG2_CTB_SIZE) {
         mpp_err( "CTB size out of range: 2^%d\n", sps->log2_ctb_size);
+        ret =  MPP_ERR_STREAM;
         goto err;
     }
     if (sps->max_transform_hierarchy_depth_inter > (RK_S32)(sps->log2_ctb_size - sps->log2_min_tb_size)) {
         mpp_err( "max_transform_hierarchy_depth_inter out of range: %d\n",
                  sps->max_transform_hierarchy_depth_inter);
+        ret =  MPP_ERR_STREAM;
         goto err;
     }
     if (sps->max_transform_hierarchy_depth_intra > (RK_S32)(sps->log2_ctb_size - sps->log2_min_tb_size)) {
         mpp_err( "max_transform_hierarchy_depth_intra out of range: %d\n",
                  sps->max_transform_hierarchy_depth_intra);
+        ret =  MPP_ERR_STREAM;
         goto err;
     }
     h265d_dbg(H265D_DBG_SPS, "sps->log2_ctb_size %d", sps->log2_ctb_size);
@@ -1782,8 +1769,46 @@ RK_S32 mpp_hevc_decode_nal_sps(HEVCContext *s)
         mpp_err(
             "max transform block size out of range: %d\n",
             sps->log2_max_trafo_size);
+        ret =  MPP_ERR_STREAM;
         goto err;
     }
+    return 0;
+__BITREAD_ERR:
+    ret =  MPP_ERR_STREAM;
+err:
+    return ret;
+}
+
+RK_S32 mpp_hevc_decode_nal_sps(HEVCContext *s)
+{
+    RK_S32 ret    = 0;
+    RK_S32 sps_id = 0;
+    RK_S32 i;
+
+    HEVCSPS *sps;
+    RK_U8 *sps_buf = mpp_calloc(RK_U8, sizeof(*sps));
+
+    if (!sps_buf)
+        return MPP_ERR_NOMEM;
+    sps = (HEVCSPS*)sps_buf;
+
+    ret = parser_sps(&s->HEVClc->gb, sps, s);
+    if (ret) {
+        mpp_free(sps_buf);
+        return ret;
+    }
+
+    sps_id = sps->sps_id;
+    if (sps->scaling_list_enable_flag)
+        s->scaling_list_listen[sps_id] = 1;
+
+    // NOTE: only do this for the first time of parsing sps
+    //       this is for extra data sps/pps parser
+    if (s->h265dctx->width == 0 && s->h265dctx->height == 0) {
+        s->h265dctx->width = sps->output_width;
+        s->h265dctx->height = sps->output_height;
+    }
+
     if (s->h265dctx->compare_info != NULL) {
         CurrentFameInf_t *info = (CurrentFameInf_t *)s->h265dctx->compare_info;
         HEVCSPS *openhevc_sps = (HEVCSPS *)&info->sps[sps_id];
@@ -1828,9 +1853,36 @@ RK_S32 mpp_hevc_decode_nal_sps(HEVCContext *s)
         s->sps_list_of_updated[sps_id] = 1;
 
     return 0;
-__BITREAD_ERR:
-err:
-    mpp_free(sps_buf);
+}
+
+RK_S32 mpp_hevc_probe_sps(BitReadCtx_t *gb, MppDecStreamInfo *info)
+{
+    HEVCSPS *sps = mpp_calloc(HEVCSPS, 1);
+    VUI *vui = NULL;
+    RK_S32 ret = 0;
+
+    if (NULL == sps)
+        return MPP_ERR_NOMEM;
+
+    ret = parser_sps(gb, sps, NULL);
+    if (ret)
+        goto DONE;
+
+    vui = &sps->vui;
+    info->width = sps->output_width;
+    info->height = sps->output_height;
+    info->profile = sps->ptl.general_ptl.profile_idc;
+    info->level = sps->ptl.general_ptl.level_idc;
+    info->bit_depth = sps->bit_depth;
+    info->fmt = sps->pix_fmt;
+    info->interlaced = vui->field_seq_flag;
+    if (vui->vui_timing_info_present_flag && vui->vui_num_units_in_tick) {
+        info->fps_num = vui->vui_time_scale;
+        info->fps_den = vui->vui_num_units_in_tick;
+    }
+
+DONE:
+    mpp_free(sps);
     return ret;
 }
 
@@ -2039,7 +2091,7 @@ int mpp_hevc_decode_nal_pps(HEVCContext *s)
     READ_ONEBIT(gb, &pps->scaling_list_data_present_flag);
     if (pps->scaling_list_data_present_flag) {
         set_default_scaling_list_data(&pps->scaling_list);
-        ret = scaling_list_data(s, &pps->scaling_list, sps);
+        ret = scaling_list_data(gb, &pps->scaling_list, sps);
 
         if (ret < 0)
             goto err;
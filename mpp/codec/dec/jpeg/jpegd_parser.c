@@ -1335,6 +1335,60 @@ static MPP_RET jpegd_callback(void *ctx, void *err_info)
     return MPP_OK;
 }
 
+static MPP_RET jpegd_probe(RK_U8 *data, RK_S32 size, MppDecStreamInfo *info)
+{
+    JpegdCtx ctx;
+    JpegdSyntax syntax;
+    BitReadCtx_t gb;
+    const RK_U8 *buf_ptr = data;
+    const RK_U8 *const buf_end = data + size;
+    RK_S32 start_code;
+
+    if (size < 4 || data[0] != 0xFF || data[1] != SOI)
+        return MPP_NOK;
+
+    memset(&ctx, 0, sizeof(ctx));
+    memset(&syntax, 0, sizeof(syntax));
+    ctx.bit_ctx = &gb;
+    ctx.syntax = &syntax;
+    buf_ptr += 2;
+
+    while (buf_ptr < buf_end) {
+        start_code = jpegd_find_marker(&buf_ptr, buf_end);
+        if (start_code < 0 || start_code == SOS || start_code == EOI)
+            break;
+
+        if (start_code >= RST0 && start_code <= RST7)
+            continue;
+
+        mpp_set_bitread_ctx(&gb, (RK_U8 *)buf_ptr, buf_end - buf_ptr);
+
+        if (start_code >= SOF0 && start_code <= SOF15 &&
+            start_code != DHT && start_code != JPG && start_code != DAC) {
+            if (buf_end - buf_ptr < 3 || jpegd_decode_sof(&ctx))
+                return MPP_ERR_STREAM;
+
+            info->width     = syntax.width;
+            info->height    = syntax.height;
+            info->profile   = start_code - SOF0;
+            info->bit_depth = buf_ptr[2];
+            info->fmt       = syntax.output_fmt;
+
+            jpegd_dbg_marker("probe %dx%d sof %d fmt %d\n", info->width,
+                             info->height, info->profile, info->fmt);
+            return MPP_OK;
+        }
+
+        /* skip whole segment to avoid the sof of thumbnail in app data */
+        if (jpegd_skip_section(&ctx))
+            return MPP_ERR_STREAM;
+
+        buf_ptr += gb.used_bits >> 3;
+    }
+
+    return MPP_NOK;
+}
+
 const ParserApi api_jpegd_parser = {
     .name = "jpegd_parse",
     .coding = MPP_VIDEO_CodingMJPEG,
@@ -1348,6 +1402,7 @@ const ParserApi api_jpegd_parser = {
     .flush = jpegd_flush,
     .control = jpegd_control,
     .callback = jpegd_callback,
+    .probe = jpegd_probe,
 };
 
 
@@ -40,4 +40,5 @@ const ParserApi api_m2vd_parser = {
     .flush = m2vd_parser_flush,
     .control = m2vd_parser_control,
     .callback = m2vd_parser_callback,
+    .probe = m2vd_parser_probe,
 };
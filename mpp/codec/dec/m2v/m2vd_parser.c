@@ -335,6 +335,8 @@ MPP_RET m2vd_parser_reset(void *ctx)
     p->left_length = 0;
     p->need_split = 0;
     p->vop_header_found = 0;
+    p->skip_frame = 0;
+    mpp_dec_skip_reset(&p->skip);
     m2vd_dbg_func("FUN_O");
     return ret;
 }
@@ -373,10 +375,16 @@ MPP_RET m2vd_parser_flush(void *ctx)
 MPP_RET m2vd_parser_control(void *ctx, MpiCmd cmd_type, void *param)
 {
     MPP_RET ret = MPP_OK;
+    M2VDContext *c = (M2VDContext *)ctx;
+    M2VDParserContext *p = (M2VDParserContext *)c->parse_ctx;
     m2vd_dbg_func("FUN_I");
-    (void)ctx;
-    (void)cmd_type;
-    (void)param;
+    switch (cmd_type) {
+    case MPP_DEC_SET_SKIP_MODE: {
+        ret = mpp_dec_skip_set(&p->skip, (MppDecSkipCfg *)param);
+    } break;
+    default : {
+    } break;
+    }
     m2vd_dbg_func("FUN_O");
     return ret;
 }
@@ -1066,6 +1074,90 @@ static MPP_RET m2vd_decode_head(M2VDParserContext *ctx)
     return ret;
 }
 
+/* frame rate of frame_rate_code in fps_num / fps_den */
+static const RK_U32 m2vd_frame_rate[16][2] = {
+    {     0,    0 },
+    { 24000, 1001 },
+    {    24,    1 },
+    {    25,    1 },
+    { 30000, 1001 },
+    {    30,    1 },
+    {    50,    1 },
+    { 60000, 1001 },
+    {    60,    1 },
+};
+
+MPP_RET m2vd_parser_probe(RK_U8 *data, RK_S32 size, MppDecStreamInfo *info)
+{
+    BitReadCtx_t bitctx;
+    BitReadCtx_t *bx = &bitctx;
+    RK_U32 code;
+    RK_U32 frame_rate_code;
+    RK_U32 i;
+
+    mpp_set_bitread_ctx(bx, data, size);
+
+    do {
+        code = m2vd_search_header(bx);
+        if (code == NO_MORE_STREAM)
+            return MPP_NOK;
+
+        mpp_skip_longbits(bx, 32);
+    } while (code != SEQUENCE_HEADER_CODE);
+
+    info->width = m2vd_read_bits(bx, 12);
+    info->height = m2vd_read_bits(bx, 12);
+    mpp_skip_bits(bx, 4); /* aspect_ratio_information */
+    frame_rate_code = m2vd_read_bits(bx, 4);
+    info->fps_num = m2vd_frame_rate[frame_rate_code][0];
+    info->fps_den = m2vd_frame_rate[frame_rate_code][1];
+    info->bit_depth = 8;
+    info->fmt = MPP_FMT_YUV420SP;
+
+    if (!info->width || !info->height)
+        return MPP_ERR_STREAM;
+
+    /* bit_rate_value, marker_bit, vbv_buffer_size, constrained_parameters_flag */
+    mpp_skip_bits(bx, 30);
+    for (i = 0; i < 2; i++) {
+        /* load_intra_quantizer_matrix and load_non_intra_quantizer_matrix */
+        if (m2vd_read_bits(bx, 1)) {
+            RK_U32 j;
+
+            for (j = 0; j < 64; j++)
+                mpp_skip_bits(bx, 8);
+        }
+    }
+
+    /* mpeg2 sequence extension follows sequence header directly */
+    if (m2vd_search_header(bx) != EXTENSION_START_CODE)
+        return MPP_OK;
+
+    mpp_skip_longbits(bx, 32);
+    if (m2vd_read_bits(bx, 4) == SEQUENCE_EXTENSION_ID) {
+        RK_U32 profile_and_level = m2vd_read_bits(bx, 8);
+        RK_U32 chroma_format;
+
+        info->profile = (profile_and_level >> 4) & 0x7;
+        info->level = profile_and_level & 0xf;
+        info->interlaced = !m2vd_read_bits(bx, 1);
+        chroma_format = m2vd_read_bits(bx, 2);
+        info->width |= m2vd_read_bits(bx, 2) << 12;
+        info->height |= m2vd_read_bits(bx, 2) << 12;
+        /* bit_rate_extension, marker_bit, vbv_buffer_size_extension, low_delay */
+        mpp_skip_bits(bx, 22);
+        info->fps_num *= m2vd_read_bits(bx, 2) + 1;
+        info->fps_den *= m2vd_read_bits(bx, 5) + 1;
+
+        if (chroma_format == 2)
+            info->fmt = MPP_FMT_YUV422SP;
+        else if (chroma_format == 3)
+            info->fmt = MPP_FMT_YUV444SP;
+    }
+
+    return MPP_OK;
+}
+
 static MPP_RET m2vd_alloc_frame(M2VDParserContext *ctx)
 {
     RK_U64 pts = (RK_U64)(ctx->pts / 1000);
@@ -1203,6 +1295,35 @@ static MPP_RET m2vd_alloc_frame(M2VDParserContext *ctx)
     return MPP_OK;
 }
 
+static RK_U32 m2vd_check_skip(M2VDParserContext *ctx)
+{
+    RK_U32 type = ctx->pic_head.picture_coding_type;
+    RK_U32 structure = ctx->pic_code_ext_head.picture_structure;
+    RK_U32 tff = ctx->pic_code_ext_head.top_field_first;
+
+    /* the second field follows the decision on the first field */
+    if ((structure == M2VD_PIC_STRUCT_FRAME) ||
+        ((structure == M2VD_PIC_STRUCT_TOP_FIELD) && tff) ||
+        ((structure == M2VD_PIC_STRUCT_BOTTOM_FIELD) && !tff))
+        ctx->skip_frame = mpp_dec_skip_check(&ctx->skip, type == M2VD_CODING_TYPE_I,
+                                             type != M2VD_CODING_TYPE_B);
+
+    if (ctx->skip_frame) {
+        /* B frames after skipped reference are dropped for missing reference */
+        if (type != M2VD_CODING_TYPE_B)
+            ctx->ref_frame_cnt = 0;
+
+        ctx->pic_head.pre_temporal_reference = ctx->pic_head.temporal_reference;
+        ctx->pic_head.pre_picture_coding_type = type;
+
+        if (M2VD_DBG_SEC_HEADER & m2vd_debug)
+            mpp_log("[m2v]: skip picture type %d temporal_reference %d",
+                    type, ctx->pic_head.temporal_reference);
+    }
+
+    return ctx->skip_frame;
+}
+
 static MPP_RET m2v_update_ref_frame(M2VDParserContext *p)
 {
 
@@ -1420,6 +1541,9 @@ MPP_RET m2vd_parser_parse(void *ctx, HalDecTask *in_task)
     }
 
     if (rev == M2VD_DEC_PICHEAD_OK) {
+        if (m2vd_check_skip(p))
+            goto __FAILED;
+
         if (MPP_OK != m2vd_alloc_frame(p)) {
             mpp_err("m2vd_alloc_frame not OK");
             goto __FAILED;
@@ -31,6 +31,7 @@
 #include "mpp_bitread.h"
 
 #include "parser_api.h"
+#include "mpp_dec_skip.h"
 #include "m2vd_syntax.h"
 #include "m2vd_com.h"
 
@@ -253,6 +254,8 @@ typedef struct M2VDParserContext_t {
     M2VDHeadPicDispExt  pic_disp_ext_head;
 
     RK_S32             resetFlag;
+    MppDecSkip         skip;
+    RK_U32             skip_frame;
 
     RK_U32          PreGetFrameTime;
     RK_S32          Group_start_Time;
@@ -302,6 +305,7 @@ MPP_RET  m2vd_parser_control(void *ctx, MpiCmd cmd_type, void *param);
 MPP_RET  m2vd_parser_prepare(void *ctx, MppPacket pkt, HalDecTask *task);
 MPP_RET  m2vd_parser_parse  (void *ctx, HalDecTask *task);
 MPP_RET  m2vd_parser_callback(void *ctx, void *err_info);
+MPP_RET  m2vd_parser_probe  (RK_U8 *data, RK_S32 size, MppDecStreamInfo *info);
 
 #endif
 
@@ -43,6 +43,7 @@ typedef struct {
     RK_U32          need_split;
     RK_U32          frame_count;
     RK_U32          internal_pts;
+    MppDecSkip      skip;
 
     // parser context
     Mpg4dParser     parser;
@@ -143,6 +144,7 @@ static MPP_RET mpg4d_reset(void *dec)
     Mpg4dCtx *p = (Mpg4dCtx *)dec;
     p->left_length  = 0;
     p->got_eos = 0;
+    mpp_dec_skip_reset(&p->skip);
     mpp_packet_set_length(p->task_pkt, 0);
     mpp_packet_set_flag(p->task_pkt, 0);
 
@@ -166,8 +168,15 @@ static MPP_RET mpg4d_control(void *dec, MpiCmd cmd_type, void *param)
         mpp_err_f("found NULL intput\n");
         return MPP_ERR_NULL_PTR;
     }
-    (void)cmd_type;
-    (void)param;
+
+    Mpg4dCtx *p = (Mpg4dCtx *)dec;
+    switch (cmd_type) {
+    case MPP_DEC_SET_SKIP_MODE : {
+        return mpp_dec_skip_set(&p->skip, (MppDecSkipCfg *)param);
+    } break;
+    default : {
+    } break;
+    }
     return MPP_OK;
 }
 
@@ -289,6 +298,18 @@ static MPP_RET mpg4d_parse(void *dec, HalDecTask *task)
         return MPP_NOK;
     }
 
+    // skipped vop never reaches hal and keeps task invalid
+    if (mpp_mpg4_parser_skip(p->parser, &p->skip)) {
+        task->valid  = 0;
+        task->output = -1;
+
+        if (p->got_eos) {
+            task->flags.eos = 1;
+            mpg4d_flush(dec);
+        }
+        return MPP_OK;
+    }
+
     mpp_mpg4_parser_setup_syntax(p->parser, &task->syntax);
     mpp_mpg4_parser_setup_hal_output(p->parser, &task->output);
     mpp_mpg4_parser_setup_refer(p->parser, task->refer, MAX_DEC_REF_NUM);
@@ -325,5 +346,6 @@ const ParserApi api_mpg4d_parser = {
     .flush = mpg4d_flush,
     .control = mpg4d_control,
     .callback = mpg4d_callback,
+    .probe = mpp_mpg4_parser_probe,
 };
 
@@ -92,6 +92,7 @@ typedef struct Mp4HdrVol_t {
     RK_U32  shape;
     RK_S32  time_inc_resolution;
     RK_U32  time_inc_bits;
+    RK_U32  fixed_time_inc;
     RK_S32  width;
     RK_S32  height;
     RK_U32  mb_width;
@@ -535,7 +536,7 @@ static MPP_RET mpg4d_parse_vol_header(Mpg4dParserImpl *p, BitReadCtx_t *cb)
 
     READ_BITS(cb, 1, &val);
     if (val) {                                          /* fixed_vop_rate */
-        SKIP_BITS(cb, mp4Hdr->vol.time_inc_bits);       /* fixed_vop_time_increment */
+        READ_BITS(cb, mp4Hdr->vol.time_inc_bits, &mp4Hdr->vol.fixed_time_inc); /* fixed_vop_time_increment */
     }
 
     if (mp4Hdr->vol.shape != MPEG4_VIDOBJLAY_SHAPE_BINARY_ONLY) {
@@ -1123,16 +1124,13 @@ MPP_RET mpp_mpg4_parser_flush(Mpg4dParser ctx)
     return MPP_OK;
 }
 
-MPP_RET mpp_mpg4_parser_reset(Mpg4dParser ctx)
+static void mpg4d_release_ref(Mpg4dParserImpl *p)
 {
-    Mpg4dParserImpl *p = (Mpg4dParserImpl *)ctx;
     MppBufSlots slots = p->frame_slots;
     Mpg4Hdr *hdr_ref0 = &p->hdr_ref0;
     Mpg4Hdr *hdr_ref1 = &p->hdr_ref1;
     RK_S32 index = hdr_ref0->slot_idx;
 
-    mpg4d_dbg_func("in\n");
-
     if (index >= 0) {
         if (!hdr_ref0->enqueued) {
             mpp_buf_slot_set_flag(slots, index, SLOT_QUEUE_USE);
@@ -1148,6 +1146,15 @@ MPP_RET mpp_mpg4_parser_reset(Mpg4dParser ctx)
         mpp_buf_slot_clr_flag(slots, index, SLOT_CODEC_USE);
         hdr_ref1->slot_idx = -1;
     }
+}
+
+MPP_RET mpp_mpg4_parser_reset(Mpg4dParser ctx)
+{
+    Mpg4dParserImpl *p = (Mpg4dParserImpl *)ctx;
+
+    mpg4d_dbg_func("in\n");
+
+    mpg4d_release_ref(p);
 
     p->found_i_vop      = 0;
     p->found_vop        = 0;
@@ -1474,6 +1481,39 @@ MPP_RET mpp_mpg4_parser_setup_refer(Mpg4dParser ctx, RK_S32 *refer, RK_S32 max_r
     return MPP_OK;
 }
 
+RK_U32 mpp_mpg4_parser_skip(Mpg4dParser ctx, MppDecSkip *skip)
+{
+    Mpg4dParserImpl *p = (Mpg4dParserImpl *)ctx;
+    Mpg4Hdr *hdr_curr = &p->hdr_curr;
+    RK_S32 coding_type = hdr_curr->vop.coding_type;
+    RK_U32 ref = (coding_type != MPEG4_B_VOP);
+    RK_U32 drop = 0;
+
+    if (skip->cfg.mode == MPP_DEC_SKIP_NONE)
+        return 0;
+
+    drop = mpp_dec_skip_check(skip, coding_type == MPEG4_I_VOP, ref);
+
+    // b vop after skipped reference vop misses its backward reference
+    if (!ref && p->hdr_ref1.slot_idx < 0)
+        drop = 1;
+
+    if (!drop)
+        return 0;
+
+    mpg4d_dbg_result("skip frame %d coding_type %d\n", p->frame_num, coding_type);
+
+    // following vop can not refer to the frames before the skipped one
+    if (ref)
+        mpg4d_release_ref(p);
+
+    init_mpg4_hdr_vop(hdr_curr);
+    hdr_curr->slot_idx = -1;
+    p->last_pts = p->pts;
+
+    return 1;
+}
+
 MPP_RET mpp_mpg4_parser_update_dpb(Mpg4dParser ctx)
 {
     Mpg4dParserImpl *p = (Mpg4dParserImpl *)ctx;
@@ -1537,5 +1577,49 @@ MPP_RET mpp_mpg4_parser_update_dpb(Mpg4dParser ctx)
     return MPP_OK;
 }
 
+MPP_RET mpp_mpg4_parser_probe(RK_U8 *data, RK_S32 size, MppDecStreamInfo *info)
+{
+    Mpg4dParserImpl p;
+    BitReadCtx_t bit_ctx;
+    BitReadCtx_t *gb = &bit_ctx;
+    RK_U32 startcode = 0xff;
+    RK_U32 val = 0;
+
+    memset(&p, 0, sizeof(p));
+    init_mpg4_header(&p.hdr_curr);
+    mpp_set_bitread_ctx(gb, data, size);
 
+    while (gb->bytes_left_) {
+        READ_BITS(gb, 8, &val);
+        startcode = (startcode << 8) | val;
 
+        if (startcode == MPG4_VOS_STARTCODE) {
+            if (mpeg4_parse_profile_level(&p, gb))
+                return MPP_ERR_STREAM;
+        } else if (startcode >= MPG4_VOL_STARTCODE && startcode <= MPG4_VOL_STOPCODE) {
+            Mp4HdrVol *vol = &p.hdr_curr.vol;
+
+            if (mpg4d_parse_vol_header(&p, gb))
+                return MPP_ERR_STREAM;
+
+            info->width     = vol->width;
+            info->height    = vol->height;
+            info->profile   = p.profile;
+            info->level     = p.level;
+            info->bit_depth = 8;
+            info->fmt       = MPP_FMT_YUV420SP;
+            info->interlaced = vol->interlacing;
+            if (vol->fixed_time_inc && vol->time_inc_resolution > 0) {
+                info->fps_num = vol->time_inc_resolution;
+                info->fps_den = vol->fixed_time_inc;
+            }
+
+            mpg4d_dbg_result("probe w %d h %d profile %d level %d\n",
+                             info->width, info->height, info->profile, info->level);
+            return MPP_OK;
+        }
+    }
+
+__BITREAD_ERR:
+    return MPP_NOK;
+}
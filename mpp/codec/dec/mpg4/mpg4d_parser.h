@@ -21,6 +21,8 @@
 #include "mpp_packet.h"
 #include "mpp_buf_slot.h"
 #include "hal_task.h"
+#include "mpp_dec_skip.h"
+#include "rk_mpi.h"
 
 #define MPG4D_DBG_FUNCTION          (0x00000001)
 #define MPG4D_DBG_STARTCODE         (0x00000002)
@@ -45,6 +47,10 @@ MPP_RET mpp_mpg4_parser_setup_syntax(Mpg4dParser ctx, MppSyntax *syntax);
 MPP_RET mpp_mpg4_parser_setup_hal_output(Mpg4dParser ctx, RK_S32 *output);
 MPP_RET mpp_mpg4_parser_setup_refer(Mpg4dParser ctx, RK_S32 *refer, RK_S32 max_ref);
 MPP_RET mpp_mpg4_parser_update_dpb(Mpg4dParser ctx);
+/* return non-zero when current vop is dropped by skip mode */
+RK_U32  mpp_mpg4_parser_skip(Mpg4dParser ctx, MppDecSkip *skip);
+/* stateless vol header parsing */
+MPP_RET mpp_mpg4_parser_probe(RK_U8 *data, RK_S32 size, MppDecStreamInfo *info);
 
 #ifdef __cplusplus
 }
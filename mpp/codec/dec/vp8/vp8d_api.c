@@ -36,4 +36,5 @@ const ParserApi api_vp8d_parser = {
     .flush = vp8d_parser_flush,
     .control = vp8d_parser_control,
     .callback = vp8d_parser_callback,
+    .probe = vp8d_parser_probe,
 };
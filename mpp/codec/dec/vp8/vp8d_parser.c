@@ -342,6 +342,7 @@ MPP_RET vp8d_parser_reset(void *ctx)
     vp8d_unref_allframe(p);
     p->needKeyFrame = 0;
     p->eos = 0;
+    mpp_dec_skip_reset(&p->skip);
     FUN_T("FUN_OUT");
     return ret;
 }
@@ -371,11 +372,17 @@ MPP_RET vp8d_parser_flush(void *ctx)
 MPP_RET vp8d_parser_control(void *ctx, MpiCmd cmd_type, void *param)
 {
     MPP_RET ret = MPP_OK;
+    VP8DContext *c = (VP8DContext *)ctx;
+    VP8DParserContext_t *p = (VP8DParserContext_t *)c->parse_ctx;
 
     FUN_T("FUN_IN");
-    (void)ctx;
-    (void)cmd_type;
-    (void)param;
+    switch (cmd_type) {
+    case MPP_DEC_SET_SKIP_MODE: {
+        ret = mpp_dec_skip_set(&p->skip, (MppDecSkipCfg *)param);
+    } break;
+    default : {
+    } break;
+    }
 
     FUN_T("FUN_OUT");
     return ret;
@@ -795,6 +802,17 @@ static void vp8hwdDecodeCoeffUpdate(VP8DParserContext_t *p)
     FUN_T("FUN_OUT");
 }
 
+/* Rollback entropy probabilities if refresh is not set */
+static void vp8hwdRestoreProbs(VP8DParserContext_t *p)
+{
+    if (p->refreshEntropyProbs == 0) {
+        memcpy((void*)&p->entropy, (void*)&p->entropyLast,
+               (unsigned long)sizeof(vp8EntropyProbs_t));
+        memcpy((void*)p->vp7ScanOrder, (void*)p->vp7PrevScanOrder,
+               (unsigned long)sizeof(p->vp7ScanOrder));
+    }
+}
+
 static MPP_RET vp8_header_parser(VP8DParserContext_t *p, RK_U8 *pbase,
                                  RK_U32 size)
 {
@@ -1223,6 +1241,20 @@ MPP_RET vp8d_parser_parse(void *ctx, HalDecTask *in_task)
 
     vp8hwdSetPartitionOffsets(p, p->bitstream_sw_buf, p->stream_size);
 
+    /* skipped frame keeps entropy update but no frame or reference update */
+    if (mpp_dec_skip_check(&p->skip, p->keyFrame,
+                           p->refreshLast || p->refreshGolden ||
+                           p->refreshAlternate || p->copyBufferToGolden ||
+                           p->copyBufferToAlternate)) {
+        vp8hwdRestoreProbs(p);
+        in_task->valid = 0;
+        if (p->eos) {
+            in_task->flags.eos = p->eos;
+        }
+        FUN_T("FUN_OUT");
+        return ret;
+    }
+
     ret = vp8d_alloc_frame(p);
     if (MPP_OK != ret) {
         mpp_err("vp8d_alloc_frame err ret %d", ret);
@@ -1231,13 +1263,7 @@ MPP_RET vp8d_parser_parse(void *ctx, HalDecTask *in_task)
     }
 
     vp8d_convert_to_syntx(p, in_task);
-    /* Rollback entropy probabilities if refresh is not set */
-    if (p->refreshEntropyProbs == 0) {
-        memcpy((void*)&p->entropy, (void*)&p->entropyLast,
-               (unsigned long)sizeof(vp8EntropyProbs_t));
-        memcpy((void*)p->vp7ScanOrder, (void*)p->vp7PrevScanOrder,
-               (unsigned long)sizeof(p->vp7ScanOrder));
-    }
+    vp8hwdRestoreProbs(p);
     in_task->syntax.data = (void *)p->dxva_ctx;
     in_task->syntax.number = 1;
     in_task->output = p->frame_out->slot_index;
@@ -1260,3 +1286,30 @@ MPP_RET vp8d_parser_callback(void *ctx, void *hal_info)
     FUN_T("FUN_OUT");
     return ret;
 }
+
+MPP_RET vp8d_parser_probe(RK_U8 *data, RK_S32 size, MppDecStreamInfo *info)
+{
+    RK_U32 tmp;
+
+    FUN_T("FUN_IN");
+    /* 3 byte frame tag + 3 byte start code + 4 byte dimension */
+    if (size < 10)
+        return MPP_NOK;
+
+    /* only key frame carries the frame size */
+    if (data[0] & 1)
+        return MPP_NOK;
+
+    tmp = (data[3] << 16) | (data[4] << 8) | (data[5] << 0);
+    if (tmp != VP8_KEY_FRAME_START_CODE)
+        return MPP_ERR_STREAM;
+
+    info->profile   = (data[0] >> 1) & 7;
+    info->width     = ((data[6] << 0) | (data[7] << 8)) & 0x3fff;
+    info->height    = ((data[8] << 0) | (data[9] << 8)) & 0x3fff;
+    info->bit_depth = 8;
+    info->fmt       = MPP_FMT_YUV420SP;
+
+    FUN_T("FUN_OUT");
+    return MPP_OK;
+}
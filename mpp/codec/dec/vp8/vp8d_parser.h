@@ -22,6 +22,7 @@
 #include "mpp_mem.h"
 
 #include "parser_api.h"
+#include "mpp_dec_skip.h"
 #include "vp8d_syntax.h"
 #include "vp8d_data.h"
 
@@ -172,6 +173,7 @@ typedef struct VP8DParserContext {
     RK_U64          pts;
 
     RK_U32          needKeyFrame;
+    MppDecSkip      skip;
     MppPacket       input_packet;
     RK_U32          eos;
 
@@ -190,6 +192,7 @@ MPP_RET  vp8d_parser_control(void *ctx, MpiCmd cmd_type, void *param);
 MPP_RET  vp8d_parser_prepare(void *ctx, MppPacket pkt, HalDecTask *task);
 MPP_RET  vp8d_parser_parse  (void *ctx, HalDecTask *task);
 MPP_RET  vp8d_parser_callback(void *ctx, void *hal_info);
+MPP_RET  vp8d_parser_probe(RK_U8 *data, RK_S32 size, MppDecStreamInfo *info);
 
 #endif
 
@@ -107,6 +107,7 @@ MPP_RET  vp9d_reset(void *ctx)
 
     Vp9CodecContext *vp9_ctx = (Vp9CodecContext *)ctx;
     vp9d_paser_reset(vp9_ctx);
+    mpp_dec_skip_reset(&vp9_ctx->skip);
     return ret = MPP_OK;
 }
 
@@ -124,6 +125,28 @@ MPP_RET  vp9d_flush(void *ctx)
     return ret = MPP_OK;
 }
 
+/*!
+***********************************************************************
+* \brief
+*   control
+***********************************************************************
+*/
+MPP_RET vp9d_control(void *ctx, MpiCmd cmd_type, void *param)
+{
+    MPP_RET ret = MPP_OK;
+    Vp9CodecContext *vp9_ctx = (Vp9CodecContext *)ctx;
+
+    switch (cmd_type) {
+    case MPP_DEC_SET_SKIP_MODE : {
+        ret = mpp_dec_skip_set(&vp9_ctx->skip, (MppDecSkipCfg *)param);
+    } break;
+    default : {
+    } break;
+    }
+
+    return ret;
+}
+
 /*!
 ***********************************************************************
 * \brief
@@ -222,7 +245,8 @@ const ParserApi api_vp9d_parser = {
     .parse = vp9d_parse,
     .reset = vp9d_reset,
     .flush = vp9d_flush,
-    .control = NULL,
+    .control = vp9d_control,
     .callback = vp9d_callback,
+    .probe = vp9d_parser_probe,
 };
 
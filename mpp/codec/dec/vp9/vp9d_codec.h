@@ -19,6 +19,7 @@
 
 #include "mpp_frame.h"
 #include "hal_task.h"
+#include "mpp_dec_skip.h"
 
 #include "vp9d_syntax.h"
 
@@ -97,6 +98,7 @@ typedef struct Vp9CodecContext {
     DXVA_PicParams_VP9 pic_params;
     // DXVA_Slice_VPx_Short slice_short;
     RK_S32 eos;
+    MppDecSkip skip;
 } Vp9CodecContext;
 
 #endif /*__VP9D_CODEC_H__*/
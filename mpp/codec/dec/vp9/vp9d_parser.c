@@ -1560,6 +1560,19 @@ RK_S32 vp9_parser_frame(Vp9CodecContext *ctx, HalDecTask *task)
     data += res;
     size -= res;
 
+    /*
+     * NOTE: vp9 inter frame uses the motion vectors of the previous decoded
+     * frame and may adapt probability context with its symbol counts. So
+     * every frame is taken as reference and only key frame based skip works.
+     */
+    if (mpp_dec_skip_check(&ctx->skip, s->keyframe, 1)) {
+        vp9d_dbg(VP9D_DBG_HEADER, "skip frame keyframe %d", s->keyframe);
+        task->valid = 0;
+        if (s->eos)
+            task->flags.eos = 1;
+        return 0;
+    }
+
     if (s->frames[REF_FRAME_MVPAIR].ref)
         vp9_unref_frame(s, &s->frames[REF_FRAME_MVPAIR]);
 
@@ -1806,3 +1819,86 @@ void vp9_parser_update(Vp9CodecContext *ctx, void *count_info)
 
     return;
 }
+
+MPP_RET vp9d_parser_probe(RK_U8 *data, RK_S32 size, MppDecStreamInfo *info)
+{
+    BitReadCtx_t bit_ctx;
+    BitReadCtx_t *gb = &bit_ctx;
+    RK_U32 val = 0;
+    RK_U32 profile = 0;
+    RK_U32 bits = 0;
+    RK_U32 ss_h = 1;
+    RK_U32 ss_v = 1;
+    RK_U32 w, h;
+
+    mpp_set_bitread_ctx(gb, data, size);
+
+    READ_BITS(gb, 2, &val);
+    if (val != 0x2) /* frame marker */
+        return MPP_ERR_STREAM;
+
+    READ_ONEBIT(gb, &val);
+    profile = val;
+    READ_ONEBIT(gb, &val);
+    profile |= val << 1;
+    if (profile == 3)
+        SKIP_BITS(gb, 1); /* reserved_zero */
+
+    READ_ONEBIT(gb, &val);
+    if (val) /* show_existing_frame */
+        return MPP_NOK;
+
+    READ_ONEBIT(gb, &val);
+    if (val) /* only key frame carries the colour config and frame size */
+        return MPP_NOK;
+
+    SKIP_BITS(gb, 2); /* show_frame, error_resilient_mode */
+
+    READ_BITS(gb, 24, &val);
+    if (val != VP9_SYNCCODE)
+        return MPP_ERR_STREAM;
+
+    if (profile >= 2) {
+        READ_ONEBIT(gb, &bits);
+        bits++;
+    }
+
+    READ_BITS(gb, 3, &val);
+    if (val != 7) { /* not sRGB */
+        SKIP_BITS(gb, 1); /* color_range */
+        if (profile & 1) {
+            READ_ONEBIT(gb, &ss_h);
+            READ_ONEBIT(gb, &ss_v);
+            SKIP_BITS(gb, 1);
+        }
+    } else {
+        ss_h = ss_v = 0;
+        if (profile & 1)
+            SKIP_BITS(gb, 1);
+    }
+
+    READ_BITS(gb, 16, &w);
+    READ_BITS(gb, 16, &h);
+
+    info->profile   = profile;
+    info->bit_depth = 8 + bits * 2;
+    info->width     = w + 1;
+    info->height    = h + 1;
+    if (val == 7)
+        info->fmt = MPP_FMT_RGB888;
+    else if (ss_h && ss_v)
+        info->fmt = bits ? MPP_FMT_YUV420SP_10BIT : MPP_FMT_YUV420SP;
+    else if (ss_h)
+        info->fmt = bits ? MPP_FMT_YUV422SP_10BIT : MPP_FMT_YUV422SP;
+    else if (ss_v)
+        info->fmt = MPP_FMT_YUV440SP;
+    else
+        info->fmt = MPP_FMT_YUV444SP;
+
+    vp9d_dbg(VP9D_DBG_HEADER, "probe w %d h %d profile %d bit_depth %d\n",
+             info->width, info->height, info->profile, info->bit_depth);
+    return MPP_OK;
+
+__BITREAD_ERR:
+    return MPP_ERR_STREAM;
+}
@@ -277,6 +277,8 @@ MPP_RET vp9d_split_init(Vp9CodecContext *vp9_ctx);
 
 RK_S32 vp9d_parser2_syntax(Vp9CodecContext *ctx);
 
+MPP_RET vp9d_parser_probe(RK_U8 *data, RK_S32 size, MppDecStreamInfo *info);
+
 #ifdef  __cplusplus
 }
 #endif
@@ -129,17 +129,14 @@ MPP_RET h264e_deinit(void *ctx)
 
     h264e_dbg_func("enter\n");
 
+    /* record nodes are owned by rc context, just unlink them */
+    struct list_head *del = &p->rc_list;
+    while (!list_empty(del))
+        list_del_init(del->next);
+
     if (p->rc)
         mpp_rc_deinit(p->rc);
 
-    struct list_head *del = &p->rc_list;
-    struct list_head *tmp;
-    while (!list_empty(del)) {
-        tmp = del->next;
-        list_del_init(tmp);
-        mpp_free(list_entry(tmp, RecordNode, list));
-    }
-
     h264e_dbg_func("leave\n");
     return MPP_OK;
 }
@@ -163,6 +160,10 @@ MPP_RET h264e_encode(void *ctx, HalEncTask *task)
     if (p->idr_request)
         p->idr_request--;
 
+    /* pre-analysis hint is used by both bit allocation and hal */
+    rc_syn->scene_cut = task->scene_cut;
+    rc_syn->complexity = task->complexity;
+
     mpp_rc_bits_allocation(p->rc, rc_syn);
     if (rc_syn->bit_target <= 0) {
         int mb_width = ((cfg->prep.width + 15) & (~15)) >> 4;
@@ -28,6 +28,8 @@ typedef struct {
     RK_U32              fast_mode;
     RK_U32              need_split;
     RK_U32              internal_pts;
+    /* hal task count, 0 for default 3 in fast mode and 2 in normal mode */
+    RK_U32              task_count;
     void                *mpp;
 } MppDecCfg;
 
@@ -0,0 +1,65 @@
+/*
+ * Copyright 2015 Rockchip Electronics Co. LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __MPP_ENC_ANALYSIS_H__
+#define __MPP_ENC_ANALYSIS_H__
+
+#include "mpp_frame.h"
+#include "mpp_enc.h"
+
+/*
+ * Encoder input pre-analysis
+ *
+ * The luma plane of input frame is downscaled by 2 in both direction and
+ * split into 8x8 blocks (16x16 on original frame). For each block the mean
+ * absolute deviation and the sad to the same block of previous frame are
+ * calculated. The analysis runs on a worker thread so it can overlap with
+ * hardware encoding of previous frames. When there is nothing to overlap
+ * with mpp_enc_analysis_proc runs it on the caller thread instead.
+ *
+ * scene_cut    - sad is higher than both intra complexity and sad history
+ * complexity   - average block mean absolute deviation in Q8
+ * sad          - average pixel sad to previous frame in Q8
+ */
+typedef struct EncAnalysisResult_t {
+    RK_S32          valid;
+    RK_S32          scene_cut;
+    RK_S32          complexity;
+    RK_S32          sad;
+} EncAnalysisResult;
+
+typedef void* MppEncAnalysis;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* enc is notified with MPP_ENC_NOTIFY_PRE_DONE when analysis finishes if not NULL */
+MPP_RET mpp_enc_analysis_init(MppEncAnalysis *ctx, MppEnc enc);
+MPP_RET mpp_enc_analysis_deinit(MppEncAnalysis ctx);
+MPP_RET mpp_enc_analysis_reset(MppEncAnalysis ctx);
+
+MPP_RET mpp_enc_analysis_start(MppEncAnalysis ctx, MppFrame frame, MppEncPrepCfg *prep);
+RK_S32  mpp_enc_analysis_done(MppEncAnalysis ctx);
+MPP_RET mpp_enc_analysis_wait(MppEncAnalysis ctx, EncAnalysisResult *result);
+MPP_RET mpp_enc_analysis_proc(MppEncAnalysis ctx, MppFrame frame, MppEncPrepCfg *prep,
+                              EncAnalysisResult *result);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /*__MPP_ENC_ANALYSIS_H__*/
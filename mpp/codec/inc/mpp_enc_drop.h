@@ -0,0 +1,58 @@
+/*
+ * Copyright 2015 Rockchip Electronics Co. LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __MPP_ENC_DROP_H__
+#define __MPP_ENC_DROP_H__
+
+#include "rk_venc_cmd.h"
+
+/* max continuous dropped frames when skip_cnt is not set */
+#define MPP_ENC_DROP_CNT_DEFAULT        2
+
+/*
+ * Input frame drop on encoder overload
+ *
+ * Input frames are expected to arrive on the fps_in timeline. The delay of a
+ * frame is the time it arrives after the expected time. When the delay plus
+ * the average encoding time is over the threshold the frame is dropped to
+ * catch up real-time. Early frame moves the timeline forward.
+ *
+ * expect   - expected arrival time of next input frame in us
+ * enc      - average encoding time of one frame in us
+ * count    - continuous dropped frame count
+ */
+typedef struct MppEncDrop_t {
+    RK_S64          expect;
+    RK_S64          enc;
+    RK_S32          count;
+} MppEncDrop;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void    mpp_enc_drop_reset(MppEncDrop *drop);
+/* return 1 when the frame arrives at now should be dropped */
+RK_S32  mpp_enc_drop_check(MppEncDrop *drop, MppEncRcCfg *rc, RK_S64 now,
+                           RK_S32 eos, RK_S32 *delay_ms);
+/* update average encoding time with the time of one frame */
+void    mpp_enc_drop_update(MppEncDrop *drop, RK_S64 time);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /*__MPP_ENC_DROP_H__*/
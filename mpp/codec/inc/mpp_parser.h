@@ -36,6 +36,9 @@ MPP_RET mpp_parser_flush(Parser prs);
 MPP_RET mpp_parser_control(Parser prs, MpiCmd cmd, void *para);
 MPP_RET mpp_hal_callback(void* prs, void *err_info);
 
+MPP_RET mpp_parser_probe(MppCodingType coding, RK_U8 *data, RK_S32 size,
+                         MppDecStreamInfo *info);
+
 #ifdef __cplusplus
 }
 #endif
@@ -75,6 +75,19 @@ typedef struct linear_model_s {
     RK_S32 *r;          /* r */
     RK_S64 *y;          /* y = x * x * r */
     RK_S32 weight_mode; /* different weight ratio*/
+
+    /*
+     * weighted running sums over the whole window, updated on each save
+     * the sample of age k has weight ratio^k so the sums only need to be
+     * scaled by ratio before adding new sample
+     */
+    double ratio;       /* weight decay ratio of weight_mode */
+    double ratio_n;     /* weight of the sample evicted from the window */
+    double sum_w;
+    double sum_x;
+    double sum_y;
+    double sum_xy;
+    double sum_xx;
 } MppLinReg;
 
 /* Virtual buffer */
@@ -222,6 +235,12 @@ typedef struct MppRateControl_s {
     RK_S32 prev_aq_prop_offset;
     RK_S32 quality;
 
+    /* average input complexity from pre-analysis in Q8, 0 for unknown */
+    RK_S32 complexity_avg;
+
+    /* preallocated record node ring for MPP_RC_DBG_RECORD */
+    struct RecordNode_t *rec_nodes;
+    RK_S32 rec_idx;
 } MppRateControl;
 
 /*
@@ -241,6 +260,10 @@ typedef struct RcSyntax_s {
 
     /* head node of rc parameter list */
     struct list_head *rc_head;
+
+    /* input pre-analysis hint, complexity is Q8 luma mad and 0 for unknown */
+    RK_S32           scene_cut;
+    RK_S32           complexity;
 } RcSyntax;
 
 /*
@@ -17,7 +17,7 @@
 #ifndef __PARSER_API_H__
 #define __PARSER_API_H__
 
-#include "rk_mpi_cmd.h"
+#include "rk_mpi.h"
 #include "mpp_packet.h"
 #include "mpp_buf_slot.h"
 #include "hal_task.h"
@@ -56,6 +56,7 @@ typedef struct DecParserInitCfg_t {
  * reset    - decoder reset function
  * flush    - decoder output all frames
  * control  - decoder configure function
+ * probe    - stateless sequence header parsing for stream information, optional
  */
 typedef struct ParserApi_t {
     char            *name;
@@ -73,6 +74,8 @@ typedef struct ParserApi_t {
     MPP_RET (*flush)(void *ctx);
     MPP_RET (*control)(void *ctx, MpiCmd cmd, void *param);
     MPP_RET (*callback)(void *ctx, void *err_info);
+
+    MPP_RET (*probe)(RK_U8 *data, RK_S32 size, MppDecStreamInfo *info);
 } ParserApi;
 
 
@@ -28,6 +28,7 @@
 #include "mpp_buffer_impl.h"
 #include "mpp_packet_impl.h"
 #include "mpp_frame_impl.h"
+#include "mpp_dec_skip.h"
 
 #include "mpp_dec_vproc.h"
 
@@ -49,6 +50,10 @@ static RK_U32 mpp_dec_debug = 0;
 #define dec_dbg_reset(fmt, ...)         mpp_dec_dbg(MPP_DEC_DBG_RESET, fmt, ## __VA_ARGS__)
 #define dec_dbg_notify(fmt, ...)        mpp_dec_dbg_f(MPP_DEC_DBG_NOTIFY, fmt, ## __VA_ARGS__)
 
+/* hal task count range for MPP_DEC_SET_TASK_COUNT */
+#define MPP_DEC_TASK_COUNT_MIN          2
+#define MPP_DEC_TASK_COUNT_MAX          16
+
 typedef union PaserTaskWait_u {
     RK_U32          val;
     struct {
@@ -289,14 +294,15 @@ static void mpp_dec_put_frame(Mpp *mpp, RK_S32 index, HalDecTaskFlag flags)
         mpp_assert(!change);
 
         if (dec->vproc) {
-            HalTaskGroup group = dec->vproc_tasks;
             HalTaskHnd hnd = NULL;
             HalTaskInfo task;
             HalDecVprocTask *vproc_task = &task.dec_vproc;
 
-            MPP_RET ret = hal_task_get_hnd(group, TASK_IDLE, &hnd);
-
-            mpp_assert(ret == MPP_OK);
+            MPP_RET ret = dec_vproc_get_task(dec->vproc, &hnd);
+            if (ret) {
+                mpp_err_f("failed to get vproc task for eos\n");
+                return ;
+            }
 
             vproc_task->flags.val = 0;
             vproc_task->flags.eos = eos;
@@ -350,20 +356,14 @@ static void mpp_dec_put_frame(Mpp *mpp, RK_S32 index, HalDecTaskFlag flags)
     }
 
     if (dec->vproc) {
-        HalTaskGroup group = dec->vproc_tasks;
         HalTaskHnd hnd = NULL;
         HalTaskInfo task;
         HalDecVprocTask *vproc_task = &task.dec_vproc;
-        MPP_RET ret = MPP_OK;
-
-        do {
-            ret = hal_task_get_hnd(group, TASK_IDLE, &hnd);
-            if (ret) {
-                msleep(10);
-            }
-        } while (ret);
-
-        mpp_assert(ret == MPP_OK);
+        MPP_RET ret = dec_vproc_get_task(dec->vproc, &hnd);
+        if (ret) {
+            mpp_err_f("failed to get vproc task\n");
+            return ;
+        }
 
         vproc_task->flags.eos = eos;
         vproc_task->flags.info_change = change;
@@ -1271,6 +1271,13 @@ MPP_RET mpp_dec_init(MppDec *dec, MppDecCfg *cfg)
 
     coding = cfg->coding;
     hal_task_count = (cfg->fast_mode) ? (3) : (2);
+    if (cfg->task_count) {
+        hal_task_count = MPP_CLIP3(MPP_DEC_TASK_COUNT_MIN, MPP_DEC_TASK_COUNT_MAX,
+                                   (RK_S32)cfg->task_count);
+        if (hal_task_count != (RK_S32)cfg->task_count)
+            mpp_log_f("task count %d is clipped to %d\n",
+                      cfg->task_count, hal_task_count);
+    }
 
     do {
         ret = mpp_buf_slot_init(&frame_slots);
@@ -1316,6 +1323,8 @@ MPP_RET mpp_dec_init(MppDec *dec, MppDecCfg *cfg)
             parser_cfg.task_count,
             cfg->fast_mode,
             cb,
+            (cfg->mpp) ? (((Mpp *)cfg->mpp)->mSched) : (NULL),
+            (cfg->mpp) ? (((Mpp *)cfg->mpp)->mDevStat) : (NULL),
         };
 
         ret = mpp_hal_init(&hal, &hal_cfg);
@@ -1553,6 +1562,52 @@ MPP_RET mpp_dec_control(MppDec ctx, MpiCmd cmd, void *param)
         mpp_err_f("found NULL input dec %p\n", dec);
         return MPP_ERR_NULL_PTR;
     }
+
+    if (cmd == MPP_DEC_SET_OUTPUT_SCALE) {
+        RK_U32 scale = (param) ? (*((RK_U32 *)param)) : (0);
+
+        if (scale != 1 && scale != 2 && scale != 4 && scale != 8) {
+            mpp_err_f("invalid output scale %d\n", scale);
+            return MPP_ERR_VALUE;
+        }
+
+        /*
+         * NOTE: only jpeg hal drives post-processor in pipeline mode.
+         * Other codecs need full size frame as reference so the decoded
+         * frame can not be replaced by the downscaled one.
+         */
+        if (dec->coding != MPP_VIDEO_CodingMJPEG && scale > 1) {
+            mpp_err_f("output scale is not supported on coding %x\n", dec->coding);
+            return MPP_NOK;
+        }
+    }
+
+    if (cmd == MPP_DEC_SET_SKIP_MODE) {
+        MppDecSkipCfg *cfg = (MppDecSkipCfg *)param;
+
+        ret = mpp_dec_skip_cfg_check(cfg);
+        if (ret)
+            return ret;
+
+        /* NOTE: skip is done in parser which knows the frame type */
+        switch (dec->coding) {
+        case MPP_VIDEO_CodingAVC :
+        case MPP_VIDEO_CodingHEVC :
+        case MPP_VIDEO_CodingVP9 :
+        case MPP_VIDEO_CodingVP8 :
+        case MPP_VIDEO_CodingMPEG2 :
+        case MPP_VIDEO_CodingMPEG4 : {
+        } break;
+        default : {
+            if (cfg->mode != MPP_DEC_SKIP_NONE) {
+                mpp_err_f("skip mode is not supported on coding %x\n", dec->coding);
+                return MPP_NOK;
+            }
+        } break;
+        }
+        dec_dbg_func("skip mode %d interval %d\n", cfg->mode, cfg->interval);
+    }
+
     mpp_parser_control(dec->parser, cmd, param);
     mpp_hal_control(dec->hal, cmd, param);
 
@@ -1589,6 +1644,10 @@ MPP_RET mpp_dec_control(MppDec ctx, MpiCmd cmd, void *param)
         dec->enable_deinterlace = (param) ? (*((RK_U32 *)param)) : (1);
         dec_dbg_func("enable deinterlace %d\n", dec->enable_deinterlace);
     } break;
+    case MPP_DEC_SET_OUTPUT_SCALE: {
+        mpp_slots_set_prop(dec->frame_slots, SLOTS_OUTPUT_SCALE, param);
+        dec_dbg_func("output scale %d\n", *((RK_U32 *)param));
+    } break;
     default : {
     } break;
     }
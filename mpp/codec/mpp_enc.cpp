@@ -21,11 +21,14 @@
 #include "mpp_env.h"
 #include "mpp_log.h"
 #include "mpp_mem.h"
+#include "mpp_time.h"
 
 #include "mpp_packet_impl.h"
 
 #include "mpp.h"
 #include "mpp_enc_impl.h"
+#include "mpp_enc_analysis.h"
+#include "mpp_enc_drop.h"
 #include "mpp_hal.h"
 #include "hal_h264e_api.h"
 
@@ -35,9 +38,18 @@
 #define MPP_ENC_DBG_DETAIL              (0x00000020)
 #define MPP_ENC_DBG_RESET               (0x00000040)
 #define MPP_ENC_DBG_NOTIFY              (0x00000080)
+#define MPP_ENC_DBG_DROP                (0x00000100)
+#define MPP_ENC_DBG_PRE                 (0x00000200)
 
 RK_U32 mpp_enc_debug = 0;
 
+/* max frames sent to hardware in one batch */
+#define MPP_ENC_BATCH_MAX               8
+/* one batch on hardware and one batch waiting for output */
+#define MPP_ENC_SLOT_MAX                (MPP_ENC_BATCH_MAX * 2)
+/* slice output poll interval in ms for checking stop and reset */
+#define MPP_ENC_SLICE_POLL_MS           10
+
 #define mpp_enc_dbg(flag, fmt, ...)     _mpp_dbg(mpp_enc_debug, flag, fmt, ## __VA_ARGS__)
 #define mpp_enc_dbg_f(flag, fmt, ...)   _mpp_dbg_f(mpp_enc_debug, flag, fmt, ## __VA_ARGS__)
 
@@ -46,6 +58,17 @@ RK_U32 mpp_enc_debug = 0;
 #define enc_dbg_status(fmt, ...)        mpp_enc_dbg_f(MPP_ENC_DBG_STATUS, fmt, ## __VA_ARGS__)
 #define enc_dbg_detail(fmt, ...)        mpp_enc_dbg_f(MPP_ENC_DBG_DETAIL, fmt, ## __VA_ARGS__)
 #define enc_dbg_notify(fmt, ...)        mpp_enc_dbg_f(MPP_ENC_DBG_NOTIFY, fmt, ## __VA_ARGS__)
+#define enc_dbg_drop(fmt, ...)          mpp_enc_dbg_f(MPP_ENC_DBG_DROP, fmt, ## __VA_ARGS__)
+#define enc_dbg_pre(fmt, ...)           mpp_enc_dbg_f(MPP_ENC_DBG_PRE, fmt, ## __VA_ARGS__)
+
+typedef struct EncBatchSlot_t {
+    HalTaskInfo         info;
+    MppPacket           packet;
+    MppBuffer           mv_info;
+    /* input buffer is held until hardware finishes this frame */
+    MppBuffer           input;
+    RK_U32              hw_wait;
+} EncBatchSlot;
 
 typedef struct MppEncImpl_t {
     MppCodingType       coding;
@@ -73,6 +96,38 @@ typedef struct MppEncImpl_t {
     /* Encoder configure set */
     MppEncCfgSet        cfg;
     MppEncCfgSet        set;
+
+    /*
+     * Hardware task batch
+     * batch     - frames per batch set by MPP_ENC_SET_TASK_BATCH
+     * batch_cur - frames per batch used by current batch
+     * slots     - ring of started frames in output order
+     * hw_count  - started frames waiting for hardware result
+     * hw_sent   - started frames have been sent to hardware
+     */
+    RK_S32              batch;
+    RK_S32              batch_cur;
+    EncBatchSlot        slots[MPP_ENC_SLOT_MAX];
+    RK_S32              slot_rd;
+    RK_S32              slot_count;
+    RK_S32              hw_count;
+    RK_S32              hw_sent;
+    RK_S64              hw_time;
+
+    /* input frame drop on overload */
+    MppEncDrop          drop;
+
+    /*
+     * Input pre-analysis
+     * pre_enable   - set by MPP_ENC_SET_PRE_ANALYSIS
+     * pre_task     - input task taken early so its analysis runs while the
+     *                previous frames are on hardware
+     * pre_started  - analysis of pre_task frame is running
+     */
+    RK_S32              pre_enable;
+    MppEncAnalysis      analysis;
+    MppTask             pre_task;
+    RK_S32              pre_started;
 } MppEncImpl;
 
 typedef union EncTaskWait_u {
@@ -83,7 +138,7 @@ typedef union EncTaskWait_u {
         RK_U32      reserv0004      : 1;   // 0x0004
         RK_U32      enc_pkt_out     : 1;   // 0x0008 MPP_ENC_NOTIFY_PACKET_ENQUEUE
 
-        RK_U32      reserv0010      : 1;   // 0x0010
+        RK_U32      enc_pre_done    : 1;   // 0x0010 MPP_ENC_NOTIFY_PRE_DONE
         RK_U32      reserv0020      : 1;   // 0x0020
         RK_U32      reserv0040      : 1;   // 0x0040
         RK_U32      reserv0080      : 1;   // 0x0080
@@ -188,6 +243,476 @@ static MPP_RET check_enc_task_wait(MppEncImpl *enc, EncTask *task)
     return ret;
 }
 
+static RK_S32 mpp_enc_check_drop(MppEncImpl *enc, MppFrame frame, RK_S32 *delay_ms)
+{
+    RK_S32 drop = mpp_enc_drop_check(&enc->drop, &enc->cfg.rc, mpp_time(),
+                                     mpp_frame_get_eos(frame), delay_ms);
+
+    enc_dbg_drop("delay %d ms enc %lld us count %d -> %s\n", *delay_ms,
+                 enc->drop.enc, enc->drop.count, (drop) ? ("drop") : ("encode"));
+
+    return drop;
+}
+
+static MppPacket mpp_enc_drop_packet(MppFrame frame, MppPacket packet,
+                                     RK_S32 delay_ms)
+{
+    if (NULL == packet)
+        mpp_packet_new(&packet);
+    else
+        mpp_packet_set_length(packet, 0);
+
+    mpp_packet_set_pts(packet, mpp_frame_get_pts(frame));
+    mpp_meta_set_s32(mpp_packet_get_meta(packet), KEY_ENC_FRAME_DROP, delay_ms);
+
+    return packet;
+}
+
+/* Return 1 when pre-analysis is enabled and can run on the frame */
+static RK_S32 mpp_enc_pre_check(MppEncImpl *enc, MppFrame frame)
+{
+    if (!enc->pre_enable || NULL == frame || NULL == mpp_frame_get_buffer(frame))
+        return 0;
+
+    if (NULL == enc->analysis) {
+        if (mpp_enc_analysis_init(&enc->analysis, enc)) {
+            mpp_err_f("failed to init pre-analysis\n");
+            return 0;
+        }
+    }
+
+    return 1;
+}
+
+/*
+ * Start pre-analysis of the input frame on worker thread.
+ * Return 1 when the analysis is started.
+ */
+static RK_S32 mpp_enc_pre_start(MppEncImpl *enc, MppFrame frame)
+{
+    if (!mpp_enc_pre_check(enc, frame))
+        return 0;
+
+    mpp_enc_analysis_start(enc->analysis, frame, &enc->cfg.prep);
+    enc->pre_started = 1;
+    return 1;
+}
+
+/*
+ * Apply pre-analysis result as hint for rate control. Scene cut is encoded
+ * as idr frame through the same path as MPP_ENC_SET_IDR_FRAME.
+ */
+static void mpp_enc_pre_apply(MppEncImpl *enc, HalEncTask *hal_task,
+                              EncAnalysisResult *result)
+{
+    if (!result->valid)
+        return;
+
+    enc_dbg_pre("complexity %d sad %d scene cut %d\n",
+                result->complexity, result->sad, result->scene_cut);
+
+    hal_task->scene_cut = result->scene_cut;
+    hal_task->complexity = result->complexity;
+
+    if (result->scene_cut) {
+        AutoMutex auto_lock(&enc->lock);
+        enc_impl_proc_cfg(enc->impl, MPP_ENC_SET_IDR_FRAME, NULL);
+    }
+}
+
+/*
+ * Collect pre-analysis result started on worker thread.
+ * Return 1 when there was a started analysis.
+ */
+static RK_S32 mpp_enc_pre_finish(MppEncImpl *enc, HalEncTask *hal_task)
+{
+    EncAnalysisResult result;
+
+    if (!enc->pre_started)
+        return 0;
+
+    enc->pre_started = 0;
+    mpp_enc_analysis_wait(enc->analysis, &result);
+    mpp_enc_pre_apply(enc, hal_task, &result);
+    return 1;
+}
+
+/*
+ * Run pre-analysis on encoder thread when there is no hardware task to
+ * overlap with. Handing it to worker thread only adds a thread switch.
+ */
+static void mpp_enc_pre_proc(MppEncImpl *enc, HalEncTask *hal_task, MppFrame frame)
+{
+    EncAnalysisResult result;
+
+    if (!mpp_enc_pre_check(enc, frame))
+        return;
+
+    mpp_enc_analysis_proc(enc->analysis, frame, &enc->cfg.prep, &result);
+    mpp_enc_pre_apply(enc, hal_task, &result);
+}
+
+/*
+ * Take the next input task and start its pre-analysis so that it overlaps
+ * with the frames on hardware.
+ */
+static void mpp_enc_pre_fetch(MppEncImpl *enc, MppPort input)
+{
+    MppFrame frame = NULL;
+
+    if (!enc->pre_enable || enc->pre_task ||
+        mpp_port_poll(input, MPP_POLL_NON_BLOCK))
+        return;
+
+    mpp_port_dequeue(input, &enc->pre_task);
+    if (NULL == enc->pre_task)
+        return;
+
+    mpp_task_meta_get_frame(enc->pre_task, KEY_INPUT_FRAME, &frame);
+    mpp_enc_pre_start(enc, frame);
+}
+
+static void mpp_enc_output_packet(MppPort output, MppPacket packet,
+                                  MppBuffer mv_info, RK_S32 is_intra)
+{
+    MppTask task_out = NULL;
+
+    // send finished task to output port
+    mpp_port_dequeue(output, &task_out);
+
+    /*
+     * task_in may be null if output port is awaken by Mpp::clear()
+     */
+    if (task_out) {
+        //set motion info buffer to output task
+        if (mv_info)
+            mpp_task_meta_set_buffer(task_out, KEY_MOTION_INFO, mv_info);
+
+        mpp_task_meta_set_packet(task_out, KEY_OUTPUT_PACKET, packet);
+
+        {
+            RK_U32 flag = mpp_packet_get_flag(packet);
+
+            mpp_task_meta_set_s32(task_out, KEY_OUTPUT_INTRA, is_intra);
+            if (is_intra) {
+                mpp_packet_set_flag(packet, flag | MPP_PACKET_FLAG_INTRA);
+            }
+        }
+
+        // setup output task here
+        mpp_port_enqueue(output, task_out);
+    } else {
+        mpp_packet_deinit(&packet);
+    }
+}
+
+/*
+ * Low delay slice output
+ * Each slice of the frame is sent in its own packet which shares the buffer
+ * of the frame packet. Output port has only one task so each slice waits
+ * for user to take the previous one. The frame packet is released here.
+ *
+ * NOTE: current hardware has no slice done interrupt so all slices are ready
+ * after hw_wait. User still can start transmission on the first slice while
+ * the remaining slices are being collected.
+ */
+static void mpp_enc_output_slices(MppEncImpl *enc, MppPort output, MppPacket packet,
+                                  MppBuffer mv_info, HalEncTask *hal_task)
+{
+    MppThread *thd = enc->thread_enc;
+    MppBuffer buffer = mpp_packet_get_buffer(packet);
+    RK_U8 *base = (RK_U8 *)mpp_packet_get_data(packet);
+    RK_S64 pts = mpp_packet_get_pts(packet);
+    RK_U32 eos = mpp_packet_get_eos(packet);
+    size_t offset = 0;
+    RK_S32 i;
+
+    for (i = 0; i < hal_task->slice_num; i++) {
+        RK_U32 last = (i == hal_task->slice_num - 1);
+        RK_U32 flag = MPP_PACKET_FLAG_PARTITION;
+        RK_U32 len = hal_task->slice_len[i];
+        MppPacket slice = NULL;
+
+        while (mpp_port_poll(output, (MppPollType)MPP_ENC_SLICE_POLL_MS)) {
+            if (MPP_THREAD_RUNNING != thd->get_status() || enc->reset_flag) {
+                enc_dbg_detail("drop %d slices on stop\n", hal_task->slice_num - i);
+                goto DONE;
+            }
+        }
+
+        mpp_packet_init(&slice, base + offset, len);
+        mpp_packet_set_buffer(slice, buffer);
+        mpp_packet_set_pts(slice, pts);
+
+        if (last) {
+            flag |= MPP_PACKET_FLAG_EOI;
+            if (eos)
+                flag |= MPP_PACKET_FLAG_EOS;
+        }
+        mpp_packet_set_flag(slice, flag);
+
+        enc_dbg_detail("slice %d offset %d size %d\n", i, offset, len);
+
+        /* motion info belongs to the whole frame and goes with the last slice */
+        mpp_enc_output_packet(output, slice, last ? mv_info : NULL,
+                              hal_task->is_intra);
+        offset += len;
+    }
+
+DONE:
+    mpp_packet_deinit(&packet);
+}
+
+/*
+ * collect the result of all started frames in output order
+ */
+static void mpp_enc_wait_batch(MppEncImpl *enc)
+{
+    RK_S32 i;
+
+    for (i = 0; i < enc->slot_count; i++) {
+        EncBatchSlot *slot = &enc->slots[(enc->slot_rd + i) % MPP_ENC_SLOT_MAX];
+        HalEncTask *hal_task = &slot->info.enc;
+
+        if (!slot->hw_wait)
+            continue;
+
+        enc_dbg_detail("mpp_hal_hw_wait  hal %p task %p\n", enc->hal, &slot->info);
+        if (mpp_hal_hw_wait(enc->hal, &slot->info))
+            mpp_err("mpp %p hal_hw_wait failed", enc->mpp);
+
+        mpp_packet_set_length(slot->packet, hal_task->length);
+        mpp_buffer_put(slot->input);
+        slot->input = NULL;
+        slot->hw_wait = 0;
+    }
+
+    if (enc->hw_count)
+        mpp_enc_drop_update(&enc->drop, (mpp_time() - enc->hw_time) / enc->hw_count);
+
+    enc->hw_count = 0;
+    enc->hw_sent = 0;
+}
+
+/*
+ * finish all started frames and drop the packets not output yet
+ */
+static void mpp_enc_clear_batch(MppEncImpl *enc)
+{
+    if (enc->pre_task) {
+        Mpp *mpp = (Mpp *)enc->mpp;
+        MppPort input = mpp_task_queue_get_port(mpp->mInputTaskQueue, MPP_PORT_OUTPUT);
+
+        if (enc->pre_started) {
+            mpp_enc_analysis_wait(enc->analysis, NULL);
+            enc->pre_started = 0;
+        }
+
+        mpp_port_enqueue(input, enc->pre_task);
+        enc->pre_task = NULL;
+    }
+
+    if (enc->hw_count && !enc->hw_sent)
+        mpp_hal_flush(enc->hal);
+
+    mpp_enc_wait_batch(enc);
+
+    while (enc->slot_count) {
+        EncBatchSlot *slot = &enc->slots[enc->slot_rd];
+
+        mpp_packet_deinit(&slot->packet);
+        enc->slot_rd = (enc->slot_rd + 1) % MPP_ENC_SLOT_MAX;
+        enc->slot_count--;
+    }
+}
+
+/*
+ * Start one input frame on hardware without waiting for its result.
+ * The input task is returned to user once the frame is started so the user
+ * can queue the next frame. Hardware will run when the batch is full or when
+ * eos or an empty frame is met.
+ */
+static void mpp_enc_start_slot(Mpp *mpp, MppPort input, MppTask task_in)
+{
+    MppEncImpl *enc = (MppEncImpl *)mpp->mEnc;
+    MppHal hal = enc->hal;
+    MppFrame frame = NULL;
+    MppPacket packet = NULL;
+    MppBuffer mv_info = NULL;
+    EncBatchSlot *slot = NULL;
+    HalTaskInfo *task_info = NULL;
+    HalEncTask *hal_task = NULL;
+    MPP_RET ret = MPP_OK;
+    RK_S32 delay = 0;
+
+    mpp_task_meta_get_frame (task_in, KEY_INPUT_FRAME,  &frame);
+    mpp_task_meta_get_packet(task_in, KEY_OUTPUT_PACKET, &packet);
+    mpp_task_meta_get_buffer(task_in, KEY_MOTION_INFO, &mv_info);
+
+    if (NULL == frame) {
+        mpp_port_enqueue(input, task_in);
+        return;
+    }
+
+    slot = &enc->slots[(enc->slot_rd + enc->slot_count) % MPP_ENC_SLOT_MAX];
+    task_info = &slot->info;
+    hal_task = &task_info->enc;
+    reset_hal_enc_task(hal_task);
+    mpp_enc_pre_finish(enc, hal_task);
+
+    if (mpp_frame_get_buffer(frame) && mpp_enc_check_drop(enc, frame, &delay)) {
+        packet = mpp_enc_drop_packet(frame, packet, delay);
+    } else if (mpp_frame_get_buffer(frame)) {
+        if (NULL == packet) {
+            RK_U32 width  = enc->cfg.prep.width;
+            RK_U32 height = enc->cfg.prep.height;
+            RK_U32 size = width * height;
+            MppBuffer buffer = NULL;
+
+            mpp_assert(size);
+            mpp_buffer_get(mpp->mPacketGroup, &buffer, size);
+            mpp_packet_init_with_buffer(&packet, buffer);
+            mpp_buffer_put(buffer);
+        }
+        mpp_assert(packet);
+
+        mpp_packet_set_pts(packet, mpp_frame_get_pts(frame));
+
+        hal_task->frame  = frame;
+        hal_task->input  = mpp_frame_get_buffer(frame);
+        hal_task->packet = packet;
+        hal_task->output = mpp_packet_get_buffer(packet);
+        hal_task->mv_info = mv_info;
+
+        {
+            /* batch size can only be changed on the first frame of a batch */
+            AutoMutex auto_lock(&enc->lock);
+            if (!enc->hw_count) {
+                enc->batch_cur = enc->batch;
+                enc->hw_time = mpp_time();
+            }
+
+            ret = enc_impl_proc_hal(enc->impl, hal_task);
+            if (ret)
+                mpp_err("mpp %p enc_impl_proc_hal failed return %d", mpp, ret);
+
+            if (!ret) {
+                enc_dbg_detail("mpp_hal_reg_gen  hal %p task %p\n", hal, task_info);
+                ret = mpp_hal_reg_gen(hal, task_info);
+                if (ret)
+                    mpp_err("mpp %p hal_reg_gen failed return %d", mpp, ret);
+            }
+        }
+
+        if (!ret) {
+            enc_dbg_detail("mpp_hal_hw_start hal %p task %p\n", hal, task_info);
+            ret = mpp_hal_hw_start(hal, task_info);
+            if (ret) {
+                /* the whole batch is dropped by hal on send failure */
+                mpp_err("mpp %p hal_hw_start failed return %d", mpp, ret);
+                enc->hw_sent = 1;
+            }
+
+            slot->input = hal_task->input;
+            mpp_buffer_inc_ref(slot->input);
+            slot->hw_wait = 1;
+            enc->hw_count++;
+        } else {
+            mpp_packet_set_length(packet, hal_task->length);
+        }
+
+        /* input frame is returned to user before hardware finishes */
+        hal_task->frame = NULL;
+    } else {
+        mpp_packet_new(&packet);
+    }
+
+    if (mpp_frame_get_eos(frame))
+        mpp_packet_set_eos(packet);
+
+    slot->packet = packet;
+    slot->mv_info = mv_info;
+    enc->slot_count++;
+
+    if (enc->hw_count && !enc->hw_sent &&
+        (enc->hw_count >= enc->batch_cur || !slot->hw_wait ||
+         mpp_frame_get_eos(frame))) {
+        ret = mpp_hal_flush(hal);
+        if (ret)
+            mpp_err("mpp %p hal_flush failed return %d", mpp, ret);
+        enc->hw_sent = 1;
+    }
+
+    mpp_task_meta_set_frame(task_in, KEY_INPUT_FRAME, frame);
+    mpp_port_enqueue(input, task_in);
+}
+
+static void mpp_enc_proc_batch(Mpp *mpp, EncTask *task)
+{
+    MppEncImpl *enc = (MppEncImpl *)mpp->mEnc;
+    MppPort input  = mpp_task_queue_get_port(mpp->mInputTaskQueue,  MPP_PORT_OUTPUT);
+    MppPort output = mpp_task_queue_get_port(mpp->mOutputTaskQueue, MPP_PORT_INPUT);
+
+    /* only wait when there is no progress on both input and output */
+    task->status.val = 0;
+    task->wait.val = 0;
+
+    // 1. output finished packet in order
+    if (enc->slot_count) {
+        EncBatchSlot *slot = &enc->slots[enc->slot_rd];
+
+        if (!slot->hw_wait) {
+            if (!mpp_port_poll(output, MPP_POLL_NON_BLOCK)) {
+                mpp_enc_output_packet(output, slot->packet, slot->mv_info,
+                                      slot->info.enc.is_intra);
+                slot->packet = NULL;
+                slot->mv_info = NULL;
+                enc->slot_rd = (enc->slot_rd + 1) % MPP_ENC_SLOT_MAX;
+                enc->slot_count--;
+                return;
+            }
+            task->wait.enc_pkt_out = 1;
+        }
+    }
+
+    // 2. collect hardware result after the batch is sent
+    if (enc->hw_count && enc->hw_sent) {
+        mpp_enc_pre_fetch(enc, input);
+        mpp_enc_wait_batch(enc);
+        task->wait.val = 0;
+        return;
+    }
+
+    // 3. start next frame when there is free slot
+    if (enc->slot_count >= MPP_ENC_SLOT_MAX)
+        return;
+
+    if (NULL == enc->pre_task) {
+        MppFrame frame = NULL;
+
+        if (mpp_port_poll(input, MPP_POLL_NON_BLOCK)) {
+            task->wait.enc_frm_in = 1;
+            return;
+        }
+
+        mpp_port_dequeue(input, &enc->pre_task);
+        mpp_assert(enc->pre_task);
+        task->wait.val = 0;
+
+        /* analysis runs while the previous batch is still on hardware */
+        mpp_task_meta_get_frame(enc->pre_task, KEY_INPUT_FRAME, &frame);
+        if (mpp_enc_pre_start(enc, frame))
+            return;
+    } else if (enc->pre_started && !mpp_enc_analysis_done(enc->analysis)) {
+        task->wait.enc_pre_done = 1;
+        return;
+    }
+
+    mpp_enc_start_slot(mpp, input, enc->pre_task);
+    enc->pre_task = NULL;
+    task->wait.val = 0;
+}
+
 void *mpp_enc_control_thread(void *data)
 {
     Mpp *mpp = (Mpp*)data;
@@ -200,11 +725,13 @@ void *mpp_enc_control_thread(void *data)
     MppPort input  = mpp_task_queue_get_port(mpp->mInputTaskQueue,  MPP_PORT_OUTPUT);
     MppPort output = mpp_task_queue_get_port(mpp->mOutputTaskQueue, MPP_PORT_INPUT);
     MppTask task_in = NULL;
-    MppTask task_out = NULL;
     MPP_RET ret = MPP_OK;
     MppFrame frame = NULL;
     MppPacket packet = NULL;
     MppBuffer mv_info = NULL;
+    RK_S32 delay = 0;
+    RK_U32 pkt_internal = 0;
+    RK_S32 pre_done = 0;
 
     memset(&task, 0, sizeof(task));
 
@@ -224,15 +751,25 @@ void *mpp_enc_control_thread(void *data)
                 enc->status_flag = 0;
             }
 
+            mpp_enc_clear_batch(enc);
+            mpp_enc_drop_reset(&enc->drop);
+            if (enc->analysis)
+                mpp_enc_analysis_reset(enc->analysis);
+
             AutoMutex autolock(thd_enc->mutex(THREAD_CONTROL));
             enc->reset_flag = 0;
             sem_post(&enc->enc_reset);
             continue;
         }
 
-        // 1. check task in
+        if (enc->batch > 1 || enc->slot_count) {
+            mpp_enc_proc_batch(mpp, &task);
+            continue;
+        }
+
+        // 1. check task in, prefetched task is ready
         if (!task.status.task_in_rdy) {
-            ret = mpp_port_poll(input, MPP_POLL_NON_BLOCK);
+            ret = (enc->pre_task) ? MPP_OK : mpp_port_poll(input, MPP_POLL_NON_BLOCK);
             if (ret) {
                 task.wait.enc_frm_in = 1;
                 continue;
@@ -256,7 +793,11 @@ void *mpp_enc_control_thread(void *data)
         }
         enc_dbg_detail("task out ready\n");
 
-        ret = mpp_port_dequeue(input, &task_in);
+        if (enc->pre_task) {
+            task_in = enc->pre_task;
+            enc->pre_task = NULL;
+        } else
+            ret = mpp_port_dequeue(input, &task_in);
         mpp_assert(task_in);
 
         mpp_task_meta_get_frame (task_in, KEY_INPUT_FRAME,  &frame);
@@ -270,10 +811,23 @@ void *mpp_enc_control_thread(void *data)
 
         reset_hal_enc_task(hal_task);
 
-        if (mpp_frame_get_buffer(frame)) {
+        /* analysis of prefetched frame is collected even when it is dropped */
+        pre_done = mpp_enc_pre_finish(enc, hal_task);
+
+        if (mpp_frame_get_buffer(frame) && mpp_enc_check_drop(enc, frame, &delay)) {
+            /*
+             * if encoder can not catch up real-time drop the input frame
+             */
+            packet = mpp_enc_drop_packet(frame, packet, delay);
+        } else if (mpp_frame_get_buffer(frame)) {
             /*
              * if there is available buffer in the input frame do encoding
              */
+            RK_S64 time_start = mpp_time();
+
+            if (!pre_done)
+                mpp_enc_pre_proc(enc, hal_task, frame);
+
             if (NULL == packet) {
                 RK_U32 width  = enc->cfg.prep.width;
                 RK_U32 height = enc->cfg.prep.height;
@@ -284,6 +838,7 @@ void *mpp_enc_control_thread(void *data)
                 mpp_buffer_get(mpp->mPacketGroup, &buffer, size);
                 mpp_packet_init_with_buffer(&packet, buffer);
                 mpp_buffer_put(buffer);
+                pkt_internal = 1;
             }
             mpp_assert(packet);
 
@@ -316,6 +871,10 @@ void *mpp_enc_control_thread(void *data)
                 mpp_err("mpp %p hal_hw_start failed return %d", mpp, ret);
                 goto TASK_END;
             }
+
+            /* next input frame is analysed while hardware is running */
+            mpp_enc_pre_fetch(enc, input);
+
             enc_dbg_detail("mpp_hal_hw_wait  hal %p task %p\n", hal, task_info);
             ret = mpp_hal_hw_wait(hal, task_info);
             if (ret) {
@@ -324,6 +883,7 @@ void *mpp_enc_control_thread(void *data)
             }
         TASK_END:
             mpp_packet_set_length(packet, hal_task->length);
+            mpp_enc_drop_update(&enc->drop, mpp_time() - time_start);
         } else {
             /*
              * else init a empty packet for output
@@ -342,43 +902,27 @@ void *mpp_enc_control_thread(void *data)
         mpp_task_meta_set_frame(task_in, KEY_INPUT_FRAME, frame);
         mpp_port_enqueue(input, task_in);
 
-        // send finished task to output port
-        ret = mpp_port_dequeue(output, &task_out);
-
-        /*
-         * task_in may be null if output port is awaken by Mpp::clear()
-         */
-        if (task_out) {
-            //set motion info buffer to output task
-            if (mv_info)
-                mpp_task_meta_set_buffer(task_out, KEY_MOTION_INFO, mv_info);
-
-            mpp_task_meta_set_packet(task_out, KEY_OUTPUT_PACKET, packet);
-
-            {
-                RK_S32 is_intra = hal_task->is_intra;
-                RK_U32 flag = mpp_packet_get_flag(packet);
-
-                mpp_task_meta_set_s32(task_out, KEY_OUTPUT_INTRA, is_intra);
-                if (is_intra) {
-                    mpp_packet_set_flag(packet, flag | MPP_PACKET_FLAG_INTRA);
-                }
-            }
-
-            // setup output task here
-            mpp_port_enqueue(output, task_out);
-        } else {
-            mpp_packet_deinit(&packet);
-        }
+        /* user provided packet is always returned as a whole frame */
+        if (pkt_internal && enc->cfg.misc.split.split_out && hal_task->slice_num > 1)
+            mpp_enc_output_slices(enc, output, packet, mv_info, hal_task);
+        else
+            mpp_enc_output_packet(output, packet, mv_info, hal_task->is_intra);
 
         task_in = NULL;
-        task_out = NULL;
         packet = NULL;
         frame = NULL;
+        pkt_internal = 0;
 
         task.status.val = 0;
     }
 
+    mpp_enc_clear_batch(enc);
+
+    if (enc->analysis) {
+        mpp_enc_analysis_deinit(enc->analysis);
+        enc->analysis = NULL;
+    }
+
     // clear remain task in output port
     release_task_in_port(input);
     release_task_in_port(mpp->mOutputPort);
@@ -456,6 +1000,8 @@ MPP_RET mpp_enc_init(MppEnc *enc, MppEncCfg *cfg)
             1/*ctrl_cfg.task_count*/,  // TODO
             0,
             cb,
+            (cfg->mpp) ? (((Mpp *)cfg->mpp)->mSched) : (NULL),
+            (cfg->mpp) ? (((Mpp *)cfg->mpp)->mDevStat) : (NULL),
         };
 
         ret = mpp_hal_init(&hal, &hal_cfg);
@@ -471,6 +1017,8 @@ MPP_RET mpp_enc_init(MppEnc *enc, MppEncCfg *cfg)
         p->tasks        = hal_cfg.tasks;
         p->frame_slots  = frame_slots;
         p->packet_slots = packet_slots;
+        p->batch        = 1;
+        p->batch_cur    = 1;
 
         sem_init(&p->enc_reset, 0, 0);
 
@@ -727,6 +1275,55 @@ MPP_RET mpp_enc_control(MppEnc ctx, MpiCmd cmd, void *param)
         enc_dbg_ctrl("set ctu qp\n");
         ret = mpp_hal_control(enc->hal, cmd, param);
     } break;
+    case MPP_ENC_SET_TASK_BATCH : {
+        RK_S32 batch = *((RK_S32 *)param);
+
+        enc_dbg_ctrl("set task batch %d\n", batch);
+        /* only H.264 hal can send multiple frames in one batch */
+        if (enc->coding != MPP_VIDEO_CodingAVC ||
+            batch < 1 || batch > MPP_ENC_BATCH_MAX) {
+            mpp_err_f("invalid task batch %d on coding %d\n", batch, enc->coding);
+            ret = MPP_NOK;
+            break;
+        }
+
+        ret = mpp_hal_control(enc->hal, cmd, param);
+        if (!ret)
+            enc->batch = batch;
+    } break;
+    case MPP_ENC_SET_SPLIT : {
+        MppEncSliceSplit *split = (MppEncSliceSplit *)param;
+
+        enc_dbg_ctrl("set split en %d mode %d size %d out %d\n", split->split_en,
+                     split->split_mode, split->slice_size, split->split_out);
+        if (split->split_en && (split->slice_size <= 0 ||
+                                split->split_mode <= MPP_ENC_SPLIT_NONE ||
+                                split->split_mode > MPP_ENC_SPLIT_BY_CTU)) {
+            mpp_err_f("invalid split mode %d size %d\n", split->split_mode,
+                      split->slice_size);
+            ret = MPP_ERR_VALUE;
+            break;
+        }
+
+        memcpy(&enc->set.misc.split, split, sizeof(enc->set.misc.split));
+        ret = mpp_hal_control(enc->hal, cmd, &enc->set.misc.split);
+        if (!ret)
+            memcpy(&enc->cfg.misc.split, split, sizeof(enc->cfg.misc.split));
+    } break;
+    case MPP_ENC_GET_SPLIT : {
+        MppEncSliceSplit *p = (MppEncSliceSplit *)param;
+
+        enc_dbg_ctrl("get split config\n");
+        memcpy(p, &enc->cfg.misc.split, sizeof(*p));
+    } break;
+    case MPP_ENC_SET_PRE_ANALYSIS : {
+        enc->pre_enable = !!*((RK_S32 *)param);
+        enc_dbg_ctrl("set pre-analysis %d\n", enc->pre_enable);
+    } break;
+    case MPP_ENC_GET_BUF_STAT : {
+        enc_dbg_ctrl("get buffer stat\n");
+        ret = mpp_hal_control(enc->hal, cmd, param);
+    } break;
     default : {
         mpp_log_f("unsupported cmd id %08x param %p\n", cmd, param);
         ret = MPP_NOK;
@@ -812,6 +1409,11 @@ void mpp_enc_update_rc_cfg(MppEncRcCfg *dst, MppEncRcCfg *src)
         if (change & MPP_ENC_RC_CFG_CHANGE_SKIP_CNT)
             dst->skip_cnt = src->skip_cnt;
 
+        if (change & MPP_ENC_RC_CFG_CHANGE_DROP_FRM) {
+            dst->drop_mode = src->drop_mode;
+            dst->drop_threshold = src->drop_threshold;
+        }
+
         /*
          * NOTE: use OR here for avoiding overwrite on multiple config
          * When next encoding is trigger the change flag will be clear
@@ -0,0 +1,451 @@
+/*
+ * Copyright 2015 Rockchip Electronics Co. LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define  MODULE_TAG "mpp_enc_analysis"
+
+#include <string.h>
+
+#include "mpp_env.h"
+#include "mpp_log.h"
+#include "mpp_mem.h"
+#include "mpp_common.h"
+#include "mpp_thread.h"
+
+#include "mpp.h"
+#include "mpp_buffer.h"
+#include "mpp_enc_analysis.h"
+
+#define ENC_ANA_DBG_FUNCTION            (0x00000001)
+#define ENC_ANA_DBG_RESULT              (0x00000010)
+
+#define enc_ana_dbg(flag, fmt, ...)     _mpp_dbg(enc_ana_debug, flag, fmt, ## __VA_ARGS__)
+#define enc_ana_dbg_f(flag, fmt, ...)   _mpp_dbg_f(enc_ana_debug, flag, fmt, ## __VA_ARGS__)
+
+#define enc_ana_dbg_func(fmt, ...)      enc_ana_dbg_f(ENC_ANA_DBG_FUNCTION, fmt, ## __VA_ARGS__)
+#define enc_ana_dbg_result(fmt, ...)    enc_ana_dbg(ENC_ANA_DBG_RESULT, fmt, ## __VA_ARGS__)
+
+/* block size on the downscaled luma plane */
+#define ENC_ANA_BLK_SIZE                8
+/* minimum frame distance between two scene cuts */
+#define ENC_ANA_CUT_MIN_DIST            8
+/* sad jump ratio to the sad history for scene cut */
+#define ENC_ANA_CUT_SAD_RATIO           3
+
+static RK_U32 enc_ana_debug = 0;
+
+typedef struct MppEncAnalysisImpl_t {
+    MppEnc              enc;
+    MppThread           *thread;
+
+    /* job posted by encoder thread, protected by THREAD_WORK lock */
+    MppFrame            frame;
+    MppEncPrepCfg       prep;
+    RK_U32              job;
+    /* no job in flight and result is ready, protected by THREAD_CONTROL lock */
+    RK_U32              done;
+    EncAnalysisResult   result;
+
+    /* downscaled luma plane of current and previous frame */
+    RK_U8               *plane[2];
+    RK_S32              plane_size;
+    RK_S32              blk_w;
+    RK_S32              blk_h;
+    RK_S32              cur;
+    RK_S32              has_prev;
+
+    /* scene cut history */
+    RK_S32              sad_avg;
+    RK_S32              cut_dist;
+} MppEncAnalysisImpl;
+
+static RK_S32 enc_ana_luma_is_8bit(MppFrameFormat format)
+{
+    if ((format & MPP_FRAME_FMT_MASK) != MPP_FRAME_FMT_YUV)
+        return 0;
+
+    switch (format) {
+    case MPP_FMT_YUV420SP_10BIT :
+    case MPP_FMT_YUV422SP_10BIT :
+    case MPP_FMT_YUV422_YUYV :
+    case MPP_FMT_YUV422_UYVY : {
+        return 0;
+    } break;
+    default : {
+    } break;
+    }
+
+    return (format < MPP_FMT_YUV_BUTT);
+}
+
+/*
+ * The kernels below work on fixed 8 pixel rows without branch in the inner
+ * loop so the compiler can vectorize them with NEON / SSE.
+ */
+static void enc_ana_downscale(RK_U8 *dst, RK_S32 dst_w, RK_S32 dst_h,
+                              const RK_U8 *src, RK_S32 stride)
+{
+    RK_S32 x, y;
+
+    for (y = 0; y < dst_h; y++) {
+        const RK_U8 *s = src + y * 2 * stride;
+        RK_U8 *d = dst + y * dst_w;
+
+        for (x = 0; x < dst_w; x++)
+            d[x] = s[x * 2];
+    }
+}
+
+static RK_S32 enc_ana_blk_sum(const RK_U8 *src, RK_S32 stride)
+{
+    RK_S32 sum = 0;
+    RK_S32 x, y;
+
+    for (y = 0; y < ENC_ANA_BLK_SIZE; y++, src += stride)
+        for (x = 0; x < ENC_ANA_BLK_SIZE; x++)
+            sum += src[x];
+
+    return sum;
+}
+
+static RK_S32 enc_ana_blk_mad(const RK_U8 *src, RK_S32 stride, RK_S32 avg)
+{
+    RK_S32 dev = 0;
+    RK_S32 x, y;
+
+    for (y = 0; y < ENC_ANA_BLK_SIZE; y++, src += stride)
+        for (x = 0; x < ENC_ANA_BLK_SIZE; x++)
+            dev += MPP_ABS(src[x] - avg);
+
+    return dev;
+}
+
+static RK_S32 enc_ana_blk_sad(const RK_U8 *src0, const RK_U8 *src1, RK_S32 stride)
+{
+    RK_S32 sad = 0;
+    RK_S32 x, y;
+
+    for (y = 0; y < ENC_ANA_BLK_SIZE; y++, src0 += stride, src1 += stride)
+        for (x = 0; x < ENC_ANA_BLK_SIZE; x++)
+            sad += MPP_ABS(src0[x] - src1[x]);
+
+    return sad;
+}
+
+static void enc_ana_proc(MppEncAnalysisImpl *p, MppFrame frame,
+                         MppEncPrepCfg *prep, EncAnalysisResult *result)
+{
+    const RK_S32 blk = ENC_ANA_BLK_SIZE;
+    MppBuffer buffer = mpp_frame_get_buffer(frame);
+    RK_S32 stride = (prep->hor_stride) ? (prep->hor_stride) : (prep->width);
+    RK_S32 blk_w = prep->width / (blk * 2);
+    RK_S32 blk_h = prep->height / (blk * 2);
+    RK_S32 plane_w = blk_w * blk;
+    RK_S32 plane_h = blk_h * blk;
+    RK_S64 mad_sum = 0;
+    RK_S64 sad_sum = 0;
+    RK_U8 *luma = NULL;
+    RK_U8 *cur = NULL;
+    RK_U8 *prev = NULL;
+    RK_S32 bx, by;
+
+    memset(result, 0, sizeof(*result));
+
+    if (NULL == buffer || !blk_w || !blk_h ||
+        !enc_ana_luma_is_8bit(prep->format))
+        return;
+
+    luma = (RK_U8 *)mpp_buffer_get_ptr(buffer);
+    if (NULL == luma)
+        return;
+
+    /* resolution change restarts the history */
+    if (blk_w != p->blk_w || blk_h != p->blk_h) {
+        RK_S32 size = plane_w * plane_h;
+
+        if (size > p->plane_size) {
+            MPP_FREE(p->plane[0]);
+            MPP_FREE(p->plane[1]);
+            p->plane[0] = mpp_malloc(RK_U8, size);
+            p->plane[1] = mpp_malloc(RK_U8, size);
+            if (NULL == p->plane[0] || NULL == p->plane[1]) {
+                mpp_err_f("failed to malloc plane size %d\n", size);
+                MPP_FREE(p->plane[0]);
+                MPP_FREE(p->plane[1]);
+                p->plane_size = 0;
+                p->blk_w = 0;
+                p->blk_h = 0;
+                return;
+            }
+            p->plane_size = size;
+        }
+
+        p->blk_w = blk_w;
+        p->blk_h = blk_h;
+        p->has_prev = 0;
+    }
+
+    cur = p->plane[p->cur];
+    prev = p->has_prev ? p->plane[!p->cur] : NULL;
+
+    enc_ana_downscale(cur, plane_w, plane_h, luma, stride);
+
+    for (by = 0; by < blk_h; by++) {
+        for (bx = 0; bx < blk_w; bx++) {
+            RK_S32 offset = by * blk * plane_w + bx * blk;
+            RK_S32 avg = enc_ana_blk_sum(cur + offset, plane_w) / (blk * blk);
+
+            mad_sum += enc_ana_blk_mad(cur + offset, plane_w, avg);
+            if (prev)
+                sad_sum += enc_ana_blk_sad(cur + offset, prev + offset, plane_w);
+        }
+    }
+
+    result->valid = 1;
+    result->complexity = (RK_S32)(mad_sum * 256 / (blk_w * blk_h * blk * blk));
+    result->sad = (RK_S32)(sad_sum * 256 / (blk_w * blk_h * blk * blk));
+
+    if (prev) {
+        /*
+         * Without motion search sad also grows on normal motion. Only take it
+         * as scene cut when the frame difference is more than its own texture
+         * and jumps from the history.
+         */
+        if (p->cut_dist >= ENC_ANA_CUT_MIN_DIST &&
+            result->sad > result->complexity &&
+            result->sad > p->sad_avg * ENC_ANA_CUT_SAD_RATIO)
+            result->scene_cut = 1;
+
+        if (result->scene_cut) {
+            p->sad_avg = 0;
+            p->cut_dist = 0;
+        } else {
+            p->sad_avg = p->sad_avg ? (p->sad_avg * 7 + result->sad) / 8 : result->sad;
+            p->cut_dist++;
+        }
+    } else {
+        p->sad_avg = 0;
+        p->cut_dist = ENC_ANA_CUT_MIN_DIST;
+    }
+
+    p->cur = !p->cur;
+    p->has_prev = 1;
+
+    enc_ana_dbg_result("complexity %d sad %d sad_avg %d scene cut %d\n",
+                       result->complexity, result->sad, p->sad_avg,
+                       result->scene_cut);
+}
+
+static void *enc_ana_thread(void *data)
+{
+    MppEncAnalysisImpl *p = (MppEncAnalysisImpl *)data;
+    MppThread *thd = p->thread;
+    EncAnalysisResult result;
+
+    while (1) {
+        MppFrame frame = NULL;
+
+        {
+            AutoMutex autolock(thd->mutex());
+            if (MPP_THREAD_RUNNING != thd->get_status())
+                break;
+
+            if (!p->job) {
+                thd->wait();
+                continue;
+            }
+
+            frame = p->frame;
+            p->frame = NULL;
+            p->job = 0;
+        }
+
+        enc_ana_proc(p, frame, &p->prep, &result);
+
+        thd->lock(THREAD_CONTROL);
+        p->result = result;
+        p->done = 1;
+        thd->signal(THREAD_CONTROL);
+        thd->unlock(THREAD_CONTROL);
+
+        if (p->enc)
+            mpp_enc_notify(p->enc, MPP_ENC_NOTIFY_PRE_DONE);
+    }
+
+    return NULL;
+}
+
+MPP_RET mpp_enc_analysis_init(MppEncAnalysis *ctx, MppEnc enc)
+{
+    MppEncAnalysisImpl *p = NULL;
+
+    if (NULL == ctx) {
+        mpp_err_f("invalid NULL input\n");
+        return MPP_ERR_NULL_PTR;
+    }
+
+    mpp_env_get_u32("enc_ana_debug", &enc_ana_debug, 0);
+
+    *ctx = NULL;
+
+    p = mpp_calloc(MppEncAnalysisImpl, 1);
+    if (NULL == p) {
+        mpp_err_f("failed to malloc context\n");
+        return MPP_ERR_MALLOC;
+    }
+
+    p->enc = enc;
+    p->done = 1;
+    p->thread = new MppThread(enc_ana_thread, p, "mpp_enc_ana");
+    if (NULL == p->thread) {
+        mpp_err_f("failed to create thread\n");
+        mpp_free(p);
+        return MPP_ERR_MALLOC;
+    }
+
+    p->thread->start();
+
+    *ctx = p;
+    return MPP_OK;
+}
+
+MPP_RET mpp_enc_analysis_deinit(MppEncAnalysis ctx)
+{
+    MppEncAnalysisImpl *p = (MppEncAnalysisImpl *)ctx;
+
+    if (NULL == p) {
+        mpp_err_f("invalid NULL input\n");
+        return MPP_ERR_NULL_PTR;
+    }
+
+    if (p->thread) {
+        p->thread->stop();
+        delete p->thread;
+        p->thread = NULL;
+    }
+
+    MPP_FREE(p->plane[0]);
+    MPP_FREE(p->plane[1]);
+    mpp_free(p);
+    return MPP_OK;
+}
+
+MPP_RET mpp_enc_analysis_reset(MppEncAnalysis ctx)
+{
+    MppEncAnalysisImpl *p = (MppEncAnalysisImpl *)ctx;
+
+    if (NULL == p) {
+        mpp_err_f("invalid NULL input\n");
+        return MPP_ERR_NULL_PTR;
+    }
+
+    /* history is only touched by worker thread when there is a job */
+    mpp_enc_analysis_wait(p, NULL);
+    memset(&p->result, 0, sizeof(p->result));
+    p->has_prev = 0;
+    p->sad_avg = 0;
+    p->cut_dist = 0;
+
+    return MPP_OK;
+}
+
+MPP_RET mpp_enc_analysis_start(MppEncAnalysis ctx, MppFrame frame, MppEncPrepCfg *prep)
+{
+    MppEncAnalysisImpl *p = (MppEncAnalysisImpl *)ctx;
+    MppThread *thd = NULL;
+
+    if (NULL == p || NULL == frame || NULL == prep) {
+        mpp_err_f("invalid input ctx %p frame %p prep %p\n", p, frame, prep);
+        return MPP_ERR_NULL_PTR;
+    }
+
+    thd = p->thread;
+
+    thd->lock(THREAD_CONTROL);
+    mpp_assert(p->done);
+    p->done = 0;
+    thd->unlock(THREAD_CONTROL);
+
+    thd->lock();
+    p->frame = frame;
+    p->prep = *prep;
+    p->job = 1;
+    thd->signal();
+    thd->unlock();
+
+    return MPP_OK;
+}
+
+RK_S32 mpp_enc_analysis_done(MppEncAnalysis ctx)
+{
+    MppEncAnalysisImpl *p = (MppEncAnalysisImpl *)ctx;
+    RK_S32 done;
+
+    if (NULL == p)
+        return 1;
+
+    p->thread->lock(THREAD_CONTROL);
+    done = p->done;
+    p->thread->unlock(THREAD_CONTROL);
+
+    return done;
+}
+
+MPP_RET mpp_enc_analysis_wait(MppEncAnalysis ctx, EncAnalysisResult *result)
+{
+    MppEncAnalysisImpl *p = (MppEncAnalysisImpl *)ctx;
+    MppThread *thd = NULL;
+
+    if (NULL == p) {
+        mpp_err_f("invalid NULL input\n");
+        return MPP_ERR_NULL_PTR;
+    }
+
+    thd = p->thread;
+
+    thd->lock(THREAD_CONTROL);
+    while (!p->done)
+        thd->wait(THREAD_CONTROL);
+
+    if (result)
+        *result = p->result;
+    thd->unlock(THREAD_CONTROL);
+
+    return MPP_OK;
+}
+
+MPP_RET mpp_enc_analysis_proc(MppEncAnalysis ctx, MppFrame frame, MppEncPrepCfg *prep,
+                              EncAnalysisResult *result)
+{
+    MppEncAnalysisImpl *p = (MppEncAnalysisImpl *)ctx;
+    EncAnalysisResult res;
+
+    if (NULL == p || NULL == frame || NULL == prep || NULL == result) {
+        mpp_err_f("invalid input ctx %p frame %p prep %p result %p\n",
+                  p, frame, prep, result);
+        return MPP_ERR_NULL_PTR;
+    }
+
+    /* history is free to use on caller thread when no job is in flight */
+    mpp_enc_analysis_wait(p, NULL);
+    enc_ana_proc(p, frame, prep, &res);
+
+    p->thread->lock(THREAD_CONTROL);
+    p->result = res;
+    p->thread->unlock(THREAD_CONTROL);
+
+    *result = res;
+    return MPP_OK;
+}
@@ -0,0 +1,63 @@
+/*
+ * Copyright 2015 Rockchip Electronics Co. LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define  MODULE_TAG "mpp_enc_drop"
+
+#include "mpp_enc_drop.h"
+
+void mpp_enc_drop_reset(MppEncDrop *drop)
+{
+    drop->expect = 0;
+    drop->count = 0;
+}
+
+RK_S32 mpp_enc_drop_check(MppEncDrop *drop, MppEncRcCfg *rc, RK_S64 now,
+                          RK_S32 eos, RK_S32 *delay_ms)
+{
+    RK_S32 fps_num = rc->fps_in_num ? rc->fps_in_num : 30;
+    RK_S32 fps_denorm = rc->fps_in_denorm ? rc->fps_in_denorm : 1;
+    RK_S64 interval = (RK_S64)1000000 * fps_denorm / fps_num;
+    RK_S64 threshold = rc->drop_threshold ?
+                       (RK_S64)rc->drop_threshold * 1000 : interval * 2;
+    /* skip_cnt 0 means frame skip is not allowed on rate control only */
+    RK_S32 drop_max = rc->skip_cnt ? rc->skip_cnt : MPP_ENC_DROP_CNT_DEFAULT;
+    RK_S64 delay;
+    RK_S32 ret = 0;
+
+    if (!rc->drop_mode || rc->fps_in_flex) {
+        mpp_enc_drop_reset(drop);
+        return 0;
+    }
+
+    if (!drop->expect || now < drop->expect)
+        drop->expect = now;
+
+    delay = now - drop->expect;
+    drop->expect += interval;
+
+    if (delay + drop->enc > threshold && drop->count < drop_max && !eos)
+        ret = 1;
+
+    drop->count = (ret) ? (drop->count + 1) : (0);
+    *delay_ms = (RK_S32)(delay / 1000);
+
+    return ret;
+}
+
+void mpp_enc_drop_update(MppEncDrop *drop, RK_S64 time)
+{
+    drop->enc = (drop->enc) ? ((drop->enc * 7 + time) / 8) : (time);
+}
@@ -214,3 +214,26 @@ MPP_RET mpp_parser_control(Parser prs, MpiCmd cmd, void *para)
     return p->api->control(p->ctx, cmd, para);
 }
 
+
+MPP_RET mpp_parser_probe(MppCodingType coding, RK_U8 *data, RK_S32 size,
+                         MppDecStreamInfo *info)
+{
+    if (NULL == data || NULL == info) {
+        mpp_err_f("found NULL input data %p info %p\n", data, info);
+        return MPP_ERR_NULL_PTR;
+    }
+
+    RK_U32 i;
+    for (i = 0; i < MPP_ARRAY_ELEMS(parsers); i++) {
+        const ParserApi *api = parsers[i];
+        if (coding == api->coding) {
+            if (!api->probe)
+                break;
+
+            return api->probe(data, size, info);
+        }
+    }
+
+    mpp_err_f("coding %x does not support probe\n", coding);
+    return MPP_ERR_VALUE;
+}
@@ -31,6 +31,9 @@
 #define MPP_RC_DBG_RECORD            (0x00001000)
 #define MPP_RC_DBG_VBV               (0x00002000)
 
+/* record nodes kept for MPP_RC_DBG_RECORD, more than one second of frames */
+#define MPP_RC_RECORD_MAX            (128)
+
 
 #define mpp_rc_dbg(flag, fmt, ...)   _mpp_dbg(mpp_rc_debug, flag, fmt, ## __VA_ARGS__)
 #define mpp_rc_dbg_f(flag, fmt, ...) _mpp_dbg_f(mpp_rc_debug, flag, fmt, ## __VA_ARGS__)
@@ -361,6 +364,7 @@ MPP_RET mpp_rc_deinit(MppRateControl *ctx)
         ctx->intra_percent = NULL;
     }
 
+    MPP_FREE(ctx->rec_nodes);
     mpp_free(ctx);
     return MPP_OK;
 }
@@ -527,6 +531,36 @@ MPP_RET mpp_rc_update_user_cfg(MppRateControl *ctx, MppEncRcCfg *cfg, RK_S32 for
     return MPP_OK;
 }
 
+/*
+ * Input pre-analysis gives the luma complexity of the frame. Inter frame more
+ * complex than the recent frames gets more bits and simpler one gets less.
+ * The pid on real bits compensates the budget in the window. Scene cut
+ * restarts the complexity history with the new content.
+ */
+static void mpp_rc_complexity_adjust(MppRateControl *ctx, RcSyntax *rc_syn)
+{
+    RK_S32 complexity = rc_syn->complexity;
+
+    if (complexity <= 0)
+        return;
+
+    if (rc_syn->scene_cut || !ctx->complexity_avg) {
+        ctx->complexity_avg = complexity;
+        return;
+    }
+
+    if (ctx->cur_frmtype != INTRA_FRAME) {
+        double ratio = sqrt((double)complexity / ctx->complexity_avg);
+
+        ratio = MPP_MAX(MPP_MIN(ratio, 1.33), 0.75);
+        mpp_rc_dbg_rc("RC: rc ctx %p complexity %d avg %d scale target %d by %.2f\n",
+                      ctx, complexity, ctx->complexity_avg, ctx->bits_target, ratio);
+        ctx->bits_target = (RK_S32)(ctx->bits_target * ratio);
+    }
+
+    ctx->complexity_avg = (ctx->complexity_avg * 7 + complexity) / 8;
+}
+
 MPP_RET mpp_rc_bits_allocation(MppRateControl *ctx, RcSyntax *rc_syn)
 {
     if (NULL == ctx || NULL == rc_syn) {
@@ -634,6 +668,8 @@ MPP_RET mpp_rc_bits_allocation(MppRateControl *ctx, RcSyntax *rc_syn)
     } break;
     }
 
+    mpp_rc_complexity_adjust(ctx, rc_syn);
+
     /* If target bit is zero, it will exist mosaic in the encoded picture.
      * In this case, half of target bit rate of previous P frame  is
      * assigned to target bit.
@@ -753,8 +789,28 @@ MPP_RET mpp_rc_record_param(struct list_head *head, MppRateControl *ctx,
     MPP_RET ret = MPP_OK;
 
     if (mpp_rc_debug & MPP_RC_DBG_RECORD) {
-        RecordNode *node = (RecordNode *)mpp_calloc(RecordNode, 1);
-        mpp_assert(node);
+        RecordNode *node;
+
+        if (NULL == ctx->rec_nodes) {
+            ctx->rec_nodes = mpp_calloc(RecordNode, MPP_RC_RECORD_MAX);
+            if (NULL == ctx->rec_nodes) {
+                mpp_err_f("failed to malloc record nodes\n");
+                return MPP_ERR_MALLOC;
+            }
+        }
+
+        /*
+         * Nodes are recycled in ring order. The oldest node normally has been
+         * released by mpp_rc_calc_real_bps already, otherwise drop it here.
+         */
+        node = &ctx->rec_nodes[ctx->rec_idx];
+        if (++ctx->rec_idx >= MPP_RC_RECORD_MAX)
+            ctx->rec_idx = 0;
+
+        if (node->list.next && !list_empty(&node->list))
+            list_del_init(&node->list);
+
+        memset(node, 0, sizeof(*node));
         INIT_LIST_HEAD(&node->list);
         node->frm_type = ctx->cur_frmtype;
         node->frm_cnt = ++ctx->frm_cnt;
@@ -824,10 +880,8 @@ MPP_RET mpp_rc_calc_real_bps(struct list_head *head, MppRateControl *ctx,
                  * number is (@acc_intra_count + @acc_inter_count) belongs to next
                  * group, so just free it next time.
                  */
-                if ((ctx->acc_intra_count + ctx->acc_inter_count) != (RK_S32)pos->frm_cnt) {
+                if ((ctx->acc_intra_count + ctx->acc_inter_count) != (RK_S32)pos->frm_cnt)
                     list_del_init(&pos->list);
-                    mpp_free(pos);
-                }
             }
 
             ctx->real_bps = 0;
@@ -837,6 +891,14 @@ MPP_RET mpp_rc_calc_real_bps(struct list_head *head, MppRateControl *ctx,
     return ret;
 }
 
+/*
+ * Weight decay ratio of each weight mode. The sample of age k has weight
+ * ratio^k and the last mode has the same weight on all samples.
+ */
+static const double linreg_ratio[6] = {
+    0.5, 0.6, 0.7, 0.8, 0.9, 1.0,
+};
+
 MPP_RET mpp_linreg_init(MppLinReg **ctx, RK_S32 size, RK_S32 weight_mode)
 {
     if (NULL == ctx) {
@@ -857,6 +919,8 @@ MPP_RET mpp_linreg_init(MppLinReg **ctx, RK_S32 size, RK_S32 weight_mode)
         p->y = (RK_S64 *)(p->r + size);
         p->size = size;
         p->weight_mode = weight_mode;
+        p->ratio = linreg_ratio[weight_mode];
+        p->ratio_n = pow(p->ratio, size);
     }
 
     *ctx = p;
@@ -874,27 +938,65 @@ MPP_RET mpp_linreg_deinit(MppLinReg *ctx)
     return MPP_OK;
 }
 
-static RK_S64 linreg_weight[6][15] = {
-    {1000, 500, 250, 125, 63, 31, 16, 8, 4, 2, 1, 0, 0, 0, 0},
-    {1000, 600, 360, 216, 130, 78, 47, 28, 17, 10, 6, 4, 2, 1, 0},
-    {1000, 700, 490, 343, 240, 168, 117, 82, 57, 40, 32, 26, 20, 16, 13},
-    {1000, 800, 640, 512, 409, 328, 262, 210, 168, 134, 107, 86, 69, 55, 44},
-    {1000, 900, 810, 729, 656, 590, 531, 478, 430, 387, 348, 313, 282, 254, 229},
-    {1000, 1000, 1000, 1000, 1000, 1000, 1000, 1000, 1000, 1000, 1000, 1000, 1000, 1000, 1000}
-};
-
-static inline RK_S64 POW(RK_S64 A, RK_S64 B)
+/* recompute the running sums to drop the rounding error of the updates */
+static void linreg_sum_refresh(MppLinReg *ctx)
 {
-    RK_S64 X = 1;
-    while (B--)
-        X *= A;
+    double w = 1.0;
+    RK_S32 i = ctx->i;
+    RK_S32 n = ctx->n;
+
+    ctx->sum_w = 0;
+    ctx->sum_x = 0;
+    ctx->sum_y = 0;
+    ctx->sum_xy = 0;
+    ctx->sum_xx = 0;
+
+    while (n--) {
+        double x;
+        double y;
+
+        if (i == 0)
+            i = ctx->size - 1;
+        else
+            i--;
+
+        x = ctx->x[i];
+        y = (double)ctx->y[i];
 
-    return X;
+        ctx->sum_w += w;
+        ctx->sum_x += w * x;
+        ctx->sum_y += w * y;
+        ctx->sum_xy += w * x * y;
+        ctx->sum_xx += w * x * x;
+        w *= ctx->ratio;
+    }
 }
 
 void mpp_save_regdata(MppLinReg *ctx, RK_S32 x, RK_S32 r)
 {
     RK_S64 y = (RK_S64)x * x * r;
+    double k = ctx->ratio;
+
+    /* age all samples in the sums and add the new one */
+    ctx->sum_w = k * ctx->sum_w + 1;
+    ctx->sum_x = k * ctx->sum_x + x;
+    ctx->sum_y = k * ctx->sum_y + y;
+    ctx->sum_xy = k * ctx->sum_xy + (double)x * y;
+    ctx->sum_xx = k * ctx->sum_xx + (double)x * x;
+
+    /* drop the evicted sample from the running sums when window is full */
+    if (ctx->n >= ctx->size) {
+        double old_x = ctx->x[ctx->i];
+        double old_y = (double)ctx->y[ctx->i];
+        double w = ctx->ratio_n;
+
+        ctx->sum_w -= w;
+        ctx->sum_x -= w * old_x;
+        ctx->sum_y -= w * old_y;
+        ctx->sum_xy -= w * old_x * old_y;
+        ctx->sum_xx -= w * old_x * old_x;
+    }
+
     ctx->x[ctx->i] = x;
     ctx->r[ctx->i] = r;
     ctx->y[ctx->i] = y;
@@ -902,29 +1004,31 @@ void mpp_save_regdata(MppLinReg *ctx, RK_S32 x, RK_S32 r)
     mpp_rc_dbg_rc("RC: linreg %p save index %d x %d r %d x*x*r %lld\n",
                   ctx, ctx->i, x, r, y);
 
-    if (++ctx->i >= ctx->size)
-        ctx->i = 0;
-
     if (ctx->n < ctx->size)
         ctx->n++;
+
+    if (++ctx->i >= ctx->size) {
+        ctx->i = 0;
+        linreg_sum_refresh(ctx);
+    }
 }
 
 MPP_RET mpp_quadreg_update(MppLinReg *ctx, RK_S32 wlen)
 {
     double A[3][3];
     double B[3];
+    /* weighted moment sum of x^0 ~ x^4, A[k][l] only depends on k + l */
+    double M[5];
 
-    RK_S32 cq = 0;
     RK_S32 est_b = 0;
     RK_S32 w = 0;
-    RK_S32 err = 0;
     RK_S32 std = 0;
 
-    RK_S32 k, l;
+    RK_S32 k;
 
     double a = 0, b = 0, c = 0;
 
-    memset(A, 0, sizeof(A));
+    memset(M, 0, sizeof(M));
     memset(B, 0, sizeof(B));
 
     /* step 2: update coefficient */
@@ -934,47 +1038,58 @@ MPP_RET mpp_quadreg_update(MppLinReg *ctx, RK_S32 wlen)
     RK_S32 *cx = ctx->x;
     RK_S32 *cr = ctx->r;
     RK_S64 *cy = ctx->y;
+    double wt = 1.0;
     RK_S32 idx = 0;
     RK_S32 aver_x = 0;
+    RK_S64 acc_x = 0;
+    RK_S64 acc_sq_x = 0;
+    RK_S64 first_x = 0;
 
-    n = ctx->n;
-    i = ctx->i;
-
-    while (n--) {
-        if (i == 0)
-            i = ctx->size - 1;
-        else
-            i--;
-
-        cq = cx[i];
-        aver_x += cx[i];
-
-        /* limite wlen when complexity change sharply */
-        if (idx++ > wlen)
-            break;
-    }
-
-    w = idx;
-    aver_x = round(1.0 * aver_x / w);
+    /* limite wlen when complexity change sharply */
+    w = MPP_MIN(ctx->n, MPP_MAX(wlen + 2, 1));
+    if (w <= 0)
+        return MPP_OK;
 
-    idx = 0;
+    /* single pass on the window: window statistic and weighted moments */
     n = w;
     i = ctx->i;
 
     while (n--) {
+        RK_S64 x, p;
+
         if (i == 0)
             i = ctx->size - 1;
         else
             i--;
 
-        if (cq != cx[i])
+        x = cx[i];
+        if (!idx)
+            first_x = x;
+        else if (x != first_x)
             est_b = 1;
 
-        err = cx[i] - aver_x;
-        std += err * err;
+        acc_x += x;
+        acc_sq_x += x * x;
         b += 1.0 * cx[i] * cr[i] / w;
+
+        mpp_rc_dbg_rc("qs[%d] %d, r[%d] %d, y[%d] %lld\n",
+                      idx, cx[i], idx, cr[i], idx, cy[i]);
+
+        p = 1;
+        for (k = 0; k < 5; k++) {
+            M[k] += wt * p;
+            if (k < 3)
+                B[k] += wt * cy[i] * p;
+            p *= x;
+        }
+        wt *= ctx->ratio;
+        idx++;
     }
 
+    aver_x = round(1.0 * acc_x / w);
+    /* sum of (x - aver_x)^2 expanded on the running sums */
+    std = acc_sq_x - 2 * aver_x * acc_x + (RK_S64)w * aver_x * aver_x;
+
     mpp_rc_dbg_rc("qstep std %f average %d\n", sqrt(1.0 * std / w), aver_x);
 
     /*
@@ -984,28 +1099,11 @@ MPP_RET mpp_quadreg_update(MppLinReg *ctx, RK_S32 wlen)
     if (sqrt(1.0 * std / w) * 32 < aver_x)
         return MPP_OK;
 
-    if (est_b && w >= 1) {
-        n = w;
-        i = ctx->i;
-        while (n--) {
-            if (i == 0)
-                i = ctx->size - 1;
-            else
-                i--;
-
-            RK_S64 wt = linreg_weight[ctx->weight_mode][idx++];
-
-            mpp_rc_dbg_rc("qs[%d] %d, r[%d] %d, y[%d] %lld\n",
-                          idx - 1, cx[i], idx - 1, cr[i], idx - 1, cy[i]);
-
-            for (k = 0; k < 3; k++) {
-                for (l = 0; l < 3; l++) {
-                    A[k][l] += wt * POW(cx[i], k + l);
-                }
-            }
-
-            for (k = 0; k < 3; k++)
-                B[k] += wt * cy[i] * POW(cx[i], k);
+    if (est_b) {
+        for (k = 0; k < 3; k++) {
+            A[k][0] = M[k];
+            A[k][1] = M[k + 1];
+            A[k][2] = M[k + 2];
         }
 
         mpp_rc_dbg_rc("\nmatrix A:\n");
@@ -1071,60 +1169,39 @@ MPP_RET mpp_linreg_update(MppLinReg *ctx)
         return MPP_ERR_NULL_PTR;
     }
 
-    /* step 2: update coefficient */
-    RK_S32 i = 0;
-    RK_S32 n;
-    RK_S64 acc_xy = 0;
-    RK_S64 acc_x = 0;
-    RK_S64 acc_y = 0;
-    RK_S64 acc_sq_x = 0;
-
-    RK_S64 b_num = 0;
-    RK_S64 denom = 0;
-
-    RK_S32 *cx = ctx->x;
-    RK_S64 *cy = ctx->y;
-    RK_S64 ws = 0;
-    RK_S32 idx = 0;
-    RK_S64 w;
-
-    n = ctx->n;
-    i = ctx->i;
+    /* step 2: update coefficient from the weighted running sums */
+    double ws = ctx->sum_w;
+    double acc_xy = ctx->sum_xy;
+    double acc_x = ctx->sum_x;
+    double acc_y = ctx->sum_y;
+    double acc_sq_x = ctx->sum_xx;
+    double b_num;
+    double denom;
 
-    while (n--) {
-        if (i == 0)
-            i = ctx->size - 1;
-        else
-            i--;
-
-        w = linreg_weight[ctx->weight_mode][idx++];
-        ws += w;
-        acc_xy += w * cx[i] * cy[i];
-        acc_x += w * cx[i];
-        acc_y += w * cy[i];
-        acc_sq_x += w * cx[i] * cx[i];
-    }
+    if (!ctx->n)
+        return MPP_OK;
 
     b_num = acc_xy - acc_y * acc_x / ws;
     denom = acc_sq_x - acc_x * acc_x / ws;
 
-    mpp_rc_dbg_rc("RC: linreg %p acc_xy %lld acc_x %lld acc_y %lld acc_sq_x %lld\n",
+    mpp_rc_dbg_rc("RC: linreg %p acc_xy %e acc_x %e acc_y %e acc_sq_x %e\n",
                   ctx, acc_xy, acc_x, acc_y, acc_sq_x);
-    mpp_rc_dbg_rc("RC: linreg %p n %d b_num %lld denom %lld\n",
+    mpp_rc_dbg_rc("RC: linreg %p n %d b_num %e denom %e\n",
                   ctx, ctx->n, b_num, denom);
 
-    mpp_rc_dbg_rc("RC: linreg %p before update coefficient a %d b %d\n",
+    mpp_rc_dbg_rc("RC: linreg %p before update coefficient a %f b %f\n",
                   ctx, ctx->a, ctx->b);
 
-    if (denom)
-        ctx->b = DIV(b_num, denom);
+    /* all x in window are the same when denom is only rounding error */
+    if (denom > acc_sq_x * 1e-9)
+        ctx->b = round(b_num / denom);
     else
         ctx->b = 0;
 
-    ctx->a = DIV(acc_y - acc_x * ctx->b, ws);
+    ctx->a = round((acc_y - acc_x * ctx->b) / ws);
     ctx->c = 0;
 
-    mpp_rc_dbg_rc("RC: linreg %p after  update coefficient a %d b %d\n",
+    mpp_rc_dbg_rc("RC: linreg %p after  update coefficient a %f b %f\n",
                   ctx, ctx->a, ctx->b);
 
     return MPP_OK;
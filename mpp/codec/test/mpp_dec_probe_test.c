@@ -0,0 +1,193 @@
+/*
+ * Copyright 2018 Rockchip Electronics Co. LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define MODULE_TAG "mpp_dec_probe_test"
+
+#include <string.h>
+
+#include "mpp_log.h"
+#include "mpp_time.h"
+#include "mpp_common.h"
+
+#include "rk_mpi.h"
+
+/* sequence headers of each coding with known stream information */
+static RK_U8 h264_annexb[] = {
+    0x00, 0x00, 0x00, 0x01, 0x09, 0xf0, 0x00, 0x00, 0x00, 0x01, 0x67, 0x64,
+    0x00, 0x28, 0xac, 0xb4, 0x03, 0xc0, 0x11, 0x3f, 0x2c, 0x20, 0x00, 0x00,
+    0x7d, 0x20, 0x00, 0x1d, 0x4c, 0x10, 0x80, 0x00, 0x00, 0x00, 0x01, 0x68,
+    0xce, 0x38, 0x80,
+};
+
+static RK_U8 h264_avcc[] = {
+    0x01, 0x64, 0x00, 0x28, 0xff, 0xe1, 0x00, 0x15, 0x67, 0x64, 0x00, 0x28,
+    0xac, 0xb4, 0x03, 0xc0, 0x11, 0x3f, 0x2c, 0x20, 0x00, 0x00, 0x7d, 0x20,
+    0x00, 0x1d, 0x4c, 0x10, 0x80, 0x01, 0x00, 0x04, 0x68, 0xce, 0x38, 0x80,
+};
+
+static RK_U8 h265_annexb[] = {
+    0x00, 0x00, 0x00, 0x01, 0x42, 0x01, 0x01, 0x02, 0x20, 0x00, 0x00, 0x03,
+    0x00, 0x90, 0x00, 0x00, 0x03, 0x00, 0x00, 0x03, 0x00, 0x78, 0xa0, 0x01,
+    0xe0, 0x20, 0x02, 0x20, 0x7c, 0x4b, 0x65, 0x97, 0x92, 0x4d, 0x92, 0xee,
+    0x01, 0x00, 0x00, 0x03, 0x00, 0x01, 0x00, 0x00, 0x03, 0x00, 0x32, 0x08,
+    0x00, 0x00, 0x00, 0x01, 0x44, 0x01, 0xc1, 0x72,
+};
+
+static RK_U8 m2v_seq[] = {
+    0x00, 0x00, 0x01, 0xb3, 0x2d, 0x02, 0x40, 0x23, 0xff, 0xff, 0xe3, 0x80,
+    0x00, 0x00, 0x01, 0xb5, 0x14, 0x82, 0x00, 0x01, 0x00, 0x00, 0x00, 0x00,
+    0x01, 0xb8, 0x00, 0x00, 0x00, 0x00,
+};
+
+static RK_U8 mpg4_vol[] = {
+    0x00, 0x00, 0x01, 0xb0, 0xf5, 0x00, 0x00, 0x01, 0xb5, 0x09, 0x00, 0x00,
+    0x01, 0x00, 0x00, 0x00, 0x01, 0x20, 0x00, 0x86, 0xc4, 0x00, 0x67, 0x0c,
+    0x2c, 0x10, 0x90, 0x71, 0x90,
+};
+
+static RK_U8 h263_pic[] = {
+    0x00, 0x00, 0x80, 0x02, 0x0c, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00,
+};
+
+static RK_U8 vp8_key[] = {
+    0x10, 0x02, 0x00, 0x9d, 0x01, 0x2a, 0x80, 0x02, 0xe0, 0x01, 0x00, 0x00,
+    0x00, 0x00,
+};
+
+static RK_U8 vp8_inter[] = {
+    0x11, 0x02, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+};
+
+static RK_U8 vp9_key[] = {
+    0x82, 0x49, 0x83, 0x42, 0x40, 0x4f, 0xf0, 0x2c, 0xf0, 0x00, 0x00, 0x00,
+    0x00,
+};
+
+static RK_U8 vp9_key_10bit[] = {
+    0x92, 0x49, 0x83, 0x42, 0x20, 0x77, 0xf8, 0x43, 0x78, 0x00, 0x00, 0x00,
+    0x00,
+};
+
+static RK_U8 jpeg_sof[] = {
+    0xff, 0xd8, 0xff, 0xe1, 0x00, 0x17, 0x45, 0x78, 0x69, 0x66, 0x00, 0x00,
+    0xff, 0xd8, 0xff, 0xc0, 0x00, 0x0b, 0x08, 0x00, 0x10, 0x00, 0x10, 0x01,
+    0x01, 0x11, 0x00, 0xff, 0xc0, 0x00, 0x11, 0x08, 0x01, 0xe0, 0x02, 0x80,
+    0x03, 0x01, 0x22, 0x00, 0x02, 0x11, 0x01, 0x03, 0x11, 0x01, 0xff, 0xda,
+};
+
+typedef struct ProbeTestCase_t {
+    const char          *name;
+    MppCodingType       coding;
+    RK_U8               *data;
+    size_t              size;
+    MPP_RET             ret;
+    MppDecStreamInfo    info;
+} ProbeTestCase;
+
+#define PROBE_CASE(name, coding, data, size, ret, w, h, profile, level, depth, fmt, i, num, den) \
+    { name, coding, data, size, ret, { coding, w, h, profile, level, depth, fmt, i, num, den } }
+
+static ProbeTestCase probe_cases[] = {
+    PROBE_CASE("h264 annexb", MPP_VIDEO_CodingAVC, h264_annexb, sizeof(h264_annexb), MPP_OK,
+    1920, 1080, 100, 40, 8, MPP_FMT_YUV420SP, 0, 60000, 2002),
+    PROBE_CASE("h264 avcC", MPP_VIDEO_CodingAVC, h264_avcc, sizeof(h264_avcc), MPP_OK,
+    1920, 1080, 100, 40, 8, MPP_FMT_YUV420SP, 0, 60000, 2002),
+    PROBE_CASE("h265 annexb", MPP_VIDEO_CodingHEVC, h265_annexb, sizeof(h265_annexb), MPP_OK,
+    3840, 2160, 2, 120, 10, MPP_FMT_YUV420SP_10BIT, 0, 50, 1),
+    PROBE_CASE("mpeg2", MPP_VIDEO_CodingMPEG2, m2v_seq, sizeof(m2v_seq), MPP_OK,
+    720, 576, 4, 8, 8, MPP_FMT_YUV420SP, 1, 25, 1),
+    PROBE_CASE("mpeg4", MPP_VIDEO_CodingMPEG4, mpg4_vol, sizeof(mpg4_vol), MPP_OK,
+    352, 288, 15, 5, 8, MPP_FMT_YUV420SP, 1, 25, 1),
+    PROBE_CASE("h263", MPP_VIDEO_CodingH263, h263_pic, sizeof(h263_pic), MPP_OK,
+    352, 288, 0, 0, 8, MPP_FMT_YUV420SP, 0, 30000, 1001),
+    PROBE_CASE("vp8", MPP_VIDEO_CodingVP8, vp8_key, sizeof(vp8_key), MPP_OK,
+    640, 480, 0, 0, 8, MPP_FMT_YUV420SP, 0, 0, 0),
+    PROBE_CASE("vp9", MPP_VIDEO_CodingVP9, vp9_key, sizeof(vp9_key), MPP_OK,
+    1280, 720, 0, 0, 8, MPP_FMT_YUV420SP, 0, 0, 0),
+    PROBE_CASE("vp9 10bit", MPP_VIDEO_CodingVP9, vp9_key_10bit, sizeof(vp9_key_10bit), MPP_OK,
+    3840, 2160, 2, 0, 10, MPP_FMT_YUV420SP_10BIT, 0, 0, 0),
+    PROBE_CASE("jpeg", MPP_VIDEO_CodingMJPEG, jpeg_sof, sizeof(jpeg_sof), MPP_OK,
+    640, 480, 0, 0, 8, MPP_FMT_YUV420SP, 0, 0, 0),
+    /* no key frame, no sequence header and no probe support */
+    PROBE_CASE("vp8 inter", MPP_VIDEO_CodingVP8, vp8_inter, sizeof(vp8_inter), MPP_NOK,
+    0, 0, 0, 0, 0, MPP_FMT_YUV420SP, 0, 0, 0),
+    PROBE_CASE("h264 no sps", MPP_VIDEO_CodingAVC, h264_annexb, 10, MPP_NOK,
+    0, 0, 0, 0, 0, MPP_FMT_YUV420SP, 0, 0, 0),
+    PROBE_CASE("avs", MPP_VIDEO_CodingAVS, m2v_seq, sizeof(m2v_seq), MPP_ERR_VALUE,
+    0, 0, 0, 0, 0, MPP_FMT_YUV420SP, 0, 0, 0),
+};
+
+static MPP_RET check_case(ProbeTestCase *c)
+{
+    MppDecStreamInfo info;
+    MppDecStreamInfo *exp = &c->info;
+    MPP_RET ret = mpp_dec_probe(c->coding, c->data, c->size, &info);
+
+    if (ret != c->ret) {
+        mpp_err("%-12s ret %d expect %d\n", c->name, ret, c->ret);
+        return MPP_NOK;
+    }
+
+    if (ret)
+        return MPP_OK;
+
+    mpp_log("%-12s %dx%d profile %d level %d bit %d fmt %x interlaced %d fps %d/%d\n",
+            c->name, info.width, info.height, info.profile, info.level,
+            info.bit_depth, info.fmt, info.interlaced, info.fps_num, info.fps_den);
+
+    if (memcmp(&info, exp, sizeof(info))) {
+        mpp_err("%-12s expect %dx%d profile %d level %d bit %d fmt %x interlaced %d fps %d/%d\n",
+                c->name, exp->width, exp->height, exp->profile, exp->level,
+                exp->bit_depth, exp->fmt, exp->interlaced, exp->fps_num, exp->fps_den);
+        return MPP_NOK;
+    }
+
+    return MPP_OK;
+}
+
+int main()
+{
+    MppDecStreamInfo info;
+    RK_S32 ret = MPP_OK;
+    RK_S64 start;
+    RK_U32 i;
+
+    mpp_log("mpp dec probe test start\n");
+
+    for (i = 0; i < MPP_ARRAY_ELEMS(probe_cases); i++) {
+        if (check_case(&probe_cases[i]))
+            ret = MPP_NOK;
+    }
+
+    if (MPP_ERR_NULL_PTR != mpp_dec_probe(MPP_VIDEO_CodingAVC, NULL, 0, &info)) {
+        mpp_err("probe on NULL data should fail\n");
+        ret = MPP_NOK;
+    }
+
+    if (MPP_NOK != mpp_dec_probe(MPP_VIDEO_CodingAVC, h264_annexb, 0, &info)) {
+        mpp_err("probe on empty data should find nothing\n");
+        ret = MPP_NOK;
+    }
+
+    /* probe is expected to be cheap enough for container demuxing */
+    start = mpp_time();
+    for (i = 0; i < 1000; i++)
+        mpp_dec_probe(MPP_VIDEO_CodingHEVC, h265_annexb, sizeof(h265_annexb), &info);
+    mpp_log("h265 probe average %.3f us\n", (mpp_time() - start) / 1000.0);
+
+    mpp_log("mpp dec probe test %s\n", ret ? "failed" : "success");
+    return ret;
+}
@@ -0,0 +1,139 @@
+/*
+ * Copyright 2015 Rockchip Electronics Co. LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define MODULE_TAG "mpp_enc_analysis_test"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "mpp_log.h"
+#include "mpp_time.h"
+#include "mpp_buffer.h"
+
+#include "mpp_enc_analysis.h"
+
+#define ANA_TEST_WIDTH          1280
+#define ANA_TEST_HEIGHT         720
+#define ANA_TEST_FRAMES         40
+/* frame index of the scene cut */
+#define ANA_TEST_CUT            20
+
+/* texture moving 2 pixels per frame, another texture after the cut */
+static void fill_frame(RK_U8 *luma, RK_S32 idx)
+{
+    RK_S32 x, y;
+    RK_S32 scene = idx >= ANA_TEST_CUT;
+    RK_S32 shift = idx * 2;
+
+    for (y = 0; y < ANA_TEST_HEIGHT; y++) {
+        RK_U8 *row = luma + y * ANA_TEST_WIDTH;
+
+        for (x = 0; x < ANA_TEST_WIDTH; x++) {
+            if (scene)
+                row[x] = ((x / 24 + y / 24) & 1) ? 220 : 30;
+            else
+                row[x] = (RK_U8)(((x + shift) * 3 + y * 2) & 0xff);
+        }
+    }
+}
+
+int main()
+{
+    MppEncAnalysis ana = NULL;
+    MppBufferGroup group = NULL;
+    MppBuffer buffer = NULL;
+    MppFrame frame = NULL;
+    MppEncPrepCfg prep;
+    EncAnalysisResult result;
+    RK_S64 time_sum = 0;
+    RK_S32 cut_count = 0;
+    RK_S32 cut_frame = -1;
+    RK_S32 ret = MPP_OK;
+    RK_S32 i;
+
+    mpp_log("mpp enc analysis test start\n");
+
+    memset(&prep, 0, sizeof(prep));
+    prep.width = ANA_TEST_WIDTH;
+    prep.height = ANA_TEST_HEIGHT;
+    prep.hor_stride = ANA_TEST_WIDTH;
+    prep.ver_stride = ANA_TEST_HEIGHT;
+    prep.format = MPP_FMT_YUV420SP;
+
+    ret = mpp_buffer_group_get_internal(&group, MPP_BUFFER_TYPE_NORMAL);
+    if (ret)
+        goto TEST_DONE;
+
+    ret = mpp_buffer_get(group, &buffer, ANA_TEST_WIDTH * ANA_TEST_HEIGHT * 3 / 2);
+    if (ret)
+        goto TEST_DONE;
+
+    mpp_frame_init(&frame);
+    mpp_frame_set_buffer(frame, buffer);
+
+    ret = mpp_enc_analysis_init(&ana, NULL);
+    if (ret)
+        goto TEST_DONE;
+
+    for (i = 0; i < ANA_TEST_FRAMES; i++) {
+        RK_S64 start;
+
+        fill_frame((RK_U8 *)mpp_buffer_get_ptr(buffer), i);
+
+        /* worker and inline analysis share the same history */
+        start = mpp_time();
+        if (i & 1) {
+            mpp_enc_analysis_start(ana, frame, &prep);
+            mpp_enc_analysis_wait(ana, &result);
+        } else
+            mpp_enc_analysis_proc(ana, frame, &prep, &result);
+        time_sum += mpp_time() - start;
+
+        if (!result.valid) {
+            mpp_err("frame %d analysis is not valid\n", i);
+            ret = MPP_NOK;
+            goto TEST_DONE;
+        }
+
+        if (result.scene_cut) {
+            cut_count++;
+            cut_frame = i;
+        }
+    }
+
+    mpp_log("analysis %dx%d average %.3f ms per frame\n",
+            ANA_TEST_WIDTH, ANA_TEST_HEIGHT,
+            time_sum / 1000.0 / ANA_TEST_FRAMES);
+
+    if (cut_count != 1 || cut_frame != ANA_TEST_CUT) {
+        mpp_err("scene cut count %d at frame %d expect one at %d\n",
+                cut_count, cut_frame, ANA_TEST_CUT);
+        ret = MPP_NOK;
+    }
+
+TEST_DONE:
+    if (ana)
+        mpp_enc_analysis_deinit(ana);
+    if (frame)
+        mpp_frame_deinit(&frame);
+    if (buffer)
+        mpp_buffer_put(buffer);
+    if (group)
+        mpp_buffer_group_put(group);
+
+    mpp_log("mpp enc analysis test %s\n", ret ? "failed" : "success");
+    return ret;
+}
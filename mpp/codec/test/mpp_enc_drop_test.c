@@ -0,0 +1,129 @@
+/*
+ * Copyright 2015 Rockchip Electronics Co. LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define MODULE_TAG "mpp_enc_drop_test"
+
+#include <string.h>
+
+#include "mpp_log.h"
+
+#include "mpp_enc_drop.h"
+
+#define DROP_TEST_FRAMES        30
+/* 30 fps input interval in us */
+#define DROP_TEST_INTERVAL      33333
+
+/*
+ * Feed frames arriving on time to an encoder spending enc_time us on each
+ * frame. Return dropped frame count and the max continuous dropped count.
+ */
+static RK_S32 drop_test_run(MppEncRcCfg *rc, RK_S64 enc_time, RK_S32 *max_cnt)
+{
+    MppEncDrop drop;
+    RK_S64 now = 1000000;
+    RK_S32 dropped = 0;
+    RK_S32 cnt = 0;
+    RK_S32 i;
+
+    memset(&drop, 0, sizeof(drop));
+    *max_cnt = 0;
+
+    for (i = 0; i < DROP_TEST_FRAMES; i++) {
+        RK_S32 delay = 0;
+
+        if (mpp_enc_drop_check(&drop, rc, now, 0, &delay)) {
+            dropped++;
+            cnt++;
+            *max_cnt = (cnt > *max_cnt) ? (cnt) : (*max_cnt);
+        } else {
+            mpp_enc_drop_update(&drop, enc_time);
+            cnt = 0;
+        }
+        now += DROP_TEST_INTERVAL;
+    }
+
+    return dropped;
+}
+
+int main()
+{
+    MppEncRcCfg rc;
+    MppEncDrop drop;
+    RK_S32 dropped = 0;
+    RK_S32 max_cnt = 0;
+    RK_S32 delay = 0;
+    MPP_RET ret = MPP_NOK;
+
+    mpp_log("mpp_enc_drop test start\n");
+
+    memset(&rc, 0, sizeof(rc));
+    rc.fps_in_num = 30;
+    rc.fps_in_denorm = 1;
+
+    /* drop mode off never drops */
+    dropped = drop_test_run(&rc, 100000, &max_cnt);
+    if (dropped) {
+        mpp_err("drop %d frames on drop mode off\n", dropped);
+        goto DONE;
+    }
+
+    /* encoding in budget never drops */
+    rc.drop_mode = 1;
+    dropped = drop_test_run(&rc, 20000, &max_cnt);
+    if (dropped) {
+        mpp_err("drop %d frames in budget\n", dropped);
+        goto DONE;
+    }
+
+    /* over budget without skip_cnt drops with the default limit */
+    dropped = drop_test_run(&rc, 100000, &max_cnt);
+    mpp_log("over budget drop %d / %d max continuous %d\n",
+            dropped, DROP_TEST_FRAMES, max_cnt);
+    if (!dropped || max_cnt != MPP_ENC_DROP_CNT_DEFAULT) {
+        mpp_err("over budget drop %d max continuous %d\n", dropped, max_cnt);
+        goto DONE;
+    }
+
+    /* skip_cnt limits continuous drop */
+    rc.skip_cnt = 1;
+    dropped = drop_test_run(&rc, 100000, &max_cnt);
+    if (dropped != DROP_TEST_FRAMES / 2 || max_cnt != 1) {
+        mpp_err("skip_cnt 1 drop %d max continuous %d\n", dropped, max_cnt);
+        goto DONE;
+    }
+
+    /* frames late on timeline are dropped even with fast encoding */
+    memset(&drop, 0, sizeof(drop));
+    rc.skip_cnt = 0;
+    mpp_enc_drop_check(&drop, &rc, 1000000, 0, &delay);
+    mpp_enc_drop_update(&drop, 1000);
+    if (!mpp_enc_drop_check(&drop, &rc, 1000000 + 200000, 0, &delay) ||
+        delay < 100) {
+        mpp_err("late frame with delay %d ms is not dropped\n", delay);
+        goto DONE;
+    }
+
+    /* eos frame is never dropped */
+    if (mpp_enc_drop_check(&drop, &rc, 1000000 + 400000, 1, &delay)) {
+        mpp_err("eos frame is dropped\n");
+        goto DONE;
+    }
+
+    ret = MPP_OK;
+DONE:
+    mpp_log("mpp_enc_drop test %s\n", ret ? "failed" : "success");
+    return ret;
+}
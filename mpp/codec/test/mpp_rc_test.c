@@ -0,0 +1,275 @@
+/*
+ * Copyright 2015 Rockchip Electronics Co. LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define MODULE_TAG "mpp_rc_test"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "mpp_log.h"
+#include "mpp_time.h"
+#include "mpp_common.h"
+
+#include "mpp_rc.h"
+
+#define RC_TEST_WIN_SIZE        15
+#define RC_TEST_LOOP            200000
+
+/* weight modes used by hal: vepu qstep / mad model, rkv qstep model, flat */
+static const RK_S32 rc_test_mode[] = { 2, 1, 4, 5 };
+static const double rc_test_ratio[] = { 0.7, 0.6, 0.9, 1.0 };
+
+/* weighted reference computed from the whole window */
+static void ref_linreg(MppLinReg *ctx, double ratio, double *a, double *b)
+{
+    double w = 1.0;
+    double acc_xy = 0, acc_x = 0, acc_y = 0, acc_sq_x = 0;
+    double ws = 0, b_num, denom;
+    RK_S32 i = ctx->i;
+    RK_S32 n = ctx->n;
+
+    while (n--) {
+        double x, y;
+
+        i = (i == 0) ? (ctx->size - 1) : (i - 1);
+        x = ctx->x[i];
+        y = (double)ctx->y[i];
+
+        ws += w;
+        acc_xy += w * x * y;
+        acc_x += w * x;
+        acc_y += w * y;
+        acc_sq_x += w * x * x;
+        w *= ratio;
+    }
+
+    b_num = acc_xy - acc_y * acc_x / ws;
+    denom = acc_sq_x - acc_x * acc_x / ws;
+
+    *b = (denom > acc_sq_x * 1e-9) ? round(b_num / denom) : 0;
+    *a = round((acc_y - acc_x * (*b)) / ws);
+}
+
+static void rc_test_sample(RK_S32 i, RK_S32 *x, RK_S32 *r)
+{
+    /* qstep walking around in a wide range with model like noise */
+    *x = 8 + (i * 37 + rand() % 64) % 400;
+    *r = 200000 / *x + rand() % 100;
+}
+
+/* relative error of the model estimation to the real value */
+static double rc_test_error(RK_S64 est, RK_S64 real)
+{
+    return fabs((double)(est - real)) / real;
+}
+
+/*
+ * Run bit allocation on 10 frames with the same complexity then one frame
+ * with the last complexity. Return the target bits of the last frame.
+ */
+static RK_S32 rc_test_alloc(RK_S32 complexity, RK_S32 last, RK_S32 scene_cut)
+{
+    MppRateControl *rc = NULL;
+    MppEncRcCfg cfg;
+    RcSyntax syn;
+    RcHalResult result;
+    RK_S32 i;
+
+    memset(&cfg, 0, sizeof(cfg));
+    cfg.change = MPP_ENC_RC_CFG_CHANGE_ALL;
+    cfg.bps_target = 2000000;
+    cfg.bps_min = 1000000;
+    cfg.bps_max = 3000000;
+    cfg.fps_in_num = 30;
+    cfg.fps_in_denorm = 1;
+    cfg.fps_out_num = 30;
+    cfg.fps_out_denorm = 1;
+    cfg.gop = 60;
+
+    mpp_rc_init(&rc);
+    if (NULL == rc)
+        return 0;
+
+    for (i = 0; i < 11; i++) {
+        memset(&syn, 0, sizeof(syn));
+        syn.complexity = (i < 10) ? (complexity) : (last);
+        syn.scene_cut = (i < 10) ? (0) : (scene_cut);
+
+        mpp_rc_update_user_cfg(rc, &cfg, 0);
+        mpp_rc_bits_allocation(rc, &syn);
+
+        /* hardware hits the target exactly */
+        result.type = syn.type;
+        result.time = 0;
+        result.bits = syn.bit_target;
+        if (i < 10)
+            mpp_rc_update_hw_result(rc, &result);
+    }
+
+    mpp_rc_deinit(rc);
+    return syn.bit_target;
+}
+
+int main()
+{
+    MppLinReg *reg[MPP_ARRAY_ELEMS(rc_test_mode)];
+    MppLinReg *decay = NULL;
+    RK_S32 x, r;
+    RK_S32 i, j;
+    RK_S64 start, end;
+    RK_S32 ret = MPP_OK;
+
+    mpp_log("mpp rc test start\n");
+
+    srand(0x1234);
+    memset(reg, 0, sizeof(reg));
+
+    for (j = 0; j < (RK_S32)MPP_ARRAY_ELEMS(rc_test_mode); j++) {
+        mpp_linreg_init(&reg[j], RC_TEST_WIN_SIZE, rc_test_mode[j]);
+        if (NULL == reg[j]) {
+            mpp_err("mpp rc test failed to init linreg\n");
+            ret = MPP_ERR_MALLOC;
+            goto TEST_DONE;
+        }
+    }
+
+    /* running sums must match the recomputed window after many evictions */
+    for (j = 0; j < (RK_S32)MPP_ARRAY_ELEMS(rc_test_mode); j++) {
+        MppLinReg *p = reg[j];
+
+        for (i = 0; i < RC_TEST_WIN_SIZE * 10 + 7; i++) {
+            double a, b;
+
+            rc_test_sample(i, &x, &r);
+            mpp_save_regdata(p, x, r);
+            mpp_linreg_update(p);
+            ref_linreg(p, rc_test_ratio[j], &a, &b);
+
+            /* allow rounding to the other integer on the running sum error */
+            if (fabs(a - p->a) > 1 + fabs(a) * 1e-9 || fabs(b - p->b) > 1) {
+                mpp_err("linreg mode %d mismatch at %d a %f - %f b %f - %f\n",
+                        rc_test_mode[j], i, p->a, a, p->b, b);
+                ret = MPP_NOK;
+                goto TEST_DONE;
+            }
+        }
+    }
+
+    mpp_log("linreg running sums check ok\n");
+
+    /*
+     * After the model changes, decayed weight follows the new samples and
+     * flat weight stays between the two models. x * x * r = 4000000 + 20000 * x
+     * then x * x * r = 8000000 + 40000 * x.
+     */
+    for (j = 0; j < (RK_S32)MPP_ARRAY_ELEMS(rc_test_mode); j++) {
+        MppLinReg *p = reg[j];
+
+        for (i = 0; i < RC_TEST_WIN_SIZE; i++) {
+            x = 16 + (i * 53) % 200;
+            mpp_save_regdata(p, x, (4000000 + 20000 * x) / (x * x));
+        }
+        for (i = 0; i < 4; i++) {
+            x = 16 + (i * 53) % 200;
+            mpp_save_regdata(p, x, (8000000 + 40000 * x) / (x * x));
+        }
+        mpp_linreg_update(p);
+    }
+
+    {
+        RK_S64 real = (8000000 + 40000 * 100) / (100 * 100);
+        double err_fast = rc_test_error(mpp_quadreg_calc(reg[1], 100), real);
+        double err_flat = rc_test_error(mpp_quadreg_calc(reg[3], 100), real);
+
+        mpp_log("model change error mode 1 %.3f mode 5 %.3f\n", err_fast, err_flat);
+        if (err_fast > 0.1 || err_fast >= err_flat) {
+            mpp_err("decayed linreg does not follow the new model\n");
+            ret = MPP_NOK;
+            goto TEST_DONE;
+        }
+    }
+
+    /* rkv hal fits qstep model with quadreg on mode 4 */
+    decay = reg[2];
+    for (i = 0; i < RC_TEST_WIN_SIZE; i++) {
+        x = 16 + (i * 53) % 400;
+        mpp_save_regdata(decay, x, 300 + 90000 / x + 20000000 / (x * x));
+    }
+    mpp_quadreg_update(decay, RC_TEST_WIN_SIZE);
+    for (x = 32; x < 400; x += 64) {
+        RK_S64 real = 300 + 90000 / x + 20000000 / (x * x);
+        double err = rc_test_error(mpp_quadreg_calc(decay, x), real);
+
+        if (err > 0.02) {
+            mpp_err("quadreg error %.3f at qstep %d\n", err, x);
+            ret = MPP_NOK;
+            goto TEST_DONE;
+        }
+    }
+
+    mpp_log("quadreg model check ok\n");
+
+    /* pre-analysis complexity moves bits between inter frames */
+    {
+        RK_S32 base = rc_test_alloc(0, 0, 0);
+        RK_S32 same = rc_test_alloc(1024, 1024, 0);
+        RK_S32 hard = rc_test_alloc(1024, 2048, 0);
+        RK_S32 easy = rc_test_alloc(1024, 512, 0);
+        RK_S32 cut = rc_test_alloc(1024, 4096, 1);
+
+        mpp_log("inter target base %d same %d hard %d easy %d cut %d\n",
+                base, same, hard, easy, cut);
+        if (same != base || hard <= same || easy >= same ||
+            hard > same * 4 / 3 + 1 || easy < same * 3 / 4 - 1 || cut != base) {
+            mpp_err("complexity bit allocation mismatch\n");
+            ret = MPP_NOK;
+            goto TEST_DONE;
+        }
+    }
+
+    mpp_log("complexity bit allocation check ok\n");
+
+    for (j = 0; j < (RK_S32)MPP_ARRAY_ELEMS(rc_test_mode); j++) {
+        start = mpp_time();
+        for (i = 0; i < RC_TEST_LOOP; i++) {
+            rc_test_sample(i, &x, &r);
+            mpp_save_regdata(reg[j], x, r);
+            mpp_linreg_update(reg[j]);
+        }
+        end = mpp_time();
+        mpp_log("linreg mode %d update %7.1f ns per frame\n", rc_test_mode[j],
+                (end - start) * 1000.0 / RC_TEST_LOOP);
+    }
+
+    start = mpp_time();
+    for (i = 0; i < RC_TEST_LOOP; i++) {
+        rc_test_sample(i, &x, &r);
+        mpp_save_regdata(decay, x, r);
+        mpp_quadreg_update(decay, RC_TEST_WIN_SIZE);
+    }
+    end = mpp_time();
+    mpp_log("quadreg       update %7.1f ns per frame\n",
+            (end - start) * 1000.0 / RC_TEST_LOOP);
+
+TEST_DONE:
+    for (j = 0; j < (RK_S32)MPP_ARRAY_ELEMS(rc_test_mode); j++)
+        if (reg[j])
+            mpp_linreg_deinit(reg[j]);
+
+    mpp_log("mpp rc test %s\n", ret ? "failed" : "success");
+    return ret;
+}
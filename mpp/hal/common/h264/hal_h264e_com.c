@@ -16,6 +16,7 @@
 
 #define MODULE_TAG "h264e_com"
 
+#include <stdlib.h>
 #include <string.h>
 #include <math.h>
 
@@ -826,3 +827,175 @@ void h264e_sei_pack2str(char *str, H264eHalContext *ctx, RcSyntax *rc_syn)
     }
 }
 
+
+/*
+ * Intra frame bits model for initial qp estimation:
+ *     bits = pels * mad * H264E_INIT_QP_BITS_SCALE / qstep
+ * mad is the average mean absolute deviation of 8x8 blocks on the luma plane
+ * downsampled by 2 in both direction.
+ *
+ * The scale is calibrated against the bpp table used when there is no
+ * estimation: with scale 0.5 the model gives the same qp as the bpp table at
+ * mad 2 on 0.05 ~ 0.4 bpp for all resolutions. So low texture content keeps
+ * the old initial qp and every doubling of mad adds 6 to the qp.
+ */
+#define H264E_INIT_QP_BITS_SCALE    0.5
+#define H264E_INIT_QP_BLK_SIZE      8
+#define H264E_INIT_QP_STEP          2
+
+static RK_S32 h264e_luma_is_planar(MppFrameFormat format)
+{
+    if ((format & MPP_FRAME_FMT_MASK) != MPP_FRAME_FMT_YUV)
+        return 0;
+
+    switch (format) {
+    case MPP_FMT_YUV420SP_10BIT :
+    case MPP_FMT_YUV422SP_10BIT :
+    case MPP_FMT_YUV422_YUYV :
+    case MPP_FMT_YUV422_UYVY : {
+        return 0;
+    } break;
+    default : {
+    } break;
+    }
+
+    return (format < MPP_FMT_YUV_BUTT);
+}
+
+/*
+ * Solve intra frame qp from luma mad with the bits model above. The mad can
+ * come from the first frame estimation or from mpp_enc pre-analysis.
+ */
+RK_S32 h264e_calc_intra_qp(MppEncPrepCfg *prep, double mad, RK_S32 bits,
+                           RK_S32 qp_min, RK_S32 qp_max)
+{
+    double qstep;
+    RK_S32 qp;
+
+    if (bits <= 0)
+        return qp_max;
+
+    /* flat frame still spends bits on block edge and header */
+    mad = MPP_MAX(mad, 1.0);
+
+    qstep = (double)prep->width * prep->height * mad * H264E_INIT_QP_BITS_SCALE / bits;
+    qp = (RK_S32)ceil(6 * log2(qstep / 0.625));
+
+    return mpp_clip(qp, qp_min, qp_max);
+}
+
+/*
+ * Estimate the qp of the first intra frame on cpu from luma complexity, so
+ * the first frames do not need to be encoded twice to find the proper qp.
+ * Return -1 when the input can not be read then caller should fall back to
+ * the bpp based estimation.
+ */
+RK_S32 h264e_estimate_init_qp(MppEncPrepCfg *prep, MppBuffer input, RK_S32 bits,
+                              RK_S32 qp_min, RK_S32 qp_max)
+{
+    const RK_S32 blk = H264E_INIT_QP_BLK_SIZE;
+    const RK_S32 step = H264E_INIT_QP_STEP;
+    RK_S32 stride = (prep->hor_stride) ? (prep->hor_stride) : (prep->width);
+    RK_S32 blk_w = blk * step;
+    RK_S32 blk_x_cnt = prep->width / blk_w;
+    RK_S32 blk_y_cnt = prep->height / blk_w;
+    RK_S64 mad_sum = 0;
+    RK_U8 *luma = NULL;
+    RK_S32 bx, by;
+    double mad;
+    RK_S32 qp;
+
+    if (NULL == input || bits <= 0 || !blk_x_cnt || !blk_y_cnt ||
+        !h264e_luma_is_planar(prep->format))
+        return -1;
+
+    luma = (RK_U8 *)mpp_buffer_get_ptr(input);
+    if (NULL == luma)
+        return -1;
+
+    for (by = 0; by < blk_y_cnt; by++) {
+        for (bx = 0; bx < blk_x_cnt; bx++) {
+            RK_U8 *src = luma + by * blk_w * stride + bx * blk_w;
+            RK_S32 sum = 0;
+            RK_S32 dev = 0;
+            RK_S32 avg;
+            RK_S32 x, y;
+
+            for (y = 0; y < blk; y++)
+                for (x = 0; x < blk; x++)
+                    sum += src[y * step * stride + x * step];
+
+            avg = sum / (blk * blk);
+
+            for (y = 0; y < blk; y++)
+                for (x = 0; x < blk; x++)
+                    dev += abs(src[y * step * stride + x * step] - avg);
+
+            mad_sum += dev;
+        }
+    }
+
+    mad = (double)mad_sum / (blk_x_cnt * blk_y_cnt * blk * blk);
+    qp = h264e_calc_intra_qp(prep, mad, bits, qp_min, qp_max);
+
+    h264e_hal_dbg(H264E_DBG_RC, "init qp %d from mad %.2f target bits %d\n",
+                  qp, mad, bits);
+
+    return qp;
+}
+
+/*
+ * Stream header cache
+ *
+ * sps / pps are serialized bit by bit with emulation prevention. The result
+ * only depends on encoder config so the bytes are kept and reused by
+ * MPP_ENC_GET_EXTRA_INFO until the config is changed again.
+ */
+void h264e_hdr_cache_reset(H264eHalContext *ctx)
+{
+    ctx->hdr_len = 0;
+    ctx->hdr_valid = 0;
+}
+
+void h264e_hdr_cache_deinit(H264eHalContext *ctx)
+{
+    MPP_FREE(ctx->hdr_buf);
+    h264e_hdr_cache_reset(ctx);
+}
+
+MPP_RET h264e_hdr_cache_write(H264eHalContext *ctx, void *data, RK_S32 len)
+{
+    if (NULL == ctx->hdr_buf) {
+        ctx->hdr_buf = mpp_calloc(RK_U8, H264E_EXTRA_INFO_BUF_SIZE);
+        if (NULL == ctx->hdr_buf) {
+            h264e_hal_err("failed to malloc header cache\n");
+            return MPP_ERR_MALLOC;
+        }
+    }
+
+    if (ctx->hdr_len + len > H264E_EXTRA_INFO_BUF_SIZE) {
+        h264e_hal_err("header size %d exceed cache size %d\n",
+                      ctx->hdr_len + len, H264E_EXTRA_INFO_BUF_SIZE);
+        return MPP_NOK;
+    }
+
+    memcpy(ctx->hdr_buf + ctx->hdr_len, data, len);
+    ctx->hdr_len += len;
+
+    return MPP_OK;
+}
+
+MPP_RET h264e_hdr_cache_get(H264eHalContext *ctx, MppPacket *pkt_out)
+{
+    MppPacket pkt = ctx->packeted_param;
+
+    if (ctx->hdr_len)
+        mpp_packet_write(pkt, 0, ctx->hdr_buf, ctx->hdr_len);
+    mpp_packet_set_length(pkt, ctx->hdr_len);
+    *pkt_out = pkt;
+
+    h264e_hal_dbg(H264E_DBG_HEADER, "get extra info %d bytes from cache\n",
+                  ctx->hdr_len);
+
+    return MPP_OK;
+}
@@ -336,6 +336,10 @@ typedef struct H264eHalContext_t {
     RK_U32                          frame_cnt_gen_ready;
     RK_U32                          frame_cnt_send_ready;
     RK_U32                          num_frames_to_send;
+    RK_U32                          frame_cnt_wait_done;
+    /* frames per hardware batch set by MPP_ENC_SET_TASK_BATCH */
+    RK_U32                          batch;
+    void                            *batch_info;
     /* @frame_cnt starts from ZERO */
     RK_U32                          frame_cnt;
     H264eHalParam                   param;
@@ -345,6 +349,13 @@ typedef struct H264eHalContext_t {
 
     void                            *param_buf;
     MppPacket                       packeted_param;
+    /*
+     * serialized stream header returned by MPP_ENC_GET_EXTRA_INFO
+     * It is only rebuilt after prep / rc / codec / sei config is changed.
+     */
+    RK_U8                           *hdr_buf;
+    RK_S32                          hdr_len;
+    RK_U32                          hdr_valid;
 
     RK_S32                          osd_plt_type; //-1:invalid, 0:user define, 1:default
     MppEncOSDData                   osd_data;
@@ -363,6 +374,11 @@ typedef struct H264eHalContext_t {
     MppData                         *qp_p;
     MppData                         *sse_p;
     H264eMbRcCtx                    mb_rc;
+    /*
+     * initial qp is estimated from the complexity of the first frame
+     * only rkv hal uses it to skip the first frame re-encode
+     */
+    RK_U32                          qp_estimated;
 } H264eHalContext;
 
 MPP_RET h264e_set_sps(H264eHalContext *ctx, H264eSps *sps);
@@ -375,5 +391,14 @@ const RK_U8 h264e_zigzag_scan8[2][64];
 void h264e_rkv_set_format(H264eHwCfg *hw_cfg, MppEncPrepCfg *prep_cfg);
 void h264e_vpu_set_format(H264eHwCfg *hw_cfg, MppEncPrepCfg *prep_cfg);
 void h264e_sei_pack2str(char *str, H264eHalContext *ctx, RcSyntax *rc_syn);
+RK_S32 h264e_estimate_init_qp(MppEncPrepCfg *prep, MppBuffer input, RK_S32 bits,
+                              RK_S32 qp_min, RK_S32 qp_max);
+RK_S32 h264e_calc_intra_qp(MppEncPrepCfg *prep, double mad, RK_S32 bits,
+                           RK_S32 qp_min, RK_S32 qp_max);
+
+void h264e_hdr_cache_reset(H264eHalContext *ctx);
+void h264e_hdr_cache_deinit(H264eHalContext *ctx);
+MPP_RET h264e_hdr_cache_write(H264eHalContext *ctx, void *data, RK_S32 len);
+MPP_RET h264e_hdr_cache_get(H264eHalContext *ctx, MppPacket *pkt_out);
 
 #endif
@@ -0,0 +1,230 @@
+/*
+ * Copyright 2018 Rockchip Electronics Co. LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define MODULE_TAG "hal_pkt_cache"
+
+#include <string.h>
+
+#include "mpp_env.h"
+#include "mpp_log.h"
+#include "mpp_mem.h"
+#include "mpp_common.h"
+
+#include "hal_pkt_cache.h"
+
+#define HAL_PKT_CACHE_DBG_FLOW      (0x00000001)
+#define HAL_PKT_CACHE_DBG_MISS      (0x00000002)
+
+#define hal_pkt_cache_dbg_f(flag, fmt, ...) \
+    _mpp_dbg_f(hal_pkt_cache_debug, flag, fmt, ## __VA_ARGS__)
+
+static RK_U32 hal_pkt_cache_debug = 0;
+
+typedef struct HalPktEntry_t {
+    RK_U32          valid;
+    RK_U32          hash;
+    RK_U32          serial;
+    /* last access time for lru replacement */
+    RK_U32          access;
+    RK_U8           *key;
+    RK_U8           *pkt;
+} HalPktEntry;
+
+typedef struct HalPktCacheImpl_t {
+    RK_S32          count;
+    size_t          key_size;
+    size_t          pkt_size;
+
+    RK_U32          serial;
+    RK_U32          access;
+    HalPktEntry     *entries;
+
+    HalPktCacheStat stat;
+} HalPktCacheImpl;
+
+/* fnv-1a hash with word step for speed on large key */
+static RK_U32 hal_pkt_cache_hash(const void *key, size_t size)
+{
+    const RK_U8 *p = (const RK_U8 *)key;
+    RK_U32 hash = 2166136261u;
+    size_t i;
+
+    for (i = 0; i + 4 <= size; i += 4) {
+        RK_U32 val;
+
+        memcpy(&val, p + i, sizeof(val));
+        hash = (hash ^ val) * 16777619u;
+    }
+    for (; i < size; i++)
+        hash = (hash ^ p[i]) * 16777619u;
+
+    return hash;
+}
+
+MPP_RET hal_pkt_cache_init(HalPktCache *cache, RK_S32 count,
+                           size_t key_size, size_t pkt_size)
+{
+    HalPktCacheImpl *p = NULL;
+    RK_U8 *buf = NULL;
+    size_t key_stride = MPP_ALIGN(key_size, 8);
+    size_t pkt_stride = MPP_ALIGN(pkt_size, 8);
+    RK_S32 i;
+
+    if (NULL == cache || count <= 0 || 0 == key_size || 0 == pkt_size) {
+        mpp_err_f("invalid input cache %p count %d key %d pkt %d\n",
+                  cache, count, key_size, pkt_size);
+        return MPP_ERR_VALUE;
+    }
+
+    mpp_env_get_u32("hal_pkt_cache_debug", &hal_pkt_cache_debug, 0);
+
+    *cache = NULL;
+
+    /* context, entries, keys and packets in one allocation */
+    p = mpp_calloc_size(HalPktCacheImpl, sizeof(HalPktCacheImpl) +
+                        sizeof(HalPktEntry) * count +
+                        (key_stride + pkt_stride) * count);
+    if (NULL == p) {
+        mpp_err_f("failed to malloc cache\n");
+        return MPP_ERR_MALLOC;
+    }
+
+    p->count = count;
+    p->key_size = key_size;
+    p->pkt_size = pkt_size;
+    p->entries = (HalPktEntry *)(p + 1);
+
+    buf = (RK_U8 *)(p->entries + count);
+    for (i = 0; i < count; i++) {
+        p->entries[i].key = buf;
+        buf += key_stride;
+        p->entries[i].pkt = buf;
+        buf += pkt_stride;
+    }
+
+    hal_pkt_cache_dbg_f(HAL_PKT_CACHE_DBG_FLOW, "%p count %d key %d pkt %d\n",
+                        p, count, key_size, pkt_size);
+
+    *cache = p;
+    return MPP_OK;
+}
+
+MPP_RET hal_pkt_cache_deinit(HalPktCache cache)
+{
+    HalPktCacheImpl *p = (HalPktCacheImpl *)cache;
+
+    if (NULL == p) {
+        mpp_err_f("invalid NULL input\n");
+        return MPP_ERR_NULL_PTR;
+    }
+
+    hal_pkt_cache_dbg_f(HAL_PKT_CACHE_DBG_FLOW, "%p hit %d miss %d\n",
+                        p, p->stat.hit, p->stat.miss);
+
+    mpp_free(p);
+    return MPP_OK;
+}
+
+void *hal_pkt_cache_get(HalPktCache cache, const void *key, RK_U32 *serial)
+{
+    HalPktCacheImpl *p = (HalPktCacheImpl *)cache;
+    RK_U32 hash;
+    RK_S32 i;
+
+    if (NULL == p || NULL == key) {
+        mpp_err_f("invalid input cache %p key %p\n", p, key);
+        return NULL;
+    }
+
+    hash = hal_pkt_cache_hash(key, p->key_size);
+
+    for (i = 0; i < p->count; i++) {
+        HalPktEntry *entry = &p->entries[i];
+
+        if (entry->valid && entry->hash == hash &&
+            !memcmp(entry->key, key, p->key_size)) {
+            entry->access = ++p->access;
+            p->stat.hit++;
+
+            if (serial)
+                *serial = entry->serial;
+
+            return entry->pkt;
+        }
+    }
+
+    p->stat.miss++;
+    hal_pkt_cache_dbg_f(HAL_PKT_CACHE_DBG_MISS, "%p miss hash %08x\n", p, hash);
+
+    return NULL;
+}
+
+void *hal_pkt_cache_put(HalPktCache cache, const void *key, const void *pkt,
+                        RK_U32 *serial)
+{
+    HalPktCacheImpl *p = (HalPktCacheImpl *)cache;
+    HalPktEntry *entry = NULL;
+    RK_S32 i;
+
+    if (NULL == p || NULL == key || NULL == pkt) {
+        mpp_err_f("invalid input cache %p key %p pkt %p\n", p, key, pkt);
+        return NULL;
+    }
+
+    /* take invalid entry first then the least recently used one */
+    entry = &p->entries[0];
+    for (i = 0; i < p->count; i++) {
+        HalPktEntry *tmp = &p->entries[i];
+
+        if (!tmp->valid) {
+            entry = tmp;
+            break;
+        }
+
+        if (tmp->access < entry->access)
+            entry = tmp;
+    }
+
+    /* zero serial is reserved for buffer not written yet */
+    p->serial++;
+    if (0 == p->serial)
+        p->serial++;
+
+    memcpy(entry->key, key, p->key_size);
+    memcpy(entry->pkt, pkt, p->pkt_size);
+    entry->hash = hal_pkt_cache_hash(key, p->key_size);
+    entry->serial = p->serial;
+    entry->access = ++p->access;
+    entry->valid = 1;
+
+    if (serial)
+        *serial = entry->serial;
+
+    return entry->pkt;
+}
+
+MPP_RET hal_pkt_cache_stat(HalPktCache cache, HalPktCacheStat *stat)
+{
+    HalPktCacheImpl *p = (HalPktCacheImpl *)cache;
+
+    if (NULL == p || NULL == stat) {
+        mpp_err_f("invalid input cache %p stat %p\n", p, stat);
+        return MPP_ERR_NULL_PTR;
+    }
+
+    *stat = p->stat;
+    return MPP_OK;
+}
@@ -0,0 +1,64 @@
+/*
+ * Copyright 2018 Rockchip Electronics Co. LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __HAL_PKT_CACHE_H__
+#define __HAL_PKT_CACHE_H__
+
+#include <stddef.h>
+
+#include "rk_type.h"
+#include "mpp_err.h"
+
+/*
+ * Cache of serialized hardware packets keyed by their input
+ *
+ * Packet built from parameter set (sps / pps) is the same while the active
+ * parameter set is unchanged. Hal fills a key with all the syntax elements
+ * used by the packet and searches the cache before serializing. The key is
+ * compared by hash then by content so any change on the elements builds a
+ * new packet.
+ *
+ * Each packet gets a serial number which is never reused in one cache. Hal can
+ * record the serial written to each hardware buffer and skip the buffer
+ * update when the serial is unchanged.
+ */
+typedef void* HalPktCache;
+
+typedef struct HalPktCacheStat_t {
+    RK_U32          hit;
+    RK_U32          miss;
+} HalPktCacheStat;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+MPP_RET hal_pkt_cache_init(HalPktCache *cache, RK_S32 count,
+                           size_t key_size, size_t pkt_size);
+MPP_RET hal_pkt_cache_deinit(HalPktCache cache);
+
+/* return cached packet and its serial on hit or NULL on miss */
+void   *hal_pkt_cache_get(HalPktCache cache, const void *key, RK_U32 *serial);
+/* save packet to the least recently used entry and return the cached copy */
+void   *hal_pkt_cache_put(HalPktCache cache, const void *key, const void *pkt,
+                          RK_U32 *serial);
+MPP_RET hal_pkt_cache_stat(HalPktCache cache, HalPktCacheStat *stat);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __HAL_PKT_CACHE_H__ */
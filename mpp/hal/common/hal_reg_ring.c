@@ -0,0 +1,152 @@
+/*
+ * Copyright 2018 Rockchip Electronics Co. LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define MODULE_TAG "hal_reg_ring"
+
+#include <string.h>
+
+#include "mpp_env.h"
+#include "mpp_log.h"
+#include "mpp_mem.h"
+#include "mpp_common.h"
+
+#include "hal_reg_ring.h"
+
+#define HAL_REG_RING_DBG_FLOW       (0x00000001)
+#define HAL_REG_RING_DBG_TASK       (0x00000002)
+
+#define hal_reg_ring_dbg_f(flag, fmt, ...) \
+    _mpp_dbg_f(hal_reg_ring_debug, flag, fmt, ## __VA_ARGS__)
+
+static RK_U32 hal_reg_ring_debug = 0;
+
+typedef struct HalRegRingImpl_t {
+    RK_S32          count;
+    size_t          elem_size;
+    /* next position to search for free element */
+    RK_S32          pos;
+
+    RK_U32          *used;
+    RK_U8           *elems;
+} HalRegRingImpl;
+
+MPP_RET hal_reg_ring_init(HalRegRing *ring, RK_S32 count, size_t elem_size)
+{
+    HalRegRingImpl *p = NULL;
+    size_t used_size = MPP_ALIGN(sizeof(RK_U32) * count, 8);
+
+    if (NULL == ring || count <= 0 || 0 == elem_size) {
+        mpp_err_f("invalid input ring %p count %d elem %d\n",
+                  ring, count, elem_size);
+        return MPP_ERR_VALUE;
+    }
+
+    mpp_env_get_u32("hal_reg_ring_debug", &hal_reg_ring_debug, 0);
+
+    *ring = NULL;
+
+    /* context, used flags and elements in one allocation */
+    p = mpp_calloc_size(HalRegRingImpl, sizeof(HalRegRingImpl) + used_size +
+                        elem_size * count);
+    if (NULL == p) {
+        mpp_err_f("failed to malloc ring\n");
+        return MPP_ERR_MALLOC;
+    }
+
+    p->count = count;
+    p->elem_size = elem_size;
+    p->used = (RK_U32 *)(p + 1);
+    p->elems = (RK_U8 *)p->used + used_size;
+
+    hal_reg_ring_dbg_f(HAL_REG_RING_DBG_FLOW, "%p count %d elem %d\n",
+                       p, count, elem_size);
+
+    *ring = p;
+    return MPP_OK;
+}
+
+MPP_RET hal_reg_ring_deinit(HalRegRing ring)
+{
+    HalRegRingImpl *p = (HalRegRingImpl *)ring;
+
+    if (NULL == p) {
+        mpp_err_f("invalid NULL input\n");
+        return MPP_ERR_NULL_PTR;
+    }
+
+    hal_reg_ring_dbg_f(HAL_REG_RING_DBG_FLOW, "%p\n", p);
+
+    mpp_free(p);
+    return MPP_OK;
+}
+
+void *hal_reg_ring_elems(HalRegRing ring)
+{
+    HalRegRingImpl *p = (HalRegRingImpl *)ring;
+
+    return (p) ? (p->elems) : (NULL);
+}
+
+RK_S32 hal_reg_ring_count(HalRegRing ring)
+{
+    HalRegRingImpl *p = (HalRegRingImpl *)ring;
+
+    return (p) ? (p->count) : (0);
+}
+
+RK_S32 hal_reg_ring_get(HalRegRing ring)
+{
+    HalRegRingImpl *p = (HalRegRingImpl *)ring;
+    RK_S32 i;
+
+    if (NULL == p) {
+        mpp_err_f("invalid NULL input\n");
+        return -1;
+    }
+
+    for (i = 0; i < p->count; i++) {
+        RK_S32 index = (p->pos + i) % p->count;
+
+        if (!p->used[index]) {
+            p->used[index] = 1;
+            p->pos = (index + 1) % p->count;
+
+            hal_reg_ring_dbg_f(HAL_REG_RING_DBG_TASK, "%p get %d\n", p, index);
+            return index;
+        }
+    }
+
+    hal_reg_ring_dbg_f(HAL_REG_RING_DBG_TASK, "%p all %d in flight\n", p, p->count);
+    return -1;
+}
+
+MPP_RET hal_reg_ring_put(HalRegRing ring, RK_S32 index)
+{
+    HalRegRingImpl *p = (HalRegRingImpl *)ring;
+
+    if (NULL == p || index < 0 || index >= p->count) {
+        mpp_err_f("invalid input ring %p index %d\n", p, index);
+        return MPP_ERR_VALUE;
+    }
+
+    if (!p->used[index])
+        mpp_err_f("put element %d which is not in use\n", index);
+
+    hal_reg_ring_dbg_f(HAL_REG_RING_DBG_TASK, "%p put %d\n", p, index);
+
+    p->used[index] = 0;
+    return MPP_OK;
+}
@@ -0,0 +1,57 @@
+/*
+ * Copyright 2018 Rockchip Electronics Co. LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __HAL_REG_RING_H__
+#define __HAL_REG_RING_H__
+
+#include <stddef.h>
+
+#include "rk_type.h"
+#include "mpp_err.h"
+
+/*
+ * Ring of per-task register sets for hal in fast mode
+ *
+ * In fast mode register generation of next task runs while previous tasks are
+ * still on hardware. So each task in flight needs its own register set and
+ * packet buffers. The ring allocates count elements of hal defined structure
+ * and hal takes one free element on gen_regs and returns it on wait.
+ *
+ * The ring depth is the hal task count from MppHalCfg which can be changed
+ * by MPP_DEC_SET_TASK_COUNT before decoder init.
+ */
+typedef void* HalRegRing;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+MPP_RET hal_reg_ring_init(HalRegRing *ring, RK_S32 count, size_t elem_size);
+MPP_RET hal_reg_ring_deinit(HalRegRing ring);
+
+/* element array base, elements are cleared on init */
+void   *hal_reg_ring_elems(HalRegRing ring);
+RK_S32  hal_reg_ring_count(HalRegRing ring);
+
+/* take next free element, return index or negative value when all in flight */
+RK_S32  hal_reg_ring_get(HalRegRing ring);
+MPP_RET hal_reg_ring_put(HalRegRing ring, RK_S32 index);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __HAL_REG_RING_H__ */
@@ -0,0 +1,197 @@
+/*
+ * Copyright 2018 Rockchip Electronics Co. LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define MODULE_TAG "hal_reg_tmpl"
+
+#include <string.h>
+
+#include "mpp_env.h"
+#include "mpp_log.h"
+#include "mpp_mem.h"
+#include "mpp_common.h"
+
+#include "hal_reg_tmpl.h"
+
+#define HAL_REG_TMPL_DBG_FLOW       (0x00000001)
+#define HAL_REG_TMPL_DBG_REBUILD    (0x00000002)
+#define HAL_REG_TMPL_DBG_CHECK      (0x00000010)
+
+#define hal_reg_tmpl_dbg_f(flag, fmt, ...) \
+    _mpp_dbg_f(hal_reg_tmpl_debug, flag, fmt, ## __VA_ARGS__)
+
+static RK_U32 hal_reg_tmpl_debug = 0;
+
+typedef struct HalRegTmplImpl_t {
+    size_t          reg_size;
+    size_t          key_size;
+
+    RK_U32          valid;
+    RK_U8           *key;
+    RK_U8           *regs;
+    /* reference register set for full regeneration check */
+    RK_U8           *ref;
+
+    HalRegTmplStat  stat;
+} HalRegTmplImpl;
+
+MPP_RET hal_reg_tmpl_init(HalRegTmpl *tmpl, size_t reg_size, size_t key_size)
+{
+    HalRegTmplImpl *p = NULL;
+    RK_U32 check = 0;
+
+    if (NULL == tmpl || 0 == reg_size || 0 == key_size) {
+        mpp_err_f("invalid input tmpl %p reg %d key %d\n",
+                  tmpl, reg_size, key_size);
+        return MPP_ERR_VALUE;
+    }
+
+    mpp_env_get_u32("hal_reg_tmpl_debug", &hal_reg_tmpl_debug, 0);
+    check = (hal_reg_tmpl_debug & HAL_REG_TMPL_DBG_CHECK) ? 1 : 0;
+
+    *tmpl = NULL;
+
+    /* context, template, key and reference in one allocation */
+    p = mpp_calloc_size(HalRegTmplImpl, sizeof(HalRegTmplImpl) +
+                        MPP_ALIGN(reg_size, 8) * (1 + check) +
+                        MPP_ALIGN(key_size, 8));
+    if (NULL == p) {
+        mpp_err_f("failed to malloc template\n");
+        return MPP_ERR_MALLOC;
+    }
+
+    p->reg_size = reg_size;
+    p->key_size = key_size;
+    p->regs = (RK_U8 *)(p + 1);
+    p->key = p->regs + MPP_ALIGN(reg_size, 8);
+    if (check)
+        p->ref = p->key + MPP_ALIGN(key_size, 8);
+
+    hal_reg_tmpl_dbg_f(HAL_REG_TMPL_DBG_FLOW, "%p reg %d key %d check %d\n",
+                       p, reg_size, key_size, check);
+
+    *tmpl = p;
+    return MPP_OK;
+}
+
+MPP_RET hal_reg_tmpl_deinit(HalRegTmpl tmpl)
+{
+    HalRegTmplImpl *p = (HalRegTmplImpl *)tmpl;
+
+    if (NULL == p) {
+        mpp_err_f("invalid NULL input\n");
+        return MPP_ERR_NULL_PTR;
+    }
+
+    hal_reg_tmpl_dbg_f(HAL_REG_TMPL_DBG_FLOW, "%p rebuild %d apply %d mismatch %d\n",
+                       p, p->stat.rebuild, p->stat.apply, p->stat.mismatch);
+
+    mpp_free(p);
+    return MPP_OK;
+}
+
+void *hal_reg_tmpl_update(HalRegTmpl tmpl, const void *key)
+{
+    HalRegTmplImpl *p = (HalRegTmplImpl *)tmpl;
+
+    if (NULL == p || NULL == key) {
+        mpp_err_f("invalid input tmpl %p key %p\n", p, key);
+        return NULL;
+    }
+
+    if (p->valid && !memcmp(p->key, key, p->key_size))
+        return NULL;
+
+    hal_reg_tmpl_dbg_f(HAL_REG_TMPL_DBG_REBUILD, "%p rebuild %d\n",
+                       p, p->stat.rebuild);
+
+    memcpy(p->key, key, p->key_size);
+    memset(p->regs, 0, p->reg_size);
+    p->valid = 1;
+    p->stat.rebuild++;
+
+    return p->regs;
+}
+
+MPP_RET hal_reg_tmpl_apply(HalRegTmpl tmpl, void *regs)
+{
+    HalRegTmplImpl *p = (HalRegTmplImpl *)tmpl;
+
+    if (NULL == p || NULL == regs) {
+        mpp_err_f("invalid input tmpl %p regs %p\n", p, regs);
+        return MPP_ERR_NULL_PTR;
+    }
+
+    if (!p->valid) {
+        mpp_err_f("template is not built yet\n");
+        return MPP_NOK;
+    }
+
+    memcpy(regs, p->regs, p->reg_size);
+    p->stat.apply++;
+    return MPP_OK;
+}
+
+void *hal_reg_tmpl_check_ref(HalRegTmpl tmpl)
+{
+    HalRegTmplImpl *p = (HalRegTmplImpl *)tmpl;
+
+    if (NULL == p || NULL == p->ref)
+        return NULL;
+
+    memset(p->ref, 0, p->reg_size);
+    return p->ref;
+}
+
+MPP_RET hal_reg_tmpl_check(HalRegTmpl tmpl, const void *regs, const void *ref)
+{
+    HalRegTmplImpl *p = (HalRegTmplImpl *)tmpl;
+    const RK_U32 *val = (const RK_U32 *)regs;
+    const RK_U32 *exp = (const RK_U32 *)ref;
+    MPP_RET ret = MPP_OK;
+    size_t i;
+
+    if (NULL == p || NULL == regs || NULL == ref) {
+        mpp_err_f("invalid input tmpl %p regs %p ref %p\n", p, regs, ref);
+        return MPP_ERR_NULL_PTR;
+    }
+
+    p->stat.check++;
+
+    for (i = 0; i < p->reg_size / sizeof(RK_U32); i++) {
+        if (val[i] != exp[i]) {
+            mpp_err_f("reg[%03d] template %08x full %08x\n", i, val[i], exp[i]);
+            ret = MPP_NOK;
+        }
+    }
+
+    if (ret)
+        p->stat.mismatch++;
+
+    return ret;
+}
+
+MPP_RET hal_reg_tmpl_stat(HalRegTmpl tmpl, HalRegTmplStat *stat)
+{
+    HalRegTmplImpl *p = (HalRegTmplImpl *)tmpl;
+
+    if (NULL == p || NULL == stat) {
+        mpp_err_f("invalid input tmpl %p stat %p\n", p, stat);
+        return MPP_ERR_NULL_PTR;
+    }
+
+    *stat = p->stat;
+    return MPP_OK;
+}
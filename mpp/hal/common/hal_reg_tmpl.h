@@ -0,0 +1,67 @@
+/*
+ * Copyright 2018 Rockchip Electronics Co. LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __HAL_REG_TMPL_H__
+#define __HAL_REG_TMPL_H__
+
+#include <stddef.h>
+
+#include "rk_type.h"
+#include "mpp_err.h"
+
+/*
+ * Register template for per-frame register generation
+ *
+ * Most of the decoder registers only depend on the sequence (resolution,
+ * stride, format, table address). Hal builds these registers into the
+ * template once when the sequence key changes. On each frame the template
+ * replaces the full register memset and the per-frame generator only writes
+ * the registers which change on each frame.
+ *
+ * With hal_reg_tmpl_debug bit 0x10 set hal_reg_tmpl_check_ref returns a
+ * buffer for full regeneration and hal_reg_tmpl_check reports every register
+ * word that differs from the template path.
+ */
+typedef void* HalRegTmpl;
+
+typedef struct HalRegTmplStat_t {
+    RK_U32          rebuild;
+    RK_U32          apply;
+    RK_U32          check;
+    RK_U32          mismatch;
+} HalRegTmplStat;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+MPP_RET hal_reg_tmpl_init(HalRegTmpl *tmpl, size_t reg_size, size_t key_size);
+MPP_RET hal_reg_tmpl_deinit(HalRegTmpl tmpl);
+
+/* return cleared template to fill on key change, NULL when still valid */
+void   *hal_reg_tmpl_update(HalRegTmpl tmpl, const void *key);
+MPP_RET hal_reg_tmpl_apply(HalRegTmpl tmpl, void *regs);
+
+/* return cleared reference register set when check is enabled */
+void   *hal_reg_tmpl_check_ref(HalRegTmpl tmpl);
+MPP_RET hal_reg_tmpl_check(HalRegTmpl tmpl, const void *regs, const void *ref);
+MPP_RET hal_reg_tmpl_stat(HalRegTmpl tmpl, HalRegTmplStat *stat);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __HAL_REG_TMPL_H__ */
@@ -0,0 +1,213 @@
+/*
+ * Copyright 2018 Rockchip Electronics Co. LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define MODULE_TAG "hal_scratch"
+
+#include <string.h>
+
+#include "mpp_env.h"
+#include "mpp_log.h"
+#include "mpp_mem.h"
+#include "mpp_common.h"
+
+#include "hal_scratch.h"
+
+#define HAL_SCRATCH_DBG_FLOW        (0x00000001)
+#define HAL_SCRATCH_DBG_GROW        (0x00000002)
+
+#define hal_scratch_dbg(flag, fmt, ...) \
+    _mpp_dbg(hal_scratch_debug, flag, fmt, ## __VA_ARGS__)
+
+#define hal_scratch_dbg_f(flag, fmt, ...) \
+    _mpp_dbg_f(hal_scratch_debug, flag, fmt, ## __VA_ARGS__)
+
+#define HAL_SCRATCH_ALIGN           16
+
+static RK_U32 hal_scratch_debug = 0;
+
+/* heap block used when arena is not large enough */
+typedef struct HalScratchBlk_t {
+    struct HalScratchBlk_t  *next;
+    size_t                  size;
+} HalScratchBlk;
+
+typedef struct HalScratchImpl_t {
+    RK_U8           *base;
+    size_t          size;
+    size_t          used;
+    /* total request size in current task including heap blocks */
+    size_t          request;
+
+    HalScratchBlk   *blks;
+
+    HalScratchStat  stat;
+} HalScratchImpl;
+
+MPP_RET hal_scratch_init(HalScratch *ctx, size_t size)
+{
+    HalScratchImpl *p = NULL;
+
+    if (NULL == ctx) {
+        mpp_err_f("invalid NULL input\n");
+        return MPP_ERR_NULL_PTR;
+    }
+
+    mpp_env_get_u32("hal_scratch_debug", &hal_scratch_debug, 0);
+
+    *ctx = NULL;
+    p = mpp_calloc(HalScratchImpl, 1);
+    if (NULL == p) {
+        mpp_err_f("failed to malloc context\n");
+        return MPP_ERR_MALLOC;
+    }
+
+    size = MPP_ALIGN(size, HAL_SCRATCH_ALIGN);
+    if (size) {
+        p->base = mpp_malloc_size(RK_U8, size);
+        if (NULL == p->base) {
+            mpp_err_f("failed to malloc arena size %d\n", size);
+            mpp_free(p);
+            return MPP_ERR_MALLOC;
+        }
+        p->size = size;
+        p->stat.alloc_count++;
+    }
+
+    hal_scratch_dbg_f(HAL_SCRATCH_DBG_FLOW, "%p size %d\n", p, size);
+
+    *ctx = p;
+    return MPP_OK;
+}
+
+static void hal_scratch_put_blks(HalScratchImpl *p)
+{
+    HalScratchBlk *blk = p->blks;
+
+    while (blk) {
+        HalScratchBlk *next = blk->next;
+
+        mpp_free(blk);
+        blk = next;
+    }
+    p->blks = NULL;
+}
+
+MPP_RET hal_scratch_deinit(HalScratch ctx)
+{
+    HalScratchImpl *p = (HalScratchImpl *)ctx;
+
+    if (NULL == p) {
+        mpp_err_f("invalid NULL input\n");
+        return MPP_ERR_NULL_PTR;
+    }
+
+    hal_scratch_dbg_f(HAL_SCRATCH_DBG_FLOW, "%p size %d peak %d alloc %d\n",
+                      p, p->size, p->stat.peak, p->stat.alloc_count);
+
+    hal_scratch_put_blks(p);
+    MPP_FREE(p->base);
+    mpp_free(p);
+    return MPP_OK;
+}
+
+void *hal_scratch_get(HalScratch ctx, size_t size)
+{
+    HalScratchImpl *p = (HalScratchImpl *)ctx;
+    HalScratchBlk *blk = NULL;
+    void *ptr = NULL;
+
+    if (NULL == p || 0 == size) {
+        mpp_err_f("invalid input ctx %p size %d\n", p, size);
+        return NULL;
+    }
+
+    size = MPP_ALIGN(size, HAL_SCRATCH_ALIGN);
+    p->request += size;
+    if (p->request > p->stat.peak)
+        p->stat.peak = p->request;
+
+    if (p->used + size <= p->size) {
+        ptr = p->base + p->used;
+        p->used += size;
+        memset(ptr, 0, size);
+        return ptr;
+    }
+
+    /* keep the header size aligned to make the payload aligned */
+    blk = (HalScratchBlk *)mpp_calloc_size(void, MPP_ALIGN(sizeof(*blk), HAL_SCRATCH_ALIGN) + size);
+    if (NULL == blk) {
+        mpp_err_f("failed to malloc size %d\n", size);
+        return NULL;
+    }
+
+    hal_scratch_dbg_f(HAL_SCRATCH_DBG_GROW, "%p arena %d used %d overflow %d\n",
+                      p, p->size, p->used, size);
+
+    blk->size = size;
+    blk->next = p->blks;
+    p->blks = blk;
+    p->stat.alloc_count++;
+
+    return (RK_U8 *)blk + MPP_ALIGN(sizeof(*blk), HAL_SCRATCH_ALIGN);
+}
+
+MPP_RET hal_scratch_reset(HalScratch ctx)
+{
+    HalScratchImpl *p = (HalScratchImpl *)ctx;
+
+    if (NULL == p) {
+        mpp_err_f("invalid NULL input\n");
+        return MPP_ERR_NULL_PTR;
+    }
+
+    /* last task overflowed, enlarge arena to cover the peak usage */
+    if (p->blks) {
+        size_t size = p->stat.peak;
+        RK_U8 *base = mpp_malloc_size(RK_U8, size);
+
+        hal_scratch_put_blks(p);
+
+        if (base) {
+            hal_scratch_dbg_f(HAL_SCRATCH_DBG_GROW, "%p arena grow %d -> %d\n",
+                              p, p->size, size);
+
+            MPP_FREE(p->base);
+            p->base = base;
+            p->size = size;
+            p->stat.alloc_count++;
+        } else
+            mpp_err_f("failed to grow arena to size %d\n", size);
+    }
+
+    p->used = 0;
+    p->request = 0;
+    p->stat.reset_count++;
+    return MPP_OK;
+}
+
+MPP_RET hal_scratch_stat(HalScratch ctx, HalScratchStat *stat)
+{
+    HalScratchImpl *p = (HalScratchImpl *)ctx;
+
+    if (NULL == p || NULL == stat) {
+        mpp_err_f("invalid input ctx %p stat %p\n", p, stat);
+        return MPP_ERR_NULL_PTR;
+    }
+
+    *stat = p->stat;
+    stat->size = p->size;
+    return MPP_OK;
+}
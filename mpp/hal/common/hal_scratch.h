@@ -0,0 +1,61 @@
+/*
+ * Copyright 2018 Rockchip Electronics Co. LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __HAL_SCRATCH_H__
+#define __HAL_SCRATCH_H__
+
+#include <stddef.h>
+
+#include "rk_type.h"
+#include "mpp_err.h"
+
+/*
+ * Per-context scratch arena for register / packet generation
+ *
+ * The arena is allocated on hal init with the expected per-task size.
+ * hal_scratch_get returns zeroed memory from the arena and all the memory is
+ * reclaimed at once by hal_scratch_reset at the start of each task.
+ *
+ * Request beyond the arena falls back to heap and the arena is enlarged to
+ * the peak usage on next reset. So after the first few tasks the task path
+ * does not touch heap any more. alloc_count in stat counts all the heap
+ * allocations done by the arena and can be used to check it.
+ */
+typedef void* HalScratch;
+
+typedef struct HalScratchStat_t {
+    size_t          size;
+    size_t          peak;
+    RK_U32          alloc_count;
+    RK_U32          reset_count;
+} HalScratchStat;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+MPP_RET hal_scratch_init(HalScratch *ctx, size_t size);
+MPP_RET hal_scratch_deinit(HalScratch ctx);
+
+void   *hal_scratch_get(HalScratch ctx, size_t size);
+MPP_RET hal_scratch_reset(HalScratch ctx);
+MPP_RET hal_scratch_stat(HalScratch ctx, HalScratchStat *stat);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __HAL_SCRATCH_H__ */
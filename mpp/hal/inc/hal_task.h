@@ -22,6 +22,8 @@
 #include "mpp_err.h"
 
 #define MAX_DEC_REF_NUM     17
+/* max slice number of one encoded frame for slice output */
+#define HAL_ENC_SLICE_MAX   256
 
 typedef void* HalTaskHnd;
 typedef void* HalTaskGroup;
@@ -190,6 +192,13 @@ typedef struct HalEncTask_t {
 
     HalEncTaskFlag  flags;
 
+    // input pre-analysis hint, complexity is Q8 luma mad and 0 for unknown
+    RK_S32          scene_cut;
+    RK_S32          complexity;
+
+    // slice byte size in stream order, only valid when slice split is on
+    RK_S32          slice_num;
+    RK_U32          slice_len[HAL_ENC_SLICE_MAX];
 } HalEncTask;
 
 typedef struct HalDecVprocTask_t {
@@ -201,6 +210,8 @@ typedef struct HalDecVprocTask_t {
 
 typedef struct HalTask_u {
     HalTaskHnd              hnd;
+    // set by mpp_hal_hw_start and the failed task is not finished on wait
+    RK_U32                  start_err;
     union {
         HalDecTask          dec;
         HalEncTask          enc;
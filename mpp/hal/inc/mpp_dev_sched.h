@@ -0,0 +1,65 @@
+/*
+ * Copyright 2018 Rockchip Electronics Co. LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __MPP_DEV_SCHED_H__
+#define __MPP_DEV_SCHED_H__
+
+#include "rk_type.h"
+#include "mpp_err.h"
+#include "rk_mpi_cmd.h"
+
+/*
+ * Hardware submission scheduler shared by all contexts in one process
+ *
+ * Each mpp context owns one session. Sessions on the same hardware device
+ * are gathered in one queue. A session must be admitted by the queue before
+ * it sends a register set to the device. It keeps the admission until all
+ * of its sent tasks are waited, or until one task is waited while a session
+ * of the same or higher class is waiting. Then the device is handed over to
+ * the next waiting session in the order of:
+ *
+ * 1. higher priority class first
+ * 2. earlier deadline first
+ * 3. first come first serve
+ *
+ * Admitted session number of one device is set by env mpp_dev_sched_depth.
+ * The default zero depth disables the scheduling and only stats are kept.
+ *
+ * Deadline is a time budget in us for each task counted from its start
+ * request. Task finished after its deadline is counted as a miss.
+ */
+typedef void* MppDevSched;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+MPP_RET mpp_dev_sched_init(MppDevSched *sched, MppCtxType type, MppCodingType coding);
+MPP_RET mpp_dev_sched_deinit(MppDevSched sched);
+
+MPP_RET mpp_dev_sched_set_priority(MppDevSched sched, MppSchedPriority priority);
+MPP_RET mpp_dev_sched_set_deadline(MppDevSched sched, RK_S64 deadline);
+MPP_RET mpp_dev_sched_get_stat(MppDevSched sched, MppSchedStat *stat);
+
+/* called before task is sent to device and after task is waited */
+MPP_RET mpp_dev_sched_start(MppDevSched sched);
+MPP_RET mpp_dev_sched_finish(MppDevSched sched);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __MPP_DEV_SCHED_H__ */
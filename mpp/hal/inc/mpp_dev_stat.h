@@ -0,0 +1,61 @@
+/*
+ * Copyright 2018 Rockchip Electronics Co. LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __MPP_DEV_STAT_H__
+#define __MPP_DEV_STAT_H__
+
+#include "rk_type.h"
+#include "mpp_err.h"
+#include "rk_mpi_cmd.h"
+
+/*
+ * Always-on hardware latency statistic of one context
+ *
+ * Hal records three latency of each task into histogram:
+ * gen   - register generation time
+ * queue - time from register ready to send, including scheduler admission
+ * hw    - time from register send to hardware done returned by wait
+ *
+ * Sent tasks are matched to the waits in send order by a single producer /
+ * single consumer ring. Histograms are updated by atomic operation so the
+ * task path never takes a lock. Reset is not synchronized with recording and
+ * may drop the samples recorded at the same time.
+ */
+typedef void* MppDevStat;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+MPP_RET mpp_dev_stat_init(MppDevStat *stat);
+MPP_RET mpp_dev_stat_deinit(MppDevStat stat);
+
+/* time is from mpp_time, send is only called after a successful start */
+void    mpp_dev_stat_gen(MppDevStat stat, RK_S64 start, RK_S64 end);
+void    mpp_dev_stat_send(MppDevStat stat, RK_S64 request, RK_S64 send);
+void    mpp_dev_stat_done(MppDevStat stat, RK_S64 done);
+
+MPP_RET mpp_dev_stat_get(MppDevStat stat, MppHwLatStat *lat);
+MPP_RET mpp_dev_stat_reset(MppDevStat stat);
+
+/* upper bound in us of the bin where the percent of samples are below */
+RK_U32  mpp_lat_hist_percentile(const MppLatHist *hist, RK_U32 percent);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __MPP_DEV_STAT_H__ */
@@ -24,6 +24,8 @@
 
 #include "hal_task.h"
 #include "mpp_enc_cfg.h"
+#include "mpp_dev_sched.h"
+#include "mpp_dev_stat.h"
 
 typedef enum MppHalType_e {
     HAL_MODE_LIBVPU,
@@ -59,6 +61,10 @@ typedef struct MppHalCfg_t {
     RK_S32          task_count;
     RK_U32          fast_mode;
     IOInterruptCB   hal_int_cb;
+    /* device scheduler session of the owner context */
+    MppDevSched     sched;
+    /* hardware latency statistic of the owner context */
+    MppDevStat      stat;
 } MppHalCfg;
 
 typedef struct MppHalApi_t {
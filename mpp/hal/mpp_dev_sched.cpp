@@ -0,0 +1,448 @@
+/*
+ * Copyright 2018 Rockchip Electronics Co. LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define MODULE_TAG "mpp_dev_sched"
+
+#include <string.h>
+
+#include "mpp_env.h"
+#include "mpp_mem.h"
+#include "mpp_list.h"
+#include "mpp_time.h"
+#include "mpp_common.h"
+#include "mpp_platform.h"
+
+#include "mpp_dev_sched.h"
+
+#define SCHED_DBG_FLOW              (0x00000001)
+#define SCHED_DBG_WAIT              (0x00000002)
+
+#define sched_dbg(flag, fmt, ...)   _mpp_dbg(mpp_dev_sched_debug, flag, fmt, ## __VA_ARGS__)
+#define sched_dbg_flow(fmt, ...)    sched_dbg(SCHED_DBG_FLOW, fmt, ## __VA_ARGS__)
+#define sched_dbg_wait(fmt, ...)    sched_dbg(SCHED_DBG_WAIT, fmt, ## __VA_ARGS__)
+
+/* max sent but not waited task of one session for deadline record */
+#define SCHED_TASK_MAX              16
+
+static RK_U32 mpp_dev_sched_debug = 0;
+
+typedef struct MppDevSchedQueue_t {
+    struct list_head    list_queue;
+    /* sessions waiting for admission in schedule order */
+    struct list_head    list_wait;
+
+    const char          *name;
+    RK_S32              session_count;
+    RK_S32              active;
+} MppDevSchedQueue;
+
+typedef struct MppDevSchedImpl_t {
+    struct list_head    list_wait;
+    MppDevSchedQueue    *queue;
+    Condition           *cond;
+
+    MppCtxType          type;
+    MppCodingType       coding;
+    MppSchedPriority    priority;
+    RK_S64              deadline;
+
+    RK_S32              inflight;
+    RK_S32              admitted;
+    /* absolute due time of waiting request, zero for no deadline */
+    RK_S64              wait_due;
+
+    /* due time ring of sent tasks in send order */
+    RK_S64              due[SCHED_TASK_MAX];
+    RK_S32              due_rd;
+
+    MppSchedStat        stat;
+} MppDevSchedImpl;
+
+class MppDevSchedService
+{
+private:
+    // avoid any unwanted function
+    MppDevSchedService();
+    ~MppDevSchedService();
+    MppDevSchedService(const MppDevSchedService &);
+    MppDevSchedService &operator=(const MppDevSchedService &);
+
+    struct list_head    mlist_queue;
+    RK_U32              depth;
+
+public:
+    static MppDevSchedService *get_instance() {
+        static MppDevSchedService instance;
+        return &instance;
+    }
+    static Mutex *get_lock() {
+        static Mutex lock;
+        return &lock;
+    }
+
+    RK_U32              get_depth() { return depth; }
+
+    MppDevSchedQueue    *get_queue(const char *name);
+    void                put_queue(MppDevSchedQueue *queue);
+
+    void                add_wait(MppDevSchedImpl *session);
+    RK_S32              need_yield(MppDevSchedImpl *session);
+    void                release(MppDevSchedImpl *session);
+};
+
+MppDevSchedService::MppDevSchedService()
+    : depth(0)
+{
+    INIT_LIST_HEAD(&mlist_queue);
+
+    mpp_env_get_u32("mpp_dev_sched_debug", &mpp_dev_sched_debug, 0);
+    mpp_env_get_u32("mpp_dev_sched_depth", &depth, 0);
+}
+
+MppDevSchedService::~MppDevSchedService()
+{
+    mpp_assert(list_empty(&mlist_queue));
+
+    while (!list_empty(&mlist_queue)) {
+        MppDevSchedQueue *pos, *n;
+        list_for_each_entry_safe(pos, n, &mlist_queue, MppDevSchedQueue, list_queue) {
+            list_del_init(&pos->list_queue);
+            mpp_free(pos);
+        }
+    }
+}
+
+MppDevSchedQueue *MppDevSchedService::get_queue(const char *name)
+{
+    MppDevSchedQueue *queue = NULL;
+    MppDevSchedQueue *pos, *n;
+
+    /* context without device node shares one default queue */
+    list_for_each_entry_safe(pos, n, &mlist_queue, MppDevSchedQueue, list_queue) {
+        if ((name == pos->name) ||
+            (name && pos->name && !strcmp(name, pos->name))) {
+            queue = pos;
+            break;
+        }
+    }
+
+    if (NULL == queue) {
+        queue = mpp_calloc(MppDevSchedQueue, 1);
+        if (NULL == queue) {
+            mpp_err_f("failed to malloc queue for %s\n", name);
+            return NULL;
+        }
+
+        INIT_LIST_HEAD(&queue->list_queue);
+        INIT_LIST_HEAD(&queue->list_wait);
+        queue->name = name;
+        list_add_tail(&queue->list_queue, &mlist_queue);
+    }
+
+    queue->session_count++;
+    return queue;
+}
+
+void MppDevSchedService::put_queue(MppDevSchedQueue *queue)
+{
+    queue->session_count--;
+    if (queue->session_count > 0)
+        return;
+
+    mpp_assert(list_empty(&queue->list_wait));
+    mpp_assert(queue->active == 0);
+
+    list_del_init(&queue->list_queue);
+    mpp_free(queue);
+}
+
+/* return non-zero when session a should be admitted before session b */
+static RK_S32 sched_before(MppDevSchedImpl *a, MppDevSchedImpl *b)
+{
+    if (a->priority != b->priority)
+        return a->priority > b->priority;
+
+    if (a->wait_due && b->wait_due)
+        return a->wait_due < b->wait_due;
+
+    return a->wait_due && !b->wait_due;
+}
+
+void MppDevSchedService::add_wait(MppDevSchedImpl *session)
+{
+    MppDevSchedQueue *queue = session->queue;
+    MppDevSchedImpl *pos, *n;
+
+    /* insert before the first session ranked lower to keep fifo on tie */
+    list_for_each_entry_safe(pos, n, &queue->list_wait, MppDevSchedImpl, list_wait) {
+        if (sched_before(session, pos)) {
+            list_add_tail(&session->list_wait, &pos->list_wait);
+            return;
+        }
+    }
+
+    list_add_tail(&session->list_wait, &queue->list_wait);
+}
+
+/*
+ * Session with tasks always in flight never becomes idle. It hands over the
+ * device after one finished task when a session of the same or higher class
+ * is waiting. Lower class waiters are served when the session becomes idle.
+ */
+RK_S32 MppDevSchedService::need_yield(MppDevSchedImpl *session)
+{
+    MppDevSchedQueue *queue = session->queue;
+    MppDevSchedImpl *next = NULL;
+
+    if (!session->inflight)
+        return 1;
+
+    if (list_empty(&queue->list_wait))
+        return 0;
+
+    next = list_entry(queue->list_wait.next, MppDevSchedImpl, list_wait);
+    return next->priority >= session->priority;
+}
+
+void MppDevSchedService::release(MppDevSchedImpl *session)
+{
+    MppDevSchedQueue *queue = session->queue;
+
+    session->admitted = 0;
+    queue->active--;
+
+    if (!list_empty(&queue->list_wait)) {
+        MppDevSchedImpl *next = list_entry(queue->list_wait.next,
+                                           MppDevSchedImpl, list_wait);
+
+        list_del_init(&next->list_wait);
+        next->admitted = 1;
+        queue->active++;
+
+        sched_dbg_flow("session %p hand over to %p prio %d\n",
+                       session, next, next->priority);
+        next->cond->signal();
+    }
+}
+
+MPP_RET mpp_dev_sched_init(MppDevSched *sched, MppCtxType type, MppCodingType coding)
+{
+    if (NULL == sched) {
+        mpp_err_f("found NULL input\n");
+        return MPP_ERR_NULL_PTR;
+    }
+
+    *sched = NULL;
+
+    MppDevSchedImpl *p = mpp_calloc(MppDevSchedImpl, 1);
+    if (NULL == p) {
+        mpp_err_f("malloc failed\n");
+        return MPP_ERR_MALLOC;
+    }
+
+    INIT_LIST_HEAD(&p->list_wait);
+    p->cond = new Condition();
+    p->type = type;
+    p->coding = coding;
+    p->priority = MPP_SCHED_PRIO_NORMAL;
+
+    const char *name = mpp_get_vcodec_dev_name(type, coding);
+    MppDevSchedService *srv = MppDevSchedService::get_instance();
+    {
+        AutoMutex auto_lock(MppDevSchedService::get_lock());
+        p->queue = srv->get_queue(name);
+    }
+
+    if (NULL == p->queue) {
+        delete p->cond;
+        mpp_free(p);
+        return MPP_NOK;
+    }
+
+    sched_dbg_flow("session %p init on %s\n", p, name);
+
+    *sched = p;
+    return MPP_OK;
+}
+
+MPP_RET mpp_dev_sched_deinit(MppDevSched sched)
+{
+    if (NULL == sched) {
+        mpp_err_f("found NULL input\n");
+        return MPP_ERR_NULL_PTR;
+    }
+
+    MppDevSchedImpl *p = (MppDevSchedImpl *)sched;
+    MppDevSchedService *srv = MppDevSchedService::get_instance();
+    {
+        AutoMutex auto_lock(MppDevSchedService::get_lock());
+
+        /* task aborted without wait still holds the device */
+        if (p->admitted)
+            srv->release(p);
+
+        mpp_assert(list_empty(&p->list_wait));
+        srv->put_queue(p->queue);
+    }
+
+    sched_dbg_flow("session %p deinit task %d miss %d\n", p,
+                   p->stat.task_count, p->stat.miss_count);
+
+    delete p->cond;
+    mpp_free(p);
+    return MPP_OK;
+}
+
+MPP_RET mpp_dev_sched_set_priority(MppDevSched sched, MppSchedPriority priority)
+{
+    if (NULL == sched) {
+        mpp_err_f("found NULL input\n");
+        return MPP_ERR_NULL_PTR;
+    }
+
+    if (priority < MPP_SCHED_PRIO_BATCH || priority >= MPP_SCHED_PRIO_BUTT) {
+        mpp_err_f("invalid priority %d\n", priority);
+        return MPP_ERR_VALUE;
+    }
+
+    MppDevSchedImpl *p = (MppDevSchedImpl *)sched;
+    AutoMutex auto_lock(MppDevSchedService::get_lock());
+
+    p->priority = priority;
+    return MPP_OK;
+}
+
+MPP_RET mpp_dev_sched_set_deadline(MppDevSched sched, RK_S64 deadline)
+{
+    if (NULL == sched) {
+        mpp_err_f("found NULL input\n");
+        return MPP_ERR_NULL_PTR;
+    }
+
+    if (deadline < 0) {
+        mpp_err_f("invalid deadline %lld\n", deadline);
+        return MPP_ERR_VALUE;
+    }
+
+    MppDevSchedImpl *p = (MppDevSchedImpl *)sched;
+    AutoMutex auto_lock(MppDevSchedService::get_lock());
+
+    p->deadline = deadline;
+    return MPP_OK;
+}
+
+MPP_RET mpp_dev_sched_get_stat(MppDevSched sched, MppSchedStat *stat)
+{
+    if (NULL == sched || NULL == stat) {
+        mpp_err_f("found NULL input sched %p stat %p\n", sched, stat);
+        return MPP_ERR_NULL_PTR;
+    }
+
+    MppDevSchedImpl *p = (MppDevSchedImpl *)sched;
+    AutoMutex auto_lock(MppDevSchedService::get_lock());
+
+    memcpy(stat, &p->stat, sizeof(*stat));
+    return MPP_OK;
+}
+
+MPP_RET mpp_dev_sched_start(MppDevSched sched)
+{
+    if (NULL == sched) {
+        mpp_err_f("found NULL input\n");
+        return MPP_ERR_NULL_PTR;
+    }
+
+    MppDevSchedImpl *p = (MppDevSchedImpl *)sched;
+    MppDevSchedService *srv = MppDevSchedService::get_instance();
+    MppDevSchedQueue *queue = p->queue;
+    RK_S64 start = mpp_time();
+    RK_S64 due = (p->deadline) ? (start + p->deadline) : (0);
+    AutoMutex auto_lock(MppDevSchedService::get_lock());
+
+    /*
+     * Tasks sent by an admitted session go on directly. A session which has
+     * handed over the device asks for admission again even with tasks in
+     * flight. Those tasks are already sent so waiting them on the same
+     * thread later does not depend on the admission.
+     */
+    if (srv->get_depth() && !p->admitted) {
+        if (queue->active < (RK_S32)srv->get_depth() &&
+            list_empty(&queue->list_wait)) {
+            p->admitted = 1;
+            queue->active++;
+        } else {
+            p->wait_due = due;
+            srv->add_wait(p);
+
+            sched_dbg_wait("session %p prio %d wait on %s active %d\n",
+                           p, p->priority, queue->name, queue->active);
+
+            while (!p->admitted)
+                p->cond->wait(MppDevSchedService::get_lock());
+        }
+    }
+
+    RK_S64 wait_time = mpp_time() - start;
+
+    if (p->inflight < SCHED_TASK_MAX)
+        p->due[(p->due_rd + p->inflight) % SCHED_TASK_MAX] = due;
+    else
+        mpp_err_f("session %p too many task in flight\n", p);
+
+    p->inflight++;
+    p->stat.wait_time += wait_time;
+    if (p->stat.max_wait < wait_time)
+        p->stat.max_wait = wait_time;
+
+    return MPP_OK;
+}
+
+MPP_RET mpp_dev_sched_finish(MppDevSched sched)
+{
+    if (NULL == sched) {
+        mpp_err_f("found NULL input\n");
+        return MPP_ERR_NULL_PTR;
+    }
+
+    MppDevSchedImpl *p = (MppDevSchedImpl *)sched;
+    MppDevSchedService *srv = MppDevSchedService::get_instance();
+    RK_S64 now = mpp_time();
+    AutoMutex auto_lock(MppDevSchedService::get_lock());
+
+    /* wait after a failed start has nothing to finish */
+    if (p->inflight <= 0)
+        return MPP_OK;
+
+    RK_S64 due = p->due[p->due_rd];
+
+    p->due_rd = (p->due_rd + 1) % SCHED_TASK_MAX;
+    p->inflight--;
+    p->stat.task_count++;
+
+    if (due && now > due) {
+        p->stat.miss_count++;
+        if (p->stat.max_late < now - due)
+            p->stat.max_late = now - due;
+
+        sched_dbg_flow("session %p task %d late %lld us\n", p,
+                       p->stat.task_count, now - due);
+    }
+
+    if (p->admitted && srv->need_yield(p))
+        srv->release(p);
+
+    return MPP_OK;
+}
@@ -0,0 +1,241 @@
+/*
+ * Copyright 2018 Rockchip Electronics Co. LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define MODULE_TAG "mpp_dev_stat"
+
+#include <string.h>
+
+#include "mpp_env.h"
+#include "mpp_log.h"
+#include "mpp_mem.h"
+#include "mpp_atomic.h"
+#include "mpp_common.h"
+
+#include "mpp_dev_stat.h"
+
+#define DEV_STAT_DBG_FLOW           (0x00000001)
+#define DEV_STAT_DBG_TASK           (0x00000002)
+
+#define dev_stat_dbg(flag, fmt, ...)    _mpp_dbg(mpp_dev_stat_debug, flag, fmt, ## __VA_ARGS__)
+#define dev_stat_dbg_f(flag, fmt, ...)  _mpp_dbg_f(mpp_dev_stat_debug, flag, fmt, ## __VA_ARGS__)
+
+/* max sent but not waited task of one context, same as scheduler */
+#define DEV_STAT_TASK_MAX           16
+
+static RK_U32 mpp_dev_stat_debug = 0;
+
+typedef struct MppDevStatImpl_t {
+    /* register ready time of the task to be sent, zero for none */
+    RK_S64              ready;
+
+    /* send time ring, written by start thread and read by wait thread */
+    RK_S64              send[DEV_STAT_TASK_MAX];
+    RK_U32              send_wr;
+    RK_U32              send_rd;
+
+    MppHwLatStat        lat;
+} MppDevStatImpl;
+
+static RK_U32 lat_hist_bin(RK_U32 val)
+{
+    RK_U32 octave;
+    RK_U32 idx;
+
+    if (val < 4)
+        return val;
+
+    octave = mpp_log2(val);
+    idx = 4 * (octave - 1) + ((val >> (octave - 2)) & 3);
+
+    return MPP_MIN(idx, MPP_LAT_HIST_BINS - 1);
+}
+
+static void lat_hist_add(MppLatHist *hist, RK_S64 time)
+{
+    RK_U32 val = (RK_U32)MPP_CLIP3(0, (RK_S64)0xffffffff, time);
+    RK_U32 max;
+
+    MPP_FETCH_ADD(&hist->bins[lat_hist_bin(val)], 1);
+    MPP_FETCH_ADD(&hist->count, 1);
+    MPP_FETCH_ADD64(&hist->sum, (RK_U64)val);
+
+    do {
+        max = hist->max;
+        if (max >= val)
+            break;
+    } while (!MPP_BOOL_CAS(&hist->max, max, val));
+}
+
+static void lat_hist_clear(MppLatHist *hist)
+{
+    RK_S32 i;
+
+    for (i = 0; i < MPP_LAT_HIST_BINS; i++)
+        MPP_FETCH_AND(&hist->bins[i], 0);
+
+    MPP_FETCH_AND(&hist->count, 0);
+    MPP_FETCH_AND(&hist->max, 0);
+    MPP_FETCH_AND64(&hist->sum, (RK_U64)0);
+}
+
+RK_U32 mpp_lat_hist_percentile(const MppLatHist *hist, RK_U32 percent)
+{
+    RK_U64 target;
+    RK_U64 acc = 0;
+    RK_S32 i;
+
+    if (NULL == hist || !hist->count)
+        return 0;
+
+    /* round up to make p100 cover the last sample */
+    target = ((RK_U64)hist->count * MPP_MIN(percent, 100) + 99) / 100;
+
+    for (i = 0; i < MPP_LAT_HIST_BINS - 1; i++) {
+        acc += hist->bins[i];
+        if (acc >= target)
+            return MPP_MIN(MPP_LAT_HIST_BIN_LOWER(i + 1) - 1, hist->max);
+    }
+
+    return hist->max;
+}
+
+MPP_RET mpp_dev_stat_init(MppDevStat *stat)
+{
+    if (NULL == stat) {
+        mpp_err_f("found NULL input\n");
+        return MPP_ERR_NULL_PTR;
+    }
+
+    mpp_env_get_u32("mpp_dev_stat_debug", &mpp_dev_stat_debug, 0);
+
+    *stat = NULL;
+
+    MppDevStatImpl *p = mpp_calloc(MppDevStatImpl, 1);
+    if (NULL == p) {
+        mpp_err_f("malloc failed\n");
+        return MPP_ERR_MALLOC;
+    }
+
+    dev_stat_dbg_f(DEV_STAT_DBG_FLOW, "%p init\n", p);
+
+    *stat = p;
+    return MPP_OK;
+}
+
+MPP_RET mpp_dev_stat_deinit(MppDevStat stat)
+{
+    if (NULL == stat) {
+        mpp_err_f("found NULL input\n");
+        return MPP_ERR_NULL_PTR;
+    }
+
+    MppDevStatImpl *p = (MppDevStatImpl *)stat;
+    MppHwLatStat *lat = &p->lat;
+
+    dev_stat_dbg_f(DEV_STAT_DBG_FLOW,
+                   "%p task %d hw p50 %d p99 %d max %d queue p99 %d gen p99 %d us\n",
+                   p, lat->hw.count,
+                   mpp_lat_hist_percentile(&lat->hw, 50),
+                   mpp_lat_hist_percentile(&lat->hw, 99), lat->hw.max,
+                   mpp_lat_hist_percentile(&lat->queue, 99),
+                   mpp_lat_hist_percentile(&lat->gen, 99));
+
+    mpp_free(p);
+    return MPP_OK;
+}
+
+void mpp_dev_stat_gen(MppDevStat stat, RK_S64 start, RK_S64 end)
+{
+    MppDevStatImpl *p = (MppDevStatImpl *)stat;
+
+    if (NULL == p)
+        return ;
+
+    lat_hist_add(&p->lat.gen, end - start);
+    p->ready = end;
+}
+
+void mpp_dev_stat_send(MppDevStat stat, RK_S64 request, RK_S64 send)
+{
+    MppDevStatImpl *p = (MppDevStatImpl *)stat;
+
+    if (NULL == p)
+        return ;
+
+    /* task without register generation only counts scheduler wait */
+    lat_hist_add(&p->lat.queue, send - ((p->ready) ? (p->ready) : (request)));
+    p->ready = 0;
+
+    if (p->send_wr - p->send_rd >= DEV_STAT_TASK_MAX) {
+        dev_stat_dbg_f(DEV_STAT_DBG_TASK, "%p too many task in flight\n", p);
+        return ;
+    }
+
+    p->send[p->send_wr % DEV_STAT_TASK_MAX] = send;
+    /* full barrier makes the slot visible before the index */
+    MPP_FETCH_ADD(&p->send_wr, 1);
+}
+
+void mpp_dev_stat_done(MppDevStat stat, RK_S64 done)
+{
+    MppDevStatImpl *p = (MppDevStatImpl *)stat;
+    RK_S64 send;
+
+    if (NULL == p)
+        return ;
+
+    /* wait after a failed start has nothing sent */
+    if (p->send_rd == MPP_FETCH_ADD(&p->send_wr, 0))
+        return ;
+
+    send = p->send[p->send_rd % DEV_STAT_TASK_MAX];
+    MPP_FETCH_ADD(&p->send_rd, 1);
+
+    lat_hist_add(&p->lat.hw, done - send);
+
+    dev_stat_dbg(DEV_STAT_DBG_TASK, "%p task %d hw %lld us\n",
+                 p, p->lat.hw.count, done - send);
+}
+
+MPP_RET mpp_dev_stat_get(MppDevStat stat, MppHwLatStat *lat)
+{
+    if (NULL == stat || NULL == lat) {
+        mpp_err_f("found NULL input stat %p lat %p\n", stat, lat);
+        return MPP_ERR_NULL_PTR;
+    }
+
+    MppDevStatImpl *p = (MppDevStatImpl *)stat;
+
+    memcpy(lat, &p->lat, sizeof(*lat));
+    return MPP_OK;
+}
+
+MPP_RET mpp_dev_stat_reset(MppDevStat stat)
+{
+    if (NULL == stat) {
+        mpp_err_f("found NULL input\n");
+        return MPP_ERR_NULL_PTR;
+    }
+
+    MppDevStatImpl *p = (MppDevStatImpl *)stat;
+
+    lat_hist_clear(&p->lat.hw);
+    lat_hist_clear(&p->lat.queue);
+    lat_hist_clear(&p->lat.gen);
+
+    dev_stat_dbg_f(DEV_STAT_DBG_FLOW, "%p reset\n", p);
+    return MPP_OK;
+}
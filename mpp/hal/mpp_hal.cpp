@@ -18,6 +18,7 @@
 
 #include "mpp_mem.h"
 #include "mpp_log.h"
+#include "mpp_time.h"
 #include "mpp_common.h"
 
 #include "mpp.h"
@@ -100,6 +101,9 @@ typedef struct MppHalImpl_t {
 
     HalTaskGroup    tasks;
     RK_S32          task_count;
+
+    MppDevSched     sched;
+    MppDevStat      stat;
 } MppHalImpl;
 
 
@@ -128,6 +132,8 @@ MPP_RET mpp_hal_init(MppHal *ctx, MppHalCfg *cfg)
             p->packet_slots = cfg->packet_slots;
             p->api          = hw_apis[i];
             p->task_count   = cfg->task_count;
+            p->sched        = cfg->sched;
+            p->stat         = cfg->stat;
             p->ctx          = mpp_calloc_size(void, p->api->ctx_size);
 
             MPP_RET ret = p->api->init(p->ctx, cfg);
@@ -179,7 +185,12 @@ MPP_RET mpp_hal_reg_gen(MppHal ctx, HalTaskInfo *task)
     }
 
     MppHalImpl *p = (MppHalImpl*)ctx;
+    RK_S64 start = (p->stat) ? mpp_time() : 0;
     MPP_RET ret = p->api->reg_gen(p->ctx, task);
+
+    if (p->stat)
+        mpp_dev_stat_gen(p->stat, start, mpp_time());
+
     return ret;
 }
 
@@ -191,7 +202,23 @@ MPP_RET mpp_hal_hw_start(MppHal ctx, HalTaskInfo *task)
     }
 
     MppHalImpl *p = (MppHalImpl*)ctx;
+    RK_S64 request = (p->stat) ? mpp_time() : 0;
+
+    /* wait for the device admission from scheduler before sending */
+    if (p->sched)
+        mpp_dev_sched_start(p->sched);
+
+    RK_S64 send = (p->stat) ? mpp_time() : 0;
     MPP_RET ret = p->api->start(p->ctx, task);
+
+    /* failed task is finished here and wait of the task skips it */
+    task->start_err = (ret) ? 1 : 0;
+    if (ret && p->sched)
+        mpp_dev_sched_finish(p->sched);
+
+    if (!ret && p->stat)
+        mpp_dev_stat_send(p->stat, request, send);
+
     return ret;
 }
 
@@ -205,6 +232,15 @@ MPP_RET mpp_hal_hw_wait(MppHal ctx, HalTaskInfo *task)
     MppHalImpl *p = (MppHalImpl*)ctx;
     MPP_RET ret = p->api->wait(p->ctx, task);
 
+    if (task->start_err)
+        return ret;
+
+    if (p->stat)
+        mpp_dev_stat_done(p->stat, mpp_time());
+
+    if (p->sched)
+        mpp_dev_sched_finish(p->sched);
+
     return ret;
 }
 
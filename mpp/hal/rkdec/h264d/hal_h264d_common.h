@@ -21,6 +21,7 @@
 #include "rk_type.h"
 
 #include "hal_h264d_global.h"
+#include "hal_reg_ring.h"
 
 #define VDPU_CABAC_TAB_SIZE        (3680)        /* bytes */
 #define VDPU_POC_BUF_SIZE          (34*4)        /* bytes */
@@ -227,8 +228,6 @@ typedef struct h264d_vdpu_priv_t {
 } H264dVdpuPriv_t;
 
 typedef struct h264d_vdpu_buf_t {
-    RK_U32 valid;
-
     MppBuffer buf;
     void *cabac_ptr;
     void *poc_ptr;
@@ -246,7 +245,9 @@ typedef struct h264d_refs_list_t {
 } H264dRefsList_t;
 
 typedef struct h264d_vdpu_reg_ctx_t {
-    H264dVdpuBuf_t reg_buf[3];
+    /* register sets in ring, one set when not in fast mode */
+    H264dVdpuBuf_t *reg_buf;
+    HalRegRing reg_ring;
 
     MppBuffer buf;
     void *cabac_ptr;
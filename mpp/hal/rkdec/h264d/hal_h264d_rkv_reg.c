@@ -26,8 +26,12 @@
 #include "mpp_mem.h"
 #include "mpp_common.h"
 #include "mpp_bitput.h"
+#include "mpp_buffer_impl.h"
 
 #include "mpp_device.h"
+#include "hal_pkt_cache.h"
+#include "hal_reg_ring.h"
+#include "hal_reg_tmpl.h"
 
 #include "hal_h264d_global.h"
 #include "hal_h264d_rkv_reg.h"
@@ -40,15 +44,70 @@
 #define RKV_RPS_SIZE              (128 + 128)         /* bytes */
 #define RKV_SCALING_LIST_SIZE     (6*16+2*64 + 128)   /* bytes */
 #define RKV_ERROR_INFO_SIZE       (256*144*4)         /* bytes */
+#define RKV_SPSPPS_CACHE_COUNT    4
 
 typedef struct h264d_rkv_buf_t {
-    RK_U32 valid;
     MppBuffer spspps;
     MppBuffer rps;
     MppBuffer sclst;
     H264dRkvRegs_t *regs;
+    /* serial of the spspps packet in spspps buffer, zero for none */
+    RK_U32 spspps_serial;
 } H264dRkvBuf_t;
 
+/* all syntax elements used by spspps packet */
+typedef struct h264d_rkv_spspps_key_t {
+    RK_S32 chroma_format_idc;
+    RK_S32 bit_depth_luma_minus8;
+    RK_S32 bit_depth_chroma_minus8;
+    RK_S32 log2_max_frame_num_minus4;
+    RK_S32 num_ref_frames;
+    RK_S32 pic_order_cnt_type;
+    RK_S32 log2_max_pic_order_cnt_lsb_minus4;
+    RK_S32 delta_pic_order_always_zero_flag;
+    RK_S32 frame_width_in_mbs;
+    RK_S32 frame_height_in_mbs;
+    RK_S32 frame_mbs_only_flag;
+    RK_S32 mbaff_frame_flag;
+    RK_S32 direct_8x8_inference_flag;
+    RK_S32 num_views;
+    RK_S32 view_id[2];
+    RK_S32 anchor_ref_l0;
+    RK_S32 anchor_ref_l1;
+    RK_S32 non_anchor_ref_l0;
+    RK_S32 non_anchor_ref_l1;
+
+    RK_S32 entropy_coding_mode_flag;
+    RK_S32 pic_order_present_flag;
+    RK_S32 num_ref_idx_l0_active_minus1;
+    RK_S32 num_ref_idx_l1_active_minus1;
+    RK_S32 weighted_pred_flag;
+    RK_S32 weighted_bipred_idc;
+    RK_S32 pic_init_qp_minus26;
+    RK_S32 pic_init_qs_minus26;
+    RK_S32 chroma_qp_index_offset;
+    RK_S32 deblocking_filter_control_present_flag;
+    RK_S32 constrained_intra_pred_flag;
+    RK_S32 redundant_pic_cnt_present_flag;
+    RK_S32 transform_8x8_mode_flag;
+    RK_S32 second_chroma_qp_index_offset;
+    RK_S32 scaleing_list_enable_flag;
+    RK_S32 sclst_fd;
+
+    /* dpb flags in bitmap */
+    RK_U32 long_term_flags;
+    RK_U32 voidx_flags;
+} H264dRkvSpsPpsKey_t;
+
+/* all inputs of the sequence level registers in template */
+typedef struct h264d_rkv_seq_key_t {
+    RK_U32 hor_virstride;
+    RK_U32 ver_virstride;
+    RK_S32 chroma_format_idc;
+    RK_S32 cabac_fd;
+    RK_S32 errinfo_fd;
+} H264dRkvSeqKey_t;
+
 typedef struct h264d_rkv_reg_ctx_t {
     RK_U8 spspps[32];
     RK_U8 rps[RKV_RPS_SIZE];
@@ -56,12 +115,17 @@ typedef struct h264d_rkv_reg_ctx_t {
 
     MppBuffer cabac_buf;
     MppBuffer errinfo_buf;
-    H264dRkvBuf_t reg_buf[3];
+    /* register sets in ring, one set when not in fast mode */
+    H264dRkvBuf_t *reg_buf;
+    HalRegRing reg_ring;
 
     MppBuffer spspps_buf;
     MppBuffer rps_buf;
     MppBuffer sclst_buf;
     H264dRkvRegs_t *regs;
+
+    HalPktCache spspps_cache;
+    HalRegTmpl reg_tmpl;
 } H264dRkvRegCtx_t;
 
 const RK_U32 rkv_cabac_table[928] = {
@@ -346,6 +410,67 @@ static MPP_RET prepare_spspps(H264dHalCtx_t *p_hal, RK_U64 *data, RK_U32 len)
     return MPP_OK;
 }
 
+static void prepare_spspps_key(H264dHalCtx_t *p_hal, H264dRkvSpsPpsKey_t *key)
+{
+    RK_S32 i = 0;
+    DXVA_PicParams_H264_MVC *pp = p_hal->pp;
+    H264dRkvRegCtx_t *reg_ctx = (H264dRkvRegCtx_t *)p_hal->reg_ctx;
+
+    memset(key, 0, sizeof(*key));
+    key->chroma_format_idc = pp->chroma_format_idc;
+    key->bit_depth_luma_minus8 = pp->bit_depth_luma_minus8;
+    key->bit_depth_chroma_minus8 = pp->bit_depth_chroma_minus8;
+    key->log2_max_frame_num_minus4 = pp->log2_max_frame_num_minus4;
+    key->num_ref_frames = pp->num_ref_frames;
+    key->pic_order_cnt_type = pp->pic_order_cnt_type;
+    key->log2_max_pic_order_cnt_lsb_minus4 = pp->log2_max_pic_order_cnt_lsb_minus4;
+    key->delta_pic_order_always_zero_flag = pp->delta_pic_order_always_zero_flag;
+    key->frame_width_in_mbs = pp->wFrameWidthInMbsMinus1 + 1;
+    key->frame_height_in_mbs = pp->wFrameHeightInMbsMinus1 + 1;
+    key->frame_mbs_only_flag = pp->frame_mbs_only_flag;
+    key->mbaff_frame_flag = pp->MbaffFrameFlag;
+    key->direct_8x8_inference_flag = pp->direct_8x8_inference_flag;
+    key->num_views = pp->num_views_minus1 + 1;
+    key->view_id[0] = pp->view_id[0];
+    key->view_id[1] = pp->view_id[1];
+    /* same as packet: ref count in bit 16 and the first ref in low bits */
+    key->anchor_ref_l0 = (pp->num_anchor_refs_l0[0] << 16) |
+                         (pp->num_anchor_refs_l0[0] ? pp->anchor_ref_l0[0][0] : 0);
+    key->anchor_ref_l1 = (pp->num_anchor_refs_l1[0] << 16) |
+                         (pp->num_anchor_refs_l1[0] ? pp->anchor_ref_l1[0][0] : 0);
+    key->non_anchor_ref_l0 = (pp->num_non_anchor_refs_l0[0] << 16) |
+                             (pp->num_non_anchor_refs_l0[0] ? pp->non_anchor_ref_l0[0][0] : 0);
+    key->non_anchor_ref_l1 = (pp->num_non_anchor_refs_l1[0] << 16) |
+                             (pp->num_non_anchor_refs_l1[0] ? pp->non_anchor_ref_l1[0][0] : 0);
+
+    key->entropy_coding_mode_flag = pp->entropy_coding_mode_flag;
+    key->pic_order_present_flag = pp->pic_order_present_flag;
+    key->num_ref_idx_l0_active_minus1 = pp->num_ref_idx_l0_active_minus1;
+    key->num_ref_idx_l1_active_minus1 = pp->num_ref_idx_l1_active_minus1;
+    key->weighted_pred_flag = pp->weighted_pred_flag;
+    key->weighted_bipred_idc = pp->weighted_bipred_idc;
+    key->pic_init_qp_minus26 = pp->pic_init_qp_minus26;
+    key->pic_init_qs_minus26 = pp->pic_init_qs_minus26;
+    key->chroma_qp_index_offset = pp->chroma_qp_index_offset;
+    key->deblocking_filter_control_present_flag = pp->deblocking_filter_control_present_flag;
+    key->constrained_intra_pred_flag = pp->constrained_intra_pred_flag;
+    key->redundant_pic_cnt_present_flag = pp->redundant_pic_cnt_present_flag;
+    key->transform_8x8_mode_flag = pp->transform_8x8_mode_flag;
+    key->second_chroma_qp_index_offset = pp->second_chroma_qp_index_offset;
+    key->scaleing_list_enable_flag = pp->scaleing_list_enable_flag;
+    key->sclst_fd = mpp_buffer_get_fd(reg_ctx->sclst_buf);
+
+    for (i = 0; i < 16; i++) {
+        if (pp->RefFrameList[i].bPicEntry == 0xff)
+            continue;
+
+        if (pp->RefFrameList[i].AssociatedFlag)
+            key->long_term_flags |= 1 << i;
+        if (pp->RefPicLayerIdList[i])
+            key->voidx_flags |= 1 << i;
+    }
+}
+
 static MPP_RET prepare_framerps(H264dHalCtx_t *p_hal, RK_U64 *data, RK_U32 len)
 {
     RK_S32 i = 0, j = 0;
@@ -428,7 +553,123 @@ static MPP_RET prepare_scanlist(H264dHalCtx_t *p_hal, RK_U64 *data, RK_U32 len)
     return MPP_OK;
 }
 
-static MPP_RET set_registers(H264dHalCtx_t *p_hal, H264dRkvRegs_t *p_regs, HalTaskInfo *task)
+static void prepare_seq_key(H264dHalCtx_t *p_hal, H264dRkvSeqKey_t *key)
+{
+    DXVA_PicParams_H264_MVC *pp = p_hal->pp;
+    H264dRkvRegCtx_t *reg_ctx = (H264dRkvRegCtx_t *)p_hal->reg_ctx;
+    MppFrame mframe = NULL;
+
+    memset(key, 0, sizeof(*key));
+    mpp_buf_slot_get_prop(p_hal->frame_slots, pp->CurrPic.Index7Bits, SLOT_FRAME_PTR, &mframe);
+    key->hor_virstride = mpp_frame_get_hor_stride(mframe);
+    key->ver_virstride = mpp_frame_get_ver_stride(mframe);
+    key->chroma_format_idc = pp->chroma_format_idc;
+    key->cabac_fd = mpp_buffer_get_fd(reg_ctx->cabac_buf);
+    key->errinfo_fd = mpp_buffer_get_fd(reg_ctx->errinfo_buf);
+}
+
+//!< registers unchanged in one sequence, p_regs is cleared
+static void set_registers_seq(H264dRkvRegs_t *p_regs, H264dRkvSeqKey_t *key)
+{
+    //!< set dec_mode && rlc_mode && rps_mode && slice_num
+    {
+        p_regs->sw02.dec_mode = 1;  //!< h264
+        if (p_regs->sw02.rps_mode) { // rps_mode == 1
+            p_regs->sw43.rps_base += 0x8;
+        }
+        p_regs->sw03.slice_num_lowbits = 0x7ff;
+        p_regs->sw03.slice_num_highbit = 1;
+    }
+    //!< caculate the yuv_frame_size
+    {
+        RK_U32 y_virstride = key->hor_virstride * key->ver_virstride;
+        RK_U32 yuv_virstride = 0;
+
+        if (key->chroma_format_idc == 0) { //!< Y400
+            yuv_virstride = y_virstride;
+        } else if (key->chroma_format_idc == 1) { //!< Y420
+            yuv_virstride = y_virstride + y_virstride / 2;
+        } else if (key->chroma_format_idc == 2) { //!< Y422
+            yuv_virstride = 2 * y_virstride;
+        }
+        p_regs->sw03.y_hor_virstride = key->hor_virstride / 16;
+        p_regs->sw03.uv_hor_virstride = key->hor_virstride / 16;
+        p_regs->sw08.y_virstride = y_virstride / 16;
+        p_regs->sw09.yuv_virstride = yuv_virstride / 16;
+    }
+    p_regs->sw06.cabactbl_base = key->cabac_fd;
+    p_regs->sw75.errorinfo_base = key->errinfo_fd;
+}
+
+//!< registers changed on each frame, p_regs is copied from template
+static void set_registers_frame(H264dHalCtx_t *p_hal, H264dRkvRegs_t *p_regs, HalTaskInfo *task)
+{
+    DXVA_PicParams_H264_MVC *pp = p_hal->pp;
+
+    if (p_regs->sw02.rlc_mode == 1) {
+        p_regs->sw05.stream_len = 0;
+    } else {
+        p_regs->sw05.stream_len = p_hal->strm_len;
+    }
+    //!< set current
+    {
+        MppBuffer mbuffer = NULL;
+        p_regs->sw40.cur_poc = pp->CurrFieldOrderCnt[0];
+        p_regs->sw74.cur_poc1 = pp->CurrFieldOrderCnt[1];
+        mpp_buf_slot_get_prop(p_hal->frame_slots, pp->CurrPic.Index7Bits, SLOT_BUFFER, &mbuffer);
+        p_regs->sw07.decout_base = mpp_buffer_get_fd(mbuffer);
+    }
+    //!< set reference
+    {
+        RK_S32 i = 0;
+        RK_S32 ref_index = -1;
+        RK_S32 near_index = -1;
+        MppBuffer mbuffer = NULL;
+
+        for (i = 0; i < 15; i++) {
+            p_regs->sw25_39[i].ref0_14_poc = (i & 1)
+                                             ? pp->FieldOrderCntList[i / 2][1] : pp->FieldOrderCntList[i / 2][0];
+            p_regs->sw49_63[i].ref15_29_poc = (i & 1)
+                                              ? pp->FieldOrderCntList[(i + 15) / 2][0] : pp->FieldOrderCntList[(i + 15) / 2][1];
+            p_regs->sw10_24[i].ref0_14_field = (pp->RefPicFiledFlags >> i) & 0x01;
+            p_regs->sw10_24[i].ref0_14_topfield_used = (pp->UsedForReferenceFlags >> (2 * i + 0)) & 0x01;
+            p_regs->sw10_24[i].ref0_14_botfield_used = (pp->UsedForReferenceFlags >> (2 * i + 1)) & 0x01;
+            p_regs->sw10_24[i].ref0_14_colmv_use_flag = (pp->RefPicColmvUsedFlags >> i) & 0x01;
+
+            if (pp->RefFrameList[i].bPicEntry != 0xff) {
+                ref_index = pp->RefFrameList[i].Index7Bits;
+                near_index = pp->RefFrameList[i].Index7Bits;
+            } else {
+                ref_index = (near_index < 0) ? pp->CurrPic.Index7Bits : near_index;
+            }
+            mpp_buf_slot_get_prop(p_hal->frame_slots, ref_index, SLOT_BUFFER, &mbuffer);
+            p_regs->sw10_24[i].ref0_14_base = mpp_buffer_get_fd(mbuffer);
+        }
+        p_regs->sw72.ref30_poc = pp->FieldOrderCntList[15][0];
+        p_regs->sw73.ref31_poc = pp->FieldOrderCntList[15][1];
+        p_regs->sw48.ref15_field = (pp->RefPicFiledFlags >> 15) & 0x01;
+        p_regs->sw48.ref15_topfield_used = (pp->UsedForReferenceFlags >> 30) & 0x01;
+        p_regs->sw48.ref15_botfield_used = (pp->UsedForReferenceFlags >> 31) & 0x01;
+        p_regs->sw48.ref15_colmv_use_flag = (pp->RefPicColmvUsedFlags >> 15) & 0x01;
+
+        if (pp->RefFrameList[15].bPicEntry != 0xff) {
+            ref_index = pp->RefFrameList[15].Index7Bits;
+        } else {
+            ref_index = (near_index < 0) ? pp->CurrPic.Index7Bits : near_index;
+        }
+        mpp_buf_slot_get_prop(p_hal->frame_slots, ref_index, SLOT_BUFFER, &mbuffer);
+        p_regs->sw48.ref15_base = mpp_buffer_get_fd(mbuffer);
+    }
+    {
+        MppBuffer mbuffer = NULL;
+        mpp_buf_slot_get_prop(p_hal->packet_slots, task->dec.input, SLOT_BUFFER, &mbuffer);
+        p_regs->sw04.strm_rlc_base = mpp_buffer_get_fd(mbuffer);
+        p_regs->sw41.rlcwrite_base = p_regs->sw04.strm_rlc_base;
+    }
+}
+
+//!< full regeneration from syntax without template, used by check only
+static MPP_RET set_registers_full(H264dHalCtx_t *p_hal, H264dRkvRegs_t *p_regs, HalTaskInfo *task)
 {
     DXVA_PicParams_H264_MVC *pp = p_hal->pp;
 
@@ -528,7 +769,33 @@ static MPP_RET set_registers(H264dHalCtx_t *p_hal, H264dRkvRegs_t *p_regs, HalTa
         p_regs->sw04.strm_rlc_base = mpp_buffer_get_fd(mbuffer);
         p_regs->sw06.cabactbl_base = mpp_buffer_get_fd(reg_ctx->cabac_buf);
         p_regs->sw41.rlcwrite_base = p_regs->sw04.strm_rlc_base;
+        p_regs->sw75.errorinfo_base = mpp_buffer_get_fd(reg_ctx->errinfo_buf);
+    }
+    return MPP_OK;
+}
+
+static MPP_RET set_registers(H264dHalCtx_t *p_hal, H264dRkvRegs_t *p_regs, HalTaskInfo *task)
+{
+    H264dRkvRegCtx_t *reg_ctx = (H264dRkvRegCtx_t *)p_hal->reg_ctx;
+    H264dRkvSeqKey_t key;
+    H264dRkvRegs_t *tmpl = NULL;
+    H264dRkvRegs_t *ref = NULL;
+
+    prepare_seq_key(p_hal, &key);
+    tmpl = (H264dRkvRegs_t *)hal_reg_tmpl_update(reg_ctx->reg_tmpl, &key);
+    if (tmpl)
+        set_registers_seq(tmpl, &key);
+
+    hal_reg_tmpl_apply(reg_ctx->reg_tmpl, p_regs);
+    set_registers_frame(p_hal, p_regs, task);
+
+    //!< debug: compare with full regeneration
+    ref = (H264dRkvRegs_t *)hal_reg_tmpl_check_ref(reg_ctx->reg_tmpl);
+    if (ref) {
+        set_registers_full(p_hal, ref, task);
+        hal_reg_tmpl_check(reg_ctx->reg_tmpl, p_regs, ref);
     }
+
     return MPP_OK;
 }
 /*!
@@ -537,6 +804,12 @@ static MPP_RET set_registers(H264dHalCtx_t *p_hal, H264dRkvRegs_t *p_regs, HalTa
 *    init
 ***********************************************************************
 */
+static void rkv_h264d_init_cabac_table(void *dst, size_t size, const void *param)
+{
+    memset(dst, 0, size);
+    memcpy(dst, param, sizeof(rkv_cabac_table));
+}
+
 //extern "C"
 MPP_RET rkv_h264d_init(void *hal, MppHalCfg *cfg)
 {
@@ -548,13 +821,24 @@ MPP_RET rkv_h264d_init(void *hal, MppHalCfg *cfg)
     MEM_CHECK(ret, p_hal->reg_ctx = mpp_calloc_size(void, sizeof(H264dRkvRegCtx_t)));
     H264dRkvRegCtx_t *reg_ctx = (H264dRkvRegCtx_t *)p_hal->reg_ctx;
     //!< malloc buffers
-    FUN_CHECK(ret = mpp_buffer_get(p_hal->buf_group,
-                                   &reg_ctx->cabac_buf, RKV_CABAC_TAB_SIZE));
+    //!< cabac table is constant and shared by all instances
+    FUN_CHECK(ret = mpp_buffer_table_get(&reg_ctx->cabac_buf, "h264d_rkv_cabac",
+                                         MPP_BUFFER_TYPE_ION, RKV_CABAC_TAB_SIZE,
+                                         rkv_h264d_init_cabac_table, rkv_cabac_table));
     FUN_CHECK(ret = mpp_buffer_get(p_hal->buf_group,
                                    &reg_ctx->errinfo_buf, RKV_ERROR_INFO_SIZE));
+    FUN_CHECK(ret = hal_pkt_cache_init(&reg_ctx->spspps_cache, RKV_SPSPPS_CACHE_COUNT,
+                                       sizeof(H264dRkvSpsPpsKey_t),
+                                       sizeof(reg_ctx->spspps)));
+    FUN_CHECK(ret = hal_reg_tmpl_init(&reg_ctx->reg_tmpl, sizeof(H264dRkvRegs_t),
+                                      sizeof(H264dRkvSeqKey_t)));
+    FUN_CHECK(ret = hal_reg_ring_init(&reg_ctx->reg_ring,
+                                      p_hal->fast_mode ? cfg->task_count : 1,
+                                      sizeof(*reg_ctx->reg_buf)));
+    reg_ctx->reg_buf = hal_reg_ring_elems(reg_ctx->reg_ring);
     // malloc buffers
     RK_U32 i = 0;
-    RK_U32 loop = p_hal->fast_mode ? MPP_ARRAY_ELEMS(reg_ctx->reg_buf) : 1;
+    RK_U32 loop = hal_reg_ring_count(reg_ctx->reg_ring);
     for (i = 0; i < loop; i++) {
         reg_ctx->reg_buf[i].regs = mpp_calloc(H264dRkvRegs_t, 1);
         FUN_CHECK(ret = mpp_buffer_get(p_hal->buf_group,
@@ -572,15 +856,10 @@ MPP_RET rkv_h264d_init(void *hal, MppHalCfg *cfg)
         reg_ctx->sclst_buf = reg_ctx->reg_buf[0].sclst;
     }
 
-    //!< copy cabac table bytes
-    FUN_CHECK(ret = mpp_buffer_write(reg_ctx->cabac_buf, 0,
-                                     (void *)rkv_cabac_table, sizeof(rkv_cabac_table)));
-
     mpp_slots_set_prop(p_hal->frame_slots, SLOTS_HOR_ALIGN, rkv_hor_align);
     mpp_slots_set_prop(p_hal->frame_slots, SLOTS_VER_ALIGN, rkv_ver_align);
     mpp_slots_set_prop(p_hal->frame_slots, SLOTS_LEN_ALIGN, rkv_len_align);
 
-    (void)cfg;
 __RETURN:
     return MPP_OK;
 __FAILED:
@@ -601,15 +880,29 @@ MPP_RET rkv_h264d_deinit(void *hal)
     H264dRkvRegCtx_t *reg_ctx = (H264dRkvRegCtx_t *)p_hal->reg_ctx;
 
     RK_U32 i = 0;
-    RK_U32 loop = p_hal->fast_mode ? MPP_ARRAY_ELEMS(reg_ctx->reg_buf) : 1;
+    RK_U32 loop = hal_reg_ring_count(reg_ctx->reg_ring);
     for (i = 0; i < loop; i++) {
         MPP_FREE(reg_ctx->reg_buf[i].regs);
         mpp_buffer_put(reg_ctx->reg_buf[i].spspps);
         mpp_buffer_put(reg_ctx->reg_buf[i].rps);
         mpp_buffer_put(reg_ctx->reg_buf[i].sclst);
     }
-    mpp_buffer_put(reg_ctx->cabac_buf);
+    if (reg_ctx->reg_ring) {
+        hal_reg_ring_deinit(reg_ctx->reg_ring);
+        reg_ctx->reg_ring = NULL;
+        reg_ctx->reg_buf = NULL;
+    }
+    if (reg_ctx->cabac_buf)
+        mpp_buffer_table_put(reg_ctx->cabac_buf);
     mpp_buffer_put(reg_ctx->errinfo_buf);
+    if (reg_ctx->spspps_cache) {
+        hal_pkt_cache_deinit(reg_ctx->spspps_cache);
+        reg_ctx->spspps_cache = NULL;
+    }
+    if (reg_ctx->reg_tmpl) {
+        hal_reg_tmpl_deinit(reg_ctx->reg_tmpl);
+        reg_ctx->reg_tmpl = NULL;
+    }
     MPP_FREE(p_hal->reg_ctx);
 
     return MPP_OK;
@@ -634,32 +927,47 @@ MPP_RET rkv_h264d_gen_regs(void *hal, HalTaskInfo *task)
     }
     H264dRkvRegCtx_t *reg_ctx = (H264dRkvRegCtx_t *)p_hal->reg_ctx;
     if (p_hal->fast_mode) {
-        RK_U32 i = 0;
-        for (i = 0; i <  MPP_ARRAY_ELEMS(reg_ctx->reg_buf); i++) {
-            if (!reg_ctx->reg_buf[i].valid) {
-                task->dec.reg_index = i;
-                reg_ctx->spspps_buf = reg_ctx->reg_buf[i].spspps;
-                reg_ctx->rps_buf = reg_ctx->reg_buf[i].rps;
-                reg_ctx->sclst_buf = reg_ctx->reg_buf[i].sclst;
-                reg_ctx->regs = reg_ctx->reg_buf[i].regs;
-                reg_ctx->reg_buf[i].valid = 1;
-                break;
-            }
+        RK_S32 i = hal_reg_ring_get(reg_ctx->reg_ring);
+
+        if (i < 0) {
+            H264D_ERR("all register sets are in flight\n");
+            return MPP_NOK;
         }
+        task->dec.reg_index = i;
+        reg_ctx->spspps_buf = reg_ctx->reg_buf[i].spspps;
+        reg_ctx->rps_buf = reg_ctx->reg_buf[i].rps;
+        reg_ctx->sclst_buf = reg_ctx->reg_buf[i].sclst;
+        reg_ctx->regs = reg_ctx->reg_buf[i].regs;
     }
 
-    prepare_spspps(p_hal, (RK_U64 *)&reg_ctx->spspps, sizeof(reg_ctx->spspps));
+    //!< sps / pps packet is only rebuilt and copied when its syntax changes
+    {
+        H264dRkvBuf_t *buf = &reg_ctx->reg_buf[p_hal->fast_mode ? task->dec.reg_index : 0];
+        H264dRkvSpsPpsKey_t key;
+        RK_U32 serial = 0;
+        void *pkt = NULL;
+
+        prepare_spspps_key(p_hal, &key);
+        pkt = hal_pkt_cache_get(reg_ctx->spspps_cache, &key, &serial);
+        if (NULL == pkt) {
+            prepare_spspps(p_hal, (RK_U64 *)&reg_ctx->spspps, sizeof(reg_ctx->spspps));
+            pkt = hal_pkt_cache_put(reg_ctx->spspps_cache, &key,
+                                    reg_ctx->spspps, &serial);
+        }
+
+        if (pkt && buf->spspps_serial != serial) {
+            RK_U8 *dst = (RK_U8 *)mpp_buffer_get_ptr(reg_ctx->spspps_buf);
+            RK_U32 i = 0;
+
+            for (i = 0; dst && i < 256; i++)
+                memcpy(dst + sizeof(reg_ctx->spspps) * i, pkt, sizeof(reg_ctx->spspps));
+            buf->spspps_serial = serial;
+        }
+    }
     prepare_framerps(p_hal, (RK_U64 *)&reg_ctx->rps, sizeof(reg_ctx->rps));
     prepare_scanlist(p_hal, (RK_U64 *)&reg_ctx->sclst, sizeof(reg_ctx->sclst));
     set_registers(p_hal, reg_ctx->regs, task);
 
-    //!< copy datas
-    RK_U32 i = 0;
-    for (i = 0; i < 256; i++) {
-        mpp_buffer_write(reg_ctx->spspps_buf,
-                         (sizeof(reg_ctx->spspps) * i), (void *)reg_ctx->spspps,
-                         sizeof(reg_ctx->spspps));
-    }
     reg_ctx->regs->sw42.pps_base = mpp_buffer_get_fd(reg_ctx->spspps_buf);
 
     mpp_buffer_write(reg_ctx->rps_buf, 0,
@@ -668,7 +976,6 @@ MPP_RET rkv_h264d_gen_regs(void *hal, HalTaskInfo *task)
 
     mpp_buffer_write(reg_ctx->sclst_buf, 0,
                      (void *)reg_ctx->sclst, sizeof(reg_ctx->sclst));
-    reg_ctx->regs->sw75.errorinfo_base = mpp_buffer_get_fd(reg_ctx->errinfo_buf);
 
 __RETURN:
     return ret = MPP_OK;
@@ -763,7 +1070,7 @@ __SKIP_HARD:
     }
     memset(&p_regs->sw01, 0, sizeof(RK_U32));
     if (p_hal->fast_mode) {
-        reg_ctx->reg_buf[task->dec.reg_index].valid = 0;
+        hal_reg_ring_put(reg_ctx->reg_ring, task->dec.reg_index);
     }
 
     (void)task;
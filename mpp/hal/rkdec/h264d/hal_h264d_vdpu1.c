@@ -722,10 +722,14 @@ MPP_RET vdpu1_h264d_init(void *hal, MppHalCfg *cfg)
 
     MEM_CHECK(ret, p_hal->reg_ctx = mpp_calloc_size(void, sizeof(H264dVdpuRegCtx_t)));
     H264dVdpuRegCtx_t *reg_ctx = (H264dVdpuRegCtx_t *)p_hal->reg_ctx;
+    FUN_CHECK(ret = hal_reg_ring_init(&reg_ctx->reg_ring,
+                                      p_hal->fast_mode ? cfg->task_count : 1,
+                                      sizeof(*reg_ctx->reg_buf)));
+    reg_ctx->reg_buf = hal_reg_ring_elems(reg_ctx->reg_ring);
     //!< malloc buffers
     {
         RK_U32 i = 0;
-        RK_U32 loop = p_hal->fast_mode ? MPP_ARRAY_ELEMS(reg_ctx->reg_buf) : 1;
+        RK_U32 loop = hal_reg_ring_count(reg_ctx->reg_ring);
 
         RK_U32 buf_size = VDPU_CABAC_TAB_SIZE +  VDPU_POC_BUF_SIZE + VDPU_SCALING_LIST_SIZE;
         for (i = 0; i < loop; i++) {
@@ -749,7 +753,6 @@ MPP_RET vdpu1_h264d_init(void *hal, MppHalCfg *cfg)
     mpp_slots_set_prop(p_hal->frame_slots, SLOTS_HOR_ALIGN, vdpu_hor_align);
     mpp_slots_set_prop(p_hal->frame_slots, SLOTS_VER_ALIGN, vdpu_ver_align);
 
-    (void)cfg;
 __RETURN:
     return MPP_OK;
 __FAILED:
@@ -771,11 +774,16 @@ MPP_RET vdpu1_h264d_deinit(void *hal)
     H264dVdpuRegCtx_t *reg_ctx = (H264dVdpuRegCtx_t *)p_hal->reg_ctx;
 
     RK_U32 i = 0;
-    RK_U32 loop = p_hal->fast_mode ? MPP_ARRAY_ELEMS(reg_ctx->reg_buf) : 1;
+    RK_U32 loop = hal_reg_ring_count(reg_ctx->reg_ring);
     for (i = 0; i < loop; i++) {
         MPP_FREE(reg_ctx->reg_buf[i].regs);
         mpp_buffer_put(reg_ctx->reg_buf[i].buf);
     }
+    if (reg_ctx->reg_ring) {
+        hal_reg_ring_deinit(reg_ctx->reg_ring);
+        reg_ctx->reg_ring = NULL;
+        reg_ctx->reg_buf = NULL;
+    }
     MPP_FREE(p_hal->reg_ctx);
     MPP_FREE(p_hal->priv);
 
@@ -806,19 +814,18 @@ MPP_RET vdpu1_h264d_gen_regs(void *hal, HalTaskInfo *task)
 
     H264dVdpuRegCtx_t *reg_ctx = (H264dVdpuRegCtx_t *)p_hal->reg_ctx;
     if (p_hal->fast_mode) {
-        RK_U32 i = 0;
-        for (i = 0; i <  MPP_ARRAY_ELEMS(reg_ctx->reg_buf); i++) {
-            if (!reg_ctx->reg_buf[i].valid) {
-                task->dec.reg_index = i;
-                reg_ctx->buf = reg_ctx->reg_buf[i].buf;
-                reg_ctx->cabac_ptr = reg_ctx->reg_buf[i].cabac_ptr;
-                reg_ctx->poc_ptr = reg_ctx->reg_buf[i].poc_ptr;
-                reg_ctx->sclst_ptr = reg_ctx->reg_buf[i].sclst_ptr;
-                reg_ctx->regs = reg_ctx->reg_buf[i].regs;
-                reg_ctx->reg_buf[i].valid = 1;
-                break;
-            }
+        RK_S32 i = hal_reg_ring_get(reg_ctx->reg_ring);
+
+        if (i < 0) {
+            H264D_ERR("all register sets are in flight\n");
+            return MPP_NOK;
         }
+        task->dec.reg_index = i;
+        reg_ctx->buf = reg_ctx->reg_buf[i].buf;
+        reg_ctx->cabac_ptr = reg_ctx->reg_buf[i].cabac_ptr;
+        reg_ctx->poc_ptr = reg_ctx->reg_buf[i].poc_ptr;
+        reg_ctx->sclst_ptr = reg_ctx->reg_buf[i].sclst_ptr;
+        reg_ctx->regs = reg_ctx->reg_buf[i].regs;
     }
 
     FUN_CHECK(ret = adjust_input(priv, &p_hal->slice_long[0], p_hal->pp));
@@ -914,7 +921,7 @@ __SKIP_HARD:
     }
     memset(&p_regs->SwReg01, 0, sizeof(RK_U32));
     if (p_hal->fast_mode) {
-        reg_ctx->reg_buf[task->dec.reg_index].valid = 0;
+        hal_reg_ring_put(reg_ctx->reg_ring, task->dec.reg_index);
     }
     (void)task;
 
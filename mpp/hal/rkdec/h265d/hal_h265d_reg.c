@@ -35,8 +35,13 @@
 #include "mpp_mem.h"
 #include "mpp_bitread.h"
 #include "mpp_bitput.h"
+#include "mpp_buffer_impl.h"
 
 #include "mpp_device.h"
+#include "hal_scratch.h"
+#include "hal_pkt_cache.h"
+#include "hal_reg_ring.h"
+#include "hal_reg_tmpl.h"
 #include "cabac.h"
 #include "hal_h265d_reg.h"
 #include "hal_h265d_api.h"
@@ -47,15 +52,41 @@
 static FILE *fp = NULL;
 #endif
 
-#define MAX_GEN_REG 3
+/* pps packet and rps packet of 64 slices in 64bit */
+#define PPS_PACKET_LEN      11
+#define RPS_PACKET_LEN(n)   ((n) * 4 + 1)
+#define SCRATCH_INIT_SIZE   (sizeof(RK_U64) * (PPS_PACKET_LEN + RPS_PACKET_LEN(64)))
+#define PPS_CACHE_COUNT     4
+
 RK_U32 h265h_debug = 0;
 typedef struct h265d_reg_buf {
-    RK_S32    use_flag;
     MppBuffer scaling_list_data;
     MppBuffer pps_data;
     MppBuffer rps_data;
     void*     hw_regs;
+    /* serial of the pps packet in pps_data, zero for none */
+    RK_U32    pps_serial;
 } h265d_reg_buf_t;
+
+/*
+ * pps packet key: picture parameters without per-frame elements, scaling
+ * matrix and the scaling list buffer referenced by the packet
+ */
+typedef struct h265d_pps_key {
+    DXVA_PicParams_HEVC pp;
+    DXVA_Qmatrix_HEVC   qm;
+    RK_S32              sl_fd;
+} h265d_pps_key_t;
+
+/* all inputs of the sequence level registers in template */
+typedef struct h265d_seq_key {
+    RK_S32 width;
+    RK_S32 height;
+    RK_S32 bit_depth_luma_minus8;
+    RK_S32 bit_depth_chroma_minus8;
+    RK_S32 tiles_enabled_flag;
+    RK_S32 cabac_fd;
+} h265d_seq_key_t;
 typedef struct h265d_reg_context {
     MppBufSlots     slots;
     MppBufSlots     packet_slots;
@@ -65,13 +96,19 @@ typedef struct h265d_reg_context {
     MppBuffer pps_data;
     MppBuffer rps_data;
     void*     hw_regs;
-    h265d_reg_buf_t g_buf[MAX_GEN_REG];
+    /* register sets in ring, one set when not in fast mode */
+    h265d_reg_buf_t *g_buf;
+    HalRegRing reg_ring;
     RK_U32 fast_mode;
     IOInterruptCB int_cb;
     MppDevCtx dev_ctx;
     RK_U32 fast_mode_err_found;
     void *scaling_rk;
     void *scaling_qm;
+    /* scratch for pps / rps packet generation, reset on each gen_regs */
+    HalScratch scratch;
+    HalPktCache pps_cache;
+    HalRegTmpl reg_tmpl;
 } h265d_reg_context_t;
 
 typedef struct ScalingList {
@@ -283,7 +320,7 @@ static MPP_RET hal_h265d_alloc_res(void *hal)
     RK_S32 ret = 0;
     h265d_reg_context_t *reg_cxt = (h265d_reg_context_t *)hal;
     if (reg_cxt->fast_mode) {
-        for (i = 0; i < MAX_GEN_REG; i++) {
+        for (i = 0; i < hal_reg_ring_count(reg_cxt->reg_ring); i++) {
             reg_cxt->g_buf[i].hw_regs =
                 mpp_calloc_size(void, sizeof(H265d_REGS_t));
             ret = mpp_buffer_get(reg_cxt->group,
@@ -339,7 +376,7 @@ static MPP_RET hal_h265d_release_res(void *hal)
     h265d_reg_context_t *reg_cxt = ( h265d_reg_context_t *)hal;
     RK_S32 i = 0;
     if (reg_cxt->fast_mode) {
-        for (i = 0; i < MAX_GEN_REG; i++) {
+        for (i = 0; i < hal_reg_ring_count(reg_cxt->reg_ring); i++) {
             if (reg_cxt->g_buf[i].scaling_list_data) {
                 ret = mpp_buffer_put(reg_cxt->g_buf[i].scaling_list_data);
                 if (ret) {
@@ -453,23 +490,49 @@ MPP_RET hal_h265d_init(void *hal, MppHalCfg *cfg)
         }
     }
 
-    ret = mpp_buffer_get(reg_cxt->group, &reg_cxt->cabac_table_data, sizeof(cabac_table));
+    /* cabac table is constant and shared by all h265d instances */
+    ret = mpp_buffer_table_get(&reg_cxt->cabac_table_data, "h265d_cabac",
+                               MPP_BUFFER_TYPE_ION, sizeof(cabac_table),
+                               NULL, cabac_table);
     if (ret) {
         mpp_err("h265d cabac_table get buffer failed\n");
         return ret;
     }
 
-    ret = mpp_buffer_write(reg_cxt->cabac_table_data, 0, (void*)cabac_table, sizeof(cabac_table));
+    ret = hal_reg_ring_init(&reg_cxt->reg_ring,
+                            reg_cxt->fast_mode ? cfg->task_count : 1,
+                            sizeof(h265d_reg_buf_t));
     if (ret) {
-        mpp_err("h265d write cabac_table data failed\n");
+        mpp_err("hal_reg_ring_init failed\n");
         return ret;
     }
+    reg_cxt->g_buf = hal_reg_ring_elems(reg_cxt->reg_ring);
 
     ret = hal_h265d_alloc_res(hal);
     if (ret) {
         mpp_err("hal_h265d_alloc_res failed\n");
         return ret;
     }
+
+    ret = hal_scratch_init(&reg_cxt->scratch, SCRATCH_INIT_SIZE);
+    if (ret) {
+        mpp_err("hal_scratch_init failed\n");
+        return ret;
+    }
+
+    ret = hal_pkt_cache_init(&reg_cxt->pps_cache, PPS_CACHE_COUNT,
+                             sizeof(h265d_pps_key_t), 80);
+    if (ret) {
+        mpp_err("hal_pkt_cache_init failed\n");
+        return ret;
+    }
+
+    ret = hal_reg_tmpl_init(&reg_cxt->reg_tmpl, sizeof(H265d_REGS_t),
+                            sizeof(h265d_seq_key_t));
+    if (ret) {
+        mpp_err("hal_reg_tmpl_init failed\n");
+        return ret;
+    }
     mpp_env_get_u32("h265h_debug", &h265h_debug, 0);
 
 #ifdef dump
@@ -491,7 +554,7 @@ MPP_RET hal_h265d_deinit(void *hal)
             mpp_err("mpp_device_deinit failed. ret: %d\n", ret);
     }
 
-    ret = mpp_buffer_put(reg_cxt->cabac_table_data);
+    ret = mpp_buffer_table_put(reg_cxt->cabac_table_data);
     if (ret) {
         mpp_err("h265d cabac_table free buffer failed\n");
         return ret;
@@ -507,6 +570,27 @@ MPP_RET hal_h265d_deinit(void *hal)
 
     hal_h265d_release_res(hal);
 
+    if (reg_cxt->reg_ring) {
+        hal_reg_ring_deinit(reg_cxt->reg_ring);
+        reg_cxt->reg_ring = NULL;
+        reg_cxt->g_buf = NULL;
+    }
+
+    if (reg_cxt->scratch) {
+        hal_scratch_deinit(reg_cxt->scratch);
+        reg_cxt->scratch = NULL;
+    }
+
+    if (reg_cxt->pps_cache) {
+        hal_pkt_cache_deinit(reg_cxt->pps_cache);
+        reg_cxt->pps_cache = NULL;
+    }
+
+    if (reg_cxt->reg_tmpl) {
+        hal_reg_tmpl_deinit(reg_cxt->reg_tmpl);
+        reg_cxt->reg_tmpl = NULL;
+    }
+
     if (reg_cxt->group) {
         ret = mpp_buffer_group_put(reg_cxt->group);
         if (ret) {
@@ -735,7 +819,7 @@ static int hal_h265d_slice_rpl(void *dxva, SliceHeader_t *sh, RefPicListTab_t *r
     return 0;
 }
 
-static RK_S32 hal_h265d_slice_output_rps(void *dxva, void *rps_buf)
+static RK_S32 hal_h265d_slice_output_rps(void *hal, void *dxva, void *rps_buf)
 {
 
     RK_U32 i, j, k;
@@ -752,6 +836,7 @@ static RK_S32 hal_h265d_slice_output_rps(void *dxva, void *rps_buf)
     RK_U32    nb_refs = 0;
     RK_S32    bit_begin;
     h265d_dxva2_picture_context_t *dxva_cxt = NULL;
+    h265d_reg_context_t *reg_cxt = (h265d_reg_context_t *)hal;
 
     memset(&rps_pic_info,   0, sizeof(rps_pic_info));
     memset(&slice_nb_rps_poc, 0, sizeof(slice_nb_rps_poc));
@@ -1022,9 +1107,14 @@ static RK_S32 hal_h265d_slice_output_rps(void *dxva, void *rps_buf)
 //out put for rk format
     {
         RK_S32  nb_slice = slice_idx + 1;
-        RK_S32  fifo_len   = nb_slice * 4 + 1;//size of rps_packet alloc more 1 64 bit invoid buffer no enought
-        RK_U64 *rps_packet = mpp_malloc(RK_U64, fifo_len);
+        RK_S32  fifo_len   = RPS_PACKET_LEN(nb_slice);//size of rps_packet alloc more 1 64 bit invoid buffer no enought
+        RK_U64 *rps_packet = hal_scratch_get(reg_cxt->scratch, sizeof(RK_U64) * fifo_len);
         BitputCtx_t bp;
+
+        if (NULL == rps_packet) {
+            mpp_err("rps_packet get scratch error");
+            return MPP_ERR_NOMEM;
+        }
         mpp_set_bitput_ctx(&bp, rps_packet, fifo_len);
         for (k = 0; k < (RK_U32)nb_slice; k++) {
             for (j = 0; j < 2; j++) {
@@ -1052,7 +1142,6 @@ static RK_S32 hal_h265d_slice_output_rps(void *dxva, void *rps_buf)
         if (rps_buf != NULL) {
             memcpy(rps_buf, rps_packet, nb_slice * 32);
         }
-        mpp_free(rps_packet);
     }
 
     return 0;
@@ -1093,9 +1182,45 @@ static void hal_h265d_output_scalinglist_packet(void *hal, void *ptr, void *dxva
 }
 
 
-static RK_S32 hal_h265d_output_pps_packet(void *hal, void *dxva)
+static RK_U32 hal_h265d_scaling_list_addr(h265d_dxva2_picture_context_t *dxva_cxt)
 {
-    RK_S32 fifo_len = 10;
+    if (dxva_cxt->pp.scaling_list_data_present_flag)
+        return (dxva_cxt->pp.pps_id + 16) * 1360;
+    else if (dxva_cxt->pp.scaling_list_enabled_flag)
+        return dxva_cxt->pp.sps_id * 1360;
+
+    return 80 * 1360;
+}
+
+static void hal_h265d_pps_key(h265d_reg_context_t *reg_cxt,
+                              h265d_dxva2_picture_context_t *dxva_cxt,
+                              h265d_pps_key_t *key)
+{
+    DXVA_PicParams_HEVC *pp = &key->pp;
+
+    memcpy(pp, &dxva_cxt->pp, sizeof(*pp));
+    memcpy(&key->qm, &dxva_cxt->qm, sizeof(key->qm));
+    key->sl_fd = mpp_buffer_get_fd(reg_cxt->scaling_list_data);
+
+    /* clear the elements which change on each frame and not in packet */
+    memset(&pp->CurrPic, 0, sizeof(pp->CurrPic));
+    pp->ucNumDeltaPocsOfRefRpsIdx = 0;
+    pp->wNumBitsForShortTermRPSInSlice = 0;
+    pp->IrapPicFlag = 0;
+    pp->IdrPicFlag = 0;
+    pp->IntraPicFlag = 0;
+    pp->CurrPicOrderCntVal = 0;
+    memset(pp->RefPicList, 0, sizeof(pp->RefPicList));
+    memset(pp->PicOrderCntValList, 0, sizeof(pp->PicOrderCntValList));
+    memset(pp->RefPicSetStCurrBefore, 0, sizeof(pp->RefPicSetStCurrBefore));
+    memset(pp->RefPicSetStCurrAfter, 0, sizeof(pp->RefPicSetStCurrAfter));
+    memset(pp->RefPicSetLtCurr, 0, sizeof(pp->RefPicSetLtCurr));
+    pp->StatusReportFeedbackNumber = 0;
+}
+
+static RK_S32 hal_h265d_output_pps_packet(void *hal, void *dxva, RK_U32 *buf_serial)
+{
+    RK_S32 fifo_len = PPS_PACKET_LEN - 1;
     RK_S32 i, j;
     RK_U32 addr;
     RK_U32 log2_min_cb_size;
@@ -1103,12 +1228,15 @@ static RK_S32 hal_h265d_output_pps_packet(void *hal, void *dxva)
     h265d_reg_context_t *reg_cxt = ( h265d_reg_context_t *)hal;
     h265d_dxva2_picture_context_t *dxva_cxt = (h265d_dxva2_picture_context_t*)dxva;
     BitputCtx_t bp;
-    RK_U64 *pps_packet = mpp_calloc(RK_U64, fifo_len + 1);
+    RK_U64 *pps_packet = NULL;
+    h265d_pps_key_t key;
+    RK_U32 serial = 0;
+    void *pkt = NULL;
+    RK_U8 *ptr_scaling = NULL;
 
     if (NULL == reg_cxt || dxva_cxt == NULL) {
         mpp_err("%s:%s:%d reg_cxt or dxva_cxt is NULL",
                 __FILE__, __FUNCTION__, __LINE__);
-        MPP_FREE(pps_packet);
         return MPP_ERR_NULL_PTR;
     }
 
@@ -1117,7 +1245,21 @@ static RK_S32 hal_h265d_output_pps_packet(void *hal, void *dxva)
         mpp_err("pps_data get ptr error");
         return MPP_ERR_NOMEM;
     }
-    memset(pps_ptr, 0, 80 * 64);
+
+    /* pps_data already has the same packet, nothing to do */
+    hal_h265d_pps_key(reg_cxt, dxva_cxt, &key);
+    pkt = hal_pkt_cache_get(reg_cxt->pps_cache, &key, &serial);
+    if (pkt && *buf_serial == serial)
+        return 0;
+
+    if (pkt)
+        goto WRITE_PPS;
+
+    pps_packet = hal_scratch_get(reg_cxt->scratch, sizeof(RK_U64) * (fifo_len + 1));
+    if (NULL == pps_packet) {
+        mpp_err("pps_packet get scratch error");
+        return MPP_ERR_NOMEM;
+    }
     // pps_packet = (RK_U64 *)(pps_ptr + dxva_cxt->pp.pps_id * 80);
 
     for (i = 0; i < 10; i++) pps_packet[i] = 0;
@@ -1283,18 +1425,9 @@ static RK_S32 hal_h265d_output_pps_packet(void *hal, void *dxva)
     }
 
     {
-        RK_U8 *ptr_scaling = (RK_U8 *)mpp_buffer_get_ptr(reg_cxt->scaling_list_data);
-        if (dxva_cxt->pp.scaling_list_data_present_flag) {
-            addr = (dxva_cxt->pp.pps_id + 16) * 1360;
-        } else if (dxva_cxt->pp.scaling_list_enabled_flag) {
-            addr = dxva_cxt->pp.sps_id * 1360;
-        } else {
-            addr = 80 * 1360;
-        }
-
-        hal_h265d_output_scalinglist_packet(hal, ptr_scaling + addr, dxva);
-
         RK_U32 fd = mpp_buffer_get_fd(reg_cxt->scaling_list_data);
+
+        addr = hal_h265d_scaling_list_addr(dxva_cxt);
         /* need to config addr */
         addr = fd | (addr << 10);
 
@@ -1302,83 +1435,144 @@ static RK_S32 hal_h265d_output_pps_packet(void *hal, void *dxva)
         mpp_put_align(&bp, 64, 0xf);
     }
 
+    pkt = hal_pkt_cache_put(reg_cxt->pps_cache, &key, pps_packet, &serial);
+    if (NULL == pkt)
+        return MPP_NOK;
+
+WRITE_PPS:
+    ptr_scaling = (RK_U8 *)mpp_buffer_get_ptr(reg_cxt->scaling_list_data);
+    addr = hal_h265d_scaling_list_addr(dxva_cxt);
+    hal_h265d_output_scalinglist_packet(hal, ptr_scaling + addr, dxva);
+
+    memset(pps_ptr, 0, 80 * 64);
     for (i = 0; i < 64; i++)
-        memcpy(pps_ptr + i * 80, pps_packet, 80);
+        memcpy((RK_U8 *)pps_ptr + i * 80, pkt, 80);
+    *buf_serial = serial;
 
 #ifdef dump
     fwrite(pps_ptr, 1, 80 * 64, fp);
     fflush(fp);
 #endif
 
-    MPP_FREE(pps_packet);
     return 0;
 }
 
-MPP_RET hal_h265d_gen_regs(void *hal,  HalTaskInfo *syn)
+static void hal_h265d_seq_key(h265d_reg_context_t *reg_cxt,
+                              h265d_dxva2_picture_context_t *dxva_cxt,
+                              h265d_seq_key_t *key)
+{
+    RK_S32 log2_min_cb_size = dxva_cxt->pp.log2_min_luma_coding_block_size_minus3 + 3;
+
+    memset(key, 0, sizeof(*key));
+    key->width = (dxva_cxt->pp.PicWidthInMinCbsY << log2_min_cb_size);
+    key->height = (dxva_cxt->pp.PicHeightInMinCbsY << log2_min_cb_size);
+    key->bit_depth_luma_minus8 = dxva_cxt->pp.bit_depth_luma_minus8;
+    key->bit_depth_chroma_minus8 = dxva_cxt->pp.bit_depth_chroma_minus8;
+    key->tiles_enabled_flag = dxva_cxt->pp.tiles_enabled_flag;
+    key->cabac_fd = mpp_buffer_get_fd(reg_cxt->cabac_table_data);
+}
+
+/* registers unchanged in one sequence, hw_regs is cleared */
+static void hal_h265d_set_regs_seq(H265d_REGS_t *hw_regs, h265d_seq_key_t *key)
 {
-    RK_S32 i = 0;
-    RK_S32 log2_min_cb_size;
-    RK_S32 width, height;
     RK_S32 stride_y, stride_uv, virstrid_y, virstrid_yuv;
 
+    stride_y = ((MPP_ALIGN(key->width, 64)
+                 * (key->bit_depth_luma_minus8 + 8)) >> 3);
+    stride_uv = ((MPP_ALIGN(key->width, 64)
+                  * (key->bit_depth_chroma_minus8 + 8)) >> 3);
 
-    H265d_REGS_t *hw_regs;
-    RK_S32 ret = MPP_SUCCESS;
-    MppBuffer streambuf = NULL;
-    RK_S32 aglin_offset = 0;
+    stride_y = hevc_hor_align(stride_y);
+    stride_uv = hevc_hor_align(stride_uv);
+    virstrid_y = hevc_ver_align(key->height) * stride_y;
+    virstrid_yuv  = virstrid_y + stride_uv * hevc_ver_align(key->height) / 2;
+
+    hw_regs->sw_picparameter.sw_y_hor_virstride = stride_y >> 4;
+    hw_regs->sw_picparameter.sw_uv_hor_virstride = stride_uv >> 4;
+    hw_regs->sw_y_virstride = virstrid_y >> 4;
+    hw_regs->sw_yuv_virstride = virstrid_yuv >> 4;
+
+    hw_regs->sw_cabactbl_base   =  key->cabac_fd;
+    hw_regs->sw_interrupt.sw_dec_e         = 1;
+    hw_regs->sw_interrupt.sw_dec_timeout_e = 1;
+    hw_regs->sw_interrupt.sw_wr_ddr_align_en = key->tiles_enabled_flag
+                                               ? 0 : 1;
+
+    hw_regs->cabac_error_en = 0xfdfffffd;
+    hw_regs->extern_error_en = 0x30000000;
+}
+
+/* registers changed on each frame, hw_regs is copied from template */
+static void hal_h265d_set_regs_frame(h265d_reg_context_t *reg_cxt,
+                                     h265d_dxva2_picture_context_t *dxva_cxt,
+                                     H265d_REGS_t *hw_regs, MppBuffer streambuf)
+{
+    RK_S32 i = 0;
     RK_S32 valid_ref = -1;
     MppBuffer framebuf = NULL;
 
-    if (syn->dec.flags.parse_err ||
-        syn->dec.flags.ref_err) {
-        h265h_dbg(H265H_DBG_TASK_ERR, "%s found task error\n", __FUNCTION__);
-        return MPP_OK;
-    }
+    hw_regs->sw_picparameter.sw_slice_num = dxva_cxt->slice_count;
 
-    h265d_dxva2_picture_context_t *dxva_cxt =
-        (h265d_dxva2_picture_context_t *)syn->dec.syntax.data;
-    h265d_reg_context_t *reg_cxt = ( h265d_reg_context_t *)hal;
+    mpp_buf_slot_get_prop(reg_cxt->slots, dxva_cxt->pp.CurrPic.Index7Bits,
+                          SLOT_BUFFER, &framebuf);
+    hw_regs->sw_decout_base  = mpp_buffer_get_fd(framebuf); //just index need map
 
-    void *rps_ptr = NULL;
-    if (reg_cxt ->fast_mode) {
-        for (i = 0; i < MAX_GEN_REG; i++) {
-            if (!reg_cxt->g_buf[i].use_flag) {
-                syn->dec.reg_index = i;
-                reg_cxt->rps_data = reg_cxt->g_buf[i].rps_data;
-                reg_cxt->scaling_list_data =
-                    reg_cxt->g_buf[i].scaling_list_data;
-                reg_cxt->pps_data = reg_cxt->g_buf[i].pps_data;
-                reg_cxt->hw_regs = reg_cxt->g_buf[i].hw_regs;
-                reg_cxt->g_buf[i].use_flag = 1;
-                break;
-            }
-        }
-        if (i == MAX_GEN_REG) {
-            mpp_err("hevc rps buf all used");
-            return MPP_ERR_NOMEM;
-        }
-    }
-    rps_ptr = mpp_buffer_get_ptr(reg_cxt->rps_data);
-    if (NULL == rps_ptr) {
+    /*if out_base is equal to zero it means this frame may error
+    we return directly add by csy*/
 
-        mpp_err("rps_data get ptr error");
-        return MPP_ERR_NOMEM;
+    if (hw_regs->sw_decout_base == 0) {
+        return;
     }
 
+    hw_regs->sw_cur_poc = dxva_cxt->pp.CurrPicOrderCntVal;
 
-    if (syn->dec.syntax.data == NULL) {
-        mpp_err("%s:%s:%d dxva is NULL", __FILE__, __FUNCTION__, __LINE__);
-        return MPP_ERR_NULL_PTR;
-    }
+    hw_regs->sw_pps_base        =  mpp_buffer_get_fd(reg_cxt->pps_data);
+    hw_regs->sw_rps_base        =  mpp_buffer_get_fd(reg_cxt->rps_data);
+    hw_regs->sw_strm_rlc_base   =  mpp_buffer_get_fd(streambuf);
+    hw_regs->sw_stream_len      = ((dxva_cxt->bitstream_size + 15)
+                                   & (~15)) + 64;
 
-    /* output pps */
-    hal_h265d_output_pps_packet(hal, syn->dec.syntax.data);
+    ///find s->rps_model[i] position, and set register
+    hw_regs->sw_ref_valid = 0;
 
-    if (NULL == reg_cxt->hw_regs) {
-        return MPP_ERR_NULL_PTR;
+    valid_ref = hw_regs->sw_decout_base;
+    for (i = 0; i < (RK_S32)MPP_ARRAY_ELEMS(dxva_cxt->pp.RefPicList); i++) {
+        if (dxva_cxt->pp.RefPicList[i].bPicEntry != 0xff &&
+            dxva_cxt->pp.RefPicList[i].bPicEntry != 0x7f) {
+            hw_regs->sw_refer_poc[i] = dxva_cxt->pp.PicOrderCntValList[i];
+            mpp_buf_slot_get_prop(reg_cxt->slots,
+                                  dxva_cxt->pp.RefPicList[i].Index7Bits,
+                                  SLOT_BUFFER, &framebuf);
+            if (framebuf != NULL) {
+                hw_regs->sw_refer_base[i] = mpp_buffer_get_fd(framebuf);
+                valid_ref = hw_regs->sw_refer_base[i];
+            } else {
+                hw_regs->sw_refer_base[i] = valid_ref;
+            }
+            hw_regs->sw_ref_valid          |=   (1 << i);
+        } else {
+            hw_regs->sw_refer_base[i] = hw_regs->sw_decout_base;
+        }
     }
 
-    hw_regs = (H265d_REGS_t*)reg_cxt->hw_regs;
+    hw_regs->sw_refer_base[0] |= ((hw_regs->sw_ref_valid & 0xf) << 10);
+    hw_regs->sw_refer_base[1] |= (((hw_regs->sw_ref_valid >> 4) & 0xf) << 10);
+    hw_regs->sw_refer_base[2] |= (((hw_regs->sw_ref_valid >> 8) & 0xf) << 10);
+    hw_regs->sw_refer_base[3] |= (((hw_regs->sw_ref_valid >> 12) & 0x7) << 10);
+}
+
+/* full regeneration from syntax without template, used by check only */
+static void hal_h265d_set_regs_full(h265d_reg_context_t *reg_cxt,
+                                    h265d_dxva2_picture_context_t *dxva_cxt,
+                                    H265d_REGS_t *hw_regs, MppBuffer streambuf)
+{
+    RK_S32 i = 0;
+    RK_S32 log2_min_cb_size;
+    RK_S32 width, height;
+    RK_S32 stride_y, stride_uv, virstrid_y, virstrid_yuv;
+    RK_S32 valid_ref = -1;
+    MppBuffer framebuf = NULL;
+
     memset(hw_regs, 0, sizeof(H265d_REGS_t));
 
     log2_min_cb_size = dxva_cxt->pp.log2_min_luma_coding_block_size_minus3 + 3;
@@ -1404,43 +1598,24 @@ MPP_RET hal_h265d_gen_regs(void *hal,  HalTaskInfo *syn)
 
     mpp_buf_slot_get_prop(reg_cxt->slots, dxva_cxt->pp.CurrPic.Index7Bits,
                           SLOT_BUFFER, &framebuf);
-    hw_regs->sw_decout_base  = mpp_buffer_get_fd(framebuf); //just index need map
-
-    /*if out_base is equal to zero it means this frame may error
-    we return directly add by csy*/
+    hw_regs->sw_decout_base  = mpp_buffer_get_fd(framebuf);
 
-    if (hw_regs->sw_decout_base == 0) {
-        return 0;
-    }
+    if (hw_regs->sw_decout_base == 0)
+        return;
 
     hw_regs->sw_cur_poc = dxva_cxt->pp.CurrPicOrderCntVal;
 
-    mpp_buf_slot_get_prop(reg_cxt->packet_slots, syn->dec.input, SLOT_BUFFER,
-                          &streambuf);
-    if ( dxva_cxt->bitstream == NULL) {
-        dxva_cxt->bitstream = mpp_buffer_get_ptr(streambuf);
-    }
-
-    hal_h265d_slice_output_rps(syn->dec.syntax.data, rps_ptr);
-
     hw_regs->sw_cabactbl_base   =  mpp_buffer_get_fd(reg_cxt->cabac_table_data);
     hw_regs->sw_pps_base        =  mpp_buffer_get_fd(reg_cxt->pps_data);
     hw_regs->sw_rps_base        =  mpp_buffer_get_fd(reg_cxt->rps_data);
     hw_regs->sw_strm_rlc_base   =  mpp_buffer_get_fd(streambuf);
     hw_regs->sw_stream_len      = ((dxva_cxt->bitstream_size + 15)
                                    & (~15)) + 64;
-    aglin_offset =  hw_regs->sw_stream_len - dxva_cxt->bitstream_size;
-    if (aglin_offset > 0) {
-        memset((void *)(dxva_cxt->bitstream + dxva_cxt->bitstream_size), 0,
-               aglin_offset);
-    }
     hw_regs->sw_interrupt.sw_dec_e         = 1;
     hw_regs->sw_interrupt.sw_dec_timeout_e = 1;
     hw_regs->sw_interrupt.sw_wr_ddr_align_en = dxva_cxt->pp.tiles_enabled_flag
                                                ? 0 : 1;
 
-
-    ///find s->rps_model[i] position, and set register
     hw_regs->sw_ref_valid = 0;
 
     hw_regs->cabac_error_en = 0xfdfffffd;
@@ -1470,6 +1645,103 @@ MPP_RET hal_h265d_gen_regs(void *hal,  HalTaskInfo *syn)
     hw_regs->sw_refer_base[1] |= (((hw_regs->sw_ref_valid >> 4) & 0xf) << 10);
     hw_regs->sw_refer_base[2] |= (((hw_regs->sw_ref_valid >> 8) & 0xf) << 10);
     hw_regs->sw_refer_base[3] |= (((hw_regs->sw_ref_valid >> 12) & 0x7) << 10);
+}
+
+MPP_RET hal_h265d_gen_regs(void *hal,  HalTaskInfo *syn)
+{
+    RK_S32 i = 0;
+    H265d_REGS_t *hw_regs;
+    H265d_REGS_t *tmpl = NULL;
+    H265d_REGS_t *ref = NULL;
+    h265d_seq_key_t key;
+    RK_S32 ret = MPP_SUCCESS;
+    MppBuffer streambuf = NULL;
+    RK_S32 aglin_offset = 0;
+
+    if (syn->dec.flags.parse_err ||
+        syn->dec.flags.ref_err) {
+        h265h_dbg(H265H_DBG_TASK_ERR, "%s found task error\n", __FUNCTION__);
+        return MPP_OK;
+    }
+
+    h265d_dxva2_picture_context_t *dxva_cxt =
+        (h265d_dxva2_picture_context_t *)syn->dec.syntax.data;
+    h265d_reg_context_t *reg_cxt = ( h265d_reg_context_t *)hal;
+
+    void *rps_ptr = NULL;
+    if (reg_cxt ->fast_mode) {
+        i = hal_reg_ring_get(reg_cxt->reg_ring);
+        if (i < 0) {
+            mpp_err("hevc rps buf all used");
+            return MPP_ERR_NOMEM;
+        }
+        syn->dec.reg_index = i;
+        reg_cxt->rps_data = reg_cxt->g_buf[i].rps_data;
+        reg_cxt->scaling_list_data =
+            reg_cxt->g_buf[i].scaling_list_data;
+        reg_cxt->pps_data = reg_cxt->g_buf[i].pps_data;
+        reg_cxt->hw_regs = reg_cxt->g_buf[i].hw_regs;
+    }
+    rps_ptr = mpp_buffer_get_ptr(reg_cxt->rps_data);
+    if (NULL == rps_ptr) {
+
+        mpp_err("rps_data get ptr error");
+        return MPP_ERR_NOMEM;
+    }
+
+
+    if (syn->dec.syntax.data == NULL) {
+        mpp_err("%s:%s:%d dxva is NULL", __FILE__, __FUNCTION__, __LINE__);
+        return MPP_ERR_NULL_PTR;
+    }
+
+    /* all packet scratch of last task is released here */
+    hal_scratch_reset(reg_cxt->scratch);
+
+    /* output pps */
+    hal_h265d_output_pps_packet(hal, syn->dec.syntax.data,
+                                &reg_cxt->g_buf[reg_cxt->fast_mode ? syn->dec.reg_index : 0].pps_serial);
+
+    if (NULL == reg_cxt->hw_regs) {
+        return MPP_ERR_NULL_PTR;
+    }
+
+    hw_regs = (H265d_REGS_t*)reg_cxt->hw_regs;
+
+    /* sequence registers are only rebuilt when the sequence changes */
+    hal_h265d_seq_key(reg_cxt, dxva_cxt, &key);
+    tmpl = (H265d_REGS_t *)hal_reg_tmpl_update(reg_cxt->reg_tmpl, &key);
+    if (tmpl)
+        hal_h265d_set_regs_seq(tmpl, &key);
+
+    hal_reg_tmpl_apply(reg_cxt->reg_tmpl, hw_regs);
+
+    mpp_buf_slot_get_prop(reg_cxt->packet_slots, syn->dec.input, SLOT_BUFFER,
+                          &streambuf);
+    hal_h265d_set_regs_frame(reg_cxt, dxva_cxt, hw_regs, streambuf);
+
+    /* debug: compare with full regeneration, error frame is not decoded */
+    ref = (H265d_REGS_t *)hal_reg_tmpl_check_ref(reg_cxt->reg_tmpl);
+    if (ref && hw_regs->sw_decout_base) {
+        hal_h265d_set_regs_full(reg_cxt, dxva_cxt, ref, streambuf);
+        hal_reg_tmpl_check(reg_cxt->reg_tmpl, hw_regs, ref);
+    }
+
+    if (hw_regs->sw_decout_base == 0) {
+        return 0;
+    }
+
+    if ( dxva_cxt->bitstream == NULL) {
+        dxva_cxt->bitstream = mpp_buffer_get_ptr(streambuf);
+    }
+
+    hal_h265d_slice_output_rps(hal, syn->dec.syntax.data, rps_ptr);
+
+    aglin_offset =  hw_regs->sw_stream_len - dxva_cxt->bitstream_size;
+    if (aglin_offset > 0) {
+        memset((void *)(dxva_cxt->bitstream + dxva_cxt->bitstream_size), 0,
+               aglin_offset);
+    }
 
     return ret;
 }
@@ -1597,7 +1869,7 @@ ERR_PROC:
     }
 
     if (reg_cxt->fast_mode) {
-        reg_cxt->g_buf[index].use_flag = 0;
+        hal_reg_ring_put(reg_cxt->reg_ring, index);
     }
 
     return ret;
@@ -29,12 +29,16 @@
 #include "mpp_bitput.h"
 
 #include "mpp_device.h"
+#include "hal_reg_ring.h"
+#include "hal_scratch.h"
 #include "hal_vp9d_api.h"
 #include "hal_vp9d_reg.h"
 #include "vp9d_syntax.h"
 #include "hal_vp9d_table.h"
 
 #define PROBE_SIZE   4864
+/* probe packet size in 64bit with one more for bitput overflow */
+#define PROBE_PACKET_LEN    304
 #define COUNT_SIZE   13208
 
 /*nCtuX*nCtuY*8*8/2
@@ -70,9 +74,7 @@ typedef struct vp9_dec_last_info {
     UCHAR feature_mask[8];
 } vp9_dec_last_info_t;
 
-#define MAX_GEN_REG 3
 typedef struct vp9d_reg_buf {
-    RK_S32    use_flag;
     MppBuffer probe_base;
     MppBuffer count_base;
     MppBuffer segid_cur_base;
@@ -85,7 +87,9 @@ typedef struct hal_vp9_context {
     MppBufSlots     packet_slots;
     MppDevCtx       dev_ctx;
     MppBufferGroup group;
-    vp9d_reg_buf_t g_buf[MAX_GEN_REG];
+    /* register sets in ring for fast mode */
+    vp9d_reg_buf_t *g_buf;
+    HalRegRing reg_ring;
     MppBuffer probe_base;
     MppBuffer count_base;
     MppBuffer segid_cur_base;
@@ -101,6 +105,8 @@ typedef struct hal_vp9_context {
     */
     RK_U32    last_segid_flag;
     RK_U32    fast_mode;
+    /* scratch for probe packet generation */
+    HalScratch scratch;
 } hal_vp9_context_t;
 
 static RK_U32 vp9_ver_align(RK_U32 val)
@@ -119,7 +125,7 @@ static MPP_RET hal_vp9d_alloc_res(hal_vp9_context_t *reg_cxt)
     RK_S32 ret = 0;
 
     if (reg_cxt->fast_mode) {
-        for (i = 0; i < MAX_GEN_REG; i++) {
+        for (i = 0; i < hal_reg_ring_count(reg_cxt->reg_ring); i++) {
             reg_cxt->g_buf[i].hw_regs = mpp_calloc_size(void, sizeof(VP9_REGS));
             ret = mpp_buffer_get(reg_cxt->group,
                                  &reg_cxt->g_buf[i].probe_base, PROBE_SIZE);
@@ -178,7 +184,7 @@ static MPP_RET hal_vp9d_release_res(hal_vp9_context_t *reg_cxt)
     RK_S32 ret = 0;
 
     if (reg_cxt->fast_mode) {
-        for (i = 0; i < MAX_GEN_REG; i++) {
+        for (i = 0; i < hal_reg_ring_count(reg_cxt->reg_ring); i++) {
             if (reg_cxt->g_buf[i].probe_base) {
                 ret = mpp_buffer_put(reg_cxt->g_buf[i].probe_base);
                 if (ret) {
@@ -297,12 +303,27 @@ MPP_RET hal_vp9d_init(void *hal, MppHalCfg *cfg)
         }
     }
 
+    ret = hal_reg_ring_init(&reg_cxt->reg_ring,
+                            reg_cxt->fast_mode ? cfg->task_count : 1,
+                            sizeof(vp9d_reg_buf_t));
+    if (ret) {
+        mpp_err("hal_reg_ring_init failed\n");
+        return ret;
+    }
+    reg_cxt->g_buf = hal_reg_ring_elems(reg_cxt->reg_ring);
+
     ret = hal_vp9d_alloc_res(reg_cxt);
     if (ret) {
         mpp_err("hal_vp9d_alloc_res failed\n");
         return ret;
     }
 
+    ret = hal_scratch_init(&reg_cxt->scratch, sizeof(RK_U64) * (PROBE_PACKET_LEN + 1));
+    if (ret) {
+        mpp_err("hal_scratch_init failed\n");
+        return ret;
+    }
+
     mpp_env_get_u32("vp9h_debug", &vp9h_debug, 0);
 
     reg_cxt->last_segid_flag = 1;
@@ -338,6 +359,17 @@ MPP_RET hal_vp9d_deinit(void *hal)
 
     hal_vp9d_release_res(reg_cxt);
 
+    if (reg_cxt->reg_ring) {
+        hal_reg_ring_deinit(reg_cxt->reg_ring);
+        reg_cxt->reg_ring = NULL;
+        reg_cxt->g_buf = NULL;
+    }
+
+    if (reg_cxt->scratch) {
+        hal_scratch_deinit(reg_cxt->scratch);
+        reg_cxt->scratch = NULL;
+    }
+
     if (reg_cxt->group) {
         ret = mpp_buffer_group_put(reg_cxt->group);
         if (ret) {
@@ -351,7 +383,7 @@ MPP_RET hal_vp9d_deinit(void *hal)
 MPP_RET hal_vp9d_output_probe(void *hal, void *dxva)
 {
     RK_S32 i, j, k, m, n;
-    RK_S32 fifo_len = 304;
+    RK_S32 fifo_len = PROBE_PACKET_LEN;
     RK_U64 *probe_packet = NULL;
     BitputCtx_t bp;
     DXVA_PicParams_VP9 *pic_param = (DXVA_PicParams_VP9*)dxva;
@@ -375,7 +407,12 @@ MPP_RET hal_vp9d_output_probe(void *hal, void *dxva)
         memcpy(uv_mode_prob, pic_param->prob.uv_mode, sizeof(uv_mode_prob));
     }
 
-    probe_packet = mpp_calloc(RK_U64, fifo_len + 1);
+    hal_scratch_reset(reg_cxt->scratch);
+    probe_packet = hal_scratch_get(reg_cxt->scratch, sizeof(RK_U64) * (fifo_len + 1));
+    if (NULL == probe_packet) {
+        mpp_err("probe_packet get scratch error");
+        return MPP_ERR_NOMEM;
+    }
     mpp_set_bitput_ctx(&bp, probe_packet, fifo_len);
     //sb info  5 x 128 bit
     for (i = 0; i < PARTITION_CONTEXTS; i++) //kf_partition_prob
@@ -594,8 +631,6 @@ MPP_RET hal_vp9d_output_probe(void *hal, void *dxva)
     }
     fflush(vp9_fp);
 #endif
-    if (probe_packet != NULL)
-        mpp_free(probe_packet);
 
     return 0;
 }
@@ -708,22 +743,17 @@ MPP_RET hal_vp9d_gen_regs(void *hal, HalTaskInfo *task)
     DXVA_PicParams_VP9 *pic_param = (DXVA_PicParams_VP9*)task->dec.syntax.data;
 
     if (reg_cxt ->fast_mode) {
-        for (i = 0; i < MAX_GEN_REG; i++) {
-            if (!reg_cxt->g_buf[i].use_flag) {
-                task->dec.reg_index = i;
-                reg_cxt->probe_base = reg_cxt->g_buf[i].probe_base;
-                reg_cxt->count_base = reg_cxt->g_buf[i].count_base;
-                reg_cxt->segid_cur_base = reg_cxt->g_buf[i].segid_cur_base;
-                reg_cxt->segid_last_base = reg_cxt->g_buf[i].segid_last_base;
-                reg_cxt->hw_regs = reg_cxt->g_buf[i].hw_regs;
-                reg_cxt->g_buf[i].use_flag = 1;
-                break;
-            }
-        }
-        if (i == MAX_GEN_REG) {
+        i = hal_reg_ring_get(reg_cxt->reg_ring);
+        if (i < 0) {
             mpp_err("vp9 fast mode buf all used\n");
             return MPP_ERR_NOMEM;
         }
+        task->dec.reg_index = i;
+        reg_cxt->probe_base = reg_cxt->g_buf[i].probe_base;
+        reg_cxt->count_base = reg_cxt->g_buf[i].count_base;
+        reg_cxt->segid_cur_base = reg_cxt->g_buf[i].segid_cur_base;
+        reg_cxt->segid_last_base = reg_cxt->g_buf[i].segid_last_base;
+        reg_cxt->hw_regs = reg_cxt->g_buf[i].hw_regs;
     }
     VP9_REGS *vp9_hw_regs = (VP9_REGS*)reg_cxt->hw_regs;
     intraFlag = (!pic_param->frame_type || pic_param->intra_only);
@@ -1036,7 +1066,7 @@ MPP_RET hal_vp9d_wait(void *hal, HalTaskInfo *task)
         reg_cxt->int_cb.callBack(reg_cxt->int_cb.opaque, (void*)&pic_param->counts);
     }
     if (reg_cxt->fast_mode) {
-        reg_cxt->g_buf[task->dec.reg_index].use_flag = 0;
+        hal_reg_ring_put(reg_cxt->reg_ring, task->dec.reg_index);
     }
 
     (void)task;
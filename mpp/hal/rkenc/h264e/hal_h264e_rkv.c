@@ -91,6 +91,16 @@ static double QP2Qstep( double qp_avg )
     return round(Qstep * 4);
 }
 
+/* QP2Qstep result on integer qp, used by qp search to avoid pow per step */
+static const RK_S32 rkv_qp2qstep[52] = {
+    3,   3,   3,   4,   4,   4,   5,   6,   6,   7,
+    8,   9,   10,  11,  13,  14,  16,  18,  20,  22,
+    25,  28,  32,  36,  40,  45,  50,  57,  63,  71,
+    80,  90,  101, 113, 127, 143, 160, 180, 202, 226,
+    254, 285, 320, 359, 403, 453, 508, 570, 640, 718,
+    806, 905
+};
+
 static MPP_RET h264e_rkv_free_buffers(H264eHalContext *ctx)
 {
     RK_S32 k = 0;
@@ -147,6 +157,39 @@ static MPP_RET h264e_rkv_free_buffers(H264eHalContext *ctx)
     return MPP_OK;
 }
 
+static RK_S64 h264e_rkv_buffers_size(MppBuffer *bufs, RK_S32 count)
+{
+    RK_S64 size = 0;
+    RK_S32 k;
+
+    for (k = 0; k < count; k++) {
+        if (bufs[k])
+            size += mpp_buffer_get_size(bufs[k]);
+    }
+
+    return size;
+}
+
+/* recon and down scaled picture are kept as reference for next frames */
+static MPP_RET h264e_rkv_get_buf_stat(H264eHalContext *ctx, MppEncBufStat *stat)
+{
+    h264e_hal_rkv_buffers *buffers = (h264e_hal_rkv_buffers *)ctx->buffers;
+
+    stat->ref_size = h264e_rkv_buffers_size(buffers->hw_rec_buf,
+                                            MPP_ARRAY_ELEMS(buffers->hw_rec_buf)) +
+                     h264e_rkv_buffers_size(buffers->hw_dsp_buf,
+                                            MPP_ARRAY_ELEMS(buffers->hw_dsp_buf));
+    stat->scratch_size = h264e_rkv_buffers_size(buffers->hw_pp_buf,
+                                                MPP_ARRAY_ELEMS(buffers->hw_pp_buf)) +
+                         h264e_rkv_buffers_size(buffers->hw_mei_buf,
+                                                MPP_ARRAY_ELEMS(buffers->hw_mei_buf)) +
+                         h264e_rkv_buffers_size(buffers->hw_roi_buf,
+                                                MPP_ARRAY_ELEMS(buffers->hw_roi_buf));
+    stat->scratch_shared = 0;
+
+    return MPP_OK;
+}
+
 static MPP_RET
 h264e_rkv_allocate_buffers(H264eHalContext *ctx, H264eHwCfg *hw_cfg)
 {
@@ -314,6 +357,7 @@ MPP_RET hal_h264e_rkv_init(void *hal, MppHalCfg *cfg)
     ctx->ioctl_input    = mpp_calloc(H264eRkvIoctlInput, 1);
     ctx->ioctl_output   = mpp_calloc(H264eRkvIoctlOutput, 1);
     ctx->regs           = mpp_calloc(H264eRkvRegSet, RKVE_LINKTABLE_FRAME_NUM);
+    ctx->batch_info     = mpp_calloc(H264eRkvBatchInfo, RKVE_LINKTABLE_FRAME_NUM);
     ctx->buffers        = mpp_calloc(h264e_hal_rkv_buffers, 1);
     ctx->extra_info     = mpp_calloc(H264eRkvExtraInfo, 1);
     ctx->dpb_ctx        = mpp_calloc(H264eRkvDpbCtx, 1);
@@ -327,6 +371,8 @@ MPP_RET hal_h264e_rkv_init(void *hal, MppHalCfg *cfg)
     ctx->frame_cnt_gen_ready = 0;
     ctx->frame_cnt_send_ready = 0;
     ctx->num_frames_to_send = 1;
+    ctx->frame_cnt_wait_done = 0;
+    ctx->batch = 1;
     ctx->osd_plt_type = RKVE_OSD_PLT_TYPE_NONE;
     ctx->hw_cfg.roi_en = 1;
 
@@ -367,6 +413,7 @@ MPP_RET hal_h264e_rkv_deinit(void *hal)
     h264e_hal_enter();
 
     MPP_FREE(ctx->regs);
+    MPP_FREE(ctx->batch_info);
     MPP_FREE(ctx->ioctl_input);
     MPP_FREE(ctx->ioctl_output);
     MPP_FREE(ctx->param_buf);
@@ -392,6 +439,7 @@ MPP_RET hal_h264e_rkv_deinit(void *hal)
         h264e_rkv_deinit_extra_info(ctx->extra_info);
         MPP_FREE(ctx->extra_info);
     }
+    h264e_hdr_cache_deinit(ctx);
 
     if (ctx->packeted_param) {
         mpp_packet_deinit(&ctx->packeted_param);
@@ -705,13 +753,15 @@ h264e_rkv_set_roi_regs(H264eHalContext *ctx, H264eRkvRegSet *regs)
 {
     MppEncROICfg *cfg = &ctx->roi_data;
     h264e_hal_rkv_buffers *bufs = (h264e_hal_rkv_buffers *)ctx->buffers;
+    /* each frame in one batch has its own roi buffer */
+    MppBuffer roi_buf = bufs->hw_roi_buf[ctx->frame_cnt_gen_ready];
     RK_U8 *roi_base;
 
     if (cfg->number && cfg->regions) {
         regs->swreg10.roi_enc = 1;
-        regs->swreg29_ctuc_addr = mpp_buffer_get_fd(bufs->hw_roi_buf[0]);
+        regs->swreg29_ctuc_addr = mpp_buffer_get_fd(roi_buf);
 
-        roi_base = (RK_U8 *)mpp_buffer_get_ptr(bufs->hw_roi_buf[0]);
+        roi_base = (RK_U8 *)mpp_buffer_get_ptr(roi_buf);
         rkv_config_roi_area(ctx, roi_base);
     }
 
@@ -787,11 +837,11 @@ h264e_rkv_find_best_qp(MppLinReg *ctx, MppEncH264Cfg *codec,
         qp_best = mpp_clip(qp_best + codec->qp_max_step, qp_min, qp_max);
     } else {
         do {
-            RK_S64 est_bits = mpp_quadreg_calc(ctx, QP2Qstep(qp));
+            RK_S64 est_bits = mpp_quadreg_calc(ctx, rkv_qp2qstep[qp]);
             RK_S64 diff = est_bits - bits;
             h264e_hal_dbg(H264E_DBG_DETAIL,
-                          "RC: qp est qp %d qstep %f bit %lld diff %lld best %lld\n",
-                          qp, QP2Qstep(qp), bits, diff, diff_best);
+                          "RC: qp est qp %d qstep %d bit %lld diff %lld best %lld\n",
+                          qp, rkv_qp2qstep[qp], bits, diff, diff_best);
             if (MPP_ABS(diff) < MPP_ABS(diff_best)) {
                 diff_best = MPP_ABS(diff);
                 qp_best = qp;
@@ -884,8 +934,19 @@ h264e_rkv_update_hw_cfg(H264eHalContext *ctx, HalEncTask *task,
     }
 
     /* init qp calculate, if outside doesn't set init qp.
-     * mpp will use bpp to estimates one.
+     * mpp will use the first frame complexity to estimate one and fall back
+     * to bpp when the input frame can not be analyzed.
      */
+    if (hw_cfg->qp <= 0 && ctx->frame_cnt == 0) {
+        RK_S32 qp = h264e_estimate_init_qp(prep, task->input, rc_syn->bit_target,
+                                           codec->qp_min, codec->qp_max);
+        if (qp > 0) {
+            hw_cfg->qp = qp;
+            hw_cfg->qp_prev = qp;
+            ctx->qp_estimated = 1;
+        }
+    }
+
     if (hw_cfg->qp <= 0) {
         RK_S32 qp_tbl[2][13] = {
             {
@@ -949,7 +1010,18 @@ h264e_rkv_update_hw_cfg(H264eHalContext *ctx, HalEncTask *task,
             hw_cfg->coding_type = RKVENC_CODING_TYPE_IDR;
             hw_cfg->frame_num = 0;
 
-            if (!is_cqp) {
+            if (!is_cqp && ctx->frame_cnt > 0 && rc_syn->scene_cut &&
+                rc_syn->complexity > 0) {
+                /*
+                 * Scene cut idr has nothing to do with previous inter frame
+                 * qp. Estimate from the new content complexity instead.
+                 */
+                hw_cfg->qp = h264e_calc_intra_qp(prep, rc_syn->complexity / 256.0,
+                                                 rc_syn->bit_target,
+                                                 codec->qp_min, codec->qp_max);
+                h264e_hal_dbg(H264E_DBG_RC, "scene cut qp %d complexity %d\n",
+                              hw_cfg->qp, rc_syn->complexity);
+            } else if (!is_cqp) {
                 if (ctx->frame_cnt > 0) {
                     hw_cfg->qp = mpp_data_avg(ctx->qp_p, -1, 1, 1);
                     if (hw_cfg->qp >= 42)
@@ -1072,8 +1144,8 @@ MPP_RET hal_h264e_rkv_gen_regs(void *hal, HalTaskInfo *task)
     h264e_hal_rkv_buffers *bufs = (h264e_hal_rkv_buffers *)ctx->buffers;
     RK_U32 buf2_idx = ctx->frame_cnt % 2;
     MppBuffer mv_info_buf = task->enc.mv_info;
-
-    ctx->enc_mode = RKV_ENC_MODE;
+    H264eRkvBatchInfo *batch_info = NULL;
+    RK_U32 idx = 0;
 
     h264e_hal_enter();
 
@@ -1101,26 +1173,18 @@ MPP_RET hal_h264e_rkv_gen_regs(void *hal, HalTaskInfo *task)
         }
     }
 
-    if (ctx->enc_mode == RKVENC_LINKTABLE_START ||
-        ctx->enc_mode == RKVENC_LINKTABLE_UPDATE) { //link table mode
-        RK_U32 idx = ctx->frame_cnt_gen_ready;
-        ctx->num_frames_to_send = RKVE_LINKTABLE_EACH_NUM;
-        if (idx == 0) {
-            ioctl_info->enc_mode = ctx->enc_mode;
-            ioctl_info->frame_num = ctx->num_frames_to_send;
-        }
-        regs = &reg_list[idx];
-        ioctl_info->reg_info[idx].reg_num = sizeof(H264eRkvRegSet) / 4;
-        ioctl_reg_info = &ioctl_info->reg_info[idx];
-    } else {
-        ctx->num_frames_to_send = 1;
-        ioctl_info->frame_num = ctx->num_frames_to_send;
-        ioctl_info->enc_mode = ctx->enc_mode;
-        regs = &reg_list[0];
-        ioctl_info->reg_info[0].reg_num = sizeof(H264eRkvRegSet) / 4;
-        ioctl_reg_info = &ioctl_info->reg_info[0];
+    /* batch size is only changed on the first frame of a batch */
+    if (ctx->frame_cnt_gen_ready == 0) {
+        ctx->num_frames_to_send = ctx->batch;
+        ctx->enc_mode = (ctx->num_frames_to_send > 1) ?
+                        RKVENC_LINKTABLE_START : RKVENC_LINKTABLE_DISABLE;
     }
 
+    idx = ctx->frame_cnt_gen_ready;
+    regs = &reg_list[idx];
+    ioctl_info->reg_info[idx].reg_num = sizeof(H264eRkvRegSet) / 4;
+    ioctl_reg_info = &ioctl_info->reg_info[idx];
+
     if (MPP_OK != h264e_rkv_reference_frame_set(ctx, syn)) {
         h264e_hal_err("h264e_rkv_reference_frame_set failed, multi-ref error");
     }
@@ -1445,33 +1509,35 @@ MPP_RET hal_h264e_rkv_gen_regs(void *hal, HalTaskInfo *task)
     extra_info->sei.frame_cnt++;
     hw_cfg->frame_num++;
 
+    /* syntax is shared by all frames so save it for collecting result */
+    batch_info = (H264eRkvBatchInfo *)ctx->batch_info + idx;
+    batch_info->syn = *rc_syn;
+    batch_info->frame_cnt = ctx->frame_cnt;
+    batch_info->qp = hw_cfg->qp;
+    batch_info->qp_min = hw_cfg->qp_min;
+    batch_info->qp_max = hw_cfg->qp_max;
+
+    /* osd data is for one frame only */
+    ctx->osd_data.buf = NULL;
+    ctx->osd_data.num_region = 0;
+
     h264e_hal_leave();
 
     return MPP_OK;
 }
 
-MPP_RET hal_h264e_rkv_start(void *hal, HalTaskInfo *task)
+/*
+ * send all generated frames to hardware in one ioctl
+ * the result of each frame is collected by hal_h264e_rkv_wait in order
+ */
+static MPP_RET h264e_rkv_send_batch(H264eHalContext *ctx)
 {
-    MPP_RET ret = MPP_OK;
-    H264eHalContext *ctx = (H264eHalContext *)hal;
     H264eRkvRegSet *reg_list = (H264eRkvRegSet *)ctx->regs;
     RK_U32 length = 0, k = 0;
     H264eRkvIoctlInput *ioctl_info = (H264eRkvIoctlInput *)ctx->ioctl_input;
-    HalEncTask *enc_task = &task->enc;
-
-    h264e_hal_enter();
-    if (enc_task->flags.err) {
-        h264e_hal_err("enc_task->flags.err %08x, return early",
-                      enc_task->flags.err);
-        return MPP_NOK;
-    }
 
-    if (ctx->frame_cnt_gen_ready != ctx->num_frames_to_send) {
-        h264e_hal_dbg(H264E_DBG_DETAIL,
-                      "frame_cnt_gen_ready(%d) != num_frames_to_send(%d), start hardware later",
-                      ctx->frame_cnt_gen_ready, ctx->num_frames_to_send);
-        return MPP_OK;
-    }
+    ioctl_info->enc_mode = ctx->enc_mode;
+    ioctl_info->frame_num = ctx->frame_cnt_gen_ready;
 
     h264e_hal_dbg(H264E_DBG_DETAIL,
                   "memcpy %d frames' regs from reg list to reg info",
@@ -1489,67 +1555,91 @@ MPP_RET hal_h264e_rkv_start(void *hal, HalTaskInfo *task)
     length = (sizeof(ioctl_info->enc_mode) + sizeof(ioctl_info->frame_num) +
               sizeof(ioctl_info->reg_info[0]) * ioctl_info->frame_num) >> 2;
 
-    ctx->frame_cnt_send_ready ++;
+    ctx->frame_cnt_send_ready = ioctl_info->frame_num;
+    ctx->frame_cnt_gen_ready = 0;
+    ctx->frame_cnt_wait_done = 0;
 
     h264e_hal_dbg(H264E_DBG_DETAIL, "vpu client is sending %d regs", length);
     if (mpp_device_send_reg(ctx->dev_ctx, (RK_U32 *)ioctl_info, length)) {
         h264e_hal_err("mpp_device_send_reg Failed!!!");
+        ctx->frame_cnt_send_ready = 0;
         return  MPP_ERR_VPUHW;
     } else {
         h264e_hal_dbg(H264E_DBG_DETAIL, "mpp_device_send_reg successfully!");
     }
 
+    return MPP_OK;
+}
+
+MPP_RET hal_h264e_rkv_start(void *hal, HalTaskInfo *task)
+{
+    MPP_RET ret = MPP_OK;
+    H264eHalContext *ctx = (H264eHalContext *)hal;
+    HalEncTask *enc_task = &task->enc;
+
+    h264e_hal_enter();
+    if (enc_task->flags.err) {
+        h264e_hal_err("enc_task->flags.err %08x, return early",
+                      enc_task->flags.err);
+        return MPP_NOK;
+    }
+
+    if (ctx->frame_cnt_gen_ready != ctx->num_frames_to_send) {
+        h264e_hal_dbg(H264E_DBG_DETAIL,
+                      "frame_cnt_gen_ready(%d) != num_frames_to_send(%d), start hardware later",
+                      ctx->frame_cnt_gen_ready, ctx->num_frames_to_send);
+        return MPP_OK;
+    }
+
+    ret = h264e_rkv_send_batch(ctx);
+
     h264e_hal_leave();
 
     return ret;
 }
 
 static MPP_RET h264e_rkv_set_feedback(H264eHalContext *ctx,
-                                      H264eRkvIoctlOutput *out, HalEncTask *enc_task)
+                                      H264eRkvIoctlOutputElem *elem,
+                                      HalEncTask *enc_task)
 {
-    RK_U32 k = 0;
-    H264eRkvIoctlOutputElem *elem = NULL;
     H264eRkvExtraInfo *extra_info = (H264eRkvExtraInfo *)ctx->extra_info;
     h264e_feedback *fb = &ctx->feedback;
 
     h264e_hal_enter();
-    for (k = 0; k < out->frame_num; k++) {
-        elem = &out->elem[k];
-        fb->qp_sum = elem->swreg71.qp_sum;
-        fb->out_hw_strm_size =
-            fb->out_strm_size = elem->swreg69.bs_lgth;
-        fb->sse_sum = elem->swreg70.sse_l32 +
-                      ((RK_S64)(elem->swreg71.sse_h8 & 0xff) << 32);
+    fb->qp_sum = elem->swreg71.qp_sum;
+    fb->out_hw_strm_size =
+        fb->out_strm_size = elem->swreg69.bs_lgth;
+    fb->sse_sum = elem->swreg70.sse_l32 +
+                  ((RK_S64)(elem->swreg71.sse_h8 & 0xff) << 32);
 
-        fb->hw_status = elem->hw_status;
-        h264e_hal_dbg(H264E_DBG_DETAIL, "hw_status: 0x%08x", elem->hw_status);
-        if (elem->hw_status & RKV_ENC_INT_LINKTABLE_FINISH)
-            h264e_hal_err("RKV_ENC_INT_LINKTABLE_FINISH");
+    fb->hw_status = elem->hw_status;
+    h264e_hal_dbg(H264E_DBG_DETAIL, "hw_status: 0x%08x", elem->hw_status);
+    if (elem->hw_status & RKV_ENC_INT_LINKTABLE_FINISH)
+        h264e_hal_dbg(H264E_DBG_DETAIL, "RKV_ENC_INT_LINKTABLE_FINISH");
 
-        if (elem->hw_status & RKV_ENC_INT_ONE_FRAME_FINISH)
-            h264e_hal_dbg(H264E_DBG_DETAIL, "RKV_ENC_INT_ONE_FRAME_FINISH");
+    if (elem->hw_status & RKV_ENC_INT_ONE_FRAME_FINISH)
+        h264e_hal_dbg(H264E_DBG_DETAIL, "RKV_ENC_INT_ONE_FRAME_FINISH");
 
-        if (elem->hw_status & RKV_ENC_INT_ONE_SLICE_FINISH)
-            h264e_hal_err("RKV_ENC_INT_ONE_SLICE_FINISH");
+    if (elem->hw_status & RKV_ENC_INT_ONE_SLICE_FINISH)
+        h264e_hal_err("RKV_ENC_INT_ONE_SLICE_FINISH");
 
-        if (elem->hw_status & RKV_ENC_INT_SAFE_CLEAR_FINISH)
-            h264e_hal_err("RKV_ENC_INT_SAFE_CLEAR_FINISH");
+    if (elem->hw_status & RKV_ENC_INT_SAFE_CLEAR_FINISH)
+        h264e_hal_err("RKV_ENC_INT_SAFE_CLEAR_FINISH");
 
-        if (elem->hw_status & RKV_ENC_INT_BIT_STREAM_OVERFLOW)
-            h264e_hal_err("RKV_ENC_INT_BIT_STREAM_OVERFLOW");
+    if (elem->hw_status & RKV_ENC_INT_BIT_STREAM_OVERFLOW)
+        h264e_hal_err("RKV_ENC_INT_BIT_STREAM_OVERFLOW");
 
-        if (elem->hw_status & RKV_ENC_INT_BUS_WRITE_FULL)
-            h264e_hal_err("RKV_ENC_INT_BUS_WRITE_FULL");
+    if (elem->hw_status & RKV_ENC_INT_BUS_WRITE_FULL)
+        h264e_hal_err("RKV_ENC_INT_BUS_WRITE_FULL");
 
-        if (elem->hw_status & RKV_ENC_INT_BUS_WRITE_ERROR)
-            h264e_hal_err("RKV_ENC_INT_BUS_WRITE_ERROR");
+    if (elem->hw_status & RKV_ENC_INT_BUS_WRITE_ERROR)
+        h264e_hal_err("RKV_ENC_INT_BUS_WRITE_ERROR");
 
-        if (elem->hw_status & RKV_ENC_INT_BUS_READ_ERROR)
-            h264e_hal_err("RKV_ENC_INT_BUS_READ_ERROR");
+    if (elem->hw_status & RKV_ENC_INT_BUS_READ_ERROR)
+        h264e_hal_err("RKV_ENC_INT_BUS_READ_ERROR");
 
-        if (elem->hw_status & RKV_ENC_INT_TIMEOUT_ERROR)
-            h264e_hal_err("RKV_ENC_INT_TIMEOUT_ERROR");
-    }
+    if (elem->hw_status & RKV_ENC_INT_TIMEOUT_ERROR)
+        h264e_hal_err("RKV_ENC_INT_TIMEOUT_ERROR");
 
     if (ctx->sei_mode != MPP_ENC_SEI_MODE_DISABLE) {
         H264eRkvNal *nal = &extra_info->nal[0];
@@ -1611,6 +1701,22 @@ static MPP_RET h264e_rkv_resend(H264eHalContext *ctx, RK_S32 mb_rc)
     return MPP_OK;
 }
 
+/*
+ * Without a good initial qp the first I and P frame are always re-encoded.
+ * When the initial qp is estimated from the first frame re-encode is only
+ * required when the real bits is far from the target.
+ */
+static RK_S32 h264e_rkv_need_first_resend(H264eHalContext *ctx, RK_S32 bit_target)
+{
+    h264e_feedback *fb = &ctx->feedback;
+    RK_S64 bits = (RK_S64)fb->out_hw_strm_size * 8;
+
+    if (!ctx->qp_estimated || (fb->hw_status & RKV_ENC_INT_BIT_STREAM_OVERFLOW))
+        return 1;
+
+    return (bits * 2 < bit_target) || (bits > (RK_S64)bit_target * 2);
+}
+
 MPP_RET hal_h264e_rkv_wait(void *hal, HalTaskInfo *task)
 {
     RK_S32 hw_ret = 0;
@@ -1618,7 +1724,10 @@ MPP_RET hal_h264e_rkv_wait(void *hal, HalTaskInfo *task)
     H264eRkvIoctlOutput *reg_out = (H264eRkvIoctlOutput *)ctx->ioctl_output;
     RK_S32 length = (sizeof(reg_out->frame_num)
                      + sizeof(reg_out->elem[0])
-                     * ctx->num_frames_to_send) >> 2;
+                     * ctx->frame_cnt_send_ready) >> 2;
+    RK_U32 batch_size = ctx->frame_cnt_send_ready;
+    RK_U32 idx = ctx->frame_cnt_wait_done;
+    H264eRkvBatchInfo *batch_info = (H264eRkvBatchInfo *)ctx->batch_info + idx;
     IOInterruptCB int_cb = ctx->int_cb;
     h264e_feedback *fb = &ctx->feedback;
     HalEncTask *enc_task = &task->enc;
@@ -1629,9 +1738,9 @@ MPP_RET hal_h264e_rkv_wait(void *hal, HalTaskInfo *task)
     H264eHwCfg *hw_cfg = &ctx->hw_cfg;
     RK_S32 num_mb = MPP_ALIGN(prep->width, 16)
                     * MPP_ALIGN(prep->height, 16) / 16 / 16;
-    RcSyntax *rc_syn = (RcSyntax *)task->enc.syntax.data;
+    RcSyntax *rc_syn = &batch_info->syn;
     struct list_head *rc_head = rc_syn->rc_head;
-    RK_U32 frame_cnt = ctx->frame_cnt;
+    RK_U32 frame_cnt = batch_info->frame_cnt;
 
     h264e_hal_enter();
 
@@ -1641,43 +1750,47 @@ MPP_RET hal_h264e_rkv_wait(void *hal, HalTaskInfo *task)
         return MPP_NOK;
     }
 
-    if (ctx->frame_cnt_gen_ready != ctx->num_frames_to_send) {
+    if (!batch_size) {
         h264e_hal_dbg(H264E_DBG_DETAIL,
                       "frame_cnt_gen_ready(%d) != num_frames_to_send(%d), wait hardware later",
                       ctx->frame_cnt_gen_ready, ctx->num_frames_to_send);
         return MPP_OK;
-    } else {
-        ctx->frame_cnt_gen_ready = 0;
-        if (ctx->enc_mode == 3) {
-            /* TODO: remove later */
-            h264e_hal_dbg(H264E_DBG_DETAIL, "only for test enc_mode 3 ...");
-            if (ctx->frame_cnt_send_ready != RKVE_LINKTABLE_FRAME_NUM) {
-                h264e_hal_dbg(H264E_DBG_DETAIL,
-                              "frame_cnt_send_ready(%d) != RKVE_LINKTABLE_FRAME_NUM(%d), wait hardware later",
-                              ctx->frame_cnt_send_ready, RKVE_LINKTABLE_FRAME_NUM);
-                return MPP_OK;
-            } else {
-                ctx->frame_cnt_send_ready = 0;
-            }
-        }
     }
 
-    h264e_hal_dbg(H264E_DBG_DETAIL, "mpp_device_wait_reg expect length %d\n",
-                  length);
+    /* the whole batch is returned on waiting its first frame */
+    if (idx == 0) {
+        h264e_hal_dbg(H264E_DBG_DETAIL, "mpp_device_wait_reg expect length %d\n",
+                      length);
 
-    hw_ret = mpp_device_wait_reg(ctx->dev_ctx, (RK_U32 *)reg_out, length);
+        hw_ret = mpp_device_wait_reg(ctx->dev_ctx, (RK_U32 *)reg_out, length);
 
-    h264e_hal_dbg(H264E_DBG_DETAIL, "mpp_device_wait_reg: ret %d\n", hw_ret);
+        h264e_hal_dbg(H264E_DBG_DETAIL, "mpp_device_wait_reg: ret %d\n", hw_ret);
 
-    if (hw_ret != MPP_OK) {
-        h264e_hal_err("hardware returns error:%d", hw_ret);
-        return MPP_ERR_VPUHW;
+        if (hw_ret != MPP_OK) {
+            h264e_hal_err("hardware returns error:%d", hw_ret);
+            ctx->frame_cnt_send_ready = 0;
+            return MPP_ERR_VPUHW;
+        }
+    }
+
+    ctx->frame_cnt_wait_done++;
+    if (ctx->frame_cnt_wait_done >= batch_size) {
+        ctx->frame_cnt_wait_done = 0;
+        ctx->frame_cnt_send_ready = 0;
     }
 
-    h264e_rkv_set_feedback(ctx, reg_out, enc_task);
+    h264e_rkv_set_feedback(ctx, &reg_out->elem[idx], enc_task);
 
-    /* we need re-encode */
-    if ((frame_cnt == 1) || (frame_cnt == 2)) {
+    /*
+     * Frames in one link table can not be re-encoded one by one.
+     * Only report the overflow and keep the truncated stream.
+     */
+    if (batch_size > 1) {
+        if (fb->hw_status & RKV_ENC_INT_BIT_STREAM_OVERFLOW)
+            h264e_hal_err("frame %d overflow in batch without re-encode\n",
+                          frame_cnt);
+    } else if (((frame_cnt == 1) || (frame_cnt == 2)) &&
+               h264e_rkv_need_first_resend(ctx, rc_syn->bit_target)) {
         if (fb->hw_status & RKV_ENC_INT_BIT_STREAM_OVERFLOW) {
             RK_S32 new_qp = fb->qp_sum / num_mb + 3;
             h264e_hal_dbg(H264E_DBG_DETAIL,
@@ -1690,7 +1803,7 @@ MPP_RET hal_h264e_rkv_wait(void *hal, HalTaskInfo *task)
              */
             h264e_rkv_resend(ctx, 1);
         }
-        h264e_rkv_set_feedback(ctx, reg_out, enc_task);
+        h264e_rkv_set_feedback(ctx, &reg_out->elem[0], enc_task);
     } else if ((RK_S32)frame_cnt < rc->fps_out_num / rc->fps_out_denorm &&
                rc_syn->type == INTER_P_FRAME &&
                rc_syn->bit_target > fb->out_hw_strm_size * 8 * 1.5) {
@@ -1708,21 +1821,21 @@ MPP_RET hal_h264e_rkv_wait(void *hal, HalTaskInfo *task)
         fb->qp_sum = new_qp * num_mb;
 
         h264e_rkv_resend(ctx, 1);
-        h264e_rkv_set_feedback(ctx, reg_out, enc_task);
+        h264e_rkv_set_feedback(ctx, &reg_out->elem[0], enc_task);
     } else if (fb->hw_status & RKV_ENC_INT_BIT_STREAM_OVERFLOW) {
         RK_S32 new_qp = fb->qp_sum / num_mb + 3;
         h264e_hal_dbg(H264E_DBG_DETAIL,
                       "re-encode for overflow ...\n");
         fb->qp_sum = new_qp * num_mb;
         h264e_rkv_resend(ctx, 1);
-        h264e_rkv_set_feedback(ctx, reg_out, enc_task);
+        h264e_rkv_set_feedback(ctx, &reg_out->elem[0], enc_task);
     }
 
     task->enc.length = fb->out_strm_size;
     h264e_hal_dbg(H264E_DBG_DETAIL, "output stream size %d\n",
                   fb->out_strm_size);
     if (int_cb.callBack) {
-        RcSyntax *syn = (RcSyntax *)task->enc.syntax.data;
+        RcSyntax *syn = rc_syn;
         RcHalResult result;
         double avg_qp = 0.0;
         RK_S32 avg_sse = 1;
@@ -1760,7 +1873,7 @@ MPP_RET hal_h264e_rkv_wait(void *hal, HalTaskInfo *task)
         h264e_hal_dbg(H264E_DBG_RC, "target bits %d real bits %d "
                       "target qp %d real qp %0.2f\n",
                       rc_syn->bit_target, result.bits,
-                      hw_cfg->qp, avg_qp);
+                      batch_info->qp, avg_qp);
 
         if (syn->type == INTER_P_FRAME || syn->gop_mode == MPP_GOP_ALL_INTRA) {
             mpp_save_regdata(ctx->inter_qs, QP2Qstep(avg_qp),
@@ -1768,7 +1881,7 @@ MPP_RET hal_h264e_rkv_wait(void *hal, HalTaskInfo *task)
             mpp_quadreg_update(ctx->inter_qs, wlen);
         }
         if (rc->quality == MPP_ENC_RC_QUALITY_AQ_ONLY) {
-            hw_cfg->qp_prev = hw_cfg->qp;
+            hw_cfg->qp_prev = batch_info->qp;
         } else {
             hw_cfg->qp_prev = avg_qp;
         }
@@ -1782,9 +1895,9 @@ MPP_RET hal_h264e_rkv_wait(void *hal, HalTaskInfo *task)
         mpp_rc_param_ops(rc_head, frame_cnt, RC_RECORD_QP_SUM, &fb->qp_sum);
         mpp_rc_param_ops(rc_head, frame_cnt, RC_RECORD_SSE_SUM, &fb->sse_sum);
 
-        mpp_rc_param_ops(rc_head, frame_cnt, RC_RECORD_QP_MIN, &hw_cfg->qp_min);
-        mpp_rc_param_ops(rc_head, frame_cnt, RC_RECORD_QP_MAX, &hw_cfg->qp_max);
-        mpp_rc_param_ops(rc_head, frame_cnt, RC_RECORD_SET_QP, &hw_cfg->qp);
+        mpp_rc_param_ops(rc_head, frame_cnt, RC_RECORD_QP_MIN, &batch_info->qp_min);
+        mpp_rc_param_ops(rc_head, frame_cnt, RC_RECORD_QP_MAX, &batch_info->qp_max);
+        mpp_rc_param_ops(rc_head, frame_cnt, RC_RECORD_SET_QP, &batch_info->qp);
 
         mpp_rc_param_ops(rc_head, frame_cnt, RC_RECORD_LIN_REG, ctx->inter_qs);
 
@@ -1794,8 +1907,6 @@ MPP_RET hal_h264e_rkv_wait(void *hal, HalTaskInfo *task)
     codec->change = 0;
     prep->change = 0;
     rc->change = 0;
-    ctx->osd_data.buf = NULL;
-    ctx->osd_data.num_region = 0;
 
     h264e_hal_leave();
 
@@ -1813,11 +1924,16 @@ MPP_RET hal_h264e_rkv_reset(void *hal)
 
 MPP_RET hal_h264e_rkv_flush(void *hal)
 {
-    (void)hal;
+    MPP_RET ret = MPP_OK;
+    H264eHalContext *ctx = (H264eHalContext *)hal;
     h264e_hal_enter();
 
+    /* send the frames of a partial batch to hardware */
+    if (ctx->frame_cnt_gen_ready)
+        ret = h264e_rkv_send_batch(ctx);
+
     h264e_hal_leave();
-    return MPP_OK;
+    return ret;
 }
 
 MPP_RET hal_h264e_rkv_control(void *hal, MpiCmd cmd_type, void *param)
@@ -1834,7 +1950,7 @@ MPP_RET hal_h264e_rkv_control(void *hal, MpiCmd cmd_type, void *param)
     case MPP_ENC_GET_EXTRA_INFO: {
         MppPacket *pkt_out = (MppPacket *)param;
         h264e_rkv_set_extra_info(ctx);
-        h264e_rkv_get_extra_info(ctx, pkt_out);
+        h264e_hdr_cache_get(ctx, pkt_out);
         break;
     }
     case MPP_ENC_SET_OSD_PLT_CFG: {
@@ -1850,7 +1966,31 @@ MPP_RET hal_h264e_rkv_control(void *hal, MpiCmd cmd_type, void *param)
         break;
     }
     case MPP_ENC_SET_SEI_CFG: {
-        ctx->sei_mode = *((MppEncSeiMode *)param);
+        MppEncSeiMode sei_mode = *((MppEncSeiMode *)param);
+
+        /* sei is generated on register generation for one frame only */
+        if (sei_mode != MPP_ENC_SEI_MODE_DISABLE && ctx->batch > 1) {
+            h264e_hal_err("sei can not be enabled with task batch %d\n",
+                          ctx->batch);
+            return MPP_NOK;
+        }
+        ctx->sei_mode = sei_mode;
+        ctx->hdr_valid = 0;
+        break;
+    }
+    case MPP_ENC_SET_TASK_BATCH: {
+        RK_S32 batch = *((RK_S32 *)param);
+
+        if (batch < 1 || batch > RKVE_LINKTABLE_FRAME_NUM) {
+            h264e_hal_err("invalid task batch %d range [1, %d]\n",
+                          batch, RKVE_LINKTABLE_FRAME_NUM);
+            return MPP_NOK;
+        }
+        if (batch > 1 && ctx->sei_mode != MPP_ENC_SEI_MODE_DISABLE) {
+            h264e_hal_err("task batch %d can not be used with sei\n", batch);
+            return MPP_NOK;
+        }
+        ctx->batch = batch;
         break;
     }
     case MPP_ENC_GET_SEI_DATA: {
@@ -1859,10 +1999,12 @@ MPP_RET hal_h264e_rkv_control(void *hal, MpiCmd cmd_type, void *param)
     }
     case MPP_ENC_SET_PREP_CFG: {
         //LKSTODO: check cfg
+        ctx->hdr_valid = 0;
         break;
     }
     case MPP_ENC_SET_RC_CFG: {
         // TODO: do rate control check here
+        ctx->hdr_valid = 0;
     } break;
     case MPP_ENC_SET_CODEC_CFG: {
         MppEncH264Cfg *src = &ctx->set->codec.h264;
@@ -1923,6 +2065,8 @@ MPP_RET hal_h264e_rkv_control(void *hal, MpiCmd cmd_type, void *param)
          */
         dst->change |= change;
         src->change = 0;
+        /* sps / pps will be rebuilt on next MPP_ENC_GET_EXTRA_INFO */
+        ctx->hdr_valid = 0;
     } break;
     case MPP_ENC_PRE_ALLOC_BUFF: {
         /* allocate buffers before encoding, so that we can save some time
@@ -1941,6 +2085,9 @@ MPP_RET hal_h264e_rkv_control(void *hal, MpiCmd cmd_type, void *param)
         ctx->qp_scale = *((RK_U32 *)param);
         ctx->qp_scale = mpp_clip(ctx->qp_scale, scale_min, scale_max);
     } break;
+    case MPP_ENC_GET_BUF_STAT: {
+        h264e_rkv_get_buf_stat(ctx, (MppEncBufStat *)param);
+    } break;
     default : {
         h264e_hal_err("unrecognizable cmd type %x", cmd_type);
     } break;
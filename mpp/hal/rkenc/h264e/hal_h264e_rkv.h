@@ -636,6 +636,18 @@ enc_mode
     2: multi-frame encode start with link table
     3: multi_frame_encode link table update
 */
+/*
+ * Per frame status saved at register generation and used when the result of
+ * this frame is collected from a link table batch.
+ */
+typedef struct H264eRkvBatchInfo_t {
+    RcSyntax                syn;
+    RK_U32                  frame_cnt;
+    RK_S32                  qp;
+    RK_S32                  qp_min;
+    RK_S32                  qp_max;
+} H264eRkvBatchInfo;
+
 typedef struct H264eRkvIoctlInput_t {
     RK_U32                  enc_mode;
     RK_U32                  frame_num;
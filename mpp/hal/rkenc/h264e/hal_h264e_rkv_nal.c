@@ -493,8 +493,16 @@ MPP_RET h264e_rkv_set_extra_info(H264eHalContext *ctx)
     H264eSps *sps = &info->sps;
     H264ePps *pps = &info->pps;
 
+    RK_S32 k;
+
     h264e_hal_enter();
 
+    /* config is not changed since last serialization */
+    if (ctx->hdr_valid) {
+        h264e_hal_leave();
+        return MPP_OK;
+    }
+
     info->nal_num = 0;
     h264e_rkv_stream_reset(&info->stream);
 
@@ -510,6 +518,18 @@ MPP_RET h264e_rkv_set_extra_info(H264eHalContext *ctx)
 
     h264e_rkv_encapsulate_nals(info);
 
+    /* nal list is reused by sei on each frame so keep a copy of the header */
+    h264e_hdr_cache_reset(ctx);
+    for (k = 0; k < info->nal_num; k++) {
+        h264e_hal_dbg(H264E_DBG_HEADER, "cache extra info nal type %d, size %d bytes",
+                      info->nal[k].i_type, info->nal[k].i_payload);
+        if (h264e_hdr_cache_write(ctx, info->nal[k].p_payload, info->nal[k].i_payload)) {
+            h264e_hal_leave();
+            return MPP_NOK;
+        }
+    }
+    ctx->hdr_valid = 1;
+
     h264e_hal_leave();
 
     return MPP_OK;
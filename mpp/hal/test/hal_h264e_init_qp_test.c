@@ -0,0 +1,129 @@
+/*
+ * Copyright 2018 Rockchip Electronics Co. LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define MODULE_TAG "hal_h264e_init_qp_test"
+
+#include <string.h>
+
+#include "mpp_log.h"
+#include "mpp_buffer.h"
+
+#include "hal_h264e_com.h"
+
+#define INIT_QP_TEST_WIDTH      640
+#define INIT_QP_TEST_HEIGHT     480
+#define INIT_QP_TEST_QP_MIN     10
+#define INIT_QP_TEST_QP_MAX     51
+
+/*
+ * Fill luma with +-dev on the pixels sampled by the estimation, every 8x8
+ * sampled block then has average 128 and mean absolute deviation dev.
+ */
+static void init_qp_test_fill(RK_U8 *luma, RK_S32 width, RK_S32 height, RK_S32 dev)
+{
+    RK_S32 x, y;
+
+    for (y = 0; y < height; y++)
+        for (x = 0; x < width; x++)
+            luma[y * width + x] = (((x >> 1) + (y >> 1)) & 1) ? (128 + dev) : (128 - dev);
+}
+
+int main()
+{
+    MppBufferGroup group = NULL;
+    MppBuffer buffer = NULL;
+    MppEncPrepCfg prep;
+    RK_S32 width = INIT_QP_TEST_WIDTH;
+    RK_S32 height = INIT_QP_TEST_HEIGHT;
+    /* 0.1 bits per pixel on the first intra frame */
+    RK_S32 bits = width * height / 10;
+    RK_S32 qp_flat = 0;
+    RK_S32 qp_tex = 0;
+    RK_S32 qp_min = INIT_QP_TEST_QP_MIN;
+    RK_S32 qp_max = INIT_QP_TEST_QP_MAX;
+    RK_U8 *luma = NULL;
+    MPP_RET ret = MPP_NOK;
+
+    mpp_log("h264e init qp test start\n");
+
+    memset(&prep, 0, sizeof(prep));
+    prep.width = width;
+    prep.height = height;
+    prep.hor_stride = width;
+    prep.ver_stride = height;
+    prep.format = MPP_FMT_YUV420SP;
+
+    ret = mpp_buffer_group_get_internal(&group, MPP_BUFFER_TYPE_ION);
+    if (!ret)
+        ret = mpp_buffer_get(group, &buffer, width * height * 3 / 2);
+    if (ret) {
+        mpp_err("failed to get input buffer\n");
+        goto DONE;
+    }
+
+    luma = (RK_U8 *)mpp_buffer_get_ptr(buffer);
+
+    /* flat frame is clipped to mad 1 and gets the lowest qp of the model */
+    memset(luma, 128, width * height);
+    qp_flat = h264e_estimate_init_qp(&prep, buffer, bits, qp_min, qp_max);
+
+    /* textured frame with mad 8 needs three more qstep doublings */
+    init_qp_test_fill(luma, width, height, 8);
+    qp_tex = h264e_estimate_init_qp(&prep, buffer, bits, qp_min, qp_max);
+
+    mpp_log("init qp flat %d textured %d\n", qp_flat, qp_tex);
+
+    if (qp_flat < qp_min || qp_tex > qp_max || qp_tex - qp_flat < 17 ||
+        qp_tex - qp_flat > 19) {
+        mpp_err("init qp mismatch flat %d textured %d\n", qp_flat, qp_tex);
+        ret = MPP_NOK;
+        goto DONE;
+    }
+
+    /* the model matches the bpp table qp 24 at mad 2 on 0.1 bpp */
+    init_qp_test_fill(luma, width, height, 2);
+    if (h264e_estimate_init_qp(&prep, buffer, bits, qp_min, qp_max) != 24) {
+        mpp_err("init qp does not match bpp table at mad 2\n");
+        ret = MPP_NOK;
+        goto DONE;
+    }
+
+    /* less target bits on the same content gives higher qp */
+    if (h264e_estimate_init_qp(&prep, buffer, bits / 4, qp_min, qp_max) <= 24) {
+        mpp_err("init qp does not increase on less bits\n");
+        ret = MPP_NOK;
+        goto DONE;
+    }
+
+    /* packed format and missing input fall back to the bpp table */
+    prep.format = MPP_FMT_YUV422_YUYV;
+    if (h264e_estimate_init_qp(&prep, buffer, bits, qp_min, qp_max) >= 0 ||
+        h264e_estimate_init_qp(&prep, NULL, bits, qp_min, qp_max) >= 0) {
+        mpp_err("init qp estimated on unsupported input\n");
+        ret = MPP_NOK;
+        goto DONE;
+    }
+
+    ret = MPP_OK;
+DONE:
+    if (buffer)
+        mpp_buffer_put(buffer);
+    if (group)
+        mpp_buffer_group_put(group);
+
+    mpp_log("h264e init qp test %s\n", ret ? "failed" : "success");
+    return ret;
+}
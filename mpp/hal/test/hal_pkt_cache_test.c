@@ -0,0 +1,227 @@
+/*
+ * Copyright 2018 Rockchip Electronics Co. LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define MODULE_TAG "hal_pkt_cache_test"
+
+#include <string.h>
+
+#include "mpp_log.h"
+#include "mpp_time.h"
+#include "mpp_bitput.h"
+
+#include "hal_pkt_cache.h"
+
+#define PKT_TEST_COUNT          4
+#define PKT_TEST_FRAMES         10000
+/* same as h264d rkv spspps packet: 256 bit packet replicated 256 times */
+#define PKT_TEST_PKT_SIZE       32
+#define PKT_TEST_PKT_REPEAT     256
+
+typedef struct PktTestKey_t {
+    RK_S32  sps_id;
+    RK_S32  pps_id;
+    RK_S32  elem[64];
+} PktTestKey;
+
+static RK_U8 pkt_test_dst[PKT_TEST_PKT_SIZE * PKT_TEST_PKT_REPEAT];
+
+/* simulate spspps packet serialization element by element */
+static void pkt_test_build(const PktTestKey *key, RK_U64 *pkt)
+{
+    BitputCtx_t bp;
+    RK_S32 i;
+
+    memset(pkt, 0, PKT_TEST_PKT_SIZE);
+    mpp_set_bitput_ctx(&bp, pkt, PKT_TEST_PKT_SIZE / 8);
+
+    mpp_put_bits(&bp, key->sps_id, 4);
+    mpp_put_bits(&bp, key->pps_id, 8);
+    for (i = 0; i < 60; i++)
+        mpp_put_bits(&bp, key->elem[i], 4);
+    mpp_put_align(&bp, 64, 0);
+}
+
+static void pkt_test_write(const void *pkt)
+{
+    RK_S32 i;
+
+    for (i = 0; i < PKT_TEST_PKT_REPEAT; i++)
+        memcpy(pkt_test_dst + i * PKT_TEST_PKT_SIZE, pkt, PKT_TEST_PKT_SIZE);
+}
+
+static void pkt_test_key(PktTestKey *key, RK_S32 id)
+{
+    RK_S32 i;
+
+    memset(key, 0, sizeof(*key));
+    key->sps_id = id & 0xf;
+    key->pps_id = id;
+    for (i = 0; i < 64; i++)
+        key->elem[i] = (id + i) & 0xf;
+}
+
+static MPP_RET pkt_test_check(HalPktCache cache)
+{
+    PktTestKey key;
+    /* bitput writes one word beyond the packet on the last bit */
+    RK_U64 pkt[PKT_TEST_PKT_SIZE / 8 + 1];
+    RK_U32 serial[PKT_TEST_COUNT + 1];
+    RK_U32 tmp = 0;
+    void *ret = NULL;
+    RK_S32 i;
+
+    /* fill all entries */
+    for (i = 0; i < PKT_TEST_COUNT; i++) {
+        pkt_test_key(&key, i);
+        if (hal_pkt_cache_get(cache, &key, NULL)) {
+            mpp_err("unexpected hit on empty entry %d\n", i);
+            return MPP_NOK;
+        }
+
+        pkt_test_build(&key, pkt);
+        ret = hal_pkt_cache_put(cache, &key, pkt, &serial[i]);
+        if (NULL == ret || memcmp(ret, pkt, PKT_TEST_PKT_SIZE) || !serial[i]) {
+            mpp_err("put failed on entry %d\n", i);
+            return MPP_NOK;
+        }
+    }
+
+    /* all hit with the same serial and content */
+    for (i = 0; i < PKT_TEST_COUNT; i++) {
+        pkt_test_key(&key, i);
+        pkt_test_build(&key, pkt);
+        ret = hal_pkt_cache_get(cache, &key, &tmp);
+        if (NULL == ret || tmp != serial[i] || memcmp(ret, pkt, PKT_TEST_PKT_SIZE)) {
+            mpp_err("hit failed on entry %d\n", i);
+            return MPP_NOK;
+        }
+    }
+
+    /* one element change must miss */
+    pkt_test_key(&key, 0);
+    key.elem[63] ^= 1;
+    if (hal_pkt_cache_get(cache, &key, NULL)) {
+        mpp_err("hit on changed key\n");
+        return MPP_NOK;
+    }
+
+    /* touch entry 1 ~ 3 then new key should replace entry 0 */
+    for (i = 1; i < PKT_TEST_COUNT; i++) {
+        pkt_test_key(&key, i);
+        hal_pkt_cache_get(cache, &key, NULL);
+    }
+
+    pkt_test_key(&key, PKT_TEST_COUNT);
+    pkt_test_build(&key, pkt);
+    hal_pkt_cache_put(cache, &key, pkt, &serial[PKT_TEST_COUNT]);
+    for (i = 0; i < PKT_TEST_COUNT; i++) {
+        if (serial[PKT_TEST_COUNT] == serial[i]) {
+            mpp_err("serial reused %d\n", serial[i]);
+            return MPP_NOK;
+        }
+    }
+
+    pkt_test_key(&key, 0);
+    if (hal_pkt_cache_get(cache, &key, NULL)) {
+        mpp_err("lru entry is not replaced\n");
+        return MPP_NOK;
+    }
+    pkt_test_key(&key, 1);
+    if (NULL == hal_pkt_cache_get(cache, &key, NULL)) {
+        mpp_err("recent entry is replaced\n");
+        return MPP_NOK;
+    }
+
+    return MPP_OK;
+}
+
+/* compare serialize + write on each frame against cache lookup */
+static void pkt_test_bench(HalPktCache cache)
+{
+    PktTestKey key;
+    /* bitput writes one word beyond the packet on the last bit */
+    RK_U64 pkt[PKT_TEST_PKT_SIZE / 8 + 1];
+    RK_U32 buf_serial = 0;
+    RK_U32 serial = 0;
+    RK_S64 start;
+    RK_S64 end;
+    RK_S64 time_base;
+    RK_S64 time_cache;
+    RK_S32 i;
+
+    start = mpp_time();
+    for (i = 0; i < PKT_TEST_FRAMES; i++) {
+        pkt_test_key(&key, i & 1);
+        pkt_test_build(&key, pkt);
+        pkt_test_write(pkt);
+    }
+    end = mpp_time();
+    time_base = end - start;
+
+    start = mpp_time();
+    for (i = 0; i < PKT_TEST_FRAMES; i++) {
+        void *ptr = NULL;
+
+        /* parameter set is unchanged in the stream */
+        pkt_test_key(&key, 1);
+        ptr = hal_pkt_cache_get(cache, &key, &serial);
+        if (NULL == ptr) {
+            pkt_test_build(&key, pkt);
+            ptr = hal_pkt_cache_put(cache, &key, pkt, &serial);
+        }
+        if (buf_serial != serial) {
+            pkt_test_write(ptr);
+            buf_serial = serial;
+        }
+    }
+    end = mpp_time();
+    time_cache = end - start;
+
+    mpp_log("%d frames serialize %lld us cached %lld us\n",
+            PKT_TEST_FRAMES, time_base, time_cache);
+}
+
+int main()
+{
+    HalPktCache cache = NULL;
+    HalPktCacheStat stat;
+    MPP_RET ret = MPP_NOK;
+
+    mpp_log("hal_pkt_cache test start\n");
+
+    ret = hal_pkt_cache_init(&cache, PKT_TEST_COUNT, sizeof(PktTestKey),
+                             PKT_TEST_PKT_SIZE);
+    if (ret) {
+        mpp_err("hal_pkt_cache_init failed\n");
+        goto DONE;
+    }
+
+    ret = pkt_test_check(cache);
+    if (ret)
+        goto DONE;
+
+    pkt_test_bench(cache);
+
+    hal_pkt_cache_stat(cache, &stat);
+    mpp_log("cache hit %d miss %d\n", stat.hit, stat.miss);
+
+DONE:
+    if (cache)
+        hal_pkt_cache_deinit(cache);
+
+    mpp_log("hal_pkt_cache test %s\n", ret ? "failed" : "success");
+    return ret;
+}
@@ -0,0 +1,107 @@
+/*
+ * Copyright 2018 Rockchip Electronics Co. LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define MODULE_TAG "hal_reg_ring_test"
+
+#include "mpp_log.h"
+
+#include "hal_reg_ring.h"
+
+#define RING_TEST_MAX_DEPTH     8
+#define RING_TEST_TASKS         1000
+
+typedef struct RingTestElem_t {
+    RK_U32  regs[64];
+    RK_S32  task;
+} RingTestElem;
+
+/* simulate gen_regs / wait in fast mode with depth tasks in flight */
+static MPP_RET ring_test_depth(RK_S32 depth)
+{
+    HalRegRing ring = NULL;
+    RingTestElem *elems = NULL;
+    RK_S32 fifo[RING_TEST_MAX_DEPTH];
+    RK_S32 rd = 0;
+    RK_S32 wr = 0;
+    MPP_RET ret = MPP_NOK;
+    RK_S32 i;
+
+    ret = hal_reg_ring_init(&ring, depth, sizeof(RingTestElem));
+    if (ret)
+        return ret;
+
+    elems = (RingTestElem *)hal_reg_ring_elems(ring);
+    if (NULL == elems || hal_reg_ring_count(ring) != depth) {
+        ret = MPP_NOK;
+        goto DONE;
+    }
+
+    for (i = 0; i < RING_TEST_TASKS; i++) {
+        RK_S32 index;
+
+        /* hardware is full, wait the oldest task */
+        if (wr - rd == depth) {
+            index = fifo[rd % depth];
+            if (elems[index].task != rd) {
+                mpp_err("depth %d task %d is overwritten by %d\n",
+                        depth, rd, elems[index].task);
+                ret = MPP_NOK;
+                goto DONE;
+            }
+            hal_reg_ring_put(ring, index);
+            rd++;
+        }
+
+        index = hal_reg_ring_get(ring);
+        if (index < 0) {
+            mpp_err("depth %d failed to get element with %d in flight\n",
+                    depth, wr - rd);
+            ret = MPP_NOK;
+            goto DONE;
+        }
+
+        elems[index].task = wr;
+        fifo[wr % depth] = index;
+        wr++;
+    }
+
+    /* all elements in flight now */
+    if (hal_reg_ring_get(ring) >= 0) {
+        mpp_err("depth %d get element on full ring\n", depth);
+        ret = MPP_NOK;
+    }
+
+DONE:
+    hal_reg_ring_deinit(ring);
+    return ret;
+}
+
+int main()
+{
+    MPP_RET ret = MPP_OK;
+    RK_S32 depth;
+
+    mpp_log("hal_reg_ring test start\n");
+
+    for (depth = 1; depth <= RING_TEST_MAX_DEPTH; depth++) {
+        ret = ring_test_depth(depth);
+        if (ret)
+            break;
+    }
+
+    mpp_log("hal_reg_ring test %s\n", ret ? "failed" : "success");
+    return ret;
+}
@@ -0,0 +1,192 @@
+/*
+ * Copyright 2018 Rockchip Electronics Co. LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define MODULE_TAG "hal_reg_tmpl_test"
+
+#include <string.h>
+
+#include "mpp_env.h"
+#include "mpp_log.h"
+
+#include "hal_reg_tmpl.h"
+
+#define REG_TEST_FRAMES     100
+
+typedef struct RegTestRegs_t {
+    RK_U32  mode;
+    RK_U32  stride;
+    RK_U32  frame_size;
+    RK_U32  table_base;
+    RK_U32  out_base;
+    RK_U32  strm_len;
+    RK_U32  ref_base[16];
+} RegTestRegs;
+
+typedef struct RegTestKey_t {
+    RK_U32  width;
+    RK_U32  height;
+} RegTestKey;
+
+/* syntax of one frame as the hal gets from parser */
+typedef struct RegTestSyntax_t {
+    RK_U32  width;
+    RK_U32  height;
+    RK_S32  frame;
+} RegTestSyntax;
+
+static void reg_test_key(RegTestKey *key, RegTestSyntax *syn)
+{
+    memset(key, 0, sizeof(*key));
+    key->width = syn->width;
+    key->height = syn->height;
+}
+
+/* sequence part, bug caches the per-frame stream length in template */
+static void reg_test_seq(RegTestRegs *regs, RegTestKey *key,
+                         RegTestSyntax *syn, RK_S32 bug)
+{
+    regs->mode = 1;
+    regs->stride = key->width;
+    regs->frame_size = key->width * key->height;
+    regs->table_base = 0x100;
+
+    if (bug)
+        regs->strm_len = syn->frame * 16;
+}
+
+static void reg_test_frame(RegTestRegs *regs, RegTestSyntax *syn, RK_S32 bug)
+{
+    RK_S32 i;
+
+    regs->out_base = syn->frame;
+    if (!bug)
+        regs->strm_len = syn->frame * 16;
+    for (i = 0; i < 16; i++)
+        regs->ref_base[i] = syn->frame + i;
+}
+
+/* original generator writing every register from syntax */
+static void reg_test_full(RegTestRegs *regs, RegTestSyntax *syn)
+{
+    RK_S32 i;
+
+    memset(regs, 0, sizeof(*regs));
+    regs->mode = 1;
+    regs->stride = syn->width;
+    regs->frame_size = syn->width * syn->height;
+    regs->table_base = 0x100;
+    regs->out_base = syn->frame;
+    regs->strm_len = syn->frame * 16;
+    for (i = 0; i < 16; i++)
+        regs->ref_base[i] = syn->frame + i;
+}
+
+static MPP_RET reg_test_run(HalRegTmpl tmpl, RK_S32 bug)
+{
+    RegTestRegs regs;
+    RegTestSyntax syn;
+    RegTestKey key;
+    MPP_RET ret = MPP_OK;
+    RK_S32 i;
+
+    for (i = 0; i < REG_TEST_FRAMES; i++) {
+        RegTestRegs *p = NULL;
+
+        /* resolution change in the middle of the stream */
+        syn.width = (i < REG_TEST_FRAMES / 2) ? 1920 : 1280;
+        syn.height = (i < REG_TEST_FRAMES / 2) ? 1088 : 720;
+        syn.frame = i;
+
+        reg_test_key(&key, &syn);
+        p = (RegTestRegs *)hal_reg_tmpl_update(tmpl, &key);
+        if (p)
+            reg_test_seq(p, &key, &syn, bug);
+
+        /* dirty value from last frame should be overwritten by template */
+        memset(&regs, 0xff, sizeof(regs));
+        hal_reg_tmpl_apply(tmpl, &regs);
+        reg_test_frame(&regs, &syn, bug);
+
+        if (regs.frame_size != syn.width * syn.height || regs.out_base != (RK_U32)i) {
+            mpp_err("frame %d register mismatch\n", i);
+            return MPP_NOK;
+        }
+
+        p = (RegTestRegs *)hal_reg_tmpl_check_ref(tmpl);
+        if (p) {
+            reg_test_full(p, &syn);
+            if (hal_reg_tmpl_check(tmpl, &regs, p))
+                ret = MPP_NOK;
+        }
+    }
+
+    return ret;
+}
+
+int main()
+{
+    HalRegTmpl tmpl = NULL;
+    HalRegTmplStat stat;
+    MPP_RET ret = MPP_NOK;
+
+    mpp_log("hal_reg_tmpl test start\n");
+
+    ret = hal_reg_tmpl_init(&tmpl, sizeof(RegTestRegs), sizeof(RegTestKey));
+    if (ret)
+        goto DONE;
+
+    ret = reg_test_run(tmpl, 0);
+    if (ret)
+        goto DONE;
+
+    hal_reg_tmpl_stat(tmpl, &stat);
+    mpp_log("rebuild %d apply %d\n", stat.rebuild, stat.apply);
+    if (stat.rebuild != 2 || stat.apply != REG_TEST_FRAMES) {
+        mpp_err("unexpected rebuild %d apply %d\n", stat.rebuild, stat.apply);
+        ret = MPP_NOK;
+        goto DONE;
+    }
+
+    hal_reg_tmpl_deinit(tmpl);
+    tmpl = NULL;
+
+    /* check mode must find the field missed by per-frame generator */
+    mpp_env_set_u32("hal_reg_tmpl_debug", 0x10);
+    ret = hal_reg_tmpl_init(&tmpl, sizeof(RegTestRegs), sizeof(RegTestKey));
+    mpp_env_set_u32("hal_reg_tmpl_debug", 0);
+    if (ret)
+        goto DONE;
+
+    /*
+     * Stream length cached in template is only right on the frame which
+     * rebuilds the template, all the other frames must be reported.
+     */
+    if (MPP_OK == reg_test_run(tmpl, 0) && MPP_OK != reg_test_run(tmpl, 1)) {
+        hal_reg_tmpl_stat(tmpl, &stat);
+        mpp_log("check %d mismatch %d\n", stat.check, stat.mismatch);
+        ret = (stat.mismatch == REG_TEST_FRAMES - 2) ? MPP_OK : MPP_NOK;
+    } else {
+        mpp_err("check mode failed\n");
+        ret = MPP_NOK;
+    }
+
+DONE:
+    if (tmpl)
+        hal_reg_tmpl_deinit(tmpl);
+
+    mpp_log("hal_reg_tmpl test %s\n", ret ? "failed" : "success");
+    return ret;
+}
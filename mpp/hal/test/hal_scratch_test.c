@@ -0,0 +1,111 @@
+/*
+ * Copyright 2018 Rockchip Electronics Co. LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define MODULE_TAG "hal_scratch_test"
+
+#include <stdint.h>
+#include <string.h>
+
+#include "mpp_log.h"
+
+#include "hal_scratch.h"
+
+#define SCRATCH_TEST_FRAMES     1000
+#define SCRATCH_TEST_MAX_SLICE  16
+
+/* simulate h265d packet generation: pps packet then rps packet per slice */
+static MPP_RET scratch_test_frame(HalScratch scratch, RK_S32 nb_slice)
+{
+    RK_U64 *pps = NULL;
+    RK_U64 *rps = NULL;
+    RK_S32 i;
+
+    hal_scratch_reset(scratch);
+
+    pps = hal_scratch_get(scratch, sizeof(RK_U64) * 11);
+    rps = hal_scratch_get(scratch, sizeof(RK_U64) * (nb_slice * 4 + 1));
+    if (NULL == pps || NULL == rps)
+        return MPP_NOK;
+
+    if (((intptr_t)pps & 15) || ((intptr_t)rps & 15)) {
+        mpp_err("unaligned scratch %p %p\n", pps, rps);
+        return MPP_NOK;
+    }
+
+    for (i = 0; i < nb_slice * 4 + 1; i++) {
+        if (rps[i]) {
+            mpp_err("scratch is not cleared at %d\n", i);
+            return MPP_NOK;
+        }
+    }
+
+    memset(pps, 0xff, sizeof(RK_U64) * 11);
+    memset(rps, 0xff, sizeof(RK_U64) * (nb_slice * 4 + 1));
+    return MPP_OK;
+}
+
+int main()
+{
+    HalScratch scratch = NULL;
+    HalScratchStat stat;
+    RK_U32 warm_alloc = 0;
+    MPP_RET ret = MPP_NOK;
+    RK_S32 i;
+
+    mpp_log("hal_scratch test start\n");
+
+    /* init arena smaller than the first frame to check the growing */
+    ret = hal_scratch_init(&scratch, 64);
+    if (ret) {
+        mpp_err("hal_scratch_init failed\n");
+        goto DONE;
+    }
+
+    /* warm up with the largest frame */
+    ret = scratch_test_frame(scratch, SCRATCH_TEST_MAX_SLICE);
+    if (!ret)
+        ret = scratch_test_frame(scratch, 1);
+    if (ret)
+        goto DONE;
+
+    hal_scratch_stat(scratch, &stat);
+    warm_alloc = stat.alloc_count;
+    mpp_log("warm up size %d peak %d alloc %d\n",
+            stat.size, stat.peak, stat.alloc_count);
+
+    /* steady state should not touch heap at all */
+    for (i = 0; i < SCRATCH_TEST_FRAMES; i++) {
+        ret = scratch_test_frame(scratch, i % SCRATCH_TEST_MAX_SLICE + 1);
+        if (ret)
+            goto DONE;
+    }
+
+    hal_scratch_stat(scratch, &stat);
+    mpp_log("steady size %d peak %d alloc %d reset %d\n",
+            stat.size, stat.peak, stat.alloc_count, stat.reset_count);
+
+    if (stat.alloc_count != warm_alloc) {
+        mpp_err("steady state heap alloc %d\n", stat.alloc_count - warm_alloc);
+        ret = MPP_NOK;
+    }
+
+DONE:
+    if (scratch)
+        hal_scratch_deinit(scratch);
+
+    mpp_log("hal_scratch test %s\n", ret ? "failed" : "success");
+    return ret;
+}
@@ -0,0 +1,231 @@
+/*
+ * Copyright 2018 Rockchip Electronics Co. LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define MODULE_TAG "mpp_dev_sched_test"
+
+#include <string.h>
+#include <stdint.h>
+
+#include "mpp_env.h"
+#include "mpp_log.h"
+#include "mpp_time.h"
+#include "mpp_thread.h"
+
+#include "mpp_dev_sched.h"
+
+#define SCHED_TEST_SESSION  4
+
+typedef struct SchedTestCtx_t {
+    MppDevSched     sched;
+    const char      *name;
+} SchedTestCtx;
+
+static pthread_mutex_t order_lock = PTHREAD_MUTEX_INITIALIZER;
+static RK_S32 order_idx = 0;
+static const char *order_names[SCHED_TEST_SESSION];
+
+static void *sched_test_worker(void *arg)
+{
+    SchedTestCtx *ctx = (SchedTestCtx *)arg;
+
+    mpp_dev_sched_start(ctx->sched);
+
+    pthread_mutex_lock(&order_lock);
+    order_names[order_idx++] = ctx->name;
+    pthread_mutex_unlock(&order_lock);
+
+    /* pretend hardware is running */
+    msleep(5);
+    mpp_dev_sched_finish(ctx->sched);
+
+    return NULL;
+}
+
+static MPP_RET sched_test_order(void)
+{
+    /* in start order, admission should follow priority then deadline */
+    static const MppSchedPriority prios[SCHED_TEST_SESSION] = {
+        MPP_SCHED_PRIO_BATCH,
+        MPP_SCHED_PRIO_NORMAL,
+        MPP_SCHED_PRIO_NORMAL,
+        MPP_SCHED_PRIO_REALTIME,
+    };
+    static const RK_S64 deadlines[SCHED_TEST_SESSION] = {
+        0, 400000, 200000, 0,
+    };
+    static const char *names[SCHED_TEST_SESSION] = {
+        "batch", "normal_late", "normal_early", "realtime",
+    };
+    static const char *expects[SCHED_TEST_SESSION] = {
+        "realtime", "normal_early", "normal_late", "batch",
+    };
+    SchedTestCtx ctxs[SCHED_TEST_SESSION];
+    pthread_t threads[SCHED_TEST_SESSION];
+    MppDevSched owner = NULL;
+    MPP_RET ret = MPP_NOK;
+    RK_S32 i;
+
+    mpp_dev_sched_init(&owner, MPP_CTX_ENC, MPP_VIDEO_CodingAVC);
+    for (i = 0; i < SCHED_TEST_SESSION; i++) {
+        ctxs[i].name = names[i];
+        mpp_dev_sched_init(&ctxs[i].sched, MPP_CTX_ENC, MPP_VIDEO_CodingAVC);
+        mpp_dev_sched_set_priority(ctxs[i].sched, prios[i]);
+        mpp_dev_sched_set_deadline(ctxs[i].sched, deadlines[i]);
+    }
+
+    /* hold the device then queue all the other sessions */
+    mpp_dev_sched_start(owner);
+
+    for (i = 0; i < SCHED_TEST_SESSION; i++) {
+        pthread_create(&threads[i], NULL, sched_test_worker, &ctxs[i]);
+        msleep(20);
+    }
+
+    mpp_dev_sched_finish(owner);
+
+    for (i = 0; i < SCHED_TEST_SESSION; i++)
+        pthread_join(threads[i], NULL);
+
+    ret = MPP_OK;
+    for (i = 0; i < SCHED_TEST_SESSION; i++) {
+        mpp_log("admit order %d %s\n", i, order_names[i]);
+        if (strcmp(order_names[i], expects[i])) {
+            mpp_err("admit order %d expect %s\n", i, expects[i]);
+            ret = MPP_NOK;
+        }
+    }
+
+    for (i = 0; i < SCHED_TEST_SESSION; i++)
+        mpp_dev_sched_deinit(ctxs[i].sched);
+    mpp_dev_sched_deinit(owner);
+
+    return ret;
+}
+
+#define SCHED_TEST_STREAM_MAX   200
+#define SCHED_TEST_SHORT_TASK   5
+
+static volatile RK_S32 short_done = 0;
+
+/* decoder in fast mode sends next task before the previous one is waited */
+static void *sched_test_stream(void *arg)
+{
+    SchedTestCtx *ctx = (SchedTestCtx *)arg;
+    RK_S32 i;
+
+    mpp_dev_sched_start(ctx->sched);
+    for (i = 0; i < SCHED_TEST_STREAM_MAX && !short_done; i++) {
+        mpp_dev_sched_start(ctx->sched);
+        msleep(2);
+        mpp_dev_sched_finish(ctx->sched);
+    }
+    mpp_dev_sched_finish(ctx->sched);
+
+    return (void *)(intptr_t)i;
+}
+
+static MPP_RET sched_test_inflight(void)
+{
+    SchedTestCtx stream;
+    MppDevSched sched = NULL;
+    pthread_t thread;
+    void *count = NULL;
+    RK_S32 i;
+
+    stream.name = "stream";
+    mpp_dev_sched_init(&stream.sched, MPP_CTX_DEC, MPP_VIDEO_CodingHEVC);
+    mpp_dev_sched_init(&sched, MPP_CTX_DEC, MPP_VIDEO_CodingHEVC);
+
+    pthread_create(&thread, NULL, sched_test_stream, &stream);
+    msleep(10);
+
+    /* the other context must get the device while stream has tasks in flight */
+    for (i = 0; i < SCHED_TEST_SHORT_TASK; i++) {
+        mpp_dev_sched_start(sched);
+        msleep(1);
+        mpp_dev_sched_finish(sched);
+    }
+    short_done = 1;
+
+    pthread_join(thread, &count);
+
+    mpp_dev_sched_deinit(sched);
+    mpp_dev_sched_deinit(stream.sched);
+
+    mpp_log("stream sent %d tasks before short context done\n", (RK_S32)(intptr_t)count);
+    if ((intptr_t)count >= SCHED_TEST_STREAM_MAX) {
+        mpp_err("short context starved by tasks in flight\n");
+        return MPP_NOK;
+    }
+
+    return MPP_OK;
+}
+
+static MPP_RET sched_test_stat(void)
+{
+    MppDevSched sched = NULL;
+    MppSchedStat stat;
+    MPP_RET ret = MPP_NOK;
+
+    mpp_dev_sched_init(&sched, MPP_CTX_DEC, MPP_VIDEO_CodingAVC);
+
+    /* task longer than its deadline is a miss */
+    mpp_dev_sched_set_deadline(sched, 1000);
+    mpp_dev_sched_start(sched);
+    msleep(10);
+    mpp_dev_sched_finish(sched);
+
+    mpp_dev_sched_set_deadline(sched, 1000000);
+    mpp_dev_sched_start(sched);
+    mpp_dev_sched_finish(sched);
+
+    /* finish without start is ignored */
+    mpp_dev_sched_finish(sched);
+
+    mpp_dev_sched_get_stat(sched, &stat);
+    mpp_log("task %d miss %d max late %lld us\n",
+            stat.task_count, stat.miss_count, stat.max_late);
+
+    if (stat.task_count == 2 && stat.miss_count == 1 && stat.max_late > 0)
+        ret = MPP_OK;
+
+    if (!mpp_dev_sched_set_priority(sched, MPP_SCHED_PRIO_BUTT)) {
+        mpp_err("invalid priority is accepted\n");
+        ret = MPP_NOK;
+    }
+
+    mpp_dev_sched_deinit(sched);
+    return ret;
+}
+
+int main()
+{
+    MPP_RET ret = MPP_OK;
+
+    mpp_log("mpp_dev_sched test start\n");
+
+    /* scheduling is disabled by default */
+    mpp_env_set_u32("mpp_dev_sched_depth", 1);
+
+    ret = sched_test_order();
+    if (!ret)
+        ret = sched_test_inflight();
+    if (!ret)
+        ret = sched_test_stat();
+
+    mpp_log("mpp_dev_sched test %s\n", ret ? "failed" : "success");
+    return ret;
+}
@@ -0,0 +1,168 @@
+/*
+ * Copyright 2018 Rockchip Electronics Co. LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define MODULE_TAG "mpp_dev_stat_test"
+
+#include "mpp_log.h"
+#include "mpp_time.h"
+#include "mpp_thread.h"
+
+#include "mpp_dev_stat.h"
+
+#define STAT_TEST_TASKS     1000
+#define STAT_TEST_INFLIGHT  4
+
+static MppDevStat stat = NULL;
+static volatile RK_S32 task_sent = 0;
+static volatile RK_S32 task_done = 0;
+
+/* simulate hal thread waiting tasks sent by another thread */
+static void *stat_test_wait(void *arg)
+{
+    while (task_done < STAT_TEST_TASKS) {
+        if (task_done >= task_sent) {
+            sched_yield();
+            continue;
+        }
+
+        /* every task runs 100 us on hardware */
+        mpp_dev_stat_done(stat, (RK_S64)task_done * 1000 + 100);
+        task_done++;
+    }
+
+    (void)arg;
+    return NULL;
+}
+
+static MPP_RET stat_test_task(void)
+{
+    pthread_t thread;
+    MppHwLatStat lat;
+    RK_U32 p50, p99;
+    RK_S32 i;
+
+    pthread_create(&thread, NULL, stat_test_wait, NULL);
+
+    for (i = 0; i < STAT_TEST_TASKS; i++) {
+        RK_S64 base = (RK_S64)i * 1000;
+
+        while (i - task_done >= STAT_TEST_INFLIGHT)
+            sched_yield();
+
+        /* gen 20 us and queue 5 us, one of 100 tasks queues 500 us */
+        mpp_dev_stat_gen(stat, base - 25, base - 5);
+        if (i % 100 == 99)
+            mpp_dev_stat_gen(stat, base - 520, base - 500);
+
+        mpp_dev_stat_send(stat, base - 5, base);
+        task_sent++;
+    }
+
+    pthread_join(thread, NULL);
+
+    mpp_dev_stat_get(stat, &lat);
+
+    p50 = mpp_lat_hist_percentile(&lat.queue, 50);
+    p99 = mpp_lat_hist_percentile(&lat.queue, 99);
+    mpp_log("hw count %d max %d avg %lld\n", lat.hw.count, lat.hw.max,
+            lat.hw.sum / lat.hw.count);
+    mpp_log("queue p50 %d p99 %d p100 %d\n", p50, p99,
+            mpp_lat_hist_percentile(&lat.queue, 100));
+
+    if (lat.hw.count != STAT_TEST_TASKS || lat.hw.max != 100 ||
+        lat.hw.sum != STAT_TEST_TASKS * 100) {
+        mpp_err("wrong hw latency\n");
+        return MPP_NOK;
+    }
+
+    if (lat.gen.count != STAT_TEST_TASKS + STAT_TEST_TASKS / 100 ||
+        lat.gen.max != 20) {
+        mpp_err("wrong gen latency\n");
+        return MPP_NOK;
+    }
+
+    if (p50 != 5 || p99 != 5 || lat.queue.max != 500) {
+        mpp_err("wrong queue percentile\n");
+        return MPP_NOK;
+    }
+
+    return MPP_OK;
+}
+
+static MPP_RET stat_test_bins(void)
+{
+    MppHwLatStat lat;
+    RK_S32 i;
+
+    mpp_dev_stat_reset(stat);
+
+    /* each value is the lower bound of its own bin */
+    for (i = 0; i < MPP_LAT_HIST_BINS; i++) {
+        mpp_dev_stat_send(stat, 0, 0);
+        mpp_dev_stat_done(stat, MPP_LAT_HIST_BIN_LOWER(i));
+    }
+
+    /* done without send is ignored */
+    mpp_dev_stat_done(stat, 10);
+
+    mpp_dev_stat_get(stat, &lat);
+
+    if (lat.hw.count != MPP_LAT_HIST_BINS) {
+        mpp_err("wrong count %d\n", lat.hw.count);
+        return MPP_NOK;
+    }
+
+    for (i = 0; i < MPP_LAT_HIST_BINS; i++) {
+        if (lat.hw.bins[i] != 1) {
+            mpp_err("bin %d lower %d count %d\n", i,
+                    MPP_LAT_HIST_BIN_LOWER(i), lat.hw.bins[i]);
+            return MPP_NOK;
+        }
+    }
+
+    mpp_dev_stat_reset(stat);
+    mpp_dev_stat_get(stat, &lat);
+    if (lat.hw.count || lat.hw.max || lat.hw.sum || lat.queue.count) {
+        mpp_err("stat is not cleared by reset\n");
+        return MPP_NOK;
+    }
+
+    return MPP_OK;
+}
+
+int main()
+{
+    MPP_RET ret = MPP_NOK;
+
+    mpp_log("mpp_dev_stat test start\n");
+
+    ret = mpp_dev_stat_init(&stat);
+    if (ret) {
+        mpp_err("mpp_dev_stat_init failed\n");
+        goto DONE;
+    }
+
+    ret = stat_test_task();
+    if (!ret)
+        ret = stat_test_bins();
+
+DONE:
+    if (stat)
+        mpp_dev_stat_deinit(stat);
+
+    mpp_log("mpp_dev_stat test %s\n", ret ? "failed" : "success");
+    return ret;
+}
@@ -20,6 +20,7 @@
 
 #include "mpp_mem.h"
 #include "mpp_common.h"
+#include "mpp_buffer_impl.h"
 
 #include "hal_h264e_com.h"
 #include "hal_h264e_vepu.h"
@@ -28,16 +29,19 @@
 
 #include "h264e_stream.h"
 
-static void hal_h264e_vpu_write_cabac_table(MppBuffer hw_cabac_tab_buf,
-                                            RK_S32 cabac_init_idc)
+static void hal_h264e_vpu_init_cabac_table(void *dst, size_t size,
+                                           const void *param)
 {
     const RK_S32(*context)[460][2];
+    RK_S32 cabac_init_idc = *(const RK_S32 *)param;
     RK_S32 i, j, qp;
 
-    RK_U8 table[H264E_CABAC_TABLE_BUF_SIZE] = {0};
+    RK_U8 *table = (RK_U8 *)dst;
 
     h264e_hal_enter();
 
+    memset(table, 0, size);
+
     for (qp = 0; qp < 52; qp++) { /* All QP values */
         for (j = 0; j < 2; j++) { /* Intra/Inter */
             if (j == 0)
@@ -64,11 +68,42 @@ static void hal_h264e_vpu_write_cabac_table(MppBuffer hw_cabac_tab_buf,
         }
     }
     h264e_swap_endian((RK_U32 *)table, H264E_CABAC_TABLE_BUF_SIZE);
-    mpp_buffer_write(hw_cabac_tab_buf, 0, table, H264E_CABAC_TABLE_BUF_SIZE);
 
     h264e_hal_leave();
 }
 
+static MPP_RET hal_h264e_vpu_get_cabac_table(h264e_hal_vpu_buffers *buffers,
+                                             RK_S32 cabac_init_idc)
+{
+    MppBuffer *table = NULL;
+
+    if (cabac_init_idc < 0 ||
+        cabac_init_idc >= (RK_S32)MPP_ARRAY_ELEMS(buffers->hw_cabac_tables)) {
+        mpp_err("invalid cabac_init_idc %d\n", cabac_init_idc);
+        return MPP_ERR_VALUE;
+    }
+
+    table = &buffers->hw_cabac_tables[cabac_init_idc];
+    if (NULL == *table) {
+        char name[32];
+        MPP_RET ret = MPP_OK;
+
+        snprintf(name, sizeof(name), "h264e_vpu_cabac_%d", cabac_init_idc);
+        ret = mpp_buffer_table_get(table, name, MPP_BUFFER_TYPE_ION,
+                                   H264E_CABAC_TABLE_BUF_SIZE,
+                                   hal_h264e_vpu_init_cabac_table,
+                                   &cabac_init_idc);
+        if (ret) {
+            mpp_err("hw_cabac_table_buf get failed\n");
+            return ret;
+        }
+    }
+
+    buffers->hw_cabac_table_buf = *table;
+    buffers->cabac_init_idc = cabac_init_idc;
+    return MPP_OK;
+}
+
 static MPP_RET h264e_vpu_nal_start(H264eStream * stream,
                                    RK_S32 nalRefIdc,
                                    H264NaluType nalUnitType)
@@ -433,13 +468,22 @@ MPP_RET h264e_vpu_set_extra_info(H264eHalContext *ctx)
         (H264eVpuExtraInfo *)ctx->extra_info;
     H264eStream *sps_stream = &info->sps_stream;
     H264eStream *pps_stream = &info->pps_stream;
+    H264eStream *sei_stream = &info->sei_stream;
     H264eSps *sps = &info->sps;
     H264ePps *pps = &info->pps;
+    MPP_RET ret = MPP_OK;
 
     h264e_hal_enter();
 
+    /* config is not changed since last serialization */
+    if (ctx->hdr_valid) {
+        h264e_hal_leave();
+        return MPP_OK;
+    }
+
     h264e_stream_reset(sps_stream);
     h264e_stream_reset(pps_stream);
+    h264e_stream_reset(sei_stream);
 
     h264e_set_sps(ctx, sps);
     h264e_set_pps(ctx, pps, sps);
@@ -453,10 +497,18 @@ MPP_RET h264e_vpu_set_extra_info(H264eHalContext *ctx)
         h264e_vpu_sei_encode(ctx);
     }
 
+    h264e_hdr_cache_reset(ctx);
+    ret = h264e_hdr_cache_write(ctx, sps_stream->buffer, sps_stream->byte_cnt);
+    if (!ret)
+        ret = h264e_hdr_cache_write(ctx, pps_stream->buffer, pps_stream->byte_cnt);
+    if (!ret)
+        ret = h264e_hdr_cache_write(ctx, sei_stream->buffer, sei_stream->byte_cnt);
+    if (!ret)
+        ctx->hdr_valid = 1;
 
     h264e_hal_leave();
 
-    return MPP_OK;
+    return ret;
 }
 
 MPP_RET h264e_vpu_free_buffers(H264eHalContext *ctx)
@@ -466,13 +518,16 @@ MPP_RET h264e_vpu_free_buffers(H264eHalContext *ctx)
     h264e_hal_vpu_buffers *p = (h264e_hal_vpu_buffers *)ctx->buffers;
     h264e_hal_enter();
 
-    if (p->hw_cabac_table_buf) {
-        ret = mpp_buffer_put(p->hw_cabac_table_buf);
-        if (ret)
-            mpp_err("hw_cabac_table_buf put failed ret %d\n", ret);
+    for (k = 0; k < (RK_S32)MPP_ARRAY_ELEMS(p->hw_cabac_tables); k++) {
+        if (p->hw_cabac_tables[k]) {
+            ret = mpp_buffer_table_put(p->hw_cabac_tables[k]);
+            if (ret)
+                mpp_err("hw_cabac_table_buf put failed ret %d\n", ret);
 
-        p->hw_cabac_table_buf = NULL;
+            p->hw_cabac_tables[k] = NULL;
+        }
     }
+    p->hw_cabac_table_buf = NULL;
 
     if (p->hw_nal_size_table_buf) {
         ret = mpp_buffer_put(p->hw_nal_size_table_buf);
@@ -514,6 +569,8 @@ MPP_RET h264e_vpu_allocate_buffers(H264eHalContext *ctx)
     buffers->cabac_init_idc = 0;
     buffers->align_width = 0;
     buffers->align_height = 0;
+    buffers->scratch_shared = mpp_buffer_shared_pool_en();
+    buffers->scratch_users = 0;
 
     ret = mpp_buffer_group_get_internal(&buffers->hw_buf_grp,
                                         MPP_BUFFER_TYPE_ION);
@@ -521,14 +578,9 @@ MPP_RET h264e_vpu_allocate_buffers(H264eHalContext *ctx)
         mpp_err("buf group get failed ret %d\n", ret);
         return ret;
     }
-    ret = mpp_buffer_get(buffers->hw_buf_grp, &buffers->hw_cabac_table_buf,
-                         H264E_CABAC_TABLE_BUF_SIZE);
-    if (ret) {
-        mpp_err("hw_cabac_table_buf get failed\n");
+    ret = hal_h264e_vpu_get_cabac_table(buffers, buffers->cabac_init_idc);
+    if (ret)
         return ret;
-    }
-    hal_h264e_vpu_write_cabac_table(buffers->hw_cabac_table_buf,
-                                    buffers->cabac_init_idc);
 
     h264e_hal_leave();
     return MPP_OK;
@@ -542,9 +594,9 @@ MPP_RET h264e_vpu_update_buffers(H264eHalContext *ctx, H264eHwCfg *hw_cfg)
     h264e_hal_enter();
 
     if (hw_cfg->cabac_init_idc != buffers->cabac_init_idc) {
-        hal_h264e_vpu_write_cabac_table(buffers->hw_cabac_table_buf,
-                                        hw_cfg->cabac_init_idc);
-        buffers->cabac_init_idc = hw_cfg->cabac_init_idc;
+        ret = hal_h264e_vpu_get_cabac_table(buffers, hw_cfg->cabac_init_idc);
+        if (ret)
+            return ret;
     }
 
     RK_S32 align_width = MPP_ALIGN(hw_cfg->width, 16);
@@ -566,11 +618,15 @@ MPP_RET h264e_vpu_update_buffers(H264eHalContext *ctx, H264eHwCfg *hw_cfg)
 
         // realloc buffer
         RK_U32 frame_size = align_width * align_height * 3 / 2;
-        ret = mpp_buffer_get(buffers->hw_buf_grp, &buffers->hw_nal_size_table_buf,
-                             (sizeof(RK_U32) * align_height));
-        if (ret) {
-            mpp_err("hw_nal_size_table_buf get failed\n");
-            return ret;
+
+        buffers->nal_size_table_size = sizeof(RK_U32) * align_height;
+        if (!buffers->scratch_shared) {
+            ret = mpp_buffer_get(buffers->hw_buf_grp, &buffers->hw_nal_size_table_buf,
+                                 buffers->nal_size_table_size);
+            if (ret) {
+                mpp_err("hw_nal_size_table_buf get failed\n");
+                return ret;
+            }
         }
         for (k = 0; k < 2; k++) {
             ret = mpp_buffer_get(buffers->hw_buf_grp, &buffers->hw_rec_buf[k],
@@ -584,6 +640,94 @@ MPP_RET h264e_vpu_update_buffers(H264eHalContext *ctx, H264eHwCfg *hw_cfg)
         buffers->align_height = align_height;
     }
 
+    /* batch frames share one table until the last one is waited */
+    if (buffers->scratch_shared) {
+        if (NULL == buffers->hw_nal_size_table_buf) {
+            ret = mpp_buffer_get_shared(&buffers->hw_nal_size_table_buf,
+                                        buffers->nal_size_table_size, 0);
+            if (ret) {
+                mpp_err("hw_nal_size_table_buf get shared failed\n");
+                return ret;
+            }
+        }
+        buffers->scratch_users++;
+    }
+
     h264e_hal_leave();
     return MPP_OK;
 }
+
+MPP_RET h264e_vpu_put_scratch(H264eHalContext *ctx)
+{
+    h264e_hal_vpu_buffers *buffers = (h264e_hal_vpu_buffers *)ctx->buffers;
+
+    if (!buffers->scratch_shared || buffers->scratch_users <= 0)
+        return MPP_OK;
+
+    buffers->scratch_users--;
+    if (!buffers->scratch_users && buffers->hw_nal_size_table_buf) {
+        mpp_buffer_put(buffers->hw_nal_size_table_buf);
+        buffers->hw_nal_size_table_buf = NULL;
+    }
+
+    return MPP_OK;
+}
+
+MPP_RET h264e_vpu_get_buf_stat(H264eHalContext *ctx, MppEncBufStat *stat)
+{
+    h264e_hal_vpu_buffers *buffers = (h264e_hal_vpu_buffers *)ctx->buffers;
+    RK_S32 k;
+
+    memset(stat, 0, sizeof(*stat));
+    for (k = 0; k < 2; k++) {
+        if (buffers->hw_rec_buf[k])
+            stat->ref_size += mpp_buffer_get_size(buffers->hw_rec_buf[k]);
+    }
+
+    stat->scratch_size = buffers->nal_size_table_size;
+    stat->scratch_shared = buffers->scratch_shared;
+
+    return MPP_OK;
+}
+
+/*
+ * Collect slice size from the nal size table written by hardware.
+ * The table has one 32bit byte size for each slice and ends with zero.
+ * When the table does not match the total stream length the frame is
+ * reported as one slice.
+ */
+MPP_RET h264e_vpu_get_slice_info(H264eHalContext *ctx, HalEncTask *task)
+{
+    h264e_hal_vpu_buffers *bufs = (h264e_hal_vpu_buffers *)ctx->buffers;
+    MppBuffer buf = bufs->hw_nal_size_table_buf;
+    RK_U32 *table = NULL;
+    RK_S32 max_num = 0;
+    RK_U32 total = 0;
+    RK_S32 i;
+
+    task->slice_num = 0;
+    if (!ctx->cfg->misc.split.split_en || NULL == buf)
+        return MPP_OK;
+
+    table = (RK_U32 *)mpp_buffer_get_ptr(buf);
+    max_num = mpp_buffer_get_size(buf) / sizeof(RK_U32);
+    max_num = H264E_HAL_MIN(max_num, HAL_ENC_SLICE_MAX);
+
+    for (i = 0; i < max_num && table[i] && total < task->length; i++) {
+        task->slice_len[i] = table[i];
+        total += table[i];
+    }
+
+    if (total != task->length) {
+        h264e_hal_dbg(H264E_DBG_DETAIL, "slice size sum %d mismatch length %d\n",
+                      total, task->length);
+        task->slice_len[0] = task->length;
+        i = 1;
+    }
+
+    task->slice_num = i;
+    h264e_hal_dbg(H264E_DBG_DETAIL, "frame %d slice num %d\n",
+                  ctx->frame_cnt, task->slice_num);
+
+    return MPP_OK;
+}
@@ -28,5 +28,8 @@ MPP_RET h264e_vpu_set_extra_info(H264eHalContext *ctx);
 
 MPP_RET h264e_vpu_free_buffers(H264eHalContext *ctx);
 MPP_RET h264e_vpu_allocate_buffers(H264eHalContext *ctx);
+MPP_RET h264e_vpu_get_slice_info(H264eHalContext *ctx, HalEncTask *task);
+MPP_RET h264e_vpu_put_scratch(H264eHalContext *ctx);
+MPP_RET h264e_vpu_get_buf_stat(H264eHalContext *ctx, MppEncBufStat *stat);
 
 #endif
@@ -388,11 +388,31 @@ MPP_RET h264e_vpu_update_hw_cfg(H264eHalContext *ctx, HalEncTask *task,
         rc->quality == MPP_ENC_RC_QUALITY_CQP) {
         hw_cfg->qp = codec->qp_init;
     } else {
+        /* estimate init qp from the first frame complexity before bpp */
+        if (hw_cfg->qp <= 0 && ctx->frame_cnt == 0) {
+            RK_S32 qp = h264e_estimate_init_qp(prep, task->input, rc_syn->bit_target,
+                                               codec->qp_min, codec->qp_max);
+            if (qp > 0) {
+                hw_cfg->qp = qp;
+                hw_cfg->qp_prev = qp;
+                /* seed intra qstep model so the estimate is used before real result */
+                mpp_save_regdata(ctx->intra_qs, h264_q_step[qp], rc_syn->bit_target);
+                mpp_linreg_update(ctx->intra_qs);
+            }
+        }
+
         /* enable mb rate control*/
         h264e_vpu_mb_rc_cfg(ctx, rc_syn, hw_cfg);
     }
-    /* slice mode setup */
-    hw_cfg->slice_size_mb_rows = 0; //(prep->height + 15) >> 4;
+    /* slice mode setup, vepu can only split slice by whole mb row */
+    hw_cfg->slice_size_mb_rows = 0;
+    if (cfg->misc.split.split_en) {
+        RK_S32 mb_w = (prep->width + 15) >> 4;
+        RK_S32 rows = (cfg->misc.split.slice_size + mb_w - 1) / mb_w;
+
+        /* zero means one slice per frame for hardware */
+        hw_cfg->slice_size_mb_rows = mpp_clip(rows, 1, 127);
+    }
 
     /* input and preprocess config, the offset is at [31:10] */
     hw_cfg->input_luma_addr = mpp_buffer_get_fd(task->input);
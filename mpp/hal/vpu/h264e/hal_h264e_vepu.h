@@ -60,8 +60,18 @@ typedef struct h264e_hal_vpu_buffers_t {
 
     MppBufferGroup hw_buf_grp;
     MppBuffer hw_rec_buf[2];
+    /*
+     * cabac table of current cabac_init_idc. Tables are from process wide
+     * table cache and kept until free_buffers for the running task.
+     */
     MppBuffer hw_cabac_table_buf;
+    MppBuffer hw_cabac_tables[3];
     MppBuffer hw_nal_size_table_buf;
+
+    /* nal size table from shared pool, held from gen_regs to wait */
+    RK_S32 scratch_shared;
+    RK_S32 scratch_users;
+    RK_U32 nal_size_table_size;
 } h264e_hal_vpu_buffers;
 
 #endif
@@ -90,6 +90,7 @@ MPP_RET hal_h264e_vepu2_deinit(void *hal)
         h264e_vpu_deinit_extra_info(ctx->extra_info);
         MPP_FREE(ctx->extra_info);
     }
+    h264e_hdr_cache_deinit(ctx);
 
     if (ctx->packeted_param) {
         mpp_packet_deinit(&ctx->packeted_param);
@@ -549,10 +550,12 @@ MPP_RET hal_h264e_vepu2_wait(void *hal, HalTaskInfo *task)
 
         if (hw_ret != MPP_OK) {
             mpp_err("hardware returns error:%d", hw_ret);
+            h264e_vpu_put_scratch(ctx);
             return MPP_ERR_VPUHW;
         }
     } else {
         mpp_err("invalid device ctx: %p", ctx->dev_ctx);
+        h264e_vpu_put_scratch(ctx);
         return MPP_NOK;
     }
 
@@ -584,6 +587,8 @@ MPP_RET hal_h264e_vepu2_wait(void *hal, HalTaskInfo *task)
             }
         } while (1);
     }
+    h264e_vpu_get_slice_info(ctx, &task->enc);
+    h264e_vpu_put_scratch(ctx);
 
     if (int_cb.callBack) {
         RcSyntax *syn = (RcSyntax *)task->enc.syntax.data;
@@ -659,30 +664,10 @@ MPP_RET hal_h264e_vepu2_control(void *hal, MpiCmd cmd_type, void *param)
     case MPP_ENC_SET_EXTRA_INFO: {
     } break;
     case MPP_ENC_GET_EXTRA_INFO: {
-        MppPacket  pkt      = ctx->packeted_param;
         MppPacket *pkt_out  = (MppPacket *)param;
 
-        H264eVpuExtraInfo *src = (H264eVpuExtraInfo *)ctx->extra_info;
-        H264eStream *sps_stream = &src->sps_stream;
-        H264eStream *pps_stream = &src->pps_stream;
-        H264eStream *sei_stream = &src->sei_stream;
-
-        size_t offset = 0;
-
         h264e_vpu_set_extra_info(ctx);
-
-        mpp_packet_write(pkt, offset, sps_stream->buffer, sps_stream->byte_cnt);
-        offset += sps_stream->byte_cnt;
-
-        mpp_packet_write(pkt, offset, pps_stream->buffer, pps_stream->byte_cnt);
-        offset += pps_stream->byte_cnt;
-
-        mpp_packet_write(pkt, offset, sei_stream->buffer, sei_stream->byte_cnt);
-        offset += sei_stream->byte_cnt;
-
-        mpp_packet_set_length(pkt, offset);
-
-        *pkt_out = pkt;
+        h264e_hdr_cache_get(ctx, pkt_out);
     } break;
     case MPP_ENC_SET_PREP_CFG : {
         MppEncPrepCfg *set = &ctx->set->prep;
@@ -708,9 +693,12 @@ MPP_RET hal_h264e_vepu2_control(void *hal, MpiCmd cmd_type, void *param)
                 ret = MPP_NOK;
             }
         }
+
+        ctx->hdr_valid = 0;
     } break;
     case MPP_ENC_SET_RC_CFG : {
         // TODO: do rate control check here
+        ctx->hdr_valid = 0;
     } break;
     case MPP_ENC_SET_CODEC_CFG : {
         MppEncH264Cfg *src = &ctx->set->codec.h264;
@@ -771,6 +759,8 @@ MPP_RET hal_h264e_vepu2_control(void *hal, MpiCmd cmd_type, void *param)
          */
         dst->change |= change;
         src->change = 0;
+        /* sps / pps will be rebuilt on next MPP_ENC_GET_EXTRA_INFO */
+        ctx->hdr_valid = 0;
     } break;
     case MPP_ENC_SET_OSD_PLT_CFG:
     case MPP_ENC_SET_OSD_DATA_CFG: {
@@ -779,11 +769,23 @@ MPP_RET hal_h264e_vepu2_control(void *hal, MpiCmd cmd_type, void *param)
     } break;
     case MPP_ENC_SET_SEI_CFG: {
         ctx->sei_mode = *((MppEncSeiMode *)param);
+        ctx->hdr_valid = 0;
     } break;
     case MPP_ENC_SET_ROI_CFG: {
         mpp_err("vepu2 do not support roi cfg\n");
         ret = MPP_NOK;
     } break;
+    case MPP_ENC_SET_SPLIT: {
+        MppEncSliceSplit *split = (MppEncSliceSplit *)param;
+
+        if (split->split_en && split->split_mode != MPP_ENC_SPLIT_BY_CTU) {
+            mpp_err("vepu2 only support slice split by mb count\n");
+            ret = MPP_NOK;
+        }
+    } break;
+    case MPP_ENC_GET_BUF_STAT: {
+        ret = h264e_vpu_get_buf_stat(ctx, (MppEncBufStat *)param);
+    } break;
     case MPP_ENC_PRE_ALLOC_BUFF:
         // vepu do not support prealloc buff, ignore cmd
         break;
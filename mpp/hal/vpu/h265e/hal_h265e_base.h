@@ -23,6 +23,7 @@
 #include "mpp_device.h"
 #include "mpp_hal.h"
 #include "rga_api.h"
+#include "swcvt_api.h"
 
 extern RK_U32 hal_h265e_debug ;
 
@@ -73,6 +74,9 @@ typedef struct hal_h265e_ctx {
      * this means the stride of chroma is align 8, so we need translate input format to nv12.
      */
     MppBuffer       pre_buf;
+    /* pre_buf is taken from shared pool on each frame and returned on wait */
+    RK_U32          pre_buf_shared;
+    RK_U32          pre_buf_size;
 
     void           *en_info;
     RK_U32          option;
@@ -87,6 +91,8 @@ typedef struct hal_h265e_ctx {
     RK_U32          init;
 
     RgaCtx          rga_ctx;
+    /* software convert when rga is not available or busy */
+    SwcvtCtx        swcvt_ctx;
     /*
      * write yuv data(only for debug)
      */
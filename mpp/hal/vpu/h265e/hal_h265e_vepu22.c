@@ -23,6 +23,7 @@
 #include "mpp_env.h"
 #include "mpp_mem.h"
 #include "mpp_common.h"
+#include "mpp_buffer_impl.h"
 
 #include "h265e_syntax.h"
 #include "hal_h265e_base.h"
@@ -131,27 +132,34 @@ MPP_RET vepu22_need_pre_process(void *hal)
      * and if the input format is YU12 or YV12, and the stride of
      * input is align 32(stride of luma is align 32, stride of chroma is align 16),
      * there is no need to proces also.
+     * Other input format is translated to NV12 by rga, or by software when
+     * rga is not available.
      *
      * return MPP_NOK means need pre process(fomrat translate)
      * return MPP_OK means need do nothing
      */
     if ((prep->format == MPP_FMT_YUV420SP) || (prep->format == MPP_FMT_YUV420SP_VU)) {
         return MPP_OK;
-    } else if (h_stride == MPP_ALIGN(prep->hor_stride, 32)) {
+    } else if ((prep->format == MPP_FMT_YUV420P) &&
+               (h_stride == MPP_ALIGN(h_stride, 32))) {
         return MPP_OK;
     }
 
-    RgaCtx rga = ctx->rga_ctx;
-    if (rga == NULL) {
-        MPP_RET ret = rga_init(&rga);
+    if (ctx->rga_ctx == NULL && ctx->swcvt_ctx == NULL) {
+        MPP_RET ret = rga_init(&ctx->rga_ctx);
         if (ret) {
-            mpp_err("init rga context failed %d\n", ret);
-        } else {
-            ctx->rga_ctx = rga;
+            mpp_log("init rga context failed %d, use software convert\n", ret);
+            ctx->rga_ctx = NULL;
+
+            ret = swcvt_init(&ctx->swcvt_ctx);
+            if (ret) {
+                mpp_err("init swcvt context failed %d\n", ret);
+                ctx->swcvt_ctx = NULL;
+            }
         }
     }
 
-    return ctx->rga_ctx ? MPP_NOK : MPP_OK;
+    return (ctx->rga_ctx || ctx->swcvt_ctx) ? MPP_NOK : MPP_OK;
 }
 
 static RK_U8 vepu22_get_endian(int endian)
@@ -1628,6 +1636,88 @@ static MPP_RET vepu22_dump_cfg(HalH265eCtx* ctx)
     return MPP_OK;
 }
 
+static RK_S32 vepu22_rga_support(MppFrameFormat format)
+{
+    switch (format) {
+    case MPP_FMT_YUV420P:
+    case MPP_FMT_YUV422P:
+    case MPP_FMT_YUV422SP:
+    case MPP_FMT_RGB565:
+    case MPP_FMT_RGB888:
+    case MPP_FMT_ARGB8888:
+        return 1;
+    default:
+        break;
+    }
+
+    return 0;
+}
+
+static MPP_RET vepu22_rga_process(RgaCtx rga, MppFrame src_frm, MppFrame dst_frm)
+{
+    MPP_RET ret = rga_control(rga, RGA_CMD_INIT, NULL);
+    if (ret) {
+        mpp_err("rga cmd init failed %d\n", ret);
+        return ret;
+    }
+
+    ret = rga_control(rga, RGA_CMD_SET_SRC, src_frm);
+    if (ret) {
+        mpp_err("rga cmd setup source failed %d\n", ret);
+        return ret;
+    }
+
+    ret = rga_control(rga, RGA_CMD_SET_DST, dst_frm);
+    if (ret) {
+        mpp_err("rga cmd setup destination failed %d\n", ret);
+        return ret;
+    }
+
+    ret = rga_control(rga, RGA_CMD_RUN_SYNC, NULL);
+    if (ret) {
+        mpp_err("rga cmd process copy failed %d\n", ret);
+        return ret;
+    }
+
+    return MPP_OK;
+}
+
+static MPP_RET vepu22_swcvt_process(HalH265eCtx* ctx, MppFrame src_frm, MppFrame dst_frm)
+{
+    MPP_RET ret = MPP_OK;
+
+    if (ctx->swcvt_ctx == NULL) {
+        ret = swcvt_init(&ctx->swcvt_ctx);
+        if (ret) {
+            mpp_err("init swcvt context failed %d\n", ret);
+            ctx->swcvt_ctx = NULL;
+            return ret;
+        }
+    }
+
+    swcvt_control(ctx->swcvt_ctx, SWCVT_CMD_INIT, NULL);
+
+    ret = swcvt_control(ctx->swcvt_ctx, SWCVT_CMD_SET_SRC, src_frm);
+    if (ret) {
+        mpp_err("swcvt cmd setup source failed %d\n", ret);
+        return ret;
+    }
+
+    ret = swcvt_control(ctx->swcvt_ctx, SWCVT_CMD_SET_DST, dst_frm);
+    if (ret) {
+        mpp_err("swcvt cmd setup destination failed %d\n", ret);
+        return ret;
+    }
+
+    ret = swcvt_control(ctx->swcvt_ctx, SWCVT_CMD_RUN_SYNC, NULL);
+    if (ret) {
+        mpp_err("swcvt cmd process failed %d\n", ret);
+        return ret;
+    }
+
+    return MPP_OK;
+}
+
 MPP_RET vepu22_pre_process(void *hal, HalTaskInfo *task)
 {
     RK_S32 ret = MPP_NOK;
@@ -1654,15 +1744,17 @@ MPP_RET vepu22_pre_process(void *hal, HalTaskInfo *task)
 
     if (ctx->pre_buf == NULL) {
         mpp_assert(size);
-        mpp_buffer_get(ctx->buf_grp, &ctx->pre_buf, size);
+        if (ctx->pre_buf_shared)
+            mpp_buffer_get_shared(&ctx->pre_buf, size, 0);
+        else
+            mpp_buffer_get(ctx->buf_grp, &ctx->pre_buf, size);
+        ctx->pre_buf_size = size;
         hal_h265e_dbg_func("mpp_buffer_get,ctx = %p size = %d,pre fd = %d", ctx,  \
                            size, mpp_buffer_get_fd(ctx->pre_buf));
     }
     mpp_assert(ctx->pre_buf != NULL);
     dst_buf = ctx->pre_buf;
 
-    RgaCtx rga = ctx->rga_ctx;
-    mpp_assert(rga != NULL);
     ret = mpp_frame_init(&src_frm);
     if (ret) {
         mpp_err("failed to init src frame\n");
@@ -1689,31 +1781,14 @@ MPP_RET vepu22_pre_process(void *hal, HalTaskInfo *task)
     mpp_frame_set_ver_stride(dst_frm, v_stride);
     mpp_frame_set_fmt(dst_frm, MPP_FMT_YUV420SP);
 
-    ret = rga_control(rga, RGA_CMD_INIT, NULL);
-    if (ret) {
-        mpp_err("rga cmd init failed %d\n", ret);
-        goto END;
-    }
+    ret = MPP_NOK;
+    if (ctx->rga_ctx && vepu22_rga_support(prep->format))
+        ret = vepu22_rga_process(ctx->rga_ctx, src_frm, dst_frm);
 
-    ret = rga_control(rga, RGA_CMD_SET_SRC, src_frm);
-    if (ret) {
-        mpp_err("rga cmd setup source failed %d\n", ret);
-        goto END;
-    }
+    /* rga is not available, busy or can not handle the format */
+    if (ret)
+        ret = vepu22_swcvt_process(ctx, src_frm, dst_frm);
 
-    ret = rga_control(rga, RGA_CMD_SET_DST, dst_frm);
-    if (ret) {
-        mpp_err("rga cmd setup destination failed %d\n", ret);
-        goto END;
-    }
-
-    ret = rga_control(rga, RGA_CMD_RUN_SYNC, NULL);
-    if (ret) {
-        mpp_err("rga cmd process copy failed %d\n", ret);
-        goto END;
-    }
-
-    ret = MPP_OK;
 END:
     if (src_frm) {
         mpp_frame_deinit(&src_frm);
@@ -1797,6 +1872,7 @@ MPP_RET hal_h265e_vepu22_init(void *hal, MppHalCfg *cfg)
     ctx->option = H265E_SET_CFG_INIT;
     ctx->init = 0;
     ctx->rga_ctx = NULL;
+    ctx->swcvt_ctx = NULL;
 
     ctx->hw_cfg = mpp_calloc_size(void, sizeof(HalH265eCfg));
     if (ctx->hw_cfg == NULL) {
@@ -1832,6 +1908,7 @@ MPP_RET hal_h265e_vepu22_init(void *hal, MppHalCfg *cfg)
         mpp_err("failed to malloc buf_grp from ion ret %d\n", ret);
         goto FAIL;
     }
+    ctx->pre_buf_shared = mpp_buffer_shared_pool_en();
 
     //!< mpp_device_init
     MppDevCfg dev_cfg = {
@@ -1894,6 +1971,11 @@ FAIL:
         ctx->rga_ctx = NULL;
     }
 
+    if (ctx->swcvt_ctx != NULL) {
+        swcvt_deinit(ctx->swcvt_ctx);
+        ctx->swcvt_ctx = NULL;
+    }
+
     return MPP_NOK;
 }
 
@@ -1942,6 +2024,11 @@ MPP_RET hal_h265e_vepu22_deinit(void *hal)
         ctx->rga_ctx = NULL;
     }
 
+    if (ctx->swcvt_ctx != NULL) {
+        swcvt_deinit(ctx->swcvt_ctx);
+        ctx->swcvt_ctx = NULL;
+    }
+
     if (ctx->mInFile != NULL) {
         fflush(ctx->mInFile);
         fclose(ctx->mInFile);
@@ -2021,6 +2108,14 @@ MPP_RET hal_h265e_vepu22_start(void *hal, HalTaskInfo *task)
     return ret;
 }
 
+static void vepu22_put_pre_buf(HalH265eCtx *ctx)
+{
+    if (ctx->pre_buf_shared && ctx->pre_buf) {
+        mpp_buffer_put(ctx->pre_buf);
+        ctx->pre_buf = NULL;
+    }
+}
+
 MPP_RET hal_h265e_vepu22_wait(void *hal, HalTaskInfo *task)
 {
     RK_S32 ret = MPP_NOK;
@@ -2035,6 +2130,7 @@ MPP_RET hal_h265e_vepu22_wait(void *hal, HalTaskInfo *task)
 
     ret = mpp_device_wait_reg(ctx->dev_ctx, (RK_U32*)&result,
                               (RK_U32)(sizeof(H265eVepu22Result) / sizeof(RK_U32)));
+    vepu22_put_pre_buf(ctx);
     if (ret) {
         mpp_err_f("leave hal hardware returns error:%d\n", ret);
         return MPP_ERR_VPUHW;
@@ -2172,6 +2268,16 @@ MPP_RET hal_h265e_vepu22_control(void *hal, MpiCmd cmd_type, void *param)
         break;
     }
 
+    case MPP_ENC_GET_BUF_STAT: {
+        MppEncBufStat *stat = (MppEncBufStat *)param;
+
+        /* reference frames are allocated by kernel driver */
+        stat->ref_size = 0;
+        stat->scratch_size = ctx->pre_buf_size;
+        stat->scratch_shared = ctx->pre_buf_shared;
+        break;
+    }
+
     default : {
         break;
     }
@@ -45,6 +45,9 @@ typedef struct PPInfo_t {
     RK_U32                 crop_height;
     RK_U32                 crop_x;
     RK_U32                 crop_y;
+    /* PP output stride from output frame, less than input when downscaled */
+    RK_U32                 out_hor_stride;
+    RK_U32                 out_ver_stride;
 } PPInfo;
 
 typedef struct JpegdHalCtx {
@@ -59,6 +62,7 @@ typedef struct JpegdHalCtx {
 
     MppFrameFormat         output_fmt;
     RK_U32                 set_output_fmt_flag;
+    RK_U32                 output_scale;
     RK_U32                 hal_debug_enable;
     RK_U32                 frame_count;
     RK_U32                 output_yuv_count;
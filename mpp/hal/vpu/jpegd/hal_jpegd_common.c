@@ -241,8 +241,9 @@ void jpegd_setup_output_fmt(JpegdHalCtx *ctx, JpegdSyntax *s, RK_S32 output)
     PPInfo *pp_info = &(ctx->pp_info);
     MppFrame frm = NULL;
 
-    if (ctx->set_output_fmt_flag && (ctx->output_fmt != s->output_fmt)) {
-        /* Using pp to convert all format to yuv420sp */
+    if ((ctx->set_output_fmt_flag && (ctx->output_fmt != s->output_fmt)) ||
+        ctx->output_scale > 1) {
+        /* Using pp to convert all format to yuv420sp and do downscale */
         switch (s->output_fmt) {
         case MPP_FMT_YUV400:
             pp_in_fmt = PP_IN_FORMAT_YUV400;
@@ -267,6 +268,10 @@ void jpegd_setup_output_fmt(JpegdHalCtx *ctx, JpegdSyntax *s, RK_S32 output)
             break;
         }
 
+        /* pp only outputs yuv420sp */
+        if (!ctx->set_output_fmt_flag)
+            ctx->output_fmt = MPP_FMT_YUV420SP;
+
         pp_info->pp_enable = 1;
         pp_info->pp_in_fmt = pp_in_fmt;
         pp_info->pp_out_fmt = PP_OUT_FORMAT_YUV420INTERLAVE;
@@ -283,6 +288,10 @@ void jpegd_setup_output_fmt(JpegdHalCtx *ctx, JpegdSyntax *s, RK_S32 output)
                           SLOT_FRAME_PTR, &frm);
     mpp_frame_set_fmt(frm, ctx->output_fmt);
 
+    /* buffer slot has reduced the frame stride by output scale */
+    pp_info->out_hor_stride = mpp_frame_get_hor_stride(frm);
+    pp_info->out_ver_stride = mpp_frame_get_ver_stride(frm);
+
     jpegd_dbg_func("exit\n");
     return;
 }
@@ -254,8 +254,8 @@ static MPP_RET jpegd_setup_pp(JpegdHalCtx *ctx, JpegdSyntax *syntax)
     RK_U32 crop_y = ctx->pp_info.crop_y;
     RK_U32 in_width = s->hor_stride;
     RK_U32 in_height = s->ver_stride;
-    RK_U32 out_width = s->hor_stride;
-    RK_U32 out_height = s->ver_stride;
+    RK_U32 out_width = ctx->pp_info.out_hor_stride;
+    RK_U32 out_height = ctx->pp_info.out_ver_stride;
 
     reg->reg0.sw_pp_axi_rd_id = 0;
     reg->reg0.sw_pp_axi_wr_id = 0;
@@ -576,7 +576,7 @@ static MPP_RET jpegd_setup_pp(JpegdHalCtx *ctx, JpegdSyntax *syntax)
         reg->reg22_pp_out_ch_base = ctx->frame_fd;
 
         mpp_device_patch_add((RK_U32 *)reg, &info->extra_info, 22,
-                             s->hor_stride * s->ver_stride);
+                             out_width * out_height);
 
         jpegd_dbg_hal("output_frame_fd:%x, reg22:%x", ctx->frame_fd,
                       reg->reg22_pp_out_ch_base);
@@ -794,6 +794,7 @@ MPP_RET hal_jpegd_vdpu2_init(void *hal, MppHalCfg *cfg)
 
     JpegHalCtx->output_fmt = MPP_FMT_YUV420SP;
     JpegHalCtx->set_output_fmt_flag = 0;
+    JpegHalCtx->output_scale = 1;
 
     //init dbg stuff
     JpegHalCtx->hal_debug_enable = 0;
@@ -847,6 +848,7 @@ MPP_RET hal_jpegd_vdpu2_deinit(void *hal)
     }
 
     JpegHalCtx->set_output_fmt_flag = 0;
+    JpegHalCtx->output_scale = 1;
     JpegHalCtx->hal_debug_enable = 0;
     JpegHalCtx->frame_count = 0;
     JpegHalCtx->output_yuv_count = 0;
@@ -873,7 +875,8 @@ MPP_RET hal_jpegd_vdpu2_gen_regs(void *hal,  HalTaskInfo *syn)
         syn->dec.valid = 0;
         jpegd_setup_output_fmt(JpegHalCtx, syntax, syn->dec.output);
 
-        if (JpegHalCtx->set_output_fmt_flag && (NULL != JpegHalCtx->dev_ctx)) {
+        if ((JpegHalCtx->set_output_fmt_flag || JpegHalCtx->output_scale > 1) &&
+            (NULL != JpegHalCtx->dev_ctx)) {
             mpp_device_deinit(JpegHalCtx->dev_ctx);
             MppDevCfg dev_cfg = {
                 .type = MPP_CTX_DEC,              /* type */
@@ -1033,6 +1036,10 @@ MPP_RET hal_jpegd_vdpu2_control(void *hal, MpiCmd cmd_type,
         JpegHalCtx->set_output_fmt_flag = 1;
         jpegd_dbg_hal("output_format:%d\n", JpegHalCtx->output_fmt);
     } break;
+    case MPP_DEC_SET_OUTPUT_SCALE: {
+        JpegHalCtx->output_scale = *((RK_U32 *)param);
+        jpegd_dbg_hal("output_scale:%d\n", JpegHalCtx->output_scale);
+    } break;
     default :
         ret = MPP_NOK;
     }
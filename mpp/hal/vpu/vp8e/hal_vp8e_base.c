@@ -22,6 +22,7 @@
 #include "mpp_hal.h"
 #include "mpp_buffer.h"
 #include "mpp_common.h"
+#include "mpp_buffer_impl.h"
 
 #include "hal_vp8e_base.h"
 #include "hal_vp8e_putbit.h"
@@ -1251,6 +1252,7 @@ static MPP_RET alloc_buffer(void *hal)
 
     //set coding format as VP8
     hw_cfg->coding_type = 1;
+    buffers->scratch_shared = mpp_buffer_shared_pool_en();
 
     ret = mpp_buffer_group_get_internal(&buffers->hw_buf_grp,
                                         MPP_BUFFER_TYPE_ION);
@@ -1289,10 +1291,14 @@ static MPP_RET alloc_buffer(void *hal)
          * At least 1 macroblock row in every slice.
          * Also used for VP8 partitions. */
         RK_U32 size_tbl = MPP_ALIGN(sizeof(RK_U32) * (pre->height + 4), 8);
-        ret = mpp_buffer_get(buffers->hw_buf_grp, &buffers->hw_size_table_buf, size_tbl);
-        if (ret) {
-            mpp_err("hw_size_table_buf get failed ret %d\n", ret);
-            goto __ERR_RET;
+
+        buffers->size_tbl_size = size_tbl;
+        if (!buffers->scratch_shared) {
+            ret = mpp_buffer_get(buffers->hw_buf_grp, &buffers->hw_size_table_buf, size_tbl);
+            if (ret) {
+                mpp_err("hw_size_table_buf get failed ret %d\n", ret);
+                goto __ERR_RET;
+            }
         }
     }
     {
@@ -1351,10 +1357,13 @@ static MPP_RET alloc_buffer(void *hal)
         RK_U32 pic_size = MPP_ALIGN(pre->width, 16) * MPP_ALIGN(pre->height, 16) * 3 / 2;
         RK_U32 out_size = pic_size / 2;
 
-        ret = mpp_buffer_get(buffers->hw_buf_grp, &buffers->hw_out_buf,  out_size);
-        if (ret) {
-            mpp_err("hw_out_buf get failed ret %d\n", ret);
-            goto __ERR_RET;
+        buffers->out_size = out_size;
+        if (!buffers->scratch_shared) {
+            ret = mpp_buffer_get(buffers->hw_buf_grp, &buffers->hw_out_buf,  out_size);
+            if (ret) {
+                mpp_err("hw_out_buf get failed ret %d\n", ret);
+                goto __ERR_RET;
+            }
         }
     }
     ctx->regs = mpp_calloc(RK_U32, ctx->reg_size);
@@ -1392,6 +1401,53 @@ __ERR_RET:
     return ret;
 }
 
+static MPP_RET get_scratch(HalVp8eCtx *ctx)
+{
+    Vp8eVpuBuf *buffers = (Vp8eVpuBuf *)ctx->buffers;
+    MPP_RET ret = MPP_OK;
+
+    if (!buffers->scratch_shared)
+        return MPP_OK;
+
+    /* kept by last frame when hardware returns error */
+    if (NULL == buffers->hw_size_table_buf) {
+        ret = mpp_buffer_get_shared(&buffers->hw_size_table_buf,
+                                    buffers->size_tbl_size, 0);
+        if (ret) {
+            mpp_err("hw_size_table_buf get shared failed ret %d\n", ret);
+            return ret;
+        }
+    }
+
+    if (NULL == buffers->hw_out_buf) {
+        ret = mpp_buffer_get_shared(&buffers->hw_out_buf, buffers->out_size, 0);
+        if (ret) {
+            mpp_err("hw_out_buf get shared failed ret %d\n", ret);
+            return ret;
+        }
+    }
+
+    return MPP_OK;
+}
+
+static void put_scratch(HalVp8eCtx *ctx)
+{
+    Vp8eVpuBuf *buffers = (Vp8eVpuBuf *)ctx->buffers;
+
+    if (!buffers->scratch_shared)
+        return;
+
+    if (buffers->hw_size_table_buf) {
+        mpp_buffer_put(buffers->hw_size_table_buf);
+        buffers->hw_size_table_buf = NULL;
+    }
+
+    if (buffers->hw_out_buf) {
+        mpp_buffer_put(buffers->hw_out_buf);
+        buffers->hw_out_buf = NULL;
+    }
+}
+
 MPP_RET hal_vp8e_enc_strm_code(void *hal, HalTaskInfo *task)
 {
     HalVp8eCtx  *ctx  = (HalVp8eCtx *)hal;
@@ -1400,6 +1456,9 @@ MPP_RET hal_vp8e_enc_strm_code(void *hal, HalTaskInfo *task)
     MppEncCfgSet  *cfg = ctx->cfg;
     MppEncPrepCfg *prep = &cfg->prep;
 
+    if (get_scratch(ctx))
+        return MPP_ERR_MALLOC;
+
     {
         RK_U32 i = 0;
         for (i = 0; i < 9; i++) {
@@ -1619,6 +1678,8 @@ MPP_RET hal_vp8e_update_buffers(void *hal, HalTaskInfo *task)
         p_out += ctx->stream_size[2];
         enc_task->length += ctx->stream_size[2];
     }
+
+    put_scratch(ctx);
     return MPP_OK;
 }
 
@@ -1642,6 +1703,30 @@ MPP_RET hal_vp8e_setup(void *hal)
     return ret;
 }
 
+MPP_RET hal_vp8e_get_buf_stat(void *hal, MppEncBufStat *stat)
+{
+    HalVp8eCtx *ctx = (HalVp8eCtx *)hal;
+    Vp8eVpuBuf *buffers = (Vp8eVpuBuf *)ctx->buffers;
+    RK_U32 i;
+
+    memset(stat, 0, sizeof(*stat));
+    if (NULL == buffers)
+        return MPP_OK;
+
+    if (buffers->hw_luma_buf)
+        stat->ref_size += mpp_buffer_get_size(buffers->hw_luma_buf);
+
+    for (i = 0; i < 2; i++) {
+        if (buffers->hw_cbcr_buf[i])
+            stat->ref_size += mpp_buffer_get_size(buffers->hw_cbcr_buf[i]);
+    }
+
+    stat->scratch_size = buffers->size_tbl_size + buffers->out_size;
+    stat->scratch_shared = buffers->scratch_shared;
+
+    return MPP_OK;
+}
+
 MPP_RET hal_vp8e_buf_free(void *hal)
 {
     HalVp8eCtx *ctx = (HalVp8eCtx *)hal;
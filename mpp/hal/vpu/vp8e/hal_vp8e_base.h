@@ -68,6 +68,11 @@ typedef struct vp8e_hal_vpu_buffers_t {
     MppBuffer   hw_prob_count_buf;
     MppBuffer   hw_mv_output_buf;
     MppBuffer   hw_out_buf;
+
+    /* size table and out buffer from shared pool, held from gen_regs to wait */
+    RK_U32      scratch_shared;
+    RK_U32      size_tbl_size;
+    RK_U32      out_size;
 } Vp8eVpuBuf;
 
 #define PENALTY_TABLE_SIZE 128
@@ -384,6 +389,7 @@ MPP_RET hal_vp8e_enc_strm_code(void *hal, HalTaskInfo *info);
 MPP_RET hal_vp8e_init_qp_table(void *hal);
 MPP_RET hal_vp8e_setup(void *hal);
 MPP_RET hal_vp8e_buf_free(void *hal);
+MPP_RET hal_vp8e_get_buf_stat(void *hal, MppEncBufStat *stat);
 #ifdef  __cplusplus
 }
 #endif
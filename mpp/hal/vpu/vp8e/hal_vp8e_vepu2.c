@@ -352,6 +352,7 @@ MPP_RET hal_vp8e_vepu2_gen_regs(void *hal, HalTaskInfo *task)
         if (ret) {
             hal_vp8e_vepu2_deinit(hal);
             mpp_err("failed to init hal vp8e\n");
+            return ret;
         } else {
             ctx->buffer_ready = 1;
         }
@@ -359,7 +360,11 @@ MPP_RET hal_vp8e_vepu2_gen_regs(void *hal, HalTaskInfo *task)
 
     memset(ctx->stream_size, 0, sizeof(ctx->stream_size));
 
-    hal_vp8e_enc_strm_code(ctx, task);
+    ret = hal_vp8e_enc_strm_code(ctx, task);
+    if (ret) {
+        mpp_err("failed to code vp8e stream ret %d\n", ret);
+        return ret;
+    }
     vp8e_vpu_frame_start(ctx);
 
     return MPP_OK;
@@ -478,9 +483,15 @@ MPP_RET hal_vp8e_vepu2_flush(void *hal)
 
 MPP_RET hal_vp8e_vepu2_control(void *hal, MpiCmd cmd, void *param)
 {
-    (void)hal;
-    (void)cmd;
-    (void)param;
+    MPP_RET ret = MPP_OK;
 
-    return MPP_OK;
+    switch (cmd) {
+    case MPP_ENC_GET_BUF_STAT : {
+        ret = hal_vp8e_get_buf_stat(hal, (MppEncBufStat *)param);
+    } break;
+    default : {
+    } break;
+    }
+
+    return ret;
 }
@@ -23,6 +23,8 @@
 #include "mpp_dec.h"
 #include "mpp_enc.h"
 #include "mpp_impl.h"
+#include "mpp_dev_sched.h"
+#include "mpp_dev_stat.h"
 
 #define MPP_DBG_FUNCTION                    (0x00000001)
 #define MPP_DBG_PACKET                      (0x00000002)
@@ -57,6 +59,7 @@
 #define MPP_ENC_NOTIFY_PACKET_DEQUEUE       (MPP_OUTPUT_DEQUEUE)
 #define MPP_ENC_NOTIFY_FRAME_DEQUEUE        (MPP_INPUT_DEQUEUE)
 #define MPP_ENC_NOTIFY_PACKET_ENQUEUE       (MPP_OUTPUT_ENQUEUE)
+#define MPP_ENC_NOTIFY_PRE_DONE             (0x00000010)
 #define MPP_ENC_RESET                       (MPP_RESET)
 
 /*
@@ -151,6 +154,11 @@ public:
     MppDec          mDec;
     MppEnc          mEnc;
 
+    /* hardware scheduler session shared by decoder / encoder hal */
+    MppDevSched     mSched;
+    /* hardware latency statistic recorded by decoder / encoder hal */
+    MppDevStat      mDevStat;
+
 private:
     void clear();
 
@@ -166,6 +174,11 @@ private:
     RK_U32          mParserFastMode;
     RK_U32          mParserNeedSplit;
     RK_U32          mParserInternalPts;     /* for MPEG2/MPEG4 */
+    RK_U32          mDecTaskCount;          /* hal task and register set count */
+
+    /* scheduler parameter which can be set before init */
+    MppSchedPriority mSchedPriority;
+    RK_S64          mSchedDeadline;
 
     /* backup extra packet for seek */
     MppPacket       mExtraPacket;
@@ -16,6 +16,7 @@
 
 #define MODULE_TAG "mpi"
 
+#include <limits.h>
 #include <string.h>
 
 #include "rk_mpi.h"
@@ -25,6 +26,7 @@
 
 #include "mpi_impl.h"
 #include "mpp_info.h"
+#include "mpp_parser.h"
 #include "mpp_common.h"
 #include "mpp_env.h"
 
@@ -547,3 +549,25 @@ void mpp_show_support_format()
     }
 }
 
+MPP_RET mpp_dec_probe(MppCodingType coding, void *data, size_t size,
+                      MppDecStreamInfo *info)
+{
+    MPP_RET ret = MPP_OK;
+
+    mpi_dbg_func("enter coding %d data %p size %d\n", coding, data, size);
+
+    if (NULL == data || NULL == info) {
+        mpp_err_f("invalid input data %p info %p\n", data, info);
+        return MPP_ERR_NULL_PTR;
+    }
+
+    memset(info, 0, sizeof(*info));
+    info->coding = coding;
+
+    /* parser takes signed size and header is found at the buffer beginning */
+    size = MPP_MIN(size, (size_t)INT_MAX);
+    ret = mpp_parser_probe(coding, (RK_U8 *)data, (RK_S32)size, info);
+
+    mpi_dbg_func("leave ret %d %dx%d\n", ret, info->width, info->height);
+    return ret;
+}
@@ -66,6 +66,8 @@ Mpp::Mpp()
       mInputTask(NULL),
       mDec(NULL),
       mEnc(NULL),
+      mSched(NULL),
+      mDevStat(NULL),
       mType(MPP_CTX_BUTT),
       mCoding(MPP_VIDEO_CodingUnused),
       mInitDone(0),
@@ -74,6 +76,9 @@ Mpp::Mpp()
       mParserFastMode(0),
       mParserNeedSplit(0),
       mParserInternalPts(0),
+      mDecTaskCount(0),
+      mSchedPriority(MPP_SCHED_PRIO_NORMAL),
+      mSchedDeadline(0),
       mExtraPacket(NULL),
       mDump(NULL)
 {
@@ -92,6 +97,15 @@ MPP_RET Mpp::init(MppCtxType type, MppCodingType coding)
 
     mType = type;
     mCoding = coding;
+
+    /* scheduler session must be ready before hal is created */
+    if (!mpp_dev_sched_init(&mSched, type, coding)) {
+        mpp_dev_sched_set_priority(mSched, mSchedPriority);
+        mpp_dev_sched_set_deadline(mSched, mSchedDeadline);
+    }
+
+    mpp_dev_stat_init(&mDevStat);
+
     switch (mType) {
     case MPP_CTX_DEC : {
         mPackets    = new mpp_list((node_destructor)mpp_packet_deinit);
@@ -121,6 +135,7 @@ MPP_RET Mpp::init(MppCtxType type, MppCodingType coding)
             mParserFastMode,
             mParserNeedSplit,
             mParserInternalPts,
+            mDecTaskCount,
             this,
         };
 
@@ -194,6 +209,16 @@ void Mpp::clear()
         }
     }
 
+    if (mSched) {
+        mpp_dev_sched_deinit(mSched);
+        mSched = NULL;
+    }
+
+    if (mDevStat) {
+        mpp_dev_stat_deinit(mDevStat);
+        mDevStat = NULL;
+    }
+
     if (mInputTaskQueue) {
         mpp_task_queue_deinit(mInputTaskQueue);
         mInputTaskQueue = NULL;
@@ -686,6 +711,61 @@ MPP_RET Mpp::control_mpp(MpiCmd cmd, MppParam param)
             mOutputTimeout = timeout;
     } break;
 
+    case MPP_SET_SCHED_PRIORITY : {
+        RK_S32 priority = (param) ? *((RK_S32 *)param) : MPP_SCHED_PRIO_NORMAL;
+
+        if (priority < MPP_SCHED_PRIO_BATCH || priority >= MPP_SCHED_PRIO_BUTT) {
+            mpp_err("invalid sched priority %d should be in range [%d, %d)\n",
+                    priority, MPP_SCHED_PRIO_BATCH, MPP_SCHED_PRIO_BUTT);
+            ret = MPP_ERR_VALUE;
+            break;
+        }
+
+        mSchedPriority = (MppSchedPriority)priority;
+        if (mSched)
+            ret = mpp_dev_sched_set_priority(mSched, mSchedPriority);
+    } break;
+    case MPP_SET_SCHED_DEADLINE : {
+        RK_S64 deadline = (param) ? *((RK_S64 *)param) : 0;
+
+        if (deadline < 0) {
+            mpp_err("invalid sched deadline %lld\n", deadline);
+            ret = MPP_ERR_VALUE;
+            break;
+        }
+
+        mSchedDeadline = deadline;
+        if (mSched)
+            ret = mpp_dev_sched_set_deadline(mSched, mSchedDeadline);
+    } break;
+    case MPP_GET_SCHED_STAT : {
+        if (NULL == mSched || NULL == param) {
+            mpp_err("sched stat is not available before init\n");
+            ret = MPP_NOK;
+            break;
+        }
+
+        ret = mpp_dev_sched_get_stat(mSched, (MppSchedStat *)param);
+    } break;
+    case MPP_GET_HW_LAT_STAT : {
+        if (NULL == mDevStat || NULL == param) {
+            mpp_err("hw latency stat is not available before init\n");
+            ret = MPP_NOK;
+            break;
+        }
+
+        ret = mpp_dev_stat_get(mDevStat, (MppHwLatStat *)param);
+    } break;
+    case MPP_RESET_HW_LAT_STAT : {
+        if (NULL == mDevStat) {
+            mpp_err("hw latency stat is not available before init\n");
+            ret = MPP_NOK;
+            break;
+        }
+
+        ret = mpp_dev_stat_reset(mDevStat);
+    } break;
+
     default : {
         ret = MPP_NOK;
     } break;
@@ -769,6 +849,11 @@ MPP_RET Mpp::control_dec(MpiCmd cmd, MppParam param)
         mParserFastMode = flag;
         ret = MPP_OK;
     } break;
+    case MPP_DEC_SET_TASK_COUNT: {
+        RK_U32 count = *((RK_U32 *)param);
+        mDecTaskCount = count;
+        ret = MPP_OK;
+    } break;
     case MPP_DEC_GET_STREAM_COUNT: {
         AutoMutex autoLock(mPackets->mutex());
         *((RK_S32 *)param) = mPackets->list_size();
@@ -776,6 +861,8 @@ MPP_RET Mpp::control_dec(MpiCmd cmd, MppParam param)
     } break;
     case MPP_DEC_GET_VPUMEM_USED_COUNT:
     case MPP_DEC_SET_OUTPUT_FORMAT:
+    case MPP_DEC_SET_OUTPUT_SCALE:
+    case MPP_DEC_SET_SKIP_MODE:
     case MPP_DEC_SET_DISABLE_ERROR:
     case MPP_DEC_SET_PRESENT_TIME_ORDER:
     case MPP_DEC_SET_IMMEDIATE_OUT:
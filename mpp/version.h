@@ -0,0 +1,27 @@
+/*
+ * Copyright 2010 Rockchip Electronics S.LSI Co. LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __VERSION_H__
+#define __VERSION_H__
+
+#define MPP_VERSION             "7893d8ce42a3f0fab2687ac6d39ef5e0a154a140"
+#define MPP_AUTHOR              "agent"
+#define MPP_DATE                ""
+#define MPP_ONE_LINE            "7893d8c author: agent [user-050] fix: log vproc task failure on eos and keep deinterlace jobs in flight when idle"
+#define MPP_VER_NUM             "-1"
+
+#endif /*__VERSION_H__*/
+
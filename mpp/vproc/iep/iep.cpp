@@ -605,6 +605,23 @@ MPP_RET iep_control(IepCtx ctx, IepCmd cmd, void *param)
 
         ret = (MPP_RET)ops_ret;
     } break;
+    case IEP_CMD_RUN_ASYNC : {
+        check_msg_image(msg);
+
+        // NOTE: caller should limit task in flight to avoid iep task queue full
+        int ops_ret = ioctl(impl->fd, IEP_SET_PARAMETER, msg);
+        if (ops_ret < 0)
+            mpp_err("pid %d ioctl IEP_SET_PARAMETER failure\n", impl->pid);
+
+        ret = (MPP_RET)ops_ret;
+    } break;
+    case IEP_CMD_WAIT : {
+        int ops_ret = ioctl(impl->fd, IEP_GET_RESULT_SYNC, 0);
+        if (ops_ret)
+            mpp_err("pid %d get result failure\n", impl->pid);
+
+        ret = (MPP_RET)ops_ret;
+    } break;
     case IEP_CMD_QUERY_CAP : {
         if (param)
             *(IepHwCap **)param = &impl->cap;
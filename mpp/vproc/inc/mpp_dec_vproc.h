@@ -37,7 +37,13 @@ extern "C" {
  * dec_vproc_deinit - stop thread and destory context
  * dec_vproc_start  - start thread processing
  * dec_vproc_signal - signal thread that one frame has be pushed for process
+ * dec_vproc_get_task - wait for an idle task to push frame, return error when
+ *                    thread is stopped
  * dec_vproc_reset  - reset process thread and discard all input
+ *
+ * Up to vproc_task_num (env, default 2, max 4) deinterlace jobs are in flight
+ * on iep and output in order. When iep is not available env vproc_sw_dei
+ * enables software deinterlace (1 - bob, 2 - linear).
  */
 
 MPP_RET dec_vproc_init(MppDecVprocCtx *ctx, MppDecVprocCfg *cfg);
@@ -46,6 +52,7 @@ MPP_RET dec_vproc_deinit(MppDecVprocCtx ctx);
 MPP_RET dec_vproc_start(MppDecVprocCtx ctx);
 MPP_RET dec_vproc_stop(MppDecVprocCtx ctx);
 MPP_RET dec_vproc_signal(MppDecVprocCtx ctx);
+MPP_RET dec_vproc_get_task(MppDecVprocCtx ctx, HalTaskHnd *hnd);
 MPP_RET dec_vproc_reset(MppDecVprocCtx ctx);
 
 #ifdef __cplusplus
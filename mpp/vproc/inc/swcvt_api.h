@@ -0,0 +1,65 @@
+/*
+ * Copyright 2018 Rockchip Electronics Co. LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __SWCVT_API_H__
+#define __SWCVT_API_H__
+
+#include "rk_type.h"
+#include "mpp_err.h"
+#include "mpp_frame.h"
+
+/*
+ * Software colour convert used as fallback when rga is not available or busy.
+ *
+ * Destination is always YUV420SP (NV12) with its own stride. Supported source:
+ * YUV420SP / YUV420SP_VU / YUV420P / YUV422SP / YUV422P / YUV422_YUYV /
+ * YUV422_UYVY / RGB888 / BGR888 / ARGB8888 / ABGR8888.
+ *
+ * Byte order in memory of rgb format follows the rga / vpu mapping:
+ * RGB888 - R G B, BGR888 - B G R, ARGB8888 - R G B A, ABGR8888 - B G R A.
+ * rgb to yuv uses BT.601 limited range.
+ *
+ * Horizontal stride of frame is in pixel like rga. The frame is split into
+ * row slices and converted by worker threads. Thread number is set by env
+ * swcvt_thread_num (default 2, 0 means convert in caller thread).
+ */
+typedef enum SwcvtCmd_e {
+    SWCVT_CMD_INIT,                         // reset source and destination
+    SWCVT_CMD_SET_SRC,                      // config source image info
+    SWCVT_CMD_SET_DST,                      // config destination image info
+
+    // process trigger command
+    SWCVT_CMD_RUN_SYNC          = 0x1000,   // start and wait process done
+    SWCVT_CMD_RUN_ASYNC,                    // start process and return
+    SWCVT_CMD_WAIT,                         // wait async process done
+} SwcvtCmd;
+
+typedef void* SwcvtCtx;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+MPP_RET swcvt_init(SwcvtCtx *ctx);
+MPP_RET swcvt_deinit(SwcvtCtx ctx);
+
+MPP_RET swcvt_control(SwcvtCtx ctx, SwcvtCmd cmd, void *param);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __SWCVT_API_H__ */
@@ -0,0 +1,79 @@
+/*
+ * Copyright 2018 Rockchip Electronics Co. LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __SWDEI_API_H__
+#define __SWDEI_API_H__
+
+#include "rk_type.h"
+#include "mpp_err.h"
+#include "mpp_buffer.h"
+
+/*
+ * Software deinterlace used as fallback when iep is not available.
+ *
+ * One task builds a progressive YUV420SP (NV12) frame from one field of the
+ * source frame. Source and destination share the same size and stride. Bob
+ * mode repeats each field line and linear mode interpolates the missing line
+ * from the field lines above and below.
+ *
+ * Async tasks are processed by one worker thread in submit order and each
+ * wait returns when the oldest not waited task is done. At most
+ * SWDEI_TASK_MAX tasks can be in flight. Env swdei_thread_num = 0 processes
+ * the task in the caller thread on submit.
+ */
+#define SWDEI_TASK_MAX              8
+
+typedef enum SwdeiMode_e {
+    SWDEI_MODE_BOB,
+    SWDEI_MODE_LINEAR,
+    SWDEI_MODE_BUTT,
+} SwdeiMode;
+
+typedef struct SwdeiTask_t {
+    MppBuffer       src;
+    MppBuffer       dst;
+    SwdeiMode       mode;
+    RK_S32          width;
+    RK_S32          height;
+    RK_S32          hor_stride;
+    RK_S32          ver_stride;
+    /* field kept from source, 0 - top field, 1 - bottom field */
+    RK_U32          bottom;
+} SwdeiTask;
+
+typedef enum SwdeiCmd_e {
+    // process trigger command, param is SwdeiTask
+    SWDEI_CMD_RUN_SYNC          = 0x1000,   // start and wait process done
+    SWDEI_CMD_RUN_ASYNC,                    // queue process and return
+    SWDEI_CMD_WAIT,                         // wait the oldest async process done
+} SwdeiCmd;
+
+typedef void* SwdeiCtx;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+MPP_RET swdei_init(SwdeiCtx *ctx);
+MPP_RET swdei_deinit(SwdeiCtx ctx);
+
+MPP_RET swdei_control(SwdeiCtx ctx, SwdeiCmd cmd, void *param);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __SWDEI_API_H__ */
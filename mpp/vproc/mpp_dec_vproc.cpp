@@ -27,6 +27,7 @@
 #include "mpp_frame_impl.h"
 #include "mpp_dec_vproc.h"
 #include "iep_api.h"
+#include "swdei_api.h"
 
 #define vproc_dbg(flag, fmt, ...) \
     do { \
@@ -49,8 +50,32 @@
 #define vproc_dbg_reset(fmt, ...)  \
     vproc_dbg_f(VPROC_DBG_RESET, fmt, ## __VA_ARGS__);
 
+/* max deinterlace job in flight, swdei queue holds two task for each job */
+#define VPROC_JOB_MAX           4
+#define VPROC_JOB_DEFAULT       2
+/* idle time in ms before the oldest job in flight is output */
+#define VPROC_IDLE_WAIT_MS      10
+
 RK_U32 vproc_debug = 0;
 
+/*
+ * One deinterlace job started on iep or swdei and not output yet.
+ * The output frames copy the info of frm. The previous frame used as the
+ * reference field is held by the job and released when the job is done.
+ */
+typedef struct VprocJob_t {
+    MppFrame            frm;
+    MppBuffer           dst[2];
+    RK_S64              pts[2];
+    RK_S32              count;
+
+    // number of started process to wait
+    RK_S32              wait;
+
+    RK_S32              rel_idx;
+    MppFrame            rel_frm;
+} VprocJob;
+
 typedef struct MppDecVprocCtxImpl_t {
     Mpp                 *mpp;
     HalTaskGroup        task_group;
@@ -62,6 +87,16 @@ typedef struct MppDecVprocCtxImpl_t {
     IepCtx              iep_ctx;
     IepCmdParamDeiCfg   dei_cfg;
 
+    // software deinterlace when iep is not available
+    SwdeiCtx            swdei_ctx;
+    SwdeiMode           swdei_mode;
+
+    // job fifo only accessed by vproc thread
+    VprocJob            jobs[VPROC_JOB_MAX];
+    RK_U32              job_wr;
+    RK_U32              job_rd;
+    RK_U32              job_max;
+
     // slot index for previous frame and current frame
     RK_S32              prev_idx;
     MppFrame            prev_frm;
@@ -92,6 +127,17 @@ static void dec_vproc_put_frame(Mpp *mpp, MppFrame frame, MppBuffer buf, RK_S64
     list->unlock();
 }
 
+static void dec_vproc_put_slot(MppDecVprocCtxImpl *ctx, RK_S32 index, MppFrame frm)
+{
+    if (frm) {
+        MppBuffer buf = mpp_frame_get_buffer(frm);
+        if (buf)
+            mpp_buffer_put(buf);
+    }
+    if (index >= 0)
+        mpp_buf_slot_clr_flag(ctx->slots, index, SLOT_QUEUE_USE);
+}
+
 static void dec_vproc_clr_prev(MppDecVprocCtxImpl *ctx)
 {
     if (vproc_debug & VPROC_DBG_STATUS) {
@@ -104,18 +150,84 @@ static void dec_vproc_clr_prev(MppDecVprocCtxImpl *ctx)
             mpp_log("clearing nothing\n");
     }
 
-    if (ctx->prev_frm) {
-        MppBuffer buf = mpp_frame_get_buffer(ctx->prev_frm);
-        if (buf)
-            mpp_buffer_put(buf);
-    }
-    if (ctx->prev_idx >= 0)
-        mpp_buf_slot_clr_flag(ctx->slots, ctx->prev_idx, SLOT_QUEUE_USE);
+    dec_vproc_put_slot(ctx, ctx->prev_idx, ctx->prev_frm);
 
     ctx->prev_idx = -1;
     ctx->prev_frm = NULL;
 }
 
+static void dec_vproc_job_done(MppDecVprocCtxImpl *ctx, RK_U32 discard)
+{
+    VprocJob *job = &ctx->jobs[ctx->job_rd % VPROC_JOB_MAX];
+    MPP_RET ret = MPP_OK;
+    RK_S32 i;
+
+    for (i = 0; i < job->wait; i++) {
+        if (ctx->iep_ctx)
+            ret = iep_control(ctx->iep_ctx, IEP_CMD_WAIT, NULL);
+        else
+            ret = swdei_control(ctx->swdei_ctx, SWDEI_CMD_WAIT, NULL);
+
+        if (ret)
+            mpp_log_f("wait job %d failed %d\n", ctx->job_rd, ret);
+    }
+
+    vproc_dbg_status("job %d done output %d discard %d\n",
+                     ctx->job_rd, job->count, discard);
+
+    for (i = 0; i < job->count; i++) {
+        if (discard)
+            mpp_buffer_put(job->dst[i]);
+        else
+            dec_vproc_put_frame(ctx->mpp, job->frm, job->dst[i], job->pts[i]);
+    }
+
+    dec_vproc_put_slot(ctx, job->rel_idx, job->rel_frm);
+    memset(job, 0, sizeof(*job));
+    ctx->job_rd++;
+}
+
+// wait all job in flight and output them in start order
+static void dec_vproc_drain(MppDecVprocCtxImpl *ctx, RK_U32 discard)
+{
+    while (ctx->job_rd != ctx->job_wr)
+        dec_vproc_job_done(ctx, discard);
+}
+
+static VprocJob *dec_vproc_get_job(MppDecVprocCtxImpl *ctx)
+{
+    VprocJob *job = NULL;
+
+    if (ctx->job_wr - ctx->job_rd >= ctx->job_max)
+        dec_vproc_job_done(ctx, 0);
+
+    job = &ctx->jobs[ctx->job_wr % VPROC_JOB_MAX];
+    memset(job, 0, sizeof(*job));
+    job->rel_idx = -1;
+
+    return job;
+}
+
+static void dec_vproc_job_add(VprocJob *job, MppBuffer buf, RK_S64 pts)
+{
+    mpp_assert(job->count < (RK_S32)MPP_ARRAY_ELEMS(job->dst));
+
+    job->dst[job->count] = buf;
+    job->pts[job->count] = pts;
+    job->count++;
+}
+
+// set task idle and wake up decoder waiting for idle task
+static void dec_vproc_release_task(MppDecVprocCtxImpl *ctx, HalTaskHnd task)
+{
+    MppThread *thd = ctx->thd;
+
+    thd->lock(THREAD_OUTPUT);
+    hal_task_hnd_set_status(task, TASK_IDLE);
+    thd->signal(THREAD_OUTPUT);
+    thd->unlock(THREAD_OUTPUT);
+}
+
 static void dec_vproc_reset_queue(MppDecVprocCtxImpl *ctx)
 {
     MppThread *thd = ctx->thd;
@@ -153,23 +265,28 @@ static void dec_vproc_set_img(MppDecVprocCtxImpl *ctx, IepImg *img, RK_S32 fd, I
         mpp_log_f("control %08x failed %d\n", cmd, ret);
 }
 
-static MppBuffer dec_vproc_get_buffer(MppBufferGroup group, size_t size)
+static MppBuffer dec_vproc_get_buffer(MppDecVprocCtxImpl *ctx, size_t size)
 {
+    MppBufferGroup group = ctx->mpp->mFrameGroup;
     MppBuffer buf = NULL;
 
     do {
         mpp_buffer_get(group, &buf, size);
-        if (NULL == buf)
-            usleep(2000);
-        else
+        if (buf)
             break;
+
+        // finished job returns its previous frame buffer to the group
+        if (ctx->job_rd != ctx->job_wr)
+            dec_vproc_job_done(ctx, 0);
+        else
+            usleep(2000);
     } while (1);
 
     return buf;
 }
 
 // start deinterlace hardware
-static void dec_vproc_start_dei(MppDecVprocCtxImpl *ctx, RK_U32 mode)
+static void dec_vproc_start_dei(MppDecVprocCtxImpl *ctx, VprocJob *job, RK_U32 mode)
 {
     ctx->dei_cfg.dei_field_order =
         (mode & MPP_FRAME_FLAG_TOP_FIRST) ?
@@ -180,9 +297,141 @@ static void dec_vproc_start_dei(MppDecVprocCtxImpl *ctx, RK_U32 mode)
     if (ret)
         mpp_log_f("IEP_CMD_SET_DEI_CFG failed %d\n", ret);
 
-    ret = iep_control(ctx->iep_ctx, IEP_CMD_RUN_SYNC, NULL);
+    ret = iep_control(ctx->iep_ctx, IEP_CMD_RUN_ASYNC, NULL);
     if (ret)
-        mpp_log_f("IEP_CMD_RUN_SYNC failed %d\n", ret);
+        mpp_log_f("IEP_CMD_RUN_ASYNC failed %d\n", ret);
+    else
+        job->wait++;
+}
+
+static void dec_vproc_start_iep(MppDecVprocCtxImpl *ctx, VprocJob *job, MppFrame frm)
+{
+    RK_U32 mode = mpp_frame_get_mode(frm);
+    MppBuffer buf = mpp_frame_get_buffer(frm);
+    MppBuffer dst0 = NULL;
+    MppBuffer dst1 = NULL;
+    int fd = -1;
+    size_t buf_size = mpp_buffer_get_size(buf);
+    IepImg img;
+
+    // setup source IepImg
+    dec_vproc_set_img_fmt(&img, frm);
+
+    MPP_RET ret = iep_control(ctx->iep_ctx, IEP_CMD_INIT, NULL);
+    if (ret)
+        mpp_log_f("IEP_CMD_INIT failed %d\n", ret);
+
+    // setup destination IepImg with new buffer
+    // NOTE: when deinterlace is enabled parser thread will reserve
+    //       more buffer than normal case
+    if (ctx->prev_frm) {
+        // 4 in 2 out case
+        vproc_dbg_status("4 field in and 2 frame out\n");
+        RK_S64 prev_pts = mpp_frame_get_pts(ctx->prev_frm);
+        RK_S64 curr_pts = mpp_frame_get_pts(frm);
+        RK_S64 first_pts = (prev_pts + curr_pts) / 2;
+
+        buf = mpp_frame_get_buffer(ctx->prev_frm);
+        fd = mpp_buffer_get_fd(buf);
+        dec_vproc_set_img(ctx, &img, fd, IEP_CMD_SET_SRC);
+
+        // setup dst 0
+        dst0 = dec_vproc_get_buffer(ctx, buf_size);
+        mpp_assert(dst0);
+        fd = mpp_buffer_get_fd(dst0);
+        dec_vproc_set_img(ctx, &img, fd, IEP_CMD_SET_DST);
+
+        buf = mpp_frame_get_buffer(frm);
+        fd = mpp_buffer_get_fd(buf);
+        dec_vproc_set_img(ctx, &img, fd, IEP_CMD_SET_DEI_SRC1);
+
+        // setup dst 1
+        dst1 = dec_vproc_get_buffer(ctx, buf_size);
+        mpp_assert(dst1);
+        fd = mpp_buffer_get_fd(dst1);
+        dec_vproc_set_img(ctx, &img, fd, IEP_CMD_SET_DEI_DST1);
+
+        ctx->dei_cfg.dei_mode = IEP_DEI_MODE_I4O2;
+
+        // start hardware
+        dec_vproc_start_dei(ctx, job, mode);
+
+        // NOTE: we need to process pts here
+        if (mode & MPP_FRAME_FLAG_TOP_FIRST) {
+            dec_vproc_job_add(job, dst0, first_pts);
+            dec_vproc_job_add(job, dst1, curr_pts);
+        } else {
+            dec_vproc_job_add(job, dst1, first_pts);
+            dec_vproc_job_add(job, dst0, curr_pts);
+        }
+    } else {
+        // 2 in 1 out case
+        vproc_dbg_status("2 field in and 1 frame out\n");
+        fd = mpp_buffer_get_fd(buf);
+        dec_vproc_set_img(ctx, &img, fd, IEP_CMD_SET_SRC);
+
+        // setup dst 0
+        dst0 = dec_vproc_get_buffer(ctx, buf_size);
+        mpp_assert(dst0);
+        fd = mpp_buffer_get_fd(dst0);
+        dec_vproc_set_img(ctx, &img, fd, IEP_CMD_SET_DST);
+
+        ctx->dei_cfg.dei_mode = IEP_DEI_MODE_I2O1;
+
+        // start hardware
+        dec_vproc_start_dei(ctx, job, mode);
+        dec_vproc_job_add(job, dst0, -1);
+    }
+}
+
+static void dec_vproc_start_swdei_field(MppDecVprocCtxImpl *ctx, VprocJob *job,
+                                        SwdeiTask *task, MppFrame src, RK_U32 bottom,
+                                        RK_S64 pts)
+{
+    MppBuffer buf = mpp_frame_get_buffer(src);
+    MppBuffer dst = dec_vproc_get_buffer(ctx, mpp_buffer_get_size(buf));
+
+    task->src = buf;
+    task->dst = dst;
+    task->bottom = bottom;
+
+    MPP_RET ret = swdei_control(ctx->swdei_ctx, SWDEI_CMD_RUN_ASYNC, task);
+    if (ret)
+        mpp_log_f("SWDEI_CMD_RUN_ASYNC failed %d\n", ret);
+    else
+        job->wait++;
+
+    dec_vproc_job_add(job, dst, pts);
+}
+
+/*
+ * Software deinterlace builds one frame from one field. The first field in
+ * time of current frame is always output. When previous frame exists its
+ * second field is output before with the middle pts like iep 4 in 2 out.
+ */
+static void dec_vproc_start_swdei(MppDecVprocCtxImpl *ctx, VprocJob *job, MppFrame frm)
+{
+    RK_U32 first = (mpp_frame_get_mode(frm) & MPP_FRAME_FLAG_TOP_FIRST) ? 0 : 1;
+    SwdeiTask task;
+
+    task.mode = ctx->swdei_mode;
+    task.width = mpp_frame_get_width(frm);
+    task.height = mpp_frame_get_height(frm);
+    task.hor_stride = mpp_frame_get_hor_stride(frm);
+    task.ver_stride = mpp_frame_get_ver_stride(frm);
+
+    if (ctx->prev_frm) {
+        RK_S64 prev_pts = mpp_frame_get_pts(ctx->prev_frm);
+        RK_S64 curr_pts = mpp_frame_get_pts(frm);
+
+        vproc_dbg_status("2 field in and 2 frame out by software\n");
+        dec_vproc_start_swdei_field(ctx, job, &task, ctx->prev_frm, !first,
+                                    (prev_pts + curr_pts) / 2);
+        dec_vproc_start_swdei_field(ctx, job, &task, frm, first, curr_pts);
+    } else {
+        vproc_dbg_status("1 field in and 1 frame out by software\n");
+        dec_vproc_start_swdei_field(ctx, job, &task, frm, first, -1);
+    }
 }
 
 static void *dec_vproc_thread(void *data)
@@ -193,7 +442,6 @@ static void *dec_vproc_thread(void *data)
     Mpp *mpp = ctx->mpp;
     MppDecImpl *dec = (MppDecImpl *)mpp->mDec;
     MppBufSlots slots = dec->frame_slots;
-    IepImg img;
 
     HalTaskHnd task = NULL;
     HalTaskInfo task_info;
@@ -203,6 +451,8 @@ static void *dec_vproc_thread(void *data)
 
     while (1) {
         MPP_RET ret = MPP_OK;
+        RK_U32 drain = 0;
+        RK_U32 done = 0;
 
         {
             AutoMutex autolock(thd->mutex());
@@ -211,17 +461,42 @@ static void *dec_vproc_thread(void *data)
                 break;
 
             if (hal_task_get_hnd(tasks, TASK_PROCESSING, &task)) {
-                // process all task then do reset process
-                thd->lock(THREAD_CONTROL);
-                if (ctx->reset)
-                    dec_vproc_reset_queue(ctx);
-                thd->unlock(THREAD_CONTROL);
-
-                thd->wait();
-                continue;
+                /*
+                 * Keep jobs in flight when idle so that they overlap with
+                 * the next task. Reset drains all jobs. When no task comes
+                 * in time the oldest job is output to not hold its frame on
+                 * a stalled stream or a decoder waiting for its slot.
+                 */
+                if (ctx->job_rd != ctx->job_wr) {
+                    if (ctx->reset)
+                        drain = 1;
+                    else if (thd->timedwait(VPROC_IDLE_WAIT_MS))
+                        done = 1;
+                    else
+                        continue;
+                } else {
+                    // process all task then do reset process
+                    thd->lock(THREAD_CONTROL);
+                    if (ctx->reset)
+                        dec_vproc_reset_queue(ctx);
+                    thd->unlock(THREAD_CONTROL);
+
+                    thd->wait();
+                    continue;
+                }
             }
         }
 
+        if (drain) {
+            dec_vproc_drain(ctx, dec->reset_flag);
+            continue;
+        }
+
+        if (done) {
+            dec_vproc_job_done(ctx, dec->reset_flag);
+            continue;
+        }
+
         if (task) {
             ret = hal_task_hnd_get_info(task, &task_info);
 
@@ -237,11 +512,12 @@ static void *dec_vproc_thread(void *data)
 
                 mpp_frame_init(&frm);
                 mpp_frame_set_eos(frm, eos);
+                dec_vproc_drain(ctx, 0);
                 dec_vproc_put_frame(mpp, frm, NULL, -1);
                 dec_vproc_clr_prev(ctx);
                 mpp_frame_deinit(&frm);
 
-                hal_task_hnd_set_status(task, TASK_IDLE);
+                dec_vproc_release_task(ctx, task);
                 continue;
             }
 
@@ -249,10 +525,11 @@ static void *dec_vproc_thread(void *data)
 
             if (change) {
                 vproc_dbg_status("info change\n");
+                dec_vproc_drain(ctx, 0);
                 dec_vproc_put_frame(mpp, frm, NULL, -1);
                 dec_vproc_clr_prev(ctx);
 
-                hal_task_hnd_set_status(task, TASK_IDLE);
+                dec_vproc_release_task(ctx, task);
                 continue;
             }
 
@@ -260,96 +537,48 @@ static void *dec_vproc_thread(void *data)
             mpp_buf_slot_dequeue(slots, &tmp, QUEUE_DEINTERLACE);
             mpp_assert(tmp == index);
 
-            if (!dec->reset_flag && ctx->iep_ctx) {
-                MppBufferGroup group = mpp->mFrameGroup;
-                RK_U32 mode = mpp_frame_get_mode(frm);
-                MppBuffer buf = mpp_frame_get_buffer(frm);
-                MppBuffer dst0 = NULL;
-                MppBuffer dst1 = NULL;
-                int fd = -1;
-                size_t buf_size = mpp_buffer_get_size(buf);
-
-                // setup source IepImg
-                dec_vproc_set_img_fmt(&img, frm);
-
-                ret = iep_control(ctx->iep_ctx, IEP_CMD_INIT, NULL);
-                if (ret)
-                    mpp_log_f("IEP_CMD_INIT failed %d\n", ret);
-
-                // setup destination IepImg with new buffer
-                // NOTE: when deinterlace is enabled parser thread will reserve
-                //       more buffer than normal case
-                if (ctx->prev_frm) {
-                    // 4 in 2 out case
-                    vproc_dbg_status("4 field in and 2 frame out\n");
-                    RK_S64 prev_pts = mpp_frame_get_pts(ctx->prev_frm);
-                    RK_S64 curr_pts = mpp_frame_get_pts(frm);
-                    RK_S64 first_pts = (prev_pts + curr_pts) / 2;
-
-                    buf = mpp_frame_get_buffer(ctx->prev_frm);
-                    fd = mpp_buffer_get_fd(buf);
-                    dec_vproc_set_img(ctx, &img, fd, IEP_CMD_SET_SRC);
-
-                    // setup dst 0
-                    dst0 = dec_vproc_get_buffer(group, buf_size);
-                    mpp_assert(dst0);
-                    fd = mpp_buffer_get_fd(dst0);
-                    dec_vproc_set_img(ctx, &img, fd, IEP_CMD_SET_DST);
-
-                    buf = mpp_frame_get_buffer(frm);
-                    fd = mpp_buffer_get_fd(buf);
-                    dec_vproc_set_img(ctx, &img, fd, IEP_CMD_SET_DEI_SRC1);
-
-                    // setup dst 1
-                    dst1 = dec_vproc_get_buffer(group, buf_size);
-                    mpp_assert(dst1);
-                    fd = mpp_buffer_get_fd(dst1);
-                    dec_vproc_set_img(ctx, &img, fd, IEP_CMD_SET_DEI_DST1);
-
-                    ctx->dei_cfg.dei_mode = IEP_DEI_MODE_I4O2;
-
-                    // start hardware
-                    dec_vproc_start_dei(ctx, mode);
-
-                    // NOTE: we need to process pts here
-                    if (mode & MPP_FRAME_FLAG_TOP_FIRST) {
-                        dec_vproc_put_frame(mpp, frm, dst0, first_pts);
-                        dec_vproc_put_frame(mpp, frm, dst1, curr_pts);
-                    } else {
-                        dec_vproc_put_frame(mpp, frm, dst1, first_pts);
-                        dec_vproc_put_frame(mpp, frm, dst0, curr_pts);
-                    }
-                } else {
-                    // 2 in 1 out case
-                    vproc_dbg_status("2 field in and 1 frame out\n");
-                    buf = mpp_frame_get_buffer(frm);
-                    fd = mpp_buffer_get_fd(buf);
-                    dec_vproc_set_img(ctx, &img, fd, IEP_CMD_SET_SRC);
-
-                    // setup dst 0
-                    dst0 = dec_vproc_get_buffer(group, buf_size);
-                    mpp_assert(dst0);
-                    fd = mpp_buffer_get_fd(dst0);
-                    dec_vproc_set_img(ctx, &img, fd, IEP_CMD_SET_DST);
-
-                    ctx->dei_cfg.dei_mode = IEP_DEI_MODE_I2O1;
-
-                    // start hardware
-                    dec_vproc_start_dei(ctx, mode);
-                    dec_vproc_put_frame(mpp, frm, dst0, -1);
-                }
+            if (!dec->reset_flag && (ctx->iep_ctx || ctx->swdei_ctx)) {
+                VprocJob *job = dec_vproc_get_job(ctx);
+
+                job->frm = frm;
+                if (ctx->iep_ctx)
+                    dec_vproc_start_iep(ctx, job, frm);
+                else
+                    dec_vproc_start_swdei(ctx, job, frm);
+
+                // previous frame is still read by the job
+                job->rel_idx = ctx->prev_idx;
+                job->rel_frm = ctx->prev_frm;
+                ctx->prev_idx = -1;
+                ctx->prev_frm = NULL;
+
+                vproc_dbg_status("job %d start output %d\n", ctx->job_wr, job->count);
+                ctx->job_wr++;
+            } else {
+                dec_vproc_drain(ctx, dec->reset_flag);
             }
 
             dec_vproc_clr_prev(ctx);
             ctx->prev_idx = index;
             ctx->prev_frm = frm;
 
-            if (eos)
+            if (eos) {
+                dec_vproc_drain(ctx, 0);
                 dec_vproc_clr_prev(ctx);
+            }
 
-            hal_task_hnd_set_status(task, TASK_IDLE);
+            // task is free once the job is started
+            dec_vproc_release_task(ctx, task);
         }
     }
+
+    dec_vproc_drain(ctx, 1);
+
+    // wake up decoder waiting for idle task
+    thd->lock(THREAD_OUTPUT);
+    thd->signal(THREAD_OUTPUT);
+    thd->unlock(THREAD_OUTPUT);
+
     mpp_dbg(MPP_DBG_INFO, "mpp_dec_post_proc_thread exited\n");
 
     return NULL;
@@ -358,6 +587,8 @@ static void *dec_vproc_thread(void *data)
 MPP_RET dec_vproc_init(MppDecVprocCtx *ctx, MppDecVprocCfg *cfg)
 {
     MPP_RET ret = MPP_OK;
+    RK_U32 job_max = VPROC_JOB_DEFAULT;
+    RK_U32 sw_dei = 0;
     if (NULL == ctx || NULL == cfg || NULL == cfg->mpp) {
         mpp_err_f("found NULL input ctx %p mpp %p\n", ctx, cfg->mpp);
         return MPP_ERR_NULL_PTR;
@@ -365,6 +596,8 @@ MPP_RET dec_vproc_init(MppDecVprocCtx *ctx, MppDecVprocCfg *cfg)
 
     vproc_dbg_func("in\n");
     mpp_env_get_u32("vproc_debug", &vproc_debug, 0);
+    mpp_env_get_u32("vproc_task_num", &job_max, VPROC_JOB_DEFAULT);
+    mpp_env_get_u32("vproc_sw_dei", &sw_dei, 0);
 
     *ctx = NULL;
 
@@ -385,7 +618,16 @@ MPP_RET dec_vproc_init(MppDecVprocCtx *ctx, MppDecVprocCfg *cfg)
         return MPP_ERR_MALLOC;
     }
     cfg->task_group = p->task_group;
+    p->job_max = MPP_CLIP3(1, VPROC_JOB_MAX, job_max);
     ret = iep_init(&p->iep_ctx);
+    if (ret && sw_dei) {
+        // 1 - bob, 2 - linear
+        p->swdei_mode = (sw_dei > 1) ? SWDEI_MODE_LINEAR : SWDEI_MODE_BOB;
+        ret = swdei_init(&p->swdei_ctx);
+        if (!ret)
+            mpp_log("iep is not available, use software deinterlace mode %d\n",
+                    p->swdei_mode);
+    }
     if (!p->thd || ret) {
         mpp_err("failed to create context\n");
         if (p->thd) {
@@ -398,6 +640,11 @@ MPP_RET dec_vproc_init(MppDecVprocCtx *ctx, MppDecVprocCfg *cfg)
             p->iep_ctx = NULL;
         }
 
+        if (p->swdei_ctx) {
+            swdei_deinit(p->swdei_ctx);
+            p->swdei_ctx = NULL;
+        }
+
         if (p->task_group) {
             hal_task_group_deinit(p->task_group);
             p->task_group = NULL;
@@ -448,6 +695,11 @@ MPP_RET dec_vproc_deinit(MppDecVprocCtx ctx)
         p->iep_ctx = NULL;
     }
 
+    if (p->swdei_ctx) {
+        swdei_deinit(p->swdei_ctx);
+        p->swdei_ctx = NULL;
+    }
+
     if (p->task_group) {
         hal_task_group_deinit(p->task_group);
         p->task_group = NULL;
@@ -516,6 +768,37 @@ MPP_RET dec_vproc_signal(MppDecVprocCtx ctx)
     return MPP_OK;
 }
 
+MPP_RET dec_vproc_get_task(MppDecVprocCtx ctx, HalTaskHnd *hnd)
+{
+    if (NULL == ctx || NULL == hnd) {
+        mpp_err_f("found NULL input ctx %p hnd %p\n", ctx, hnd);
+        return MPP_ERR_NULL_PTR;
+    }
+
+    MppDecVprocCtxImpl *p = (MppDecVprocCtxImpl *)ctx;
+    MppThread *thd = p->thd;
+    MPP_RET ret = MPP_NOK;
+
+    if (NULL == thd)
+        return MPP_NOK;
+
+    // vproc thread signals on each task done and on exit
+    thd->lock(THREAD_OUTPUT);
+    while (MPP_OK != (ret = hal_task_get_hnd(p->task_group, TASK_IDLE, hnd))) {
+        MppThreadStatus status = thd->get_status();
+
+        if (MPP_THREAD_RUNNING != status && MPP_THREAD_WAITING != status) {
+            mpp_err_f("vproc thread is not running\n");
+            break;
+        }
+
+        thd->wait(THREAD_OUTPUT);
+    }
+    thd->unlock(THREAD_OUTPUT);
+
+    return ret;
+}
+
 MPP_RET dec_vproc_reset(MppDecVprocCtx ctx)
 {
     if (NULL == ctx) {
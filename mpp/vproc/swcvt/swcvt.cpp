@@ -0,0 +1,639 @@
+/*
+ * Copyright 2018 Rockchip Electronics Co. LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define MODULE_TAG "swcvt"
+
+#include <string.h>
+
+#include "mpp_env.h"
+#include "mpp_mem.h"
+#include "mpp_log.h"
+#include "mpp_common.h"
+#include "mpp_thread.h"
+#include "mpp_buffer.h"
+
+#include "swcvt_api.h"
+
+#define SWCVT_DBG_FUNCTION      (0x00000001)
+#define SWCVT_DBG_INFO          (0x00000002)
+
+#define swcvt_dbg(flag, fmt, ...)   _mpp_dbg(swcvt_debug, flag, fmt, ## __VA_ARGS__)
+#define swcvt_dbg_func(fmt, ...)    _mpp_dbg_f(swcvt_debug, SWCVT_DBG_FUNCTION, fmt, ## __VA_ARGS__)
+#define swcvt_dbg_info(fmt, ...)    _mpp_dbg(swcvt_debug, SWCVT_DBG_INFO, fmt, ## __VA_ARGS__)
+
+#define SWCVT_THREAD_MAX        8
+#define SWCVT_THREAD_DEFAULT    2
+
+static RK_U32 swcvt_debug = 0;
+
+typedef struct SwcvtImg_t {
+    RK_U8           *ptr;
+    MppFrameFormat  fmt;
+    RK_S32          width;
+    RK_S32          height;
+    RK_S32          hor_stride;
+    RK_S32          ver_stride;
+} SwcvtImg;
+
+/* convert luma row y and y + 1 and chroma row y / 2 */
+typedef void (*SwcvtRowFunc)(const SwcvtImg *src, const SwcvtImg *dst, RK_S32 y);
+
+struct SwcvtCtxImpl_t;
+
+typedef struct SwcvtWorker_t {
+    struct SwcvtCtxImpl_t   *impl;
+    MppThread               *thread;
+
+    /* row slice posted to worker, protected by THREAD_WORK lock */
+    RK_S32                  job;
+    RK_S32                  y_start;
+    RK_S32                  y_end;
+} SwcvtWorker;
+
+typedef struct SwcvtCtxImpl_t {
+    SwcvtImg        src;
+    SwcvtImg        dst;
+    SwcvtRowFunc    func;
+
+    RK_S32          thread_num;
+    SwcvtWorker     workers[SWCVT_THREAD_MAX];
+
+    /* number of slice in flight, protected by cond */
+    MppMutexCond    *cond;
+    RK_S32          pending;
+} SwcvtCtxImpl;
+
+/*
+ * The row kernels below have no data dependent branch in the inner loop and
+ * are called with constant pixel layout so the compiler can specialize and
+ * vectorize them with NEON / SSE.
+ */
+static inline void swcvt_interleave(RK_U8 *dst, const RK_U8 *u, const RK_U8 *v, RK_S32 w)
+{
+    RK_S32 x;
+
+    for (x = 0; x < w; x++) {
+        dst[2 * x + 0] = u[x];
+        dst[2 * x + 1] = v[x];
+    }
+}
+
+static inline void swcvt_interleave_avg(RK_U8 *dst, const RK_U8 *u0, const RK_U8 *u1,
+                                        const RK_U8 *v0, const RK_U8 *v1, RK_S32 w)
+{
+    RK_S32 x;
+
+    for (x = 0; x < w; x++) {
+        dst[2 * x + 0] = (RK_U8)((u0[x] + u1[x] + 1) >> 1);
+        dst[2 * x + 1] = (RK_U8)((v0[x] + v1[x] + 1) >> 1);
+    }
+}
+
+static inline void swcvt_avg(RK_U8 *dst, const RK_U8 *s0, const RK_U8 *s1, RK_S32 w)
+{
+    RK_S32 x;
+
+    for (x = 0; x < w; x++)
+        dst[x] = (RK_U8)((s0[x] + s1[x] + 1) >> 1);
+}
+
+static inline void swcvt_swap(RK_U8 *dst, const RK_U8 *src, RK_S32 w)
+{
+    RK_S32 x;
+
+    for (x = 0; x < w; x++) {
+        dst[2 * x + 0] = src[2 * x + 1];
+        dst[2 * x + 1] = src[2 * x + 0];
+    }
+}
+
+static inline void swcvt_packed_luma(RK_U8 *dst, const RK_U8 *src, RK_S32 w,
+                                     const RK_S32 bpp, const RK_S32 off)
+{
+    RK_S32 x;
+
+    for (x = 0; x < w; x++)
+        dst[x] = src[x * bpp + off];
+}
+
+/* BT.601 limited range */
+static inline RK_U8 swcvt_rgb_y(RK_S32 r, RK_S32 g, RK_S32 b)
+{
+    return (RK_U8)(((66 * r + 129 * g + 25 * b + 128) >> 8) + 16);
+}
+
+/* r / g / b are sum of 2x2 pixel */
+static inline RK_U8 swcvt_rgb_u(RK_S32 r, RK_S32 g, RK_S32 b)
+{
+    return (RK_U8)(((-38 * r - 74 * g + 112 * b + 512) >> 10) + 128);
+}
+
+static inline RK_U8 swcvt_rgb_v(RK_S32 r, RK_S32 g, RK_S32 b)
+{
+    return (RK_U8)(((112 * r - 94 * g - 18 * b + 512) >> 10) + 128);
+}
+
+static inline void swcvt_rgb_luma(RK_U8 *dst, const RK_U8 *src, RK_S32 w,
+                                  const RK_S32 bpp, const RK_S32 r, const RK_S32 b)
+{
+    RK_S32 x;
+
+    for (x = 0; x < w; x++) {
+        const RK_U8 *p = src + x * bpp;
+
+        dst[x] = swcvt_rgb_y(p[r], p[1], p[b]);
+    }
+}
+
+static inline void swcvt_rgb_chroma(RK_U8 *dst, const RK_U8 *s0, const RK_U8 *s1, RK_S32 w,
+                                    const RK_S32 bpp, const RK_S32 r, const RK_S32 b)
+{
+    RK_S32 pair = w / 2;
+    RK_S32 x;
+
+    for (x = 0; x < pair; x++) {
+        const RK_U8 *p0 = s0 + x * 2 * bpp;
+        const RK_U8 *p1 = s1 + x * 2 * bpp;
+        RK_S32 rs = p0[r] + p0[r + bpp] + p1[r] + p1[r + bpp];
+        RK_S32 gs = p0[1] + p0[1 + bpp] + p1[1] + p1[1 + bpp];
+        RK_S32 bs = p0[b] + p0[b + bpp] + p1[b] + p1[b + bpp];
+
+        dst[2 * x + 0] = swcvt_rgb_u(rs, gs, bs);
+        dst[2 * x + 1] = swcvt_rgb_v(rs, gs, bs);
+    }
+
+    /* odd width repeats the last column */
+    if (w & 1) {
+        const RK_U8 *p0 = s0 + pair * 2 * bpp;
+        const RK_U8 *p1 = s1 + pair * 2 * bpp;
+        RK_S32 rs = (p0[r] + p1[r]) * 2;
+        RK_S32 gs = (p0[1] + p1[1]) * 2;
+        RK_S32 bs = (p0[b] + p1[b]) * 2;
+
+        dst[2 * pair + 0] = swcvt_rgb_u(rs, gs, bs);
+        dst[2 * pair + 1] = swcvt_rgb_v(rs, gs, bs);
+    }
+}
+
+/*
+ * Row functions for each source format. Odd height repeats the last row so
+ * the second row pointer may alias the first one.
+ */
+#define SWCVT_ROW_SETUP() \
+    RK_S32 w = src->width; \
+    RK_S32 cw = (w + 1) / 2; \
+    RK_S32 y1 = (y + 1 < src->height) ? (y + 1) : (y); \
+    RK_S32 ss = src->hor_stride; \
+    RK_S32 ds = dst->hor_stride; \
+    RK_U8 *d0 = dst->ptr + y * ds; \
+    RK_U8 *d1 = dst->ptr + y1 * ds; \
+    RK_U8 *duv = dst->ptr + ds * dst->ver_stride + (y / 2) * ds
+
+static void swcvt_row_nv12(const SwcvtImg *src, const SwcvtImg *dst, RK_S32 y)
+{
+    SWCVT_ROW_SETUP();
+    const RK_U8 *suv = src->ptr + ss * src->ver_stride + (y / 2) * ss;
+
+    memcpy(d0, src->ptr + y * ss, w);
+    memcpy(d1, src->ptr + y1 * ss, w);
+    memcpy(duv, suv, cw * 2);
+}
+
+static void swcvt_row_nv21(const SwcvtImg *src, const SwcvtImg *dst, RK_S32 y)
+{
+    SWCVT_ROW_SETUP();
+    const RK_U8 *svu = src->ptr + ss * src->ver_stride + (y / 2) * ss;
+
+    memcpy(d0, src->ptr + y * ss, w);
+    memcpy(d1, src->ptr + y1 * ss, w);
+    swcvt_swap(duv, svu, cw);
+}
+
+static void swcvt_row_i420(const SwcvtImg *src, const SwcvtImg *dst, RK_S32 y)
+{
+    SWCVT_ROW_SETUP();
+    RK_S32 luma_size = ss * src->ver_stride;
+    const RK_U8 *su = src->ptr + luma_size + (y / 2) * (ss / 2);
+    const RK_U8 *sv = src->ptr + luma_size + luma_size / 4 + (y / 2) * (ss / 2);
+
+    memcpy(d0, src->ptr + y * ss, w);
+    memcpy(d1, src->ptr + y1 * ss, w);
+    swcvt_interleave(duv, su, sv, cw);
+}
+
+static void swcvt_row_nv16(const SwcvtImg *src, const SwcvtImg *dst, RK_S32 y)
+{
+    SWCVT_ROW_SETUP();
+    const RK_U8 *suv = src->ptr + ss * src->ver_stride;
+
+    memcpy(d0, src->ptr + y * ss, w);
+    memcpy(d1, src->ptr + y1 * ss, w);
+    swcvt_avg(duv, suv + y * ss, suv + y1 * ss, cw * 2);
+}
+
+static void swcvt_row_i422(const SwcvtImg *src, const SwcvtImg *dst, RK_S32 y)
+{
+    SWCVT_ROW_SETUP();
+    RK_S32 luma_size = ss * src->ver_stride;
+    const RK_U8 *su = src->ptr + luma_size;
+    const RK_U8 *sv = src->ptr + luma_size + luma_size / 2;
+    RK_S32 cs = ss / 2;
+
+    memcpy(d0, src->ptr + y * ss, w);
+    memcpy(d1, src->ptr + y1 * ss, w);
+    swcvt_interleave_avg(duv, su + y * cs, su + y1 * cs, sv + y * cs, sv + y1 * cs, cw);
+}
+
+static inline void swcvt_row_packed422(const SwcvtImg *src, const SwcvtImg *dst, RK_S32 y,
+                                       const RK_S32 y_off, const RK_S32 u_off)
+{
+    SWCVT_ROW_SETUP();
+    const RK_U8 *s0 = src->ptr + y * ss * 2;
+    const RK_U8 *s1 = src->ptr + y1 * ss * 2;
+    RK_S32 x;
+
+    swcvt_packed_luma(d0, s0, w, 2, y_off);
+    swcvt_packed_luma(d1, s1, w, 2, y_off);
+
+    for (x = 0; x < cw; x++) {
+        duv[2 * x + 0] = (RK_U8)((s0[4 * x + u_off] + s1[4 * x + u_off] + 1) >> 1);
+        duv[2 * x + 1] = (RK_U8)((s0[4 * x + u_off + 2] + s1[4 * x + u_off + 2] + 1) >> 1);
+    }
+}
+
+static void swcvt_row_yuyv(const SwcvtImg *src, const SwcvtImg *dst, RK_S32 y)
+{
+    swcvt_row_packed422(src, dst, y, 0, 1);
+}
+
+static void swcvt_row_uyvy(const SwcvtImg *src, const SwcvtImg *dst, RK_S32 y)
+{
+    swcvt_row_packed422(src, dst, y, 1, 0);
+}
+
+static inline void swcvt_row_rgb(const SwcvtImg *src, const SwcvtImg *dst, RK_S32 y,
+                                 const RK_S32 bpp, const RK_S32 r, const RK_S32 b)
+{
+    SWCVT_ROW_SETUP();
+    const RK_U8 *s0 = src->ptr + y * ss * bpp;
+    const RK_U8 *s1 = src->ptr + y1 * ss * bpp;
+
+    (void)cw;
+    swcvt_rgb_luma(d0, s0, w, bpp, r, b);
+    swcvt_rgb_luma(d1, s1, w, bpp, r, b);
+    swcvt_rgb_chroma(duv, s0, s1, w, bpp, r, b);
+}
+
+static void swcvt_row_rgb888(const SwcvtImg *src, const SwcvtImg *dst, RK_S32 y)
+{
+    swcvt_row_rgb(src, dst, y, 3, 0, 2);
+}
+
+static void swcvt_row_bgr888(const SwcvtImg *src, const SwcvtImg *dst, RK_S32 y)
+{
+    swcvt_row_rgb(src, dst, y, 3, 2, 0);
+}
+
+static void swcvt_row_argb8888(const SwcvtImg *src, const SwcvtImg *dst, RK_S32 y)
+{
+    swcvt_row_rgb(src, dst, y, 4, 0, 2);
+}
+
+static void swcvt_row_abgr8888(const SwcvtImg *src, const SwcvtImg *dst, RK_S32 y)
+{
+    swcvt_row_rgb(src, dst, y, 4, 2, 0);
+}
+
+static SwcvtRowFunc swcvt_get_row_func(MppFrameFormat fmt)
+{
+    switch (fmt) {
+    case MPP_FMT_YUV420SP : {
+        return swcvt_row_nv12;
+    } break;
+    case MPP_FMT_YUV420SP_VU : {
+        return swcvt_row_nv21;
+    } break;
+    case MPP_FMT_YUV420P : {
+        return swcvt_row_i420;
+    } break;
+    case MPP_FMT_YUV422SP : {
+        return swcvt_row_nv16;
+    } break;
+    case MPP_FMT_YUV422P : {
+        return swcvt_row_i422;
+    } break;
+    case MPP_FMT_YUV422_YUYV : {
+        return swcvt_row_yuyv;
+    } break;
+    case MPP_FMT_YUV422_UYVY : {
+        return swcvt_row_uyvy;
+    } break;
+    case MPP_FMT_RGB888 : {
+        return swcvt_row_rgb888;
+    } break;
+    case MPP_FMT_BGR888 : {
+        return swcvt_row_bgr888;
+    } break;
+    case MPP_FMT_ARGB8888 : {
+        return swcvt_row_argb8888;
+    } break;
+    case MPP_FMT_ABGR8888 : {
+        return swcvt_row_abgr8888;
+    } break;
+    default : {
+    } break;
+    }
+
+    return NULL;
+}
+
+static void swcvt_proc_rows(SwcvtCtxImpl *p, RK_S32 y_start, RK_S32 y_end)
+{
+    RK_S32 y;
+
+    for (y = y_start; y < y_end; y += 2)
+        p->func(&p->src, &p->dst, y);
+}
+
+static void *swcvt_thread(void *data)
+{
+    SwcvtWorker *worker = (SwcvtWorker *)data;
+    SwcvtCtxImpl *p = worker->impl;
+    MppThread *thd = worker->thread;
+
+    while (1) {
+        RK_S32 y_start;
+        RK_S32 y_end;
+
+        {
+            AutoMutex autolock(thd->mutex());
+            if (MPP_THREAD_RUNNING != thd->get_status())
+                break;
+
+            if (!worker->job) {
+                thd->wait();
+                continue;
+            }
+
+            y_start = worker->y_start;
+            y_end = worker->y_end;
+            worker->job = 0;
+        }
+
+        swcvt_proc_rows(p, y_start, y_end);
+
+        p->cond->lock();
+        p->pending--;
+        if (!p->pending)
+            p->cond->signal();
+        p->cond->unlock();
+    }
+
+    return NULL;
+}
+
+static MPP_RET swcvt_config_image(SwcvtImg *img, MppFrame frame)
+{
+    MppBuffer buf = mpp_frame_get_buffer(frame);
+
+    if (NULL == buf) {
+        mpp_err_f("invalid frame %p without buffer\n", frame);
+        return MPP_ERR_NULL_PTR;
+    }
+
+    img->ptr = (RK_U8 *)mpp_buffer_get_ptr(buf);
+    img->fmt = mpp_frame_get_fmt(frame);
+    img->width = mpp_frame_get_width(frame);
+    img->height = mpp_frame_get_height(frame);
+    img->hor_stride = mpp_frame_get_hor_stride(frame);
+    img->ver_stride = mpp_frame_get_ver_stride(frame);
+
+    if (!img->hor_stride)
+        img->hor_stride = img->width;
+    if (!img->ver_stride)
+        img->ver_stride = img->height;
+
+    if (NULL == img->ptr || img->width <= 0 || img->height <= 0 ||
+        img->hor_stride < img->width || img->ver_stride < img->height) {
+        mpp_err_f("invalid image ptr %p size %dx%d stride %dx%d\n", img->ptr,
+                  img->width, img->height, img->hor_stride, img->ver_stride);
+        return MPP_NOK;
+    }
+
+    return MPP_OK;
+}
+
+static MPP_RET swcvt_wait(SwcvtCtxImpl *p)
+{
+    p->cond->lock();
+    while (p->pending)
+        p->cond->wait();
+    p->cond->unlock();
+
+    return MPP_OK;
+}
+
+static MPP_RET swcvt_start(SwcvtCtxImpl *p)
+{
+    SwcvtImg *src = &p->src;
+    SwcvtImg *dst = &p->dst;
+    RK_S32 slice;
+    RK_S32 i;
+
+    /* previous async process must finish before touching the images */
+    swcvt_wait(p);
+
+    p->func = swcvt_get_row_func(src->fmt);
+    if (NULL == p->func) {
+        mpp_err_f("unsupport source format %d\n", src->fmt);
+        return MPP_NOK;
+    }
+
+    if (dst->fmt != MPP_FMT_YUV420SP || NULL == dst->ptr || NULL == src->ptr ||
+        dst->width < src->width || dst->height < src->height) {
+        mpp_err_f("invalid destination fmt %d size %dx%d for source size %dx%d\n",
+                  dst->fmt, dst->width, dst->height, src->width, src->height);
+        return MPP_NOK;
+    }
+
+    swcvt_dbg_info("convert fmt %d -> %d size %dx%d stride %d -> %d threads %d\n",
+                   src->fmt, dst->fmt, src->width, src->height,
+                   src->hor_stride, dst->hor_stride, p->thread_num);
+
+    if (!p->thread_num) {
+        swcvt_proc_rows(p, 0, src->height);
+        return MPP_OK;
+    }
+
+    /* split by row pairs */
+    slice = ((src->height + 1) / 2 + p->thread_num - 1) / p->thread_num * 2;
+
+    p->cond->lock();
+    p->pending = (src->height + slice - 1) / slice;
+    p->cond->unlock();
+
+    for (i = 0; i < p->thread_num; i++) {
+        SwcvtWorker *worker = &p->workers[i];
+        RK_S32 y_start = i * slice;
+        MppThread *thd = worker->thread;
+
+        if (y_start >= src->height)
+            break;
+
+        thd->lock();
+        worker->y_start = y_start;
+        worker->y_end = MPP_MIN(y_start + slice, src->height);
+        worker->job = 1;
+        thd->signal();
+        thd->unlock();
+    }
+
+    return MPP_OK;
+}
+
+MPP_RET swcvt_init(SwcvtCtx *ctx)
+{
+    SwcvtCtxImpl *p = NULL;
+    RK_U32 thread_num = 0;
+    RK_S32 i;
+
+    if (NULL == ctx) {
+        mpp_err_f("invalid NULL input\n");
+        return MPP_ERR_NULL_PTR;
+    }
+
+    mpp_env_get_u32("swcvt_debug", &swcvt_debug, 0);
+    mpp_env_get_u32("swcvt_thread_num", &thread_num, SWCVT_THREAD_DEFAULT);
+
+    swcvt_dbg_func("in\n");
+
+    *ctx = NULL;
+
+    p = mpp_calloc(SwcvtCtxImpl, 1);
+    if (NULL == p) {
+        mpp_err_f("malloc context failed\n");
+        return MPP_ERR_MALLOC;
+    }
+
+    p->cond = new MppMutexCond();
+    if (NULL == p->cond) {
+        mpp_err_f("failed to create condition\n");
+        mpp_free(p);
+        return MPP_ERR_MALLOC;
+    }
+
+    p->thread_num = (RK_S32)MPP_MIN(thread_num, SWCVT_THREAD_MAX);
+
+    for (i = 0; i < p->thread_num; i++) {
+        SwcvtWorker *worker = &p->workers[i];
+
+        worker->impl = p;
+        worker->thread = new MppThread(swcvt_thread, worker, "mpp_swcvt");
+        if (NULL == worker->thread) {
+            mpp_err_f("failed to create thread %d\n", i);
+            p->thread_num = i;
+            break;
+        }
+
+        worker->thread->start();
+    }
+
+    *ctx = p;
+    swcvt_dbg_func("out\n");
+    return MPP_OK;
+}
+
+MPP_RET swcvt_deinit(SwcvtCtx ctx)
+{
+    SwcvtCtxImpl *p = (SwcvtCtxImpl *)ctx;
+    RK_S32 i;
+
+    swcvt_dbg_func("in\n");
+
+    if (NULL == p) {
+        mpp_err_f("invalid NULL input\n");
+        return MPP_ERR_NULL_PTR;
+    }
+
+    swcvt_wait(p);
+
+    for (i = 0; i < p->thread_num; i++) {
+        SwcvtWorker *worker = &p->workers[i];
+
+        if (worker->thread) {
+            worker->thread->stop();
+            delete worker->thread;
+            worker->thread = NULL;
+        }
+    }
+
+    delete p->cond;
+    mpp_free(p);
+
+    swcvt_dbg_func("out\n");
+    return MPP_OK;
+}
+
+MPP_RET swcvt_control(SwcvtCtx ctx, SwcvtCmd cmd, void *param)
+{
+    SwcvtCtxImpl *p = (SwcvtCtxImpl *)ctx;
+    MPP_RET ret = MPP_OK;
+
+    if (NULL == p) {
+        mpp_err_f("invalid NULL input\n");
+        return MPP_ERR_NULL_PTR;
+    }
+
+    swcvt_dbg_func("in cmd 0x%x\n", cmd);
+
+    switch (cmd) {
+    case SWCVT_CMD_INIT : {
+        swcvt_wait(p);
+        memset(&p->src, 0, sizeof(p->src));
+        memset(&p->dst, 0, sizeof(p->dst));
+    } break;
+    case SWCVT_CMD_SET_SRC :
+    case SWCVT_CMD_SET_DST : {
+        if (NULL == param) {
+            mpp_err_f("invalid NULL param for cmd 0x%x\n", cmd);
+            ret = MPP_ERR_NULL_PTR;
+            break;
+        }
+
+        swcvt_wait(p);
+        ret = swcvt_config_image((cmd == SWCVT_CMD_SET_SRC) ? &p->src : &p->dst,
+                                 (MppFrame)param);
+    } break;
+    case SWCVT_CMD_RUN_SYNC : {
+        ret = swcvt_start(p);
+        if (!ret)
+            ret = swcvt_wait(p);
+    } break;
+    case SWCVT_CMD_RUN_ASYNC : {
+        ret = swcvt_start(p);
+    } break;
+    case SWCVT_CMD_WAIT : {
+        ret = swcvt_wait(p);
+    } break;
+    default : {
+        mpp_err_f("invalid cmd 0x%x\n", cmd);
+        ret = MPP_NOK;
+    } break;
+    }
+
+    swcvt_dbg_func("out ret %d\n", ret);
+    return ret;
+}
@@ -0,0 +1,394 @@
+/*
+ * Copyright 2018 Rockchip Electronics Co. LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define MODULE_TAG "swcvt_test"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "mpp_env.h"
+#include "mpp_log.h"
+#include "mpp_mem.h"
+#include "mpp_time.h"
+#include "mpp_common.h"
+#include "mpp_buffer.h"
+
+#include "swcvt_api.h"
+
+/* odd size to cover the edge handling */
+#define SWCVT_TEST_WIDTH        101
+#define SWCVT_TEST_HEIGHT       37
+#define SWCVT_TEST_HOR_STRIDE   112
+#define SWCVT_TEST_VER_STRIDE   40
+#define SWCVT_TEST_DST_STRIDE   128
+/* size for speed test */
+#define SWCVT_PERF_WIDTH        1920
+#define SWCVT_PERF_HEIGHT       1080
+#define SWCVT_PERF_LOOP         10
+
+typedef struct SwcvtTestFmt_t {
+    MppFrameFormat  fmt;
+    const char      *name;
+    RK_S32          bpp;            // byte per pixel of packed format
+    RK_S32          r_off;
+    RK_S32          b_off;
+} SwcvtTestFmt;
+
+static SwcvtTestFmt test_fmts[] = {
+    {   MPP_FMT_YUV420SP,       "nv12",     1,  0,  0,  },
+    {   MPP_FMT_YUV420SP_VU,    "nv21",     1,  0,  0,  },
+    {   MPP_FMT_YUV420P,        "i420",     1,  0,  0,  },
+    {   MPP_FMT_YUV422SP,       "nv16",     1,  0,  0,  },
+    {   MPP_FMT_YUV422P,        "i422",     1,  0,  0,  },
+    {   MPP_FMT_YUV422_YUYV,    "yuyv",     2,  0,  0,  },
+    {   MPP_FMT_YUV422_UYVY,    "uyvy",     2,  0,  0,  },
+    {   MPP_FMT_RGB888,         "rgb888",   3,  0,  2,  },
+    {   MPP_FMT_BGR888,         "bgr888",   3,  2,  0,  },
+    {   MPP_FMT_ARGB8888,       "argb8888", 4,  0,  2,  },
+    {   MPP_FMT_ABGR8888,       "abgr8888", 4,  2,  0,  },
+};
+
+static RK_S32 clip_y(RK_S32 y, RK_S32 h)
+{
+    return (y < h) ? y : h - 1;
+}
+
+/* plain per pixel reference of the source layout */
+static void ref_get_yuv(const SwcvtTestFmt *tf, const RK_U8 *src, RK_S32 x, RK_S32 y,
+                        RK_S32 *py, RK_S32 *pu, RK_S32 *pv)
+{
+    const RK_S32 hs = SWCVT_TEST_HOR_STRIDE;
+    const RK_S32 luma_size = SWCVT_TEST_HOR_STRIDE * SWCVT_TEST_VER_STRIDE;
+    RK_S32 cx = x / 2;
+
+    switch (tf->fmt) {
+    case MPP_FMT_YUV420SP : {
+        *py = src[y * hs + x];
+        *pu = src[luma_size + (y / 2) * hs + cx * 2];
+        *pv = src[luma_size + (y / 2) * hs + cx * 2 + 1];
+    } break;
+    case MPP_FMT_YUV420SP_VU : {
+        *py = src[y * hs + x];
+        *pv = src[luma_size + (y / 2) * hs + cx * 2];
+        *pu = src[luma_size + (y / 2) * hs + cx * 2 + 1];
+    } break;
+    case MPP_FMT_YUV420P : {
+        *py = src[y * hs + x];
+        *pu = src[luma_size + (y / 2) * hs / 2 + cx];
+        *pv = src[luma_size * 5 / 4 + (y / 2) * hs / 2 + cx];
+    } break;
+    case MPP_FMT_YUV422SP : {
+        *py = src[y * hs + x];
+        *pu = src[luma_size + y * hs + cx * 2];
+        *pv = src[luma_size + y * hs + cx * 2 + 1];
+    } break;
+    case MPP_FMT_YUV422P : {
+        *py = src[y * hs + x];
+        *pu = src[luma_size + y * hs / 2 + cx];
+        *pv = src[luma_size * 3 / 2 + y * hs / 2 + cx];
+    } break;
+    case MPP_FMT_YUV422_YUYV : {
+        *py = src[y * hs * 2 + x * 2];
+        *pu = src[y * hs * 2 + cx * 4 + 1];
+        *pv = src[y * hs * 2 + cx * 4 + 3];
+    } break;
+    case MPP_FMT_YUV422_UYVY : {
+        *py = src[y * hs * 2 + x * 2 + 1];
+        *pu = src[y * hs * 2 + cx * 4];
+        *pv = src[y * hs * 2 + cx * 4 + 2];
+    } break;
+    default : {
+        const RK_U8 *p = src + (y * hs + x) * tf->bpp;
+        RK_S32 r = p[tf->r_off];
+        RK_S32 g = p[1];
+        RK_S32 b = p[tf->b_off];
+
+        *py = ((66 * r + 129 * g + 25 * b + 128) >> 8) + 16;
+        /* rgb returns the pixel itself and average is done by caller */
+        *pu = r;
+        *pv = b;
+        (void)g;
+    } break;
+    }
+}
+
+static void ref_convert(const SwcvtTestFmt *tf, const RK_U8 *src, RK_U8 *dst)
+{
+    const RK_S32 w = SWCVT_TEST_WIDTH;
+    const RK_S32 h = SWCVT_TEST_HEIGHT;
+    const RK_S32 ds = SWCVT_TEST_DST_STRIDE;
+    RK_U8 *duv = dst + ds * SWCVT_TEST_VER_STRIDE;
+    RK_S32 x, y, u, v;
+
+    for (y = 0; y < h; y++) {
+        for (x = 0; x < w; x++) {
+            RK_S32 luma;
+
+            ref_get_yuv(tf, src, x, y, &luma, &u, &v);
+            dst[y * ds + x] = (RK_U8)luma;
+        }
+    }
+
+    for (y = 0; y < (h + 1) / 2; y++) {
+        RK_S32 y0 = y * 2;
+        RK_S32 y1 = clip_y(y0 + 1, h);
+
+        for (x = 0; x < (w + 1) / 2; x++) {
+            RK_S32 x0 = x * 2;
+            RK_S32 x1 = MPP_MIN(x0 + 1, w - 1);
+            RK_S32 luma, u0, v0, u1, v1;
+
+            if (tf->bpp >= 3) {
+                RK_S32 rs = 0, gs = 0, bs = 0;
+                RK_S32 xs[2] = { x0, x1 };
+                RK_S32 ys[2] = { y0, y1 };
+                RK_S32 i, j;
+
+                for (j = 0; j < 2; j++) {
+                    for (i = 0; i < 2; i++) {
+                        const RK_U8 *p = src + (ys[j] * SWCVT_TEST_HOR_STRIDE + xs[i]) * tf->bpp;
+
+                        rs += p[tf->r_off];
+                        gs += p[1];
+                        bs += p[tf->b_off];
+                    }
+                }
+
+                u = ((-38 * rs - 74 * gs + 112 * bs + 512) >> 10) + 128;
+                v = ((112 * rs - 94 * gs - 18 * bs + 512) >> 10) + 128;
+            } else if (tf->fmt == MPP_FMT_YUV422SP || tf->fmt == MPP_FMT_YUV422P ||
+                       tf->fmt == MPP_FMT_YUV422_YUYV || tf->fmt == MPP_FMT_YUV422_UYVY) {
+                ref_get_yuv(tf, src, x0, y0, &luma, &u0, &v0);
+                ref_get_yuv(tf, src, x0, y1, &luma, &u1, &v1);
+                u = (u0 + u1 + 1) >> 1;
+                v = (v0 + v1 + 1) >> 1;
+            } else {
+                ref_get_yuv(tf, src, x0, y0, &luma, &u, &v);
+            }
+
+            duv[y * ds + x * 2] = (RK_U8)u;
+            duv[y * ds + x * 2 + 1] = (RK_U8)v;
+        }
+    }
+}
+
+static RK_S32 compare(const RK_U8 *dst, const RK_U8 *ref)
+{
+    const RK_S32 w = SWCVT_TEST_WIDTH;
+    const RK_S32 h = SWCVT_TEST_HEIGHT;
+    const RK_S32 ds = SWCVT_TEST_DST_STRIDE;
+    const RK_S32 uv_offset = ds * SWCVT_TEST_VER_STRIDE;
+    RK_S32 x, y;
+
+    for (y = 0; y < h; y++)
+        for (x = 0; x < w; x++)
+            if (dst[y * ds + x] != ref[y * ds + x]) {
+                mpp_err("luma mismatch at %d,%d %d vs %d\n", x, y,
+                        dst[y * ds + x], ref[y * ds + x]);
+                return MPP_NOK;
+            }
+
+    for (y = 0; y < (h + 1) / 2; y++)
+        for (x = 0; x < (w + 1) / 2 * 2; x++)
+            if (dst[uv_offset + y * ds + x] != ref[uv_offset + y * ds + x]) {
+                mpp_err("chroma mismatch at %d,%d %d vs %d\n", x, y,
+                        dst[uv_offset + y * ds + x], ref[uv_offset + y * ds + x]);
+                return MPP_NOK;
+            }
+
+    return MPP_OK;
+}
+
+static void setup_frame(MppFrame frame, MppBuffer buf, MppFrameFormat fmt,
+                        RK_S32 w, RK_S32 h, RK_S32 hs, RK_S32 vs)
+{
+    mpp_frame_set_buffer(frame, buf);
+    mpp_frame_set_fmt(frame, fmt);
+    mpp_frame_set_width(frame, w);
+    mpp_frame_set_height(frame, h);
+    mpp_frame_set_hor_stride(frame, hs);
+    mpp_frame_set_ver_stride(frame, vs);
+}
+
+static RK_S32 test_convert(SwcvtCtx ctx, MppBufferGroup group)
+{
+    const RK_S32 src_size = SWCVT_TEST_HOR_STRIDE * SWCVT_TEST_VER_STRIDE * 4;
+    const RK_S32 dst_size = SWCVT_TEST_DST_STRIDE * SWCVT_TEST_VER_STRIDE * 3 / 2;
+    MppBuffer src_buf = NULL;
+    MppBuffer dst_buf = NULL;
+    MppFrame src_frm = NULL;
+    MppFrame dst_frm = NULL;
+    RK_U8 *ref = NULL;
+    RK_S32 ret = MPP_NOK;
+    RK_U32 i;
+
+    ref = mpp_malloc(RK_U8, dst_size);
+    if (NULL == ref)
+        goto TEST_DONE;
+
+    if (mpp_buffer_get(group, &src_buf, src_size) ||
+        mpp_buffer_get(group, &dst_buf, dst_size))
+        goto TEST_DONE;
+
+    mpp_frame_init(&src_frm);
+    mpp_frame_init(&dst_frm);
+
+    for (i = 0; i < MPP_ARRAY_ELEMS(test_fmts); i++) {
+        SwcvtTestFmt *tf = &test_fmts[i];
+        RK_U8 *src = (RK_U8 *)mpp_buffer_get_ptr(src_buf);
+        RK_U8 *dst = (RK_U8 *)mpp_buffer_get_ptr(dst_buf);
+        RK_S32 j;
+
+        srand(i + 1);
+        for (j = 0; j < src_size; j++)
+            src[j] = (RK_U8)rand();
+
+        memset(dst, 0, dst_size);
+        memset(ref, 0, dst_size);
+
+        setup_frame(src_frm, src_buf, tf->fmt, SWCVT_TEST_WIDTH, SWCVT_TEST_HEIGHT,
+                    SWCVT_TEST_HOR_STRIDE, SWCVT_TEST_VER_STRIDE);
+        setup_frame(dst_frm, dst_buf, MPP_FMT_YUV420SP, SWCVT_TEST_WIDTH, SWCVT_TEST_HEIGHT,
+                    SWCVT_TEST_DST_STRIDE, SWCVT_TEST_VER_STRIDE);
+
+        swcvt_control(ctx, SWCVT_CMD_INIT, NULL);
+        swcvt_control(ctx, SWCVT_CMD_SET_SRC, src_frm);
+        swcvt_control(ctx, SWCVT_CMD_SET_DST, dst_frm);
+        if (swcvt_control(ctx, SWCVT_CMD_RUN_SYNC, NULL)) {
+            mpp_err("convert %s failed\n", tf->name);
+            goto TEST_DONE;
+        }
+
+        ref_convert(tf, src, ref);
+        if (compare(dst, ref)) {
+            mpp_err("convert %s mismatch\n", tf->name);
+            goto TEST_DONE;
+        }
+
+        mpp_log("convert %s -> nv12 match\n", tf->name);
+    }
+
+    ret = MPP_OK;
+
+TEST_DONE:
+    if (src_frm)
+        mpp_frame_deinit(&src_frm);
+    if (dst_frm)
+        mpp_frame_deinit(&dst_frm);
+    if (src_buf)
+        mpp_buffer_put(src_buf);
+    if (dst_buf)
+        mpp_buffer_put(dst_buf);
+    MPP_FREE(ref);
+
+    return ret;
+}
+
+static RK_S32 test_perf(SwcvtCtx ctx, MppBufferGroup group)
+{
+    const RK_S32 size = SWCVT_PERF_WIDTH * SWCVT_PERF_HEIGHT;
+    MppBuffer src_buf = NULL;
+    MppBuffer dst_buf = NULL;
+    MppFrame src_frm = NULL;
+    MppFrame dst_frm = NULL;
+    RK_S64 start;
+    RK_S32 ret = MPP_NOK;
+    RK_S32 i;
+
+    if (mpp_buffer_get(group, &src_buf, size * 4) ||
+        mpp_buffer_get(group, &dst_buf, size * 3 / 2))
+        goto TEST_DONE;
+
+    memset(mpp_buffer_get_ptr(src_buf), 0x80, size * 4);
+
+    mpp_frame_init(&src_frm);
+    mpp_frame_init(&dst_frm);
+    setup_frame(src_frm, src_buf, MPP_FMT_ARGB8888, SWCVT_PERF_WIDTH, SWCVT_PERF_HEIGHT,
+                SWCVT_PERF_WIDTH, SWCVT_PERF_HEIGHT);
+    setup_frame(dst_frm, dst_buf, MPP_FMT_YUV420SP, SWCVT_PERF_WIDTH, SWCVT_PERF_HEIGHT,
+                SWCVT_PERF_WIDTH, SWCVT_PERF_HEIGHT);
+
+    swcvt_control(ctx, SWCVT_CMD_INIT, NULL);
+    swcvt_control(ctx, SWCVT_CMD_SET_SRC, src_frm);
+    swcvt_control(ctx, SWCVT_CMD_SET_DST, dst_frm);
+
+    start = mpp_time();
+    for (i = 0; i < SWCVT_PERF_LOOP; i++) {
+        /* async start and wait as encoder does with other work in between */
+        if (swcvt_control(ctx, SWCVT_CMD_RUN_ASYNC, NULL))
+            goto TEST_DONE;
+        swcvt_control(ctx, SWCVT_CMD_WAIT, NULL);
+    }
+
+    mpp_log("argb8888 -> nv12 %dx%d average %.3f ms per frame\n",
+            SWCVT_PERF_WIDTH, SWCVT_PERF_HEIGHT,
+            (mpp_time() - start) / 1000.0 / SWCVT_PERF_LOOP);
+
+    ret = MPP_OK;
+
+TEST_DONE:
+    if (src_frm)
+        mpp_frame_deinit(&src_frm);
+    if (dst_frm)
+        mpp_frame_deinit(&dst_frm);
+    if (src_buf)
+        mpp_buffer_put(src_buf);
+    if (dst_buf)
+        mpp_buffer_put(dst_buf);
+
+    return ret;
+}
+
+int main()
+{
+    static const RK_U32 thread_nums[] = { 0, 1, 3 };
+    MppBufferGroup group = NULL;
+    SwcvtCtx ctx = NULL;
+    RK_S32 ret = MPP_OK;
+    RK_U32 i;
+
+    mpp_log("swcvt test start\n");
+
+    ret = mpp_buffer_group_get_internal(&group, MPP_BUFFER_TYPE_NORMAL);
+    if (ret)
+        goto TEST_DONE;
+
+    for (i = 0; i < MPP_ARRAY_ELEMS(thread_nums); i++) {
+        mpp_env_set_u32("swcvt_thread_num", thread_nums[i]);
+        mpp_log("swcvt test with %d thread\n", thread_nums[i]);
+
+        ret = swcvt_init(&ctx);
+        if (ret)
+            goto TEST_DONE;
+
+        ret = test_convert(ctx, group);
+        if (!ret)
+            ret = test_perf(ctx, group);
+
+        swcvt_deinit(ctx);
+        ctx = NULL;
+
+        if (ret)
+            goto TEST_DONE;
+    }
+
+TEST_DONE:
+    if (group)
+        mpp_buffer_group_put(group);
+
+    mpp_log("swcvt test %s\n", ret ? "failed" : "success");
+    return ret;
+}
@@ -0,0 +1,329 @@
+/*
+ * Copyright 2018 Rockchip Electronics Co. LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define MODULE_TAG "swdei"
+
+#include <string.h>
+
+#include "mpp_env.h"
+#include "mpp_mem.h"
+#include "mpp_log.h"
+#include "mpp_common.h"
+#include "mpp_thread.h"
+
+#include "swdei_api.h"
+
+#define SWDEI_DBG_FUNCTION      (0x00000001)
+#define SWDEI_DBG_INFO          (0x00000002)
+
+#define swdei_dbg(flag, fmt, ...)   _mpp_dbg(swdei_debug, flag, fmt, ## __VA_ARGS__)
+#define swdei_dbg_func(fmt, ...)    _mpp_dbg_f(swdei_debug, SWDEI_DBG_FUNCTION, fmt, ## __VA_ARGS__)
+#define swdei_dbg_info(fmt, ...)    _mpp_dbg(swdei_debug, SWDEI_DBG_INFO, fmt, ## __VA_ARGS__)
+
+#define SWDEI_THREAD_DEFAULT    1
+
+static RK_U32 swdei_debug = 0;
+
+typedef struct SwdeiCtxImpl_t {
+    MppThread       *thread;
+
+    /*
+     * task ring, wr is updated by caller under thread lock, done is updated
+     * by worker under cond and rd is only used by caller
+     */
+    SwdeiTask       tasks[SWDEI_TASK_MAX];
+    RK_U32          wr;
+    RK_U32          rd;
+
+    MppMutexCond    *cond;
+    RK_U32          done;
+} SwdeiCtxImpl;
+
+/*
+ * The row kernel has no data dependent branch in the inner loop so the
+ * compiler can vectorize it with NEON / SSE.
+ */
+static inline void swdei_avg(RK_U8 *dst, const RK_U8 *s0, const RK_U8 *s1, RK_S32 w)
+{
+    RK_S32 x;
+
+    for (x = 0; x < w; x++)
+        dst[x] = (RK_U8)((s0[x] + s1[x] + 1) >> 1);
+}
+
+static void swdei_plane(RK_U8 *dst, const RK_U8 *src, RK_S32 w, RK_S32 h,
+                        RK_S32 stride, RK_U32 bottom, SwdeiMode mode)
+{
+    RK_S32 y;
+
+    for (y = 0; y < h; y++) {
+        RK_U8 *d = dst + y * stride;
+        RK_S32 above = y - 1;
+        RK_S32 below = y + 1;
+
+        if ((RK_U32)(y & 1) == bottom) {
+            memcpy(d, src + y * stride, w);
+            continue;
+        }
+
+        /* edge line has field line on one side only */
+        if (above < 0)
+            above = below;
+        if (below >= h)
+            below = above;
+
+        /* one line plane without the kept field line */
+        if (above >= h) {
+            memcpy(d, src + y * stride, w);
+            continue;
+        }
+
+        if (mode == SWDEI_MODE_BOB)
+            memcpy(d, src + ((bottom) ? below : above) * stride, w);
+        else
+            swdei_avg(d, src + above * stride, src + below * stride, w);
+    }
+}
+
+static void swdei_proc(const SwdeiTask *task)
+{
+    RK_U8 *src = (RK_U8 *)mpp_buffer_get_ptr(task->src);
+    RK_U8 *dst = (RK_U8 *)mpp_buffer_get_ptr(task->dst);
+    RK_S32 stride = task->hor_stride;
+    RK_S32 luma_size = stride * task->ver_stride;
+
+    swdei_plane(dst, src, task->width, task->height, stride,
+                task->bottom, task->mode);
+    swdei_plane(dst + luma_size, src + luma_size, MPP_ALIGN(task->width, 2),
+                (task->height + 1) / 2, stride, task->bottom, task->mode);
+}
+
+static MPP_RET swdei_check_task(const SwdeiTask *task)
+{
+    size_t size = 0;
+
+    if (NULL == task || NULL == task->src || NULL == task->dst) {
+        mpp_err_f("invalid task %p without buffer\n", task);
+        return MPP_ERR_NULL_PTR;
+    }
+
+    size = (size_t)task->hor_stride * task->ver_stride * 3 / 2;
+
+    if (task->mode >= SWDEI_MODE_BUTT || task->bottom > 1 ||
+        task->width <= 0 || task->height <= 0 ||
+        task->hor_stride < MPP_ALIGN(task->width, 2) ||
+        task->ver_stride < task->height ||
+        NULL == mpp_buffer_get_ptr(task->src) ||
+        NULL == mpp_buffer_get_ptr(task->dst) ||
+        mpp_buffer_get_size(task->src) < size ||
+        mpp_buffer_get_size(task->dst) < size) {
+        mpp_err_f("invalid task mode %d field %d size %dx%d stride %dx%d\n",
+                  task->mode, task->bottom, task->width, task->height,
+                  task->hor_stride, task->ver_stride);
+        return MPP_NOK;
+    }
+
+    return MPP_OK;
+}
+
+static void *swdei_thread(void *data)
+{
+    SwdeiCtxImpl *p = (SwdeiCtxImpl *)data;
+    MppThread *thd = p->thread;
+    RK_U32 proc = 0;
+
+    while (1) {
+        SwdeiTask task;
+
+        {
+            AutoMutex autolock(thd->mutex());
+            if (MPP_THREAD_RUNNING != thd->get_status())
+                break;
+
+            if (proc == p->wr) {
+                thd->wait();
+                continue;
+            }
+
+            task = p->tasks[proc % SWDEI_TASK_MAX];
+        }
+
+        swdei_proc(&task);
+        proc++;
+
+        p->cond->lock();
+        p->done = proc;
+        p->cond->signal();
+        p->cond->unlock();
+    }
+
+    return NULL;
+}
+
+static MPP_RET swdei_submit(SwdeiCtxImpl *p, SwdeiTask *task)
+{
+    MPP_RET ret = swdei_check_task(task);
+
+    if (ret)
+        return ret;
+
+    if (p->wr - p->rd >= SWDEI_TASK_MAX) {
+        mpp_err_f("too many task in flight\n");
+        return MPP_NOK;
+    }
+
+    swdei_dbg_info("task %d mode %d field %d size %dx%d stride %dx%d\n",
+                   p->wr, task->mode, task->bottom, task->width, task->height,
+                   task->hor_stride, task->ver_stride);
+
+    if (NULL == p->thread) {
+        swdei_proc(task);
+        p->wr++;
+        p->done = p->wr;
+        return MPP_OK;
+    }
+
+    p->thread->lock();
+    p->tasks[p->wr % SWDEI_TASK_MAX] = *task;
+    p->wr++;
+    p->thread->signal();
+    p->thread->unlock();
+
+    return MPP_OK;
+}
+
+static MPP_RET swdei_wait(SwdeiCtxImpl *p)
+{
+    if (p->rd == p->wr)
+        return MPP_OK;
+
+    p->cond->lock();
+    while ((RK_S32)(p->done - p->rd) <= 0)
+        p->cond->wait();
+    p->cond->unlock();
+
+    p->rd++;
+    return MPP_OK;
+}
+
+MPP_RET swdei_init(SwdeiCtx *ctx)
+{
+    SwdeiCtxImpl *p = NULL;
+    RK_U32 thread_num = 0;
+
+    if (NULL == ctx) {
+        mpp_err_f("invalid NULL input\n");
+        return MPP_ERR_NULL_PTR;
+    }
+
+    mpp_env_get_u32("swdei_debug", &swdei_debug, 0);
+    mpp_env_get_u32("swdei_thread_num", &thread_num, SWDEI_THREAD_DEFAULT);
+
+    swdei_dbg_func("in\n");
+
+    *ctx = NULL;
+
+    p = mpp_calloc(SwdeiCtxImpl, 1);
+    if (NULL == p) {
+        mpp_err_f("malloc context failed\n");
+        return MPP_ERR_MALLOC;
+    }
+
+    p->cond = new MppMutexCond();
+    if (NULL == p->cond) {
+        mpp_err_f("failed to create condition\n");
+        mpp_free(p);
+        return MPP_ERR_MALLOC;
+    }
+
+    /* one worker keeps the tasks in submit order */
+    if (thread_num) {
+        p->thread = new MppThread(swdei_thread, p, "mpp_swdei");
+        if (p->thread)
+            p->thread->start();
+        else
+            mpp_err_f("failed to create thread, process in caller thread\n");
+    }
+
+    *ctx = p;
+    swdei_dbg_func("out\n");
+    return MPP_OK;
+}
+
+MPP_RET swdei_deinit(SwdeiCtx ctx)
+{
+    SwdeiCtxImpl *p = (SwdeiCtxImpl *)ctx;
+
+    swdei_dbg_func("in\n");
+
+    if (NULL == p) {
+        mpp_err_f("invalid NULL input\n");
+        return MPP_ERR_NULL_PTR;
+    }
+
+    while (p->rd != p->wr)
+        swdei_wait(p);
+
+    if (p->thread) {
+        p->thread->stop();
+        delete p->thread;
+        p->thread = NULL;
+    }
+
+    delete p->cond;
+    mpp_free(p);
+
+    swdei_dbg_func("out\n");
+    return MPP_OK;
+}
+
+MPP_RET swdei_control(SwdeiCtx ctx, SwdeiCmd cmd, void *param)
+{
+    SwdeiCtxImpl *p = (SwdeiCtxImpl *)ctx;
+    MPP_RET ret = MPP_OK;
+
+    if (NULL == p) {
+        mpp_err_f("invalid NULL input\n");
+        return MPP_ERR_NULL_PTR;
+    }
+
+    swdei_dbg_func("in cmd 0x%x\n", cmd);
+
+    switch (cmd) {
+    case SWDEI_CMD_RUN_SYNC : {
+        /* previous async process must finish to keep the wait order */
+        while (p->rd != p->wr)
+            swdei_wait(p);
+
+        ret = swdei_submit(p, (SwdeiTask *)param);
+        if (!ret)
+            ret = swdei_wait(p);
+    } break;
+    case SWDEI_CMD_RUN_ASYNC : {
+        ret = swdei_submit(p, (SwdeiTask *)param);
+    } break;
+    case SWDEI_CMD_WAIT : {
+        ret = swdei_wait(p);
+    } break;
+    default : {
+        mpp_err_f("invalid cmd 0x%x\n", cmd);
+        ret = MPP_NOK;
+    } break;
+    }
+
+    swdei_dbg_func("out ret %d\n", ret);
+    return ret;
+}
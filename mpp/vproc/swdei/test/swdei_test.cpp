@@ -0,0 +1,317 @@
+/*
+ * Copyright 2018 Rockchip Electronics Co. LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define MODULE_TAG "swdei_test"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "mpp_env.h"
+#include "mpp_log.h"
+#include "mpp_mem.h"
+#include "mpp_time.h"
+#include "mpp_common.h"
+#include "mpp_buffer.h"
+
+#include "swdei_api.h"
+
+/* odd size to cover the edge handling */
+#define SWDEI_TEST_WIDTH        101
+#define SWDEI_TEST_HEIGHT       37
+#define SWDEI_TEST_HOR_STRIDE   112
+#define SWDEI_TEST_VER_STRIDE   40
+#define SWDEI_TEST_SIZE         (SWDEI_TEST_HOR_STRIDE * SWDEI_TEST_VER_STRIDE * 3 / 2)
+/* size for speed test */
+#define SWDEI_PERF_WIDTH        1920
+#define SWDEI_PERF_HEIGHT       1088
+#define SWDEI_PERF_LOOP         16
+
+static const char *mode_names[] = {
+    "bob",
+    "linear",
+};
+
+/* plain per pixel reference on one plane */
+static void ref_plane(RK_U8 *dst, const RK_U8 *src, RK_S32 w, RK_S32 h,
+                      RK_U32 bottom, SwdeiMode mode)
+{
+    const RK_S32 s = SWDEI_TEST_HOR_STRIDE;
+    RK_S32 x, y;
+
+    for (y = 0; y < h; y++) {
+        for (x = 0; x < w; x++) {
+            RK_S32 val;
+
+            if ((RK_U32)(y & 1) == bottom) {
+                val = src[y * s + x];
+            } else if (mode == SWDEI_MODE_BOB) {
+                RK_S32 ys = (bottom) ? (y + 1) : (y - 1);
+
+                if (ys >= h)
+                    ys = y - 1;
+                val = src[ys * s + x];
+            } else if (y == 0) {
+                val = src[s + x];
+            } else if (y == h - 1) {
+                val = src[(y - 1) * s + x];
+            } else {
+                val = (src[(y - 1) * s + x] + src[(y + 1) * s + x] + 1) / 2;
+            }
+
+            dst[y * s + x] = (RK_U8)val;
+        }
+    }
+}
+
+static void ref_dei(RK_U8 *dst, const RK_U8 *src, RK_U32 bottom, SwdeiMode mode)
+{
+    const RK_S32 luma_size = SWDEI_TEST_HOR_STRIDE * SWDEI_TEST_VER_STRIDE;
+
+    ref_plane(dst, src, SWDEI_TEST_WIDTH, SWDEI_TEST_HEIGHT, bottom, mode);
+    ref_plane(dst + luma_size, src + luma_size, (SWDEI_TEST_WIDTH + 1) / 2 * 2,
+              (SWDEI_TEST_HEIGHT + 1) / 2, bottom, mode);
+}
+
+static RK_S32 compare(const RK_U8 *dst, const RK_U8 *ref)
+{
+    const RK_S32 s = SWDEI_TEST_HOR_STRIDE;
+    const RK_S32 uv_offset = s * SWDEI_TEST_VER_STRIDE;
+    RK_S32 x, y;
+
+    for (y = 0; y < SWDEI_TEST_HEIGHT; y++)
+        for (x = 0; x < SWDEI_TEST_WIDTH; x++)
+            if (dst[y * s + x] != ref[y * s + x]) {
+                mpp_err("luma mismatch at %d,%d %d vs %d\n", x, y,
+                        dst[y * s + x], ref[y * s + x]);
+                return MPP_NOK;
+            }
+
+    for (y = 0; y < (SWDEI_TEST_HEIGHT + 1) / 2; y++)
+        for (x = 0; x < (SWDEI_TEST_WIDTH + 1) / 2 * 2; x++)
+            if (dst[uv_offset + y * s + x] != ref[uv_offset + y * s + x]) {
+                mpp_err("chroma mismatch at %d,%d %d vs %d\n", x, y,
+                        dst[uv_offset + y * s + x], ref[uv_offset + y * s + x]);
+                return MPP_NOK;
+            }
+
+    return MPP_OK;
+}
+
+static void setup_task(SwdeiTask *task, MppBuffer src, MppBuffer dst,
+                       SwdeiMode mode, RK_U32 bottom)
+{
+    task->src = src;
+    task->dst = dst;
+    task->mode = mode;
+    task->width = SWDEI_TEST_WIDTH;
+    task->height = SWDEI_TEST_HEIGHT;
+    task->hor_stride = SWDEI_TEST_HOR_STRIDE;
+    task->ver_stride = SWDEI_TEST_VER_STRIDE;
+    task->bottom = bottom;
+}
+
+/* queue all mode and field combination in flight then check in wait order */
+static RK_S32 test_dei(SwdeiCtx ctx, MppBufferGroup group)
+{
+    MppBuffer src_buf = NULL;
+    MppBuffer dst_bufs[SWDEI_TASK_MAX];
+    SwdeiTask task;
+    RK_U8 *ref = NULL;
+    RK_U8 *src = NULL;
+    RK_S32 ret = MPP_NOK;
+    RK_S32 i;
+
+    memset(dst_bufs, 0, sizeof(dst_bufs));
+
+    ref = mpp_malloc(RK_U8, SWDEI_TEST_SIZE);
+    if (NULL == ref)
+        goto TEST_DONE;
+
+    if (mpp_buffer_get(group, &src_buf, SWDEI_TEST_SIZE))
+        goto TEST_DONE;
+
+    for (i = 0; i < SWDEI_TASK_MAX; i++)
+        if (mpp_buffer_get(group, &dst_bufs[i], SWDEI_TEST_SIZE))
+            goto TEST_DONE;
+
+    src = (RK_U8 *)mpp_buffer_get_ptr(src_buf);
+    srand(1);
+    for (i = 0; i < SWDEI_TEST_SIZE; i++)
+        src[i] = (RK_U8)rand();
+
+    for (i = 0; i < SWDEI_TASK_MAX; i++) {
+        memset(mpp_buffer_get_ptr(dst_bufs[i]), 0, SWDEI_TEST_SIZE);
+        setup_task(&task, src_buf, dst_bufs[i], (SwdeiMode)(i & 1), (i >> 1) & 1);
+        if (swdei_control(ctx, SWDEI_CMD_RUN_ASYNC, &task)) {
+            mpp_err("submit task %d failed\n", i);
+            goto TEST_DONE;
+        }
+    }
+
+    /* queue is full now */
+    setup_task(&task, src_buf, dst_bufs[0], SWDEI_MODE_BOB, 0);
+    if (!swdei_control(ctx, SWDEI_CMD_RUN_ASYNC, &task)) {
+        mpp_err("submit on full queue should fail\n");
+        goto TEST_DONE;
+    }
+
+    for (i = 0; i < SWDEI_TASK_MAX; i++) {
+        SwdeiMode mode = (SwdeiMode)(i & 1);
+        RK_U32 bottom = (i >> 1) & 1;
+
+        swdei_control(ctx, SWDEI_CMD_WAIT, NULL);
+
+        ref_dei(ref, src, bottom, mode);
+        if (compare((RK_U8 *)mpp_buffer_get_ptr(dst_bufs[i]), ref)) {
+            mpp_err("%s %s field mismatch\n", mode_names[mode],
+                    bottom ? "bottom" : "top");
+            goto TEST_DONE;
+        }
+
+        if (i < 4)
+            mpp_log("%s %s field match\n", mode_names[mode],
+                    bottom ? "bottom" : "top");
+    }
+
+    /* sync run after async ones */
+    setup_task(&task, src_buf, dst_bufs[0], SWDEI_MODE_LINEAR, 1);
+    if (swdei_control(ctx, SWDEI_CMD_RUN_SYNC, &task))
+        goto TEST_DONE;
+
+    ref_dei(ref, src, 1, SWDEI_MODE_LINEAR);
+    if (compare((RK_U8 *)mpp_buffer_get_ptr(dst_bufs[0]), ref)) {
+        mpp_err("sync run mismatch\n");
+        goto TEST_DONE;
+    }
+
+    /* invalid task */
+    task.height = SWDEI_TEST_VER_STRIDE + 1;
+    if (!swdei_control(ctx, SWDEI_CMD_RUN_SYNC, &task)) {
+        mpp_err("invalid task should fail\n");
+        goto TEST_DONE;
+    }
+
+    ret = MPP_OK;
+
+TEST_DONE:
+    if (src_buf)
+        mpp_buffer_put(src_buf);
+    for (i = 0; i < SWDEI_TASK_MAX; i++)
+        if (dst_bufs[i])
+            mpp_buffer_put(dst_bufs[i]);
+    MPP_FREE(ref);
+
+    return ret;
+}
+
+static RK_S32 test_perf(SwdeiCtx ctx, MppBufferGroup group)
+{
+    const RK_S32 size = SWDEI_PERF_WIDTH * SWDEI_PERF_HEIGHT * 3 / 2;
+    MppBuffer src_buf = NULL;
+    MppBuffer dst_bufs[2] = { NULL, NULL };
+    SwdeiTask task;
+    RK_S64 start;
+    RK_S32 ret = MPP_NOK;
+    RK_S32 i;
+
+    if (mpp_buffer_get(group, &src_buf, size) ||
+        mpp_buffer_get(group, &dst_bufs[0], size) ||
+        mpp_buffer_get(group, &dst_bufs[1], size))
+        goto TEST_DONE;
+
+    memset(mpp_buffer_get_ptr(src_buf), 0x80, size);
+
+    task.mode = SWDEI_MODE_LINEAR;
+    task.width = SWDEI_PERF_WIDTH;
+    task.height = SWDEI_PERF_HEIGHT;
+    task.hor_stride = SWDEI_PERF_WIDTH;
+    task.ver_stride = SWDEI_PERF_HEIGHT;
+    task.src = src_buf;
+
+    start = mpp_time();
+    /* two fields in flight as vproc does on 4 field in 2 frame out */
+    for (i = 0; i < SWDEI_PERF_LOOP; i += 2) {
+        task.dst = dst_bufs[0];
+        task.bottom = 0;
+        if (swdei_control(ctx, SWDEI_CMD_RUN_ASYNC, &task))
+            goto TEST_DONE;
+
+        task.dst = dst_bufs[1];
+        task.bottom = 1;
+        if (swdei_control(ctx, SWDEI_CMD_RUN_ASYNC, &task))
+            goto TEST_DONE;
+
+        swdei_control(ctx, SWDEI_CMD_WAIT, NULL);
+        swdei_control(ctx, SWDEI_CMD_WAIT, NULL);
+    }
+
+    mpp_log("linear %dx%d average %.3f ms per field\n",
+            SWDEI_PERF_WIDTH, SWDEI_PERF_HEIGHT,
+            (mpp_time() - start) / 1000.0 / SWDEI_PERF_LOOP);
+
+    ret = MPP_OK;
+
+TEST_DONE:
+    if (src_buf)
+        mpp_buffer_put(src_buf);
+    if (dst_bufs[0])
+        mpp_buffer_put(dst_bufs[0]);
+    if (dst_bufs[1])
+        mpp_buffer_put(dst_bufs[1]);
+
+    return ret;
+}
+
+int main()
+{
+    static const RK_U32 thread_nums[] = { 0, 1 };
+    MppBufferGroup group = NULL;
+    SwdeiCtx ctx = NULL;
+    RK_S32 ret = MPP_OK;
+    RK_U32 i;
+
+    mpp_log("swdei test start\n");
+
+    ret = mpp_buffer_group_get_internal(&group, MPP_BUFFER_TYPE_NORMAL);
+    if (ret)
+        goto TEST_DONE;
+
+    for (i = 0; i < MPP_ARRAY_ELEMS(thread_nums); i++) {
+        mpp_env_set_u32("swdei_thread_num", thread_nums[i]);
+        mpp_log("swdei test with %d thread\n", thread_nums[i]);
+
+        ret = swdei_init(&ctx);
+        if (ret)
+            goto TEST_DONE;
+
+        ret = test_dei(ctx, group);
+        if (!ret)
+            ret = test_perf(ctx, group);
+
+        swdei_deinit(ctx);
+        ctx = NULL;
+
+        if (ret)
+            goto TEST_DONE;
+    }
+
+TEST_DONE:
+    if (group)
+        mpp_buffer_group_put(group);
+
+    mpp_log("swdei test %s\n", ret ? "failed" : "success");
+    return ret;
+}
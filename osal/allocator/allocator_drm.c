@@ -363,6 +363,26 @@ static MPP_RET os_allocator_drm_mmap(void *ctx, MppBufferInfo *data)
     return ret;
 }
 
+static MPP_RET os_allocator_drm_munmap(void *ctx, MppBufferInfo *data)
+{
+    allocator_ctx_drm *p;
+
+    if (NULL == ctx) {
+        mpp_err_f("does not accept NULL input\n");
+        return MPP_ERR_NULL_PTR;
+    }
+    p = (allocator_ctx_drm *)ctx;
+
+    if (data->ptr) {
+        drm_dbg_func("dev %d munmap %p size %d\n", p->drm_device,
+                     data->ptr, data->size);
+        drm_munmap(data->ptr, data->size);
+        data->ptr = NULL;
+    }
+
+    return MPP_OK;
+}
+
 os_allocator allocator_drm = {
     .open = os_allocator_drm_open,
     .close = os_allocator_drm_close,
@@ -371,4 +391,5 @@ os_allocator allocator_drm = {
     .import = os_allocator_drm_import,
     .release = os_allocator_drm_free,
     .mmap = os_allocator_drm_mmap,
+    .munmap = os_allocator_drm_munmap,
 };
@@ -108,6 +108,19 @@ static MPP_RET allocator_ext_dma_mmap(void *ctx, MppBufferInfo *info)
     return MPP_OK;
 }
 
+static MPP_RET allocator_ext_dma_munmap(void *ctx, MppBufferInfo *info)
+{
+    mpp_assert(ctx);
+    mpp_assert(info->size);
+
+    if (info->ptr) {
+        munmap(info->ptr, info->size);
+        info->ptr = NULL;
+    }
+
+    return MPP_OK;
+}
+
 static MPP_RET allocator_ext_dma_release(void *ctx, MppBufferInfo *info)
 {
     mpp_assert(ctx);
@@ -143,4 +156,5 @@ os_allocator allocator_ext_dma = {
     .import = allocator_ext_dma_import,
     .release = allocator_ext_dma_release,
     .mmap = allocator_ext_dma_mmap,
+    .munmap = allocator_ext_dma_munmap,
 };
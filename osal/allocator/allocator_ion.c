@@ -427,6 +427,25 @@ static MPP_RET allocator_ion_mmap(void *ctx, MppBufferInfo *data)
     return ret;
 }
 
+static MPP_RET allocator_ion_munmap(void *ctx, MppBufferInfo *data)
+{
+    if (NULL == ctx) {
+        mpp_err_f("do not accept NULL input\n");
+        return MPP_ERR_NULL_PTR;
+    }
+
+    ion_dbg_func("enter: ctx %p fd %d ptr %p size %d\n",
+                 ctx, data->fd, data->ptr, data->size);
+
+    if (data->ptr) {
+        munmap(data->ptr, data->size);
+        data->ptr = NULL;
+    }
+
+    ion_dbg_func("leave\n");
+    return MPP_OK;
+}
+
 static MPP_RET allocator_ion_free(void *ctx, MppBufferInfo *data)
 {
     allocator_ctx_ion *p = NULL;
@@ -489,5 +508,6 @@ os_allocator allocator_ion = {
     .import = allocator_ion_import,
     .release = allocator_ion_free,
     .mmap = allocator_ion_mmap,
+    .munmap = allocator_ion_munmap,
 };
 
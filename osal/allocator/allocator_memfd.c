@@ -0,0 +1,301 @@
+/*
+ * Copyright 2018 Rockchip Electronics Co. LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define MODULE_TAG "mpp_memfd"
+
+#include <unistd.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+
+#include "allocator_memfd.h"
+
+#include "mpp_env.h"
+#include "mpp_mem.h"
+#include "mpp_log.h"
+#include "mpp_common.h"
+
+#ifndef MFD_CLOEXEC
+#define MFD_CLOEXEC                 0x0001U
+#endif
+#ifndef MFD_HUGETLB
+#define MFD_HUGETLB                 0x0004U
+#endif
+
+#define MEMFD_HUGE_PAGE_SIZE        (SZ_1M * 2)
+
+#define MEMFD_FUNCTION              (0x00000001)
+#define MEMFD_HUGE_PAGE             (0x00000002)
+
+#define memfd_dbg(flag, fmt, ...)   _mpp_dbg(memfd_debug, flag, fmt, ## __VA_ARGS__)
+#define memfd_dbg_f(flag, fmt, ...) _mpp_dbg_f(memfd_debug, flag, fmt, ## __VA_ARGS__)
+#define memfd_dbg_func(fmt, ...)    memfd_dbg_f(MEMFD_FUNCTION, fmt, ## __VA_ARGS__)
+
+/*
+ * Normal buffer allocator on memfd. Buffer has a real fd which can be shared
+ * with other process or imported by dma-buf path like ion / drm buffer.
+ *
+ * Large buffer tries hugetlb memfd for 2MB huge page first to reduce TLB miss
+ * on software access. The huge page pool may not be reserved in system so
+ * the first failure disables huge page on the allocator.
+ */
+typedef struct {
+    RK_U32  huge_enable;
+} allocator_ctx_memfd;
+
+static RK_U32 memfd_debug = 0;
+
+static int memfd_create_fd(const char *name, RK_U32 flags)
+{
+#if defined(__NR_memfd_create)
+    return syscall(__NR_memfd_create, name, flags);
+#else
+    (void)name;
+    (void)flags;
+    errno = ENOSYS;
+    return -1;
+#endif
+}
+
+static MPP_RET memfd_map_fd(RK_S32 fd, size_t size, void **ptr)
+{
+    void *p = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+
+    if (p == MAP_FAILED)
+        return MPP_ERR_NULL_PTR;
+
+#if defined(MADV_HUGEPAGE)
+    /* let shmem transparent huge page work on normal memfd */
+    if (size >= MEMFD_HUGE_PAGE_SIZE)
+        madvise(p, size, MADV_HUGEPAGE);
+#endif
+
+    *ptr = p;
+    return MPP_OK;
+}
+
+static MPP_RET allocator_memfd_open(void **ctx, MppAllocatorCfg *cfg)
+{
+    allocator_ctx_memfd *p = NULL;
+
+    if (NULL == ctx) {
+        mpp_err_f("do not accept NULL input\n");
+        return MPP_ERR_NULL_PTR;
+    }
+
+    mpp_env_get_u32("memfd_debug", &memfd_debug, 0);
+
+    p = mpp_malloc(allocator_ctx_memfd, 1);
+    if (NULL == p) {
+        mpp_err_f("failed to allocate context\n");
+        *ctx = NULL;
+        return MPP_ERR_MALLOC;
+    }
+
+    (void)cfg;
+    p->huge_enable = 1;
+    mpp_env_get_u32("memfd_huge_page", &p->huge_enable, 1);
+
+    *ctx = p;
+    return MPP_OK;
+}
+
+/*
+ * hugetlb memfd reserves huge pages on mmap. Map it on allocation to detect
+ * empty huge page pool instead of failing on the later cpu access.
+ */
+static RK_S32 allocator_memfd_alloc_huge(allocator_ctx_memfd *p, MppBufferInfo *info)
+{
+    size_t size = MPP_ALIGN(info->size, MEMFD_HUGE_PAGE_SIZE);
+    void *ptr = NULL;
+    RK_S32 fd = memfd_create_fd("mpp_buffer_huge", MFD_CLOEXEC | MFD_HUGETLB);
+
+    if (fd < 0)
+        goto FAILED;
+
+    if (ftruncate(fd, size) || memfd_map_fd(fd, size, &ptr)) {
+        close(fd);
+        goto FAILED;
+    }
+
+    // huge page buffer size is aligned for mmap / munmap on hugetlbfs
+    info->fd = fd;
+    info->ptr = ptr;
+    info->size = size;
+
+    memfd_dbg(MEMFD_HUGE_PAGE, "alloc huge page fd %d size %d\n", fd, size);
+    return fd;
+
+FAILED:
+    memfd_dbg(MEMFD_HUGE_PAGE, "huge page is disabled for %s\n", strerror(errno));
+    p->huge_enable = 0;
+    return -1;
+}
+
+static MPP_RET allocator_memfd_alloc(void *ctx, MppBufferInfo *info)
+{
+    allocator_ctx_memfd *p = (allocator_ctx_memfd *)ctx;
+    RK_S32 fd = -1;
+
+    if (NULL == ctx) {
+        mpp_err_f("found NULL context input\n");
+        return MPP_ERR_NULL_PTR;
+    }
+
+    memfd_dbg_func("enter: ctx %p size %d\n", ctx, info->size);
+
+    if (p->huge_enable && info->size >= MEMFD_HUGE_PAGE_SIZE)
+        fd = allocator_memfd_alloc_huge(p, info);
+
+    if (fd < 0) {
+        fd = memfd_create_fd("mpp_buffer", MFD_CLOEXEC);
+        if (fd < 0) {
+            mpp_err_f("memfd_create failed for %s\n", strerror(errno));
+            return MPP_ERR_MALLOC;
+        }
+
+        if (ftruncate(fd, info->size)) {
+            mpp_err_f("fd %d resize to %d failed for %s\n", fd, info->size,
+                      strerror(errno));
+            close(fd);
+            return MPP_ERR_MALLOC;
+        }
+
+        // cpu mapping is created on first access
+        info->fd = fd;
+        info->ptr = NULL;
+    }
+
+    info->hnd = NULL;
+
+    memfd_dbg_func("leave: fd %d ptr %p size %d\n", info->fd, info->ptr, info->size);
+    return MPP_OK;
+}
+
+static MPP_RET allocator_memfd_free(void *ctx, MppBufferInfo *info)
+{
+    (void) ctx;
+
+    memfd_dbg_func("enter: fd %d ptr %p size %d\n", info->fd, info->ptr, info->size);
+
+    // imported user memory is not owned by allocator
+    if (info->fd < 0) {
+        info->ptr = NULL;
+        return MPP_OK;
+    }
+
+    if (info->ptr) {
+        munmap(info->ptr, info->size);
+        info->ptr = NULL;
+    }
+
+    if (info->fd >= 0) {
+        close(info->fd);
+        info->fd = -1;
+    }
+
+    return MPP_OK;
+}
+
+static MPP_RET allocator_memfd_import(void *ctx, MppBufferInfo *info)
+{
+    RK_S32 fd;
+
+    mpp_assert(ctx);
+    mpp_assert(info->size);
+
+    /*
+     * user memory is kept as it is like normal allocator and the fd is
+     * ignored. Caller may commit memory with a zero fd from memset info.
+     */
+    if (info->ptr) {
+        info->fd = -1;
+        info->hnd = NULL;
+        return MPP_OK;
+    }
+
+    if (info->fd < 0) {
+        mpp_err_f("invalid import without fd and ptr\n");
+        return MPP_ERR_VALUE;
+    }
+
+    // hold a new fd and mapping to make buffer life independent to user
+    fd = fcntl(info->fd, F_DUPFD_CLOEXEC, 0);
+    if (fd < 0) {
+        mpp_err_f("fd %d import failed for %s\n", info->fd, strerror(errno));
+        return MPP_NOK;
+    }
+
+    info->fd = fd;
+    info->ptr = NULL;
+    info->hnd = NULL;
+    return MPP_OK;
+}
+
+static MPP_RET allocator_memfd_mmap(void *ctx, MppBufferInfo *info)
+{
+    MPP_RET ret = MPP_OK;
+
+    mpp_assert(ctx);
+    mpp_assert(info->size);
+
+    if (NULL == info->ptr && info->fd >= 0)
+        ret = memfd_map_fd(info->fd, info->size, &info->ptr);
+
+    if (ret)
+        mpp_err_f("fd %d size %d mmap failed for %s\n", info->fd, info->size,
+                  strerror(errno));
+
+    return ret;
+}
+
+static MPP_RET allocator_memfd_munmap(void *ctx, MppBufferInfo *info)
+{
+    mpp_assert(ctx);
+
+    if (info->fd < 0)
+        return MPP_NOK;
+
+    if (info->ptr) {
+        munmap(info->ptr, info->size);
+        info->ptr = NULL;
+    }
+
+    return MPP_OK;
+}
+
+static MPP_RET allocator_memfd_close(void *ctx)
+{
+    if (ctx) {
+        mpp_free(ctx);
+        return MPP_OK;
+    }
+    mpp_err_f("found NULL context input\n");
+    return MPP_NOK;
+}
+
+os_allocator allocator_memfd = {
+    .open = allocator_memfd_open,
+    .close = allocator_memfd_close,
+    .alloc = allocator_memfd_alloc,
+    .free = allocator_memfd_free,
+    .import = allocator_memfd_import,
+    .release = allocator_memfd_free,
+    .mmap = allocator_memfd_mmap,
+    .munmap = allocator_memfd_munmap,
+};
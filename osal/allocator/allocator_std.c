@@ -103,6 +103,14 @@ static MPP_RET allocator_std_mmap(void *ctx, MppBufferInfo *info)
     return MPP_OK;
 }
 
+/* normal buffer is heap memory which can not be unmapped */
+static MPP_RET allocator_std_munmap(void *ctx, MppBufferInfo *info)
+{
+    mpp_assert(ctx);
+    (void) info;
+    return MPP_NOK;
+}
+
 static MPP_RET allocator_std_close(void *ctx)
 {
     if (ctx) {
@@ -121,5 +129,6 @@ os_allocator allocator_std = {
     .import = allocator_std_import,
     .release = allocator_std_release,
     .mmap = allocator_std_mmap,
+    .munmap = allocator_std_munmap,
 };
 
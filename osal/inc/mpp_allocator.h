@@ -37,6 +37,7 @@ typedef struct MppAllocatorApi_t {
     MPP_RET (*import)(MppAllocator allocator, MppBufferInfo *data);
     MPP_RET (*release)(MppAllocator allocator, MppBufferInfo *data);
     MPP_RET (*mmap)(MppAllocator allocator, MppBufferInfo *data);
+    MPP_RET (*munmap)(MppAllocator allocator, MppBufferInfo *data);
 } MppAllocatorApi;
 
 #ifdef __cplusplus
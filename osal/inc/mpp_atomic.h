@@ -0,0 +1,85 @@
+/*
+ * Copyright 2018 Rockchip Electronics Co. LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __MPP_ATOMIC_H__
+#define __MPP_ATOMIC_H__
+
+#include "rk_type.h"
+
+/*
+ * Atomic operation wrapper for different compiler
+ *
+ * All operations are full memory barrier except MPP_LOCK_XCHG which is an
+ * acquire barrier only. Only 32bit and pointer size data are supported on
+ * all platforms. 64bit data must use the 64 suffix version which may need
+ * libatomic on 32bit platform without native 64bit atomic instruction.
+ */
+#if defined(_MSC_VER)
+
+#include <windows.h>
+#include <intrin.h>
+
+#define MPP_FETCH_ADD(ptr, val)     InterlockedExchangeAdd((volatile LONG *)(ptr), (LONG)(val))
+#define MPP_FETCH_SUB(ptr, val)     InterlockedExchangeAdd((volatile LONG *)(ptr), -(LONG)(val))
+#define MPP_FETCH_OR(ptr, val)      _InterlockedOr((volatile LONG *)(ptr), (LONG)(val))
+#define MPP_FETCH_AND(ptr, val)     _InterlockedAnd((volatile LONG *)(ptr), (LONG)(val))
+#define MPP_ADD_FETCH(ptr, val)     (MPP_FETCH_ADD(ptr, val) + (val))
+#define MPP_SUB_FETCH(ptr, val)     (MPP_FETCH_SUB(ptr, val) - (val))
+#define MPP_BOOL_CAS(ptr, old, val) \
+    (InterlockedCompareExchange((volatile LONG *)(ptr), (LONG)(val), (LONG)(old)) == (LONG)(old))
+#define MPP_PTR_CAS(ptr, old, val)  \
+    (InterlockedCompareExchangePointer((PVOID volatile *)(ptr), (PVOID)(val), (PVOID)(old)) == (PVOID)(old))
+#define MPP_LOCK_XCHG(ptr, val)     InterlockedExchangePointer((PVOID volatile *)(ptr), (PVOID)(val))
+#define MPP_SYNC()                  MemoryBarrier()
+
+#define MPP_FETCH_ADD64(ptr, val)   InterlockedExchangeAdd64((volatile LONGLONG *)(ptr), (LONGLONG)(val))
+#define MPP_FETCH_AND64(ptr, val)   InterlockedAnd64((volatile LONGLONG *)(ptr), (LONGLONG)(val))
+
+static __inline RK_S32 mpp_ctz(RK_U32 val)
+{
+    unsigned long idx = 0;
+    _BitScanForward(&idx, val);
+    return (RK_S32)idx;
+}
+
+#else
+
+#define MPP_FETCH_ADD(ptr, val)     __sync_fetch_and_add(ptr, val)
+#define MPP_FETCH_SUB(ptr, val)     __sync_fetch_and_sub(ptr, val)
+#define MPP_FETCH_OR(ptr, val)      __sync_fetch_and_or(ptr, val)
+#define MPP_FETCH_AND(ptr, val)     __sync_fetch_and_and(ptr, val)
+#define MPP_ADD_FETCH(ptr, val)     __sync_add_and_fetch(ptr, val)
+#define MPP_SUB_FETCH(ptr, val)     __sync_sub_and_fetch(ptr, val)
+#define MPP_BOOL_CAS(ptr, old, val) __sync_bool_compare_and_swap(ptr, old, val)
+#define MPP_PTR_CAS(ptr, old, val)  __sync_bool_compare_and_swap(ptr, old, val)
+#define MPP_LOCK_XCHG(ptr, val)     __sync_lock_test_and_set(ptr, val)
+#define MPP_SYNC()                  __sync_synchronize()
+
+#define MPP_FETCH_ADD64(ptr, val)   __sync_fetch_and_add(ptr, val)
+#define MPP_FETCH_AND64(ptr, val)   __sync_fetch_and_and(ptr, val)
+
+/* NOTE: val can not be zero */
+static __inline RK_S32 mpp_ctz(RK_U32 val)
+{
+    return __builtin_ctz(val);
+}
+
+#endif
+
+/* atomic read of a 32bit value which may be modified by other threads */
+#define MPP_ATOMIC_READ(ptr)        MPP_FETCH_ADD(ptr, 0)
+
+#endif /*__MPP_ATOMIC_H__*/
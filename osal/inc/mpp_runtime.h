@@ -29,6 +29,12 @@ extern "C" {
  */
 RK_U32 mpp_rt_allcator_is_valid(MppBufferType type);
 
+/*
+ * memfd is used as normal buffer allocator with real fd when it is valid.
+ * It can be disabled by env mpp_rt_memfd=0.
+ */
+RK_U32 mpp_rt_memfd_is_valid(void);
+
 #ifdef __cplusplus
 }
 #endif
@@ -197,6 +197,7 @@ public:
     void lock()     { mLock.lock(); }
     void unlock()   { mLock.unlock(); }
     void wait()     { mCondition.wait(mLock); }
+    RK_S32 wait(RK_S64 timeout) { return mCondition.timedwait(mLock, timeout); }
     void signal()   { mCondition.signal(); }
     Mutex *mutex()  { return &mLock; }
 
@@ -252,6 +253,22 @@ public:
             mStatus[id] = status;
     }
 
+    // wait with timeout in ms, return non-zero on timeout
+    RK_S32 timedwait(RK_S64 timeout, MppThreadSignal id = THREAD_WORK) {
+        mpp_assert(id < THREAD_SIGNAL_BUTT);
+        MppThreadStatus status = mStatus[id];
+        RK_S32 ret;
+
+        mStatus[id] = MPP_THREAD_WAITING;
+        ret = mMutexCond[id].wait(timeout);
+
+        // check the status is not changed then restore status
+        if (mStatus[id] == MPP_THREAD_WAITING)
+            mStatus[id] = status;
+
+        return ret;
+    }
+
     void signal(MppThreadSignal id = THREAD_WORK) {
         mpp_assert(id < THREAD_SIGNAL_BUTT);
         mMutexCond[id].signal();
@@ -21,6 +21,7 @@
 #include "allocator_drm.h"
 #include "allocator_ext_dma.h"
 #include "allocator_ion.h"
+#include "allocator_memfd.h"
 #include "allocator_std.h"
 
 /*
@@ -33,13 +34,14 @@ MPP_RET os_allocator_get(os_allocator *api, MppBufferType type)
     MPP_RET ret = MPP_OK;
     switch (type) {
     case MPP_BUFFER_TYPE_NORMAL : {
-        *api = allocator_std;
+        *api = (mpp_rt_memfd_is_valid()) ? allocator_memfd : allocator_std;
     } break;
     case MPP_BUFFER_TYPE_ION : {
         *api = (mpp_rt_allcator_is_valid(MPP_BUFFER_TYPE_ION)) ? allocator_ion :
 #if HAVE_DRM
                (mpp_rt_allcator_is_valid(MPP_BUFFER_TYPE_DRM)) ? allocator_drm :
 #endif
+               (mpp_rt_memfd_is_valid()) ? allocator_memfd :
                allocator_std;
     } break;
     case MPP_BUFFER_TYPE_EXT_DMA: {
@@ -52,6 +54,7 @@ MPP_RET os_allocator_get(os_allocator *api, MppBufferType type)
         * api =
 #endif
                (mpp_rt_allcator_is_valid(MPP_BUFFER_TYPE_ION)) ? allocator_ion :
+               (mpp_rt_memfd_is_valid()) ? allocator_memfd :
                allocator_std;
     } break;
     default : {
@@ -35,6 +35,7 @@ typedef enum OsAllocatorApiId_e {
     ALLOC_API_IMPORT,
     ALLOC_API_RELEASE,
     ALLOC_API_MMAP,
+    ALLOC_API_MUNMAP,
     ALLOC_API_BUTT,
 } OsAllocatorApiId;
 
@@ -69,6 +70,9 @@ static MPP_RET mpp_allocator_api_wrapper(MppAllocator allocator,
     case ALLOC_API_MMAP : {
         func = p->os_api.mmap;
     } break;
+    case ALLOC_API_MUNMAP : {
+        func = p->os_api.munmap;
+    } break;
     default : {
         func = NULL;
     } break;
@@ -108,6 +112,11 @@ static MPP_RET mpp_allocator_mmap(MppAllocator allocator, MppBufferInfo *info)
     return mpp_allocator_api_wrapper(allocator, info, ALLOC_API_MMAP);
 }
 
+static MPP_RET mpp_allocator_munmap(MppAllocator allocator, MppBufferInfo *info)
+{
+    return mpp_allocator_api_wrapper(allocator, info, ALLOC_API_MUNMAP);
+}
+
 static MppAllocatorApi mpp_allocator_api = {
     .size = sizeof(mpp_allocator_api),
     .version = 1,
@@ -116,6 +125,7 @@ static MppAllocatorApi mpp_allocator_api = {
     .import = mpp_allocator_import,
     .release =  mpp_allocator_release,
     .mmap  = mpp_allocator_mmap,
+    .munmap = mpp_allocator_munmap,
 };
 
 MPP_RET mpp_allocator_get(MppAllocator *allocator,
@@ -18,7 +18,9 @@
 
 #include <fcntl.h>
 #include <unistd.h>
+#include <sys/syscall.h>
 
+#include "mpp_env.h"
 #include "mpp_log.h"
 #include "mpp_common.h"
 #include "mpp_runtime.h"
@@ -58,6 +60,7 @@ private:
     MppRuntimeService &operator=(const MppRuntimeService &);
 
     RK_U32  allocator_valid[MPP_BUFFER_TYPE_BUTT];
+    RK_U32  memfd_valid;
 
 public:
     static MppRuntimeService *get_instance() {
@@ -66,6 +69,7 @@ public:
     }
 
     RK_U32 get_allocator_valid(MppBufferType type);
+    RK_U32 get_memfd_valid() { return memfd_valid; };
 };
 
 RK_U32 MppRuntimeService::get_allocator_valid(MppBufferType type)
@@ -150,9 +154,30 @@ MppRuntimeService::MppRuntimeService()
         if (!allocator_found)
             mpp_log("Can NOT found allocator in dts, enable both ion and drm\n");
     }
+
+    memfd_valid = 0;
+    mpp_env_get_u32("mpp_rt_memfd", &memfd_valid, 1);
+    if (memfd_valid) {
+#if defined(__NR_memfd_create)
+        int fd = syscall(__NR_memfd_create, "mpp_rt", 0);
+
+        if (fd >= 0)
+            close(fd);
+        else
+            memfd_valid = 0;
+#else
+        memfd_valid = 0;
+#endif
+        mpp_log("%s memfd allocator\n", memfd_valid ? "found" : "NOT found");
+    }
 }
 
 RK_U32 mpp_rt_allcator_is_valid(MppBufferType type)
 {
     return MppRuntimeService::get_instance()->get_allocator_valid(type);
 }
+
+RK_U32 mpp_rt_memfd_is_valid(void)
+{
+    return MppRuntimeService::get_instance()->get_memfd_valid();
+}
@@ -30,6 +30,7 @@ typedef struct os_allocator_t {
     OsAllocatorFunc import;
     OsAllocatorFunc release;
     OsAllocatorFunc mmap;
+    OsAllocatorFunc munmap;
 } os_allocator;
 
 #ifdef __cplusplus
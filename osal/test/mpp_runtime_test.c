@@ -31,5 +31,10 @@ int main()
     else
         mpp_log("mpp found drm buffer is invalid\n");
 
+    if (mpp_rt_memfd_is_valid())
+        mpp_log("mpp found memfd buffer is valid\n");
+    else
+        mpp_log("mpp found memfd buffer is invalid\n");
+
     return 0;
 }
@@ -58,6 +58,9 @@ typedef struct {
     RK_S32          frame_count;
     RK_S32          frame_num;
     size_t          max_usage;
+
+    /* downscale by software when decoder can not do it */
+    RK_U32          sw_scale;
 } MpiDecLoopData;
 
 typedef struct {
@@ -69,6 +72,8 @@ typedef struct {
     RK_U32          width;
     RK_U32          height;
     RK_U32          debug;
+    RK_U32          scale;
+    MppDecSkipCfg   skip;
 
     RK_U32          have_input;
     RK_U32          have_output;
@@ -81,6 +86,8 @@ typedef struct {
 
     // report information
     size_t          max_usage;
+    RK_S32          frame_count;
+    RK_S64          elapsed;
 } MpiDecTestCmd;
 
 static OptionInfo mpi_dec_cmd[] = {
@@ -94,8 +101,50 @@ static OptionInfo mpi_dec_cmd[] = {
     {"d",               "debug",                "debug flag"},
     {"x",               "timeout",              "output timeout interval"},
     {"n",               "frame_number",         "max output frame number"},
+    {"s",               "scale",                "output downscale ratio 1 / 2 / 4 / 8"},
+    {"k",               "skip",                 "skip mode[:interval] 1 - non-ref 2 - non-key 3 - gop"},
 };
 
+static void dump_frame(MpiDecLoopData *data, MppFrame frame)
+{
+    RK_U32 scale = data->sw_scale;
+    RK_U32 width = mpp_frame_get_width(frame);
+    RK_U32 height = mpp_frame_get_height(frame);
+    RK_U32 hor_stride = mpp_frame_get_hor_stride(frame);
+    RK_U32 ver_stride = mpp_frame_get_ver_stride(frame);
+    MppFrameFormat fmt = mpp_frame_get_fmt(frame);
+    MppBuffer buffer = mpp_frame_get_buffer(frame);
+    RK_U32 out_w, out_h, out_stride, i;
+    RK_U8 *tmp = NULL;
+
+    if (scale <= 1 || fmt != MPP_FMT_YUV420SP || NULL == buffer) {
+        dump_mpp_frame_to_file(frame, data->fp_output);
+        return ;
+    }
+
+    /*
+     * decoder can not scale this coding, downscale with software box filter.
+     * The output size matches the post-processor but pixels are not bit
+     * exact as the post-processor uses bilinear filter.
+     */
+    out_w = (width + scale - 1) / scale;
+    out_h = (height + scale - 1) / scale;
+    out_stride = MPP_ALIGN(out_w, 16);
+    tmp = mpp_malloc(RK_U8, out_stride * out_h * 3 / 2 + out_stride);
+    if (NULL == tmp)
+        return ;
+
+    scale_yuv_image(tmp, mpp_buffer_get_ptr(buffer), width, height,
+                    hor_stride, ver_stride, out_stride, out_h, fmt, scale);
+
+    for (i = 0; i < out_h; i++)
+        fwrite(tmp + i * out_stride, 1, out_w, data->fp_output);
+    for (i = 0; i < out_h / 2; i++)
+        fwrite(tmp + (out_h + i) * out_stride, 1, out_w, data->fp_output);
+
+    mpp_free(tmp);
+}
+
 static int decode_simple(MpiDecLoopData *data)
 {
     RK_U32 pkt_done = 0;
@@ -323,7 +372,7 @@ static int decode_simple(MpiDecLoopData *data)
                     data->frame_count++;
                     mpp_log("decode_get_frame get frame %d\n", data->frame_count);
                     if (data->fp_output && !err_info)
-                        dump_mpp_frame_to_file(frame, data->fp_output);
+                        dump_frame(data, frame);
                 }
                 frm_eos = mpp_frame_get_eos(frame);
                 mpp_frame_deinit(&frame);
@@ -453,7 +502,7 @@ static int decode_advanced(MpiDecLoopData *data)
         if (frame) {
             /* write frame to file here */
             if (data->fp_output)
-                dump_mpp_frame_to_file(frame, data->fp_output);
+                dump_frame(data, frame);
 
             data->frame_count++;
             mpp_log("decoded frame %d\n", data->frame_count);
@@ -499,6 +548,7 @@ int mpi_dec_test_decode(MpiDecTestCmd *cmd)
     size_t packet_size  = cmd->pkt_size;
     MppBuffer pkt_buf   = NULL;
     MppBuffer frm_buf   = NULL;
+    RK_S64 time_start   = 0;
 
     MpiDecLoopData data;
 
@@ -645,6 +695,24 @@ int mpi_dec_test_decode(MpiDecTestCmd *cmd)
     data.frame_count    = 0;
     data.frame_num      = cmd->frame_num;
 
+    if (cmd->scale > 1) {
+        ret = mpi->control(ctx, MPP_DEC_SET_OUTPUT_SCALE, &cmd->scale);
+        if (ret) {
+            mpp_log("decoder can not scale output, use software scaler\n");
+            data.sw_scale = cmd->scale;
+        }
+    }
+
+    if (cmd->skip.mode) {
+        ret = mpi->control(ctx, MPP_DEC_SET_SKIP_MODE, &cmd->skip);
+        if (ret) {
+            mpp_err("decoder can not set skip mode %d\n", cmd->skip.mode);
+            goto MPP_TEST_OUT;
+        }
+    }
+
+    time_start = mpp_time();
+
     if (cmd->simple) {
         while (!data.eos) {
             decode_simple(&data);
@@ -659,7 +727,9 @@ int mpi_dec_test_decode(MpiDecTestCmd *cmd)
         }
     }
 
+    cmd->elapsed = mpp_time() - time_start;
     cmd->max_usage = data.max_usage;
+    cmd->frame_count = data.frame_count;
 
     ret = mpi->reset(ctx);
     if (MPP_OK != ret) {
@@ -863,6 +933,31 @@ static RK_S32 mpi_dec_test_parse_options(int argc, char **argv, MpiDecTestCmd* c
                     goto PARSE_OPINIONS_OUT;
                 }
                 break;
+            case 'k':
+                if (next) {
+                    char *interval = strchr(next, ':');
+
+                    cmd->skip.mode = (MppDecSkipMode)atoi(next);
+                    cmd->skip.interval = (interval) ? (atoi(interval + 1)) : (0);
+                }
+
+                if (!next || cmd->skip.mode >= MPP_DEC_SKIP_BUTT ||
+                    (cmd->skip.mode == MPP_DEC_SKIP_GOP && !cmd->skip.interval)) {
+                    mpp_err("invalid skip mode\n");
+                    goto PARSE_OPINIONS_OUT;
+                }
+                break;
+            case 's':
+                if (next) {
+                    cmd->scale = atoi(next);
+                }
+
+                if (!next || (cmd->scale != 1 && cmd->scale != 2 &&
+                              cmd->scale != 4 && cmd->scale != 8)) {
+                    mpp_err("invalid output scale\n");
+                    goto PARSE_OPINIONS_OUT;
+                }
+                break;
             default:
                 mpp_err("skip invalid opt %c\n", *opt);
                 break;
@@ -919,9 +1014,12 @@ int main(int argc, char **argv)
     cmd->simple = (cmd->type != MPP_VIDEO_CodingMJPEG) ? (1) : (0);
 
     ret = mpi_dec_test_decode(cmd);
-    if (MPP_OK == ret)
+    if (MPP_OK == ret) {
         mpp_log("test success max memory %.2f MB\n", cmd->max_usage / (float)(1 << 20));
-    else
+        if (cmd->elapsed > 0)
+            mpp_log("decoded %d frames in %lld us fps %.2f\n", cmd->frame_count,
+                    cmd->elapsed, cmd->frame_count * 1000000.0 / cmd->elapsed);
+    } else
         mpp_err("test failed ret %d\n", ret);
 
     mpp_env_set_u32("mpi_debug", 0x0);
@@ -42,6 +42,7 @@ typedef struct {
     MppFrameFormat  format;
     RK_U32          debug;
     RK_U32          num_frames;
+    RK_U32          slice_mbs;
 
     RK_U32          have_input;
     RK_U32          have_output;
@@ -54,6 +55,10 @@ typedef struct {
     RK_U32 frame_count;
     RK_U64 stream_size;
 
+    // latency from frame put to first / last packet get in us
+    RK_S64 first_pkt_time;
+    RK_S64 frame_time;
+
     // src and dst
     FILE *fp_input;
     FILE *fp_output;
@@ -77,6 +82,7 @@ typedef struct {
     MppFrameFormat fmt;
     MppCodingType type;
     RK_U32 num_frames;
+    RK_U32 slice_mbs;
 
     // resources
     size_t frame_size;
@@ -97,6 +103,7 @@ static OptionInfo mpi_enc_cmd[] = {
     {"f",               "format",               "the format of input picture"},
     {"t",               "type",                 "output stream coding type"},
     {"n",               "max frame number",     "max encoding frame number"},
+    {"s",               "slice mb count",       "split slice by mb count and output slice by slice"},
     {"d",               "debug",                "debug flag"},
 };
 
@@ -127,6 +134,7 @@ MPP_RET test_ctx_init(MpiEncTestData **data, MpiEncTestCmd *cmd)
     if (cmd->type == MPP_VIDEO_CodingMJPEG)
         cmd->num_frames = 1;
     p->num_frames   = cmd->num_frames;
+    p->slice_mbs    = cmd->slice_mbs;
 
     if (cmd->have_input) {
         p->fp_input = fopen(cmd->file_input, "rb");
@@ -320,6 +328,21 @@ MPP_RET test_mpp_setup(MpiEncTestData *p)
         goto RET;
     }
 
+    /* optional low delay slice output */
+    if (p->slice_mbs) {
+        MppEncSliceSplit split;
+
+        split.split_en = 1;
+        split.split_mode = MPP_ENC_SPLIT_BY_CTU;
+        split.slice_size = p->slice_mbs;
+        split.split_out = 1;
+        ret = mpi->control(ctx, MPP_ENC_SET_SPLIT, &split);
+        if (ret) {
+            mpp_err("mpi control enc set split failed ret %d\n", ret);
+            goto RET;
+        }
+    }
+
 RET:
     return ret;
 }
@@ -360,6 +383,9 @@ MPP_RET test_mpp_run(MpiEncTestData *p)
         MppFrame frame = NULL;
         MppPacket packet = NULL;
         void *buf = mpp_buffer_get_ptr(p->frm_buf);
+        RK_S64 start = 0;
+        size_t frm_len = 0;
+        RK_U32 frm_end = 0;
 
         if (p->fp_input) {
             ret = read_yuv_image(buf, p->fp_input, p->width, p->height,
@@ -394,31 +420,55 @@ MPP_RET test_mpp_run(MpiEncTestData *p)
         else
             mpp_frame_set_buffer(frame, p->frm_buf);
 
+        start = mpp_time();
         ret = mpi->encode_put_frame(ctx, frame);
         if (ret) {
             mpp_err("mpp encode put frame failed\n");
             goto RET;
         }
 
-        ret = mpi->encode_get_packet(ctx, &packet);
-        if (ret) {
-            mpp_err("mpp encode get packet failed\n");
-            goto RET;
-        }
+        /* on slice output one frame is returned in multiple packets */
+        do {
+            void *ptr;
+            size_t len;
+
+            ret = mpi->encode_get_packet(ctx, &packet);
+            if (ret) {
+                mpp_err("mpp encode get packet failed\n");
+                goto RET;
+            }
+
+            if (NULL == packet) {
+                /* no output for this frame yet */
+                if (!frm_len)
+                    break;
+
+                /* wait for the rest of the slices until the eoi packet */
+                msleep(1);
+                continue;
+            }
 
-        if (packet) {
             // write packet to file here
-            void *ptr   = mpp_packet_get_pos(packet);
-            size_t len  = mpp_packet_get_length(packet);
+            ptr = mpp_packet_get_pos(packet);
+            len = mpp_packet_get_length(packet);
+
+            if (!frm_len)
+                p->first_pkt_time += mpp_time() - start;
 
+            frm_end = !mpp_packet_is_partition(packet) || mpp_packet_is_eoi(packet);
+            frm_len += len;
             p->pkt_eos = mpp_packet_get_eos(packet);
 
             if (p->fp_output)
                 fwrite(ptr, 1, len, p->fp_output);
             mpp_packet_deinit(&packet);
+        } while (!frm_end);
+
+        if (frm_end) {
+            p->frame_time += mpp_time() - start;
 
-            mpp_log_f("encoded frame %d size %d\n", p->frame_count, len);
-            p->stream_size += len;
+            mpp_log_f("encoded frame %d size %d\n", p->frame_count, frm_len);
+            p->stream_size += frm_len;
             p->frame_count++;
 
             if (p->pkt_eos) {
@@ -503,10 +553,13 @@ MPP_TEST_OUT:
         p->frm_buf = NULL;
     }
 
-    if (MPP_OK == ret)
+    if (MPP_OK == ret) {
         mpp_log("mpi_enc_test success total frame %d bps %lld\n",
                 p->frame_count, (RK_U64)((p->stream_size * 8 * p->fps) / p->frame_count));
-    else
+        mpp_log("average latency first packet %.2f ms whole frame %.2f ms\n",
+                (float)p->first_pkt_time / 1000 / p->frame_count,
+                (float)p->frame_time / 1000 / p->frame_count);
+    } else
         mpp_err("mpi_enc_test failed ret %d\n", ret);
 
     test_ctx_deinit(&p);
@@ -632,6 +685,14 @@ static RK_S32 mpi_enc_test_parse_options(int argc, char **argv, MpiEncTestCmd* c
                     goto PARSE_OPINIONS_OUT;
                 }
                 break;
+            case 's':
+                if (next) {
+                    cmd->slice_mbs = atoi(next);
+                } else {
+                    mpp_err("invalid slice mb count\n");
+                    goto PARSE_OPINIONS_OUT;
+                }
+                break;
             default:
                 mpp_err("skip invalid opt %c\n", *opt);
                 break;
@@ -656,6 +717,7 @@ static void mpi_enc_test_show_options(MpiEncTestCmd* cmd)
     mpp_log("height     : %d\n", cmd->height);
     mpp_log("format     : %d\n", cmd->format);
     mpp_log("type       : %d\n", cmd->type);
+    mpp_log("slice mbs  : %d\n", cmd->slice_mbs);
     mpp_log("debug flag : %x\n", cmd->debug);
 }
 
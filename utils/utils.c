@@ -20,6 +20,7 @@
 
 #include "mpp_mem.h"
 #include "mpp_log.h"
+#include "mpp_common.h"
 #include "utils.h"
 
 void _show_options(int count, OptionInfo *options)
@@ -411,6 +412,72 @@ MPP_RET fill_yuv_image(RK_U8 *buf, RK_U32 width, RK_U32 height,
     return ret;
 }
 
+/* average of scale x scale block, block on right / bottom edge may be smaller */
+static void scale_plane_box(RK_U8 *dst, RK_U32 dst_stride, RK_U8 *src,
+                            RK_U32 src_stride, RK_U32 width, RK_U32 height,
+                            RK_U32 step, RK_U32 scale)
+{
+    RK_U32 out_w = (width + scale - 1) / scale;
+    RK_U32 out_h = (height + scale - 1) / scale;
+    RK_U32 x, y, i, j;
+
+    for (y = 0; y < out_h; y++, dst += dst_stride) {
+        RK_U32 y_end = MPP_MIN((y + 1) * scale, height);
+
+        for (x = 0; x < out_w; x++) {
+            RK_U32 x_end = MPP_MIN((x + 1) * scale, width);
+            RK_U32 sum = 0;
+            RK_U32 cnt = 0;
+
+            for (j = y * scale; j < y_end; j++) {
+                RK_U8 *p = src + j * src_stride;
+
+                for (i = x * scale; i < x_end; i++)
+                    sum += p[i * step];
+
+                cnt += x_end - x * scale;
+            }
+
+            dst[x * step] = (sum + cnt / 2) / cnt;
+        }
+    }
+}
+
+MPP_RET scale_yuv_image(RK_U8 *dst, RK_U8 *src, RK_U32 width, RK_U32 height,
+                        RK_U32 hor_stride, RK_U32 ver_stride,
+                        RK_U32 dst_hor_stride, RK_U32 dst_ver_stride,
+                        MppFrameFormat fmt, RK_U32 scale)
+{
+    MPP_RET ret = MPP_OK;
+    RK_U8 *src_c = NULL;
+    RK_U8 *dst_c = NULL;
+
+    if (NULL == dst || NULL == src || 0 == scale) {
+        mpp_err_f("invalid input dst %p src %p scale %d\n", dst, src, scale);
+        return MPP_ERR_VALUE;
+    }
+
+    src_c = src + hor_stride * ver_stride;
+    dst_c = dst + dst_hor_stride * dst_ver_stride;
+
+    switch (fmt) {
+    case MPP_FMT_YUV420SP : {
+        scale_plane_box(dst, dst_hor_stride, src, hor_stride,
+                        width, height, 1, scale);
+        /* interleaved u and v are scaled separately */
+        scale_plane_box(dst_c, dst_hor_stride, src_c, hor_stride,
+                        width / 2, height / 2, 2, scale);
+        scale_plane_box(dst_c + 1, dst_hor_stride, src_c + 1, hor_stride,
+                        width / 2, height / 2, 2, scale);
+    } break;
+    default : {
+        mpp_err_f("scaling function do not support type %d\n", fmt);
+        ret = MPP_NOK;
+    } break;
+    }
+    return ret;
+}
+
 RK_S32 parse_config_line(const char *str, OpsLine *info)
 {
     RK_S32 cnt = sscanf(str, "%*[^,],%d,%[^,],%llu,%llu\n",
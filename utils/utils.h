@@ -65,6 +65,11 @@ MPP_RET read_yuv_image(RK_U8 *buf, FILE *fp, RK_U32 width, RK_U32 height,
 MPP_RET fill_yuv_image(RK_U8 *buf, RK_U32 width, RK_U32 height,
                        RK_U32 hor_stride, RK_U32 ver_stride, MppFrameFormat fmt,
                        RK_U32 frame_count);
+/* software box filter downscale for codecs without post-processor scaling */
+MPP_RET scale_yuv_image(RK_U8 *dst, RK_U8 *src, RK_U32 width, RK_U32 height,
+                        RK_U32 hor_stride, RK_U32 ver_stride,
+                        RK_U32 dst_hor_stride, RK_U32 dst_ver_stride,
+                        MppFrameFormat fmt, RK_U32 scale);
 
 typedef struct OpsLine_t {
     RK_U32      index;